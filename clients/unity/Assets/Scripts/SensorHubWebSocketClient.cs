@@ -25,8 +25,18 @@ public class SensorHubWebSocketClient : MonoBehaviour
     [Header("Visualizer")]
     public RPLidarVisualizer lidarVisualizer;
 
-    [Header("Polling / heartbeat")]
-    [Tooltip("Milliseconds between poll messages")]
+    [Header("Grid map (livox_bridge LIVOX_GRID, push mode)")]
+    [Tooltip("Texture edge in 16-cell tiles; bridge tiles wrap around it (use the bridge's tiles_per_side)")]
+    public int gridTextureTiles = 16;
+    [Tooltip("Occupancy map of the lidar sensor's grid deltas, one pixel per cell (created on the first delta)")]
+    public Texture2D gridTexture;
+
+    [Header("Push / polling / heartbeat")]
+    [Tooltip("Subscribe with mode=push: the server sends every sample as it arrives (no polling); point clouds come as binary bridge frames")]
+    public bool pushMode = true;
+    [Tooltip("Push mode: samples the server queues per sensor before dropping the oldest")]
+    public int pushQueue = 4;
+    [Tooltip("Milliseconds between poll messages (poll mode only)")]
     public int pollIntervalMs = 100;
     [Tooltip("Send ping every N milliseconds (0 disables heartbeat)")]
     public int pingIntervalMs = 5000;
@@ -56,6 +66,12 @@ public class SensorHubWebSocketClient : MonoBehaviour
     private readonly ConcurrentQueue<(float[] anglesDeg, float[] distances)> lidarQueue =
         new ConcurrentQueue<(float[] anglesDeg, float[] distances)>();
 
+    // Grid tiles decoded on the receive thread, written into gridTexture on the main thread
+    private const int GridTileCells = 16;
+    private const int GridTileBytes = 1292;
+    private readonly ConcurrentQueue<(int tx, int ty, Color32[] pixels)> gridQueue =
+        new ConcurrentQueue<(int tx, int ty, Color32[] pixels)>();
+
     private bool firstLidarFrameLogged = false;
 
     #region Unity lifecycle
@@ -81,6 +97,7 @@ public class SensorHubWebSocketClient : MonoBehaviour
         {
             lidarVisualizer?.ShowScan(item.anglesDeg, item.distances);
         }
+        ApplyGridTiles();
 
         // Heartbeat timeout check
         if (ws != null && ws.State == WebSocketState.Open && connectionTimeoutMs > 0)
@@ -142,7 +159,8 @@ public class SensorHubWebSocketClient : MonoBehaviour
 
                 // Start tasks
                 receiveTask = Task.Run(() => ReceiveLoopAsync(cts.Token), cts.Token);
-                sendTask = Task.Run(() => PollLoopAsync(cts.Token), cts.Token);
+                if (!pushMode)
+                    sendTask = Task.Run(() => PollLoopAsync(cts.Token), cts.Token);
                 pingTask = Task.Run(() => PingLoopAsync(cts.Token), cts.Token);
 
                 // Reset backoff once we are connected
@@ -211,8 +229,9 @@ public class SensorHubWebSocketClient : MonoBehaviour
     {
         foreach (var sid in sensorIds)
         {
-            var subMsg = new { action = "subscribe", sensor_id = sid };
-            var payload = JsonConvert.SerializeObject(subMsg);
+            var payload = pushMode
+                ? JsonConvert.SerializeObject(new { action = "subscribe", sensor_id = sid, mode = "push", queue = pushQueue })
+                : JsonConvert.SerializeObject(new { action = "subscribe", sensor_id = sid });
             await ws.SendAsync(Encoding.UTF8.GetBytes(payload),
                                WebSocketMessageType.Text, true, CancellationToken.None);
             if (verboseLogs) Debug.Log($"WS: Sent subscribe for {sid}");
@@ -244,6 +263,11 @@ public class SensorHubWebSocketClient : MonoBehaviour
                 while (!result.EndOfMessage);
 
                 lastRxUtc = DateTime.UtcNow;
+                if (result.MessageType == WebSocketMessageType.Binary)
+                {
+                    HandleBinary(ms.GetBuffer(), (int)ms.Length);
+                    continue;
+                }
                 var msg = Encoding.UTF8.GetString(ms.ToArray());
                 HandleMessage(msg);
             }
@@ -339,56 +363,21 @@ public class SensorHubWebSocketClient : MonoBehaviour
 
                         // Flexible payload resolution
                         JToken payloadCandidate = data[lidarSensorId] ?? data;
-                        JToken payload = payloadCandidate["data"] ?? payloadCandidate;
-
-                        float[] angles = TryGetFloatArray(payload, "angles", "theta", "angle");
-                        float[] distances = TryGetFloatArray(payload, "distances", "ranges", "distance_mm", "range_mm", "range", "r", "d");
-
-                        if ((angles == null || distances == null) && payload["points"] is JArray points)
-                        {
-                            var aList = new System.Collections.Generic.List<float>(points.Count);
-                            var dList = new System.Collections.Generic.List<float>(points.Count);
-                            foreach (var p in points)
-                            {
-                                float a = TryGetFloat(p, "angle", "theta");
-                                float d = TryGetFloat(p, "distance", "range", "distance_mm", "range_mm", "r", "d");
-                                aList.Add(a);
-                                dList.Add(d);
-                            }
-                            angles = aList.ToArray();
-                            distances = dList.ToArray();
-                        }
-
-                        if (angles == null || distances == null || angles.Length != distances.Length)
-                        {
-                            if (!firstLidarFrameLogged)
-                            {
-                                firstLidarFrameLogged = true;
-                                var keys = (payload as JObject)?.Properties().Select(k => k.Name);
-                                Debug.LogWarning($"WS: Lidar payload shape not matched. Keys = [{string.Join(",", keys ?? Array.Empty<string>())}]");
-                            }
-                            return;
-                        }
-
-                        // Units: radians → degrees
-                        bool isRadians = angles.Max() > 3.5f;
-                        float[] anglesDeg = isRadians ? angles.Select(a => a * Mathf.Rad2Deg).ToArray() : angles;
-
-                        // Heuristic mm vs meters
-                        float med = Median(distances);
-                        if (lidarVisualizer != null)
-                        {
-                            lidarVisualizer.distanceScale = (med > 10f) ? 0.001f : 1f;
-                            if (!firstLidarFrameLogged || verboseLogs)
-                                Debug.Log($"WS: Lidar arrays ok. angles={angles.Length}, distances={distances.Length}, anglesUnit={(isRadians ? "radians" : "degrees")}, distanceMedian={med:F1}, distanceScale={lidarVisualizer.distanceScale:F3}");
-                        }
-                        else
-                        {
-                            Debug.LogWarning("WS: Lidar data received but visualizer is null.");
-                        }
-
-                        lidarQueue.Enqueue((anglesDeg, distances));
-                        firstLidarFrameLogged = true;
+                        HandleLidarPayload(payloadCandidate["data"] ?? payloadCandidate);
+                        break;
+                    }
+
+                case "sample":
+                    {
+                        // push mode: one sample of one sensor
+                        if (root.Value<string>("sensor_id") == lidarSensorId && root["data"] != null)
+                            HandleLidarPayload(root["data"]);
+                        break;
+                    }
+
+                case "dropped":
+                    {
+                        if (verboseLogs) Debug.Log($"WS: Server dropped {root.Value<long>("count")} samples of {root.Value<string>("sensor_id")} (client too slow)");
                         break;
                     }
 
@@ -406,6 +395,159 @@ public class SensorHubWebSocketClient : MonoBehaviour
         }
     }
 
+    private void HandleLidarPayload(JToken payload)
+    {
+        float[] angles = TryGetFloatArray(payload, "angles", "theta", "angle");
+        float[] distances = TryGetFloatArray(payload, "distances", "ranges", "distance_mm", "range_mm", "range", "r", "d");
+
+        if ((angles == null || distances == null) && payload["points"] is JArray points)
+        {
+            var aList = new System.Collections.Generic.List<float>(points.Count);
+            var dList = new System.Collections.Generic.List<float>(points.Count);
+            foreach (var p in points)
+            {
+                float a = TryGetFloat(p, "angle", "theta");
+                float d = TryGetFloat(p, "distance", "range", "distance_mm", "range_mm", "r", "d");
+                aList.Add(a);
+                dList.Add(d);
+            }
+            angles = aList.ToArray();
+            distances = dList.ToArray();
+        }
+
+        if (angles == null || distances == null || angles.Length != distances.Length)
+        {
+            if (!firstLidarFrameLogged)
+            {
+                firstLidarFrameLogged = true;
+                var keys = (payload as JObject)?.Properties().Select(k => k.Name);
+                Debug.LogWarning($"WS: Lidar payload shape not matched. Keys = [{string.Join(",", keys ?? Array.Empty<string>())}]");
+            }
+            return;
+        }
+
+        // Units: radians → degrees
+        bool isRadians = angles.Max() > 3.5f;
+        float[] anglesDeg = isRadians ? angles.Select(a => a * Mathf.Rad2Deg).ToArray() : angles;
+
+        // Heuristic mm vs meters
+        float med = Median(distances);
+        if (lidarVisualizer != null)
+        {
+            lidarVisualizer.distanceScale = (med > 10f) ? 0.001f : 1f;
+            if (!firstLidarFrameLogged || verboseLogs)
+                Debug.Log($"WS: Lidar arrays ok. angles={angles.Length}, distances={distances.Length}, anglesUnit={(isRadians ? "radians" : "degrees")}, distanceMedian={med:F1}, distanceScale={lidarVisualizer.distanceScale:F3}");
+        }
+        else
+        {
+            Debug.LogWarning("WS: Lidar data received but visualizer is null.");
+        }
+
+        lidarQueue.Enqueue((anglesDeg, distances));
+        firstLidarFrameLogged = true;
+    }
+
+    // Binary push frame: u16 id length, sensor id (UTF-8), then one livox_bridge frame
+    // (56-byte LVXB header + points, bridge_frame.h). Scans (POINT_XYZRT or its columnar
+    // form, meters) and CARTESIAN_HIGH packets (mm) are projected onto the sensor's XY plane
+    // for the 2D view.
+    private const int BridgeHeaderSize = 56;
+
+    private void HandleBinary(byte[] buf, int len)
+    {
+        if (len < 2) return;
+        int idLen = buf[0] | (buf[1] << 8);
+        int off = 2 + idLen;
+        if (len < off + BridgeHeaderSize) return;
+        if (Encoding.UTF8.GetString(buf, 2, idLen) != lidarSensorId) return;
+        if (buf[off] != (byte)'L' || buf[off + 1] != (byte)'V' || buf[off + 2] != (byte)'X' || buf[off + 3] != (byte)'B')
+            return;
+
+        byte msgType = buf[off + 5];
+        byte pointFormat = buf[off + 6];
+        int count = (int)BitConverter.ToUInt32(buf, off + 20);
+        int stride, p = off + BridgeHeaderSize, yOff = 4;
+        bool meters;
+        if (msgType == 6 && pointFormat == 8)                // grid delta: GRID_TILE records
+        {
+            if (count > 0 && len >= p + count * GridTileBytes) HandleGridTiles(buf, p, count);
+            return;
+        }
+        if (msgType != 1 && msgType != 2) return;          // points / scan; IMU is not drawn
+        if (pointFormat == 4) { stride = 20; meters = true; }        // POINT_XYZRT, float32 m
+        else if (pointFormat == 1) { stride = 14; meters = false; }  // CARTESIAN_HIGH, int32 mm
+        else if (pointFormat == 7) { stride = 4; meters = true; }    // XYZRT columns: x[n], y[n], ...
+        else return;
+        if (count <= 0) return;
+        if (pointFormat == 7)
+        {
+            if (len < p + count * 18) return;
+            yOff = count * 4;
+        }
+        else if (len < p + count * stride) return;
+
+        var anglesDeg = new float[count];
+        var distances = new float[count];
+        for (int i = 0; i < count; ++i, p += stride)
+        {
+            float x = meters ? BitConverter.ToSingle(buf, p) : BitConverter.ToInt32(buf, p);
+            float y = meters ? BitConverter.ToSingle(buf, p + yOff) : BitConverter.ToInt32(buf, p + 4);
+            anglesDeg[i] = Mathf.Atan2(y, x) * Mathf.Rad2Deg;
+            distances[i] = Mathf.Sqrt(x * x + y * y);
+        }
+        if (lidarVisualizer != null)
+            lidarVisualizer.distanceScale = meters ? 1f : 0.001f;
+        lidarQueue.Enqueue((anglesDeg, distances));
+        firstLidarFrameLogged = true;
+    }
+
+    // One colour per cell: clear = unknown, grey = ground seen, red with the occupancy evidence.
+    private void HandleGridTiles(byte[] buf, int p, int count)
+    {
+        const int n = GridTileCells * GridTileCells;
+        for (int t = 0; t < count; ++t, p += GridTileBytes)
+        {
+            int tx = BitConverter.ToInt32(buf, p);
+            int ty = BitConverter.ToInt32(buf, p + 4);
+            bool cleared = (buf[p + 10] & 0x01) != 0;        // left the bridge's window
+            var pixels = new Color32[n];
+            if (!cleared)
+            {
+                for (int i = 0; i < n; ++i)
+                {
+                    short ground = BitConverter.ToInt16(buf, p + 12 + 2 * i);
+                    byte occ = buf[p + 12 + 4 * n + i];
+                    if (ground == short.MinValue) continue;  // not observed
+                    pixels[i] = occ > 0 ? new Color32(255, (byte)(255 - occ), (byte)(255 - occ), 255)
+                                        : new Color32(96, 96, 96, 255);
+                }
+            }
+            gridQueue.Enqueue((tx, ty, pixels));
+        }
+    }
+
+    private void ApplyGridTiles()
+    {
+        if (gridQueue.IsEmpty) return;
+        int size = Mathf.Max(gridTextureTiles, 1) * GridTileCells;
+        if (gridTexture == null || gridTexture.width != size)
+        {
+            gridTexture = new Texture2D(size, size, TextureFormat.RGBA32, false);
+            gridTexture.filterMode = FilterMode.Point;
+            gridTexture.wrapMode = TextureWrapMode.Repeat;
+            gridTexture.SetPixels32(new Color32[size * size]);
+        }
+        int tiles = size / GridTileCells;
+        while (gridQueue.TryDequeue(out var tile))
+        {
+            // tiles wrap like the bridge's window, so a moving map never shifts pixels
+            int x = (((tile.tx % tiles) + tiles) % tiles) * GridTileCells;
+            int y = (((tile.ty % tiles) + tiles) % tiles) * GridTileCells;
+            gridTexture.SetPixels32(x, y, GridTileCells, GridTileCells, tile.pixels);
+        }
+        gridTexture.Apply(false);
+    }
+
     private static float[] TryGetFloatArray(JToken obj, params string[] keys)
     {
         foreach (var k in keys)
@@ -0,0 +1,183 @@
+// Livox MID-360 Bridge - per-subscriber backpressure (adaptive decimation)
+//
+// A subscriber that cannot keep up otherwise loses datagrams in its kernel receive buffer:
+// at random, and visible nowhere in the bridge. BackpressurePolicy watches two signals per
+// subscriber over windows of window_ns:
+//   - send errors on its UDP lane (sendmmsg / sendmsg failures, udp_batcher.h)
+//   - lag the consumer reports itself with
+//       {"cmd":"lag","lost":<n>,"queued":<n>,"capacity":<n>}
+//     lost: records it lost so far, cumulative (receive-queue overflows, incomplete scans,
+//     its own queue drops, shm overruns); queued / capacity: its receive queue right now
+// and steps the subscriber's level (subscriptions.h):
+//   kSubFull         everything it subscribed to
+//   kSubDownsampled  scans voxel-downsampled to voxel_m (kBridgeFlagDownsampled)
+//   kSubShed         downsampled, and only every shed_every-th scan / range image
+// A window with more errors, more lost records or a queue at least half full steps one
+// level down; recover_windows clean windows in a row step one level back up. Without scan
+// assembly there is nothing to voxelize, so level 1 is skipped. IMU, info, stats and grid
+// records are small and always sent whole. Every transition goes to the caller, which
+// reports it on the stats stream. Emitter thread only.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bridge_transport.h"
+#include "subscriptions.h"
+
+struct BackpressureConfig {
+    bool enabled;
+    uint64_t window_ns;
+    uint32_t recover_windows;    // clean windows before stepping back up
+    uint32_t shed_every;         // kSubShed: keep every Nth scan
+    float voxel_m;               // kSubDownsampled voxel edge
+    bool downsample;             // scans are assembled, so level 1 exists
+
+    BackpressureConfig()
+        : enabled(true), window_ns(500000000ull), recover_windows(6), shed_every(4), voxel_m(0.2f),
+          downsample(true) {}
+};
+
+enum BackpressureReason { kBpNone, kBpSendErrors, kBpLost, kBpQueue, kBpRecovered };
+
+static inline const char* backpressure_reason_name(uint8_t r) {
+    static const char* const kNames[] = { "none", "send_errors", "lost", "queue", "recovered" };
+    return r <= kBpRecovered ? kNames[r] : "?";
+}
+
+// One level change, as handed to the caller.
+struct BackpressureTransition {
+    uint32_t sub;                // subscriber id
+    uint8_t from;
+    uint8_t to;
+    uint8_t reason;              // BackpressureReason
+    uint64_t send_errors;        // in the window
+    uint64_t lost;               // in the window, as reported
+    uint32_t queued;
+    uint32_t capacity;
+};
+
+class BackpressurePolicy {
+public:
+    BackpressurePolicy() : next_ns_(0), transitions_(0) { std::memset(st_, 0, sizeof(st_)); }
+
+    void configure(const BackpressureConfig& cfg) { cfg_ = cfg; }
+    const BackpressureConfig& config() const { return cfg_; }
+    bool enabled() const { return cfg_.enabled; }
+    uint64_t transitions() const { return transitions_; }
+
+    // A {"cmd":"lag"} report of subscriber slot; kept until the next window closes.
+    void report(size_t slot, uint32_t id, uint64_t lost, uint32_t queued, uint32_t capacity) {
+        State& s = st_[slot];
+        if (s.id != id) reset(slot, id);
+        if (!s.lost_based) {
+            // losses from before this subscription are not this window's
+            s.lost = lost;
+            s.lost_based = true;
+        }
+        s.reported_lost = lost;
+        s.queued = queued;
+        s.capacity = capacity;
+        s.reported = true;
+        ++s.reports;
+    }
+
+    // Close the window when it is due: evaluate every subscriber, apply level changes to the
+    // transport's table and call on_change(const BackpressureTransition&) for each.
+    template <typename Fn>
+    void poll(uint64_t now_ns, BridgeTransport& out, Fn on_change) {
+        if (!cfg_.enabled || now_ns < next_ns_) return;
+        next_ns_ = now_ns + cfg_.window_ns;
+        SubscriberTable& subs = out.subs();
+        for (size_t i = 0; i < SubscriberTable::kMax; ++i) {
+            const Subscriber& sub = subs.at(i);
+            if (!sub.active) continue;
+            State& s = st_[i];
+            const uint64_t errors = out.send_errors(i + 1);
+            if (s.id != sub.id) reset(i, sub.id);
+            if (!s.errors_based) {
+                // the lane's count includes earlier subscribers of the slot
+                s.errors = errors;
+                s.errors_based = true;
+            }
+            BackpressureTransition t;
+            std::memset(&t, 0, sizeof(t));
+            t.sub = sub.id;
+            t.from = sub.level;
+            t.send_errors = errors - s.errors;
+            // a consumer that restarted reports a smaller total: take it as the new baseline
+            t.lost = s.reported_lost > s.lost ? s.reported_lost - s.lost : 0;
+            t.queued = s.reported ? s.queued : 0;
+            t.capacity = s.reported ? s.capacity : 0;
+            s.errors = errors;
+            s.lost = s.reported_lost;
+            s.reported = false;
+            s.total_lost += t.lost;
+            if (t.send_errors) t.reason = kBpSendErrors;
+            else if (t.lost) t.reason = kBpLost;
+            else if (t.capacity && t.queued * 2 >= t.capacity) t.reason = kBpQueue;
+            if (t.reason != kBpNone) {
+                s.clean = 0;
+                t.to = step_down(sub.level);
+            }
+            else if (sub.level != kSubFull && ++s.clean >= cfg_.recover_windows) {
+                s.clean = 0;
+                t.reason = kBpRecovered;
+                t.to = step_up(sub.level);
+            }
+            else {
+                t.to = sub.level;
+            }
+            if (t.to == t.from) continue;
+            subs.set_level(i, t.to);
+            ++s.transitions;
+            ++transitions_;
+            on_change(t);
+        }
+    }
+
+    // Per-subscriber totals for the stats record.
+    uint64_t transitions(size_t slot, uint32_t id) const { return st_[slot].id == id ? st_[slot].transitions : 0; }
+    uint64_t lost(size_t slot, uint32_t id) const { return st_[slot].id == id ? st_[slot].total_lost : 0; }
+    uint64_t reports(size_t slot, uint32_t id) const { return st_[slot].id == id ? st_[slot].reports : 0; }
+
+private:
+    struct State {
+        uint32_t id;             // subscriber the slot's state belongs to
+        bool errors_based;
+        bool lost_based;
+        uint64_t errors;         // lane send errors at the last window
+        uint64_t lost;           // reported lost at the last window
+        uint64_t reported_lost;
+        uint32_t queued;
+        uint32_t capacity;
+        bool reported;           // a report arrived in this window
+        uint32_t clean;          // clean windows in a row
+        uint64_t transitions;
+        uint64_t total_lost;
+        uint64_t reports;
+    };
+
+    // Slot taken by a new subscriber: its baselines are taken at the first window / report.
+    void reset(size_t slot, uint32_t id) {
+        std::memset(&st_[slot], 0, sizeof(State));
+        st_[slot].id = id;
+    }
+
+    uint8_t step_down(uint8_t level) const {
+        if (level >= kSubShed) return kSubShed;
+        return (level == kSubFull && cfg_.downsample) ? kSubDownsampled : kSubShed;
+    }
+
+    uint8_t step_up(uint8_t level) const {
+        if (level == kSubShed && cfg_.downsample) return kSubDownsampled;
+        return kSubFull;
+    }
+
+    BackpressureConfig cfg_;
+    State st_[SubscriberTable::kMax];
+    uint64_t next_ns_;
+    uint64_t transitions_;
+};
@@ -0,0 +1,231 @@
+// Livox MID-360 Bridge - binary frame wire format (version 2)
+//
+// Every binary message starts with a fixed 56-byte little-endian header followed by
+// `payload_len` bytes of payload. All structs are packed; consumers (Python adapter,
+// recorders, clients) must mirror this layout exactly. Bump kBridgeFrameVersion on any
+// incompatible change.
+//
+//   offset  size  field
+//   0       4     magic         'L','V','X','B'
+//   4       1     version       kBridgeFrameVersion
+//   5       1     msg_type      BridgeMsgType
+//   6       1     point_format  BridgePointFormat: payload record layout
+//   7       1     time_type     SDK pkt->time_type (0 none, 1 gPTP, 2 GPS)
+//   8       4     handle        SDK device handle
+//   12      4     seq           bridge-wide message sequence (detects loss/reorder)
+//   16      2     frag_index    fragment index for messages split across datagrams
+//   18      2     frag_count    total fragments (1 when not fragmented)
+//   20      4     point_count   records (points / IMU samples) carried in this fragment
+//   24      4     payload_len   bytes following the header
+//   28      1     frame_cnt     SDK pkt->frame_cnt
+//   29      1     flags         BridgeFrameFlags
+//   30      2     reserved      0 (scans: SDK packets merged, saturating)
+//   32      8     host_ts_ns    host CLOCK_MONOTONIC at capture
+//   40      8     device_ts_ns  SDK pkt->timestamp (device clock, ns)
+//   48      8     stamp_ns      device_ts_ns mapped to host CLOCK_REALTIME (ns), see clock_sync.h
+//
+// Version 2 added stamp_ns; scan point t_offset_ns is relative to stamp_ns.
+// IMU batches (msg 3) carry the first sample's stamp in stamp_ns and device_ts_ns = 0; an
+// IMU preint (msg 4) carries one record and follows the scan whose seq it names.
+// A compressed scan (msg 5) is sent as independently decodable blocks, one per message:
+// frag_index / frag_count number the blocks, point_count is the block's points, and the
+// payload is a BridgeCodecBlock plus columns (see scan_codec.h); point_format names the
+// decoded layout.
+// A columnar scan (point_format kBridgePointXyzrtColumns, LIVOX_POINT_LAYOUT=columns) carries
+// the BridgePoint fields of its n points as columns: x[n], y[n], z[n] float32,
+// t_offset_ns[n] uint32, reflectivity[n], tag[n] uint8 (no reserved field). Every fragment
+// is laid out on its own, so reassembly joins fragments column by column.
+// A grid delta (msg 6) carries the tiles of the rolling grid map (grid_map.h) that changed
+// since the previous delta, one BridgeGridTile per record; stamp_ns is the scan's that
+// caused it (0 for deltas caused by a grid_pose / grid_snapshot command).
+// A laser scan (msg 7, rplidar_bridge) is one 360 degree revolution of a 2D scanner, one
+// BridgeLaserPoint per measurement in angle order. handle is derived from the device serial
+// (never 0), frame_cnt counts revolutions, device_ts_ns is 0 (the device has no clock) and
+// stamp_ns is the host CLOCK_REALTIME the first measurement of the revolution arrived.
+// A range image (msg 8, LIVOX_RANGE_IMAGE) is one scan projected onto height x width pixels
+// of elevation x azimuth (range_image.h). Its records are image rows: point_count rows of
+// width pixels, laid out per fragment as range_m[rows][width] float32 (0 = no return) then
+// intensity[rows][width] uint8, so width = payload_len / (5 * point_count) and a message
+// that fits one fragment (shm slots sized for it) is the whole image as two dense arrays.
+// Fragments carry consecutive rows from row 0; header fields are the scan's.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+static const uint32_t kBridgeFrameMagic = 0x4258564Cu;   // "LVXB" read as little-endian u32
+static const uint8_t  kBridgeFrameVersion = 2;
+
+enum BridgeMsgType {
+    kBridgeMsgPoints = 1,   // one SDK packet, points in SDK layout
+    kBridgeMsgScan = 2,     // one assembled scan, BridgePoint layout
+    kBridgeMsgImu = 3,      // batch of IMU samples, BridgeImuSample layout
+    kBridgeMsgImuPreint = 4, // IMU integrated over one scan, BridgeImuPreint layout
+    kBridgeMsgScanCompressed = 5, // one block of a scan, scan_codec.h, decodes to BridgePoint
+    kBridgeMsgGridDelta = 6, // changed tiles of the grid map, BridgeGridTile layout
+    kBridgeMsgLaserScan = 7, // one revolution of a 2D laser scanner, BridgeLaserPoint layout
+    kBridgeMsgRangeImage = 8, // one scan as a range / intensity image, kBridgeRangeImageRows layout
+};
+
+enum BridgeFrameFlags {
+    kBridgeFlagFused = 0x01,      // scan merged from several devices (handle = kBridgeFusedHandle)
+    kBridgeFlagDeskewed = 0x02,   // scan points rotated into the sensor frame at stamp_ns (IMU)
+    kBridgeFlagDownsampled = 0x04,  // scan voxel-downsampled for a lagging subscriber (backpressure.h)
+};
+
+// SDK handles are derived from the device IP and never 0
+static const uint32_t kBridgeFusedHandle = 0;
+
+// Point payload layouts. Values match LivoxLidarPointDataType so per-packet frames are a
+// straight copy of LivoxLidarEthernetPacket::data.
+enum BridgePointFormat {
+    kBridgePointCartesianHigh = 1,   // int32 x,y,z (mm), uint8 reflectivity, uint8 tag  -> 14 B
+    kBridgePointCartesianLow = 2,    // int16 x,y,z (cm), uint8 reflectivity, uint8 tag  -> 8 B
+    kBridgePointSpherical = 3,       // uint32 depth (mm), uint16 theta, uint16 phi (0.01 deg),
+                                     // uint8 reflectivity, uint8 tag                    -> 10 B
+    kBridgePointXyzrt = 4,           // BridgePoint                                     -> 20 B
+    kBridgeImuSample = 5,            // BridgeImuSample                                 -> 32 B
+    kBridgeImuPreint = 6,            // BridgeImuPreint                                 -> 64 B
+    kBridgePointXyzrtColumns = 7,    // BridgePoint fields as columns, see above          -> 18 B
+    kBridgeGridTile = 8,             // BridgeGridTile                                  -> 1292 B
+    kBridgeLaserPoint = 9,           // BridgeLaserPoint                                -> 16 B
+    kBridgeRangeImageRows = 10,      // image rows as planes, see above          -> 5 B per pixel
+};
+
+static const size_t kBridgeColumnsPointBytes = 18;
+static const size_t kBridgeRangePixelBytes = 5;     // kBridgeRangeImageRows: float32 range + uint8 intensity
+
+// Grid tiles are kBridgeGridTileCells x kBridgeGridTileCells cells; a cell layer holding
+// kBridgeGridUnknown has not been observed.
+static const size_t kBridgeGridTileCells = 16;
+static const int16_t kBridgeGridUnknown = -32768;
+
+enum BridgeGridTileFlags {
+    kBridgeGridTileCleared = 0x01,   // the tile left the map window: forget it (layers unknown)
+};
+
+#pragma pack(push, 1)
+struct BridgeFrameHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  msg_type;
+    uint8_t  point_format;
+    uint8_t  time_type;
+    uint32_t handle;
+    uint32_t seq;
+    uint16_t frag_index;
+    uint16_t frag_count;
+    uint32_t point_count;
+    uint32_t payload_len;
+    uint8_t  frame_cnt;
+    uint8_t  flags;
+    uint16_t reserved;
+    uint64_t host_ts_ns;
+    uint64_t device_ts_ns;
+    uint64_t stamp_ns;
+};
+
+
+// Assembled-scan point: float32 x,y,z (m), uint32 t_offset_ns from the scan stamp_ns,
+// uint8 reflectivity, uint8 tag, uint16 reserved
+struct BridgePoint {
+    float    x;
+    float    y;
+    float    z;
+    uint32_t t_offset_ns;
+    uint8_t  reflectivity;
+    uint8_t  tag;
+    uint16_t reserved;
+};
+
+// IMU sample: stamp_ns on the mapped host clock, gyro (rad/s) then accelerometer (g),
+// as reported by the SDK
+struct BridgeImuSample {
+    uint64_t stamp_ns;
+    float    gx, gy, gz;
+    float    ax, ay, az;
+};
+
+// Preintegrated IMU over [start_ns, end_ns] (mapped host clock, clipped to the samples
+// available), expressed in the frame at start_ns: dq = rotation (w, x, y, z), dv = velocity
+// change (m/s) and dp = displacement (m, zero initial velocity) from specific force, gravity
+// not removed. scan_seq is the seq of the scan message it belongs to.
+struct BridgeImuPreint {
+    uint32_t scan_seq;
+    uint32_t samples;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    float    dq[4];
+    float    dv[3];
+    float    dp[3];
+};
+
+// One tile of the grid map: cells [tx * 16, tx * 16 + 16) x [ty * 16, ty * 16 + 16) of the
+// map frame, cell (cx, cy) covering [cx, cx + 1) * cell_mm / 1000 m. Layers are row-major
+// [cy % 16][cx % 16]: lowest z seen (ground) and highest z of the latest scan (height), in
+// cm of the map frame, and occupancy 0..255 (evidence of an obstacle above the ground).
+struct BridgeGridTile {
+    int32_t  tx;
+    int32_t  ty;
+    uint16_t cell_mm;
+    uint8_t  flags;          // BridgeGridTileFlags
+    uint8_t  reserved;
+    int16_t  ground_cm[kBridgeGridTileCells * kBridgeGridTileCells];
+    int16_t  height_cm[kBridgeGridTileCells * kBridgeGridTileCells];
+    uint8_t  occupancy[kBridgeGridTileCells * kBridgeGridTileCells];
+};
+
+// 2D laser measurement: bearing (deg, clockwise seen from above, 0 = scanner front), range
+// (mm, 0 = no return), t_offset_ns from the scan stamp_ns, device signal quality
+struct BridgeLaserPoint {
+    float    angle_deg;
+    float    range_mm;
+    uint32_t t_offset_ns;
+    uint8_t  quality;
+    uint8_t  reserved[3];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BridgeFrameHeader) == 56, "BridgeFrameHeader must stay 56 bytes");
+static_assert(sizeof(BridgePoint) == 20, "BridgePoint must stay 20 bytes");
+static_assert(sizeof(BridgeImuSample) == 32, "BridgeImuSample must stay 32 bytes");
+static_assert(sizeof(BridgeImuPreint) == 64, "BridgeImuPreint must stay 64 bytes");
+static_assert(sizeof(BridgeGridTile) == 1292, "BridgeGridTile must stay 1292 bytes");
+static_assert(sizeof(BridgeLaserPoint) == 16, "BridgeLaserPoint must stay 16 bytes");
+
+// Size in bytes of one point for a given format; 0 for unknown formats.
+static inline size_t bridge_point_size(uint8_t point_format) {
+    switch (point_format) {
+    case kBridgePointCartesianHigh: return 14;
+    case kBridgePointCartesianLow:  return 8;
+    case kBridgePointSpherical:     return 10;
+    case kBridgePointXyzrt:         return sizeof(BridgePoint);
+    case kBridgeImuSample:          return sizeof(BridgeImuSample);
+    case kBridgeImuPreint:          return sizeof(BridgeImuPreint);
+    case kBridgePointXyzrtColumns:  return kBridgeColumnsPointBytes;
+    case kBridgeGridTile:           return sizeof(BridgeGridTile);
+    case kBridgeLaserPoint:         return sizeof(BridgeLaserPoint);
+    default:                        return 0;
+    }
+}
+
+static inline void bridge_init_header(BridgeFrameHeader* h, uint8_t msg_type) {
+    h->magic = kBridgeFrameMagic;
+    h->version = kBridgeFrameVersion;
+    h->msg_type = msg_type;
+    h->point_format = 0;
+    h->time_type = 0;
+    h->handle = 0;
+    h->seq = 0;
+    h->frag_index = 0;
+    h->frag_count = 1;
+    h->point_count = 0;
+    h->payload_len = 0;
+    h->frame_cnt = 0;
+    h->flags = 0;
+    h->reserved = 0;
+    h->host_ts_ns = 0;
+    h->device_ts_ns = 0;
+    h->stamp_ns = 0;
+}
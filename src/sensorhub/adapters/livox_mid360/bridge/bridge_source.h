@@ -0,0 +1,67 @@
+// Livox MID-360 Bridge - pluggable input sources
+//
+// A source produces what the SDK callbacks would: point and IMU packets in SDK layout with
+// their arrival times, and device-info updates. It pushes them into the bridge through a
+// BridgeSourceSink, i.e. the same enqueue path as the SDK callbacks, so everything from the
+// queues on (assembly, filtering, fusion, serialization, transports) runs unchanged.
+//
+//   sdk        Livox SDK2 (livox_bridge.cpp; absent when built with LIVOX_BRIDGE_NO_SDK)
+//   replay     a .lvxr recording (replay_source.h)
+//   synthetic  generated MID-360-like devices at a set packet rate (synthetic_source.h)
+//
+// Sources that deliver from their own thread must use exactly one thread for points and one
+// for IMU (the queues are single-producer); the built-in ones use a single thread for both.
+
+#pragma once
+
+#include <errno.h>
+#include <time.h>
+
+#include <cstdint>
+
+#include "livox_sdk_compat.h"
+
+struct BridgeSourceSink {
+    // t0: when the source started handling the packet (callback entry); host_ns / host_rt_ns:
+    // its arrival time on CLOCK_MONOTONIC / CLOCK_REALTIME.
+    void (*points)(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t t0,
+        uint64_t host_ns, uint64_t host_rt_ns);
+    void (*imu)(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t t0,
+        uint64_t host_ns, uint64_t host_rt_ns);
+    void (*info)(uint32_t handle, const LivoxLidarInfo* info);
+    // Block while the points (imu false) or IMU queue is full; sources running faster than
+    // real time call it instead of dropping. Returns false once the source must stop.
+    bool (*wait_for_room)(bool imu);
+    // The source ran out of input (end of a recording, generator duration reached).
+    void (*finished)();
+};
+
+class BridgeSource {
+public:
+    virtual ~BridgeSource() {}
+    virtual const char* name() const = 0;
+    // False (with a message on stderr) if the source cannot start.
+    virtual bool start(const BridgeSourceSink& sink) = 0;
+    // Stop delivering; no sink call is made after it returns.
+    virtual void stop() = 0;
+};
+
+// Pacing helpers for sources that run their own thread (CLOCK_MONOTONIC, like host_ns).
+static inline uint64_t source_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t source_realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void source_sleep_until_ns(uint64_t t) {
+    timespec ts;
+    ts.tv_sec = (time_t)(t / 1000000000ull);
+    ts.tv_nsec = (long)(t % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
@@ -0,0 +1,218 @@
+// Livox MID-360 Bridge - warm-restart state file
+//
+// The bridge runs under systemd with Restart=always; without this file every restart forgets
+// the fleet, the configuration applied to it and who subscribed. BridgeState is a small JSON
+// document (LIVOX_STATE_FILE):
+//
+//   {"version":1,"clean":true,"bin_seq":123456,
+//    "devices":[{"handle":..,"dev_type":9,"sn":"..","ip":"..","applied":31,"work_mode":1,
+//                "pattern":0,"fov":[0,360,-7,52],"fov_enable":1,"imu":1}],
+//    "subscribers":[{"addr":"127.0.0.1","port":19001,"streams":3,"format":1,"decimate":1,
+//                    "expires_us":1760000000000000}]}
+//
+// Per device it keeps the handle, SN, IP and the last work mode / scan pattern / FoV / IMU
+// setting an SDK request applied successfully (`applied` flags which are known). Subscriber
+// leases end at a CLOCK_REALTIME time (0 = never), so downtime counts against them. bin_seq
+// is the next binary frame seq; a file not written at shutdown ("clean":false) makes the
+// restarted bridge skip kSeqCrashGap ahead, past whatever it sent after the last save.
+//
+// save() writes <path>.tmp and renames it over the file, so a crash leaves the old or the
+// new state, never half of one. It is not fsync'ed: the file is a cache, losing the last
+// second of it on power loss only costs a cold start.
+
+#pragma once
+
+#include <arpa/inet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "json_lite.h"
+
+enum CachedConfigBits { kCfgWorkMode = 1, kCfgPattern = 2, kCfgFov = 4, kCfgFovEnable = 8, kCfgImu = 16 };
+
+struct CachedDevice {
+    uint32_t handle;
+    uint8_t  dev_type;
+    char     sn[17];
+    char     ip[17];
+    uint32_t applied;        // CachedConfigBits of the fields below that are known
+    int32_t  work_mode;
+    int32_t  pattern;
+    int32_t  fov[4];         // yaw_start, yaw_stop, pitch_start, pitch_stop
+    int32_t  fov_enable;
+    int32_t  imu_enable;
+};
+
+struct CachedSubscriber {
+    uint32_t addr;           // network byte order
+    uint16_t port;
+    uint8_t  format;         // BridgeEncoding
+    uint32_t streams;        // BridgeStream mask
+    uint32_t decimate;
+    uint64_t expires_rt_ns;  // CLOCK_REALTIME lease end, 0 = never
+};
+
+class BridgeState {
+public:
+    static const size_t kMaxDevices = 16;
+    static const size_t kMaxSubscribers = 16;
+    static const uint32_t kSeqCrashGap = 1u << 20;
+    static const size_t kMaxFileBytes = 16384;
+
+    BridgeState() { clear(); }
+
+    void clear() {
+        n_devices = n_subscribers = 0;
+        bin_seq = 0;
+        clean = false;
+        std::memset(devices, 0, sizeof(devices));
+        std::memset(subscribers, 0, sizeof(subscribers));
+    }
+
+    CachedDevice* find(uint32_t handle) {
+        for (size_t i = 0; i < n_devices; ++i)
+            if (devices[i].handle == handle) return &devices[i];
+        return NULL;
+    }
+
+    CachedDevice* find_sn(const char* sn) {
+        if (!sn[0]) return NULL;
+        for (size_t i = 0; i < n_devices; ++i)
+            if (std::strncmp(devices[i].sn, sn, sizeof(devices[i].sn)) == 0) return &devices[i];
+        return NULL;
+    }
+
+    // Entry of handle, created empty if new; NULL when the table is full.
+    CachedDevice* add(uint32_t handle) {
+        if (CachedDevice* d = find(handle)) return d;
+        if (n_devices == kMaxDevices) return NULL;
+        CachedDevice* d = &devices[n_devices++];
+        std::memset(d, 0, sizeof(*d));
+        d->handle = handle;
+        return d;
+    }
+
+    // False if the file is missing or not a version-1 state (the bridge then starts cold).
+    bool load(const char* path) {
+        clear();
+        FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        static char buf[kMaxFileBytes];
+        const size_t len = std::fread(buf, 1, sizeof(buf), f);
+        std::fclose(f);
+        JsonValue root, v;
+        if (!json_parse(buf, buf + len, &root) || root.type != kJsonObject ||
+            json_find_number(root, "version", 0) != 1)
+            return false;
+        clean = json_find(root, "clean", &v) && v.type == kJsonTrue;
+        bin_seq = (uint32_t)json_find_number(root, "bin_seq", 0);
+        if (json_find(root, "devices", &v)) {
+            JsonIter it(v);
+            JsonValue d;
+            while (n_devices < kMaxDevices && it.next(&d)) load_device(d);
+        }
+        if (json_find(root, "subscribers", &v)) {
+            JsonIter it(v);
+            JsonValue s;
+            while (n_subscribers < kMaxSubscribers && it.next(&s)) load_subscriber(s);
+        }
+        return true;
+    }
+
+    bool save(const char* path, bool clean_exit) const {
+        static char buf[kMaxFileBytes];
+        size_t n = 0;
+        n += fmt(buf + n, sizeof(buf) - n, "{\"version\":1,\"clean\":%s,\"bin_seq\":%u,\"devices\":[",
+            clean_exit ? "true" : "false", bin_seq);
+        for (size_t i = 0; i < n_devices; ++i) {
+            const CachedDevice& d = devices[i];
+            n += fmt(buf + n, sizeof(buf) - n,
+                "%s{\"handle\":%u,\"dev_type\":%u,\"sn\":\"%s\",\"ip\":\"%s\",\"applied\":%u,\"work_mode\":%d,"
+                "\"pattern\":%d,\"fov\":[%d,%d,%d,%d],\"fov_enable\":%d,\"imu\":%d}",
+                i ? "," : "", d.handle, d.dev_type, d.sn, d.ip, d.applied, d.work_mode, d.pattern,
+                d.fov[0], d.fov[1], d.fov[2], d.fov[3], d.fov_enable, d.imu_enable);
+        }
+        n += fmt(buf + n, sizeof(buf) - n, "%s", "],\"subscribers\":[");
+        for (size_t i = 0; i < n_subscribers; ++i) {
+            const CachedSubscriber& s = subscribers[i];
+            char addr[INET_ADDRSTRLEN];
+            in_addr a;
+            a.s_addr = s.addr;
+            if (!inet_ntop(AF_INET, &a, addr, sizeof(addr))) continue;
+            n += fmt(buf + n, sizeof(buf) - n,
+                "%s{\"addr\":\"%s\",\"port\":%u,\"streams\":%u,\"format\":%u,\"decimate\":%u,"
+                "\"expires_us\":%llu}",
+                i ? "," : "", addr, s.port, s.streams, s.format, s.decimate,
+                (unsigned long long)(s.expires_rt_ns / 1000));
+        }
+        n += fmt(buf + n, sizeof(buf) - n, "%s", "]}\n");
+
+        char tmp[512];
+        if (std::snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return false;
+        FILE* f = std::fopen(tmp, "wb");
+        if (!f) return false;
+        const bool ok = std::fwrite(buf, 1, n, f) == n;
+        if (std::fclose(f) != 0 || !ok) { std::remove(tmp); return false; }
+        return std::rename(tmp, path) == 0;
+    }
+
+    size_t n_devices;
+    size_t n_subscribers;
+    uint32_t bin_seq;        // next binary frame seq
+    bool clean;              // the file was written at shutdown
+    CachedDevice devices[kMaxDevices];
+    CachedSubscriber subscribers[kMaxSubscribers];
+
+private:
+    // snprintf that never advances past the buffer
+    template <typename... Args>
+    static size_t fmt(char* p, size_t cap, const char* f, Args... args) {
+        if (cap == 0) return 0;
+        const int n = std::snprintf(p, cap, f, args...);
+        return n < 0 ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+    }
+
+    void load_device(const JsonValue& o) {
+        if (o.type != kJsonObject) return;
+        const double h = json_find_number(o, "handle", 0);
+        if (h <= 0 || h > 4294967295.0) return;
+        CachedDevice* d = add((uint32_t)h);
+        if (!d) return;
+        JsonValue v;
+        d->dev_type = (uint8_t)json_find_number(o, "dev_type", 0);
+        if (json_find(o, "sn", &v)) json_string(v, d->sn, sizeof(d->sn));
+        if (json_find(o, "ip", &v)) json_string(v, d->ip, sizeof(d->ip));
+        d->applied = (uint32_t)json_find_number(o, "applied", 0);
+        d->work_mode = (int32_t)json_find_number(o, "work_mode", 0);
+        d->pattern = (int32_t)json_find_number(o, "pattern", 0);
+        d->fov_enable = (int32_t)json_find_number(o, "fov_enable", 0);
+        d->imu_enable = (int32_t)json_find_number(o, "imu", 0);
+        if (json_find(o, "fov", &v)) {
+            JsonIter it(v);
+            JsonValue x;
+            for (size_t k = 0; k < 4 && it.next(&x); ++k) d->fov[k] = (int32_t)json_number(x, 0);
+        }
+    }
+
+    void load_subscriber(const JsonValue& o) {
+        if (o.type != kJsonObject) return;
+        JsonValue v;
+        char addr[INET_ADDRSTRLEN];
+        if (!json_find(o, "addr", &v)) return;
+        json_string(v, addr, sizeof(addr));
+        CachedSubscriber& s = subscribers[n_subscribers];
+        in_addr a;
+        const double port = json_find_number(o, "port", 0);
+        if (inet_pton(AF_INET, addr, &a) != 1 || port <= 0 || port > 65535) return;
+        s.addr = a.s_addr;
+        s.port = (uint16_t)port;
+        s.streams = (uint32_t)json_find_number(o, "streams", 0);
+        s.format = (uint8_t)json_find_number(o, "format", 0);
+        s.decimate = (uint32_t)json_find_number(o, "decimate", 1);
+        s.expires_rt_ns = (uint64_t)json_find_number(o, "expires_us", 0) * 1000ull;
+        if (s.streams) ++n_subscribers;
+    }
+};
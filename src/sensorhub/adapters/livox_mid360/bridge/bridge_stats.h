@@ -0,0 +1,195 @@
+// Livox MID-360 Bridge - counters and latency histograms
+//
+// LatencyHistogram is HDR-style: log-linear buckets (16 linear sub-buckets per power of
+// two, so ~6% relative resolution) from 1 ns to ~18 min, fixed size, no allocation.
+// Each histogram has exactly one writing thread and updates its cells with plain relaxed
+// load/store, so recording costs a few adds and no locked instruction; any thread may
+// take a snapshot. Percentiles are computed from snapshot differences, which gives
+// per-interval latency without ever resetting the writer's cells.
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+class LatencyHistogram {
+public:
+    static const int kSubBits = 4;
+    static const int kSub = 1 << kSubBits;
+    static const int kMaxExp = 40;                       // values clamp at 2^40 ns
+    static const size_t kBuckets = (size_t)(kMaxExp - kSubBits + 2) * kSub;
+
+    struct Snapshot {
+        uint64_t counts[kBuckets];
+        uint64_t n;
+        uint64_t max;
+
+        void diff(const Snapshot& now, const Snapshot& before) {
+            for (size_t i = 0; i < kBuckets; ++i) counts[i] = now.counts[i] - before.counts[i];
+            n = now.n - before.n;
+            max = now.max;
+        }
+
+        // Upper bound of the bucket holding quantile q (0..1); 0 when empty.
+        uint64_t percentile(double q) const {
+            if (n == 0) return 0;
+            uint64_t rank = (uint64_t)(q * (double)n);
+            if (rank >= n) rank = n - 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen > rank) return bucket_upper(i);
+            }
+            return bucket_upper(kBuckets - 1);
+        }
+    };
+
+    LatencyHistogram() : max_(0) {
+        for (size_t i = 0; i < kBuckets; ++i) counts_[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Single writer only.
+    void record(uint64_t ns) {
+        std::atomic<uint64_t>& c = counts_[bucket_index(ns)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > max_.load(std::memory_order_relaxed)) max_.store(ns, std::memory_order_relaxed);
+    }
+
+    void snapshot(Snapshot* out) const {
+        out->n = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            out->counts[i] = counts_[i].load(std::memory_order_relaxed);
+            out->n += out->counts[i];
+        }
+        out->max = max_.load(std::memory_order_relaxed);
+    }
+
+    static size_t bucket_index(uint64_t v) {
+        if (v < (uint64_t)kSub) return (size_t)v;
+        int e = 63 - __builtin_clzll(v);
+        if (e > kMaxExp) { e = kMaxExp; v = (1ull << (kMaxExp + 1)) - 1; }
+        const uint64_t sub = (v >> (e - kSubBits)) & (kSub - 1);
+        return (size_t)(e - kSubBits + 1) * kSub + (size_t)sub;
+    }
+
+    static uint64_t bucket_upper(size_t idx) {
+        if (idx < (size_t)kSub) return idx;
+        const int e = (int)(idx / kSub) + kSubBits - 1;
+        const uint64_t sub = idx % kSub;
+        return ((uint64_t)(kSub + sub + 1) << (e - kSubBits)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> max_;
+};
+
+// Monotonic event counters; relaxed increments from whichever thread owns the event.
+struct BridgeCounters {
+    std::atomic<uint64_t> point_packets;    // PointCloudCallback invocations
+    std::atomic<uint64_t> points;           // points received
+    std::atomic<uint64_t> imu_packets;
+    std::atomic<uint64_t> truncated;        // packets cut to the queue slot size
+    std::atomic<uint64_t> short_packets;    // length shorter than header + dot_num points: clamped / dropped
+    std::atomic<uint64_t> records;          // records handed to a transport
+    std::atomic<uint64_t> udp_bytes;
+    std::atomic<uint64_t> shm_bytes;
+    std::atomic<uint64_t> scans;
+    std::atomic<uint64_t> points_out;       // points published (after filtering)
+
+    BridgeCounters()
+        : point_packets(0), points(0), imu_packets(0), truncated(0), short_packets(0), records(0),
+          udp_bytes(0), shm_bytes(0), scans(0), points_out(0) {}
+
+    static void inc(std::atomic<uint64_t>& c, uint64_t n = 1) { c.fetch_add(n, std::memory_order_relaxed); }
+    static uint64_t get(const std::atomic<uint64_t>& c) { return c.load(std::memory_order_relaxed); }
+};
+
+// "name":{"n","p50","p99","p999","max"} in us over the n_h histograms merged, for the
+// interval since *prev (advanced to now when `advance`). Stats thread only: the snapshots
+// are static.
+static inline int format_latency(char* buf, size_t cap, const char* name, const LatencyHistogram* h,
+    size_t n_h, LatencyHistogram::Snapshot* prev, bool advance) {
+    static LatencyHistogram::Snapshot cur, part, d;
+    h[0].snapshot(&cur);
+    for (size_t k = 1; k < n_h; ++k) {
+        h[k].snapshot(&part);
+        for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) cur.counts[i] += part.counts[i];
+        cur.n += part.n;
+        if (part.max > cur.max) cur.max = part.max;
+    }
+    d.diff(cur, *prev);
+    if (advance) *prev = cur;
+    return std::snprintf(buf, cap,
+        "\"%s\":{\"n\":%" PRIu64 ",\"p50\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}",
+        name, d.n, d.percentile(0.50) / 1000.0, d.percentile(0.99) / 1000.0,
+        d.percentile(0.999) / 1000.0, d.max / 1000.0);
+}
+
+// Bounded appender for stats records. Appends that do not fit are dropped whole, and the
+// writer stays full from then on, so the length never passes the buffer whatever the
+// record grows to. Sections (begin() / end()) are rolled back as a unit when the writer
+// filled up inside one, and close() writes from a reserved tail, so a record cut short
+// still ends in valid JSON (the caller adds "truncated":true).
+class StatsWriter {
+public:
+    static const size_t kReserve = 48;       // for close(): brackets and "truncated"
+
+    StatsWriter(char* buf, size_t cap)
+        : buf_(buf), limit_(cap > kReserve ? cap - kReserve : 0), cap_(cap), n_(0), full_(false) {
+        if (cap_) buf_[0] = 0;
+    }
+
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (full_) return;
+        va_list ap;
+        va_start(ap, fmt);
+        const int w = std::vsnprintf(buf_ + n_, limit_ - n_, fmt, ap);
+        va_end(ap);
+        advance(w);
+    }
+
+    // format_latency(), which moves *prev even when the text does not fit.
+    void latency(const char* name, const LatencyHistogram* h, size_t n_h, LatencyHistogram::Snapshot* prev,
+        bool advance_prev) {
+        const size_t room = full_ ? 0 : limit_ - n_;
+        const int w = format_latency(room ? buf_ + n_ : NULL, room, name, h, n_h, prev, advance_prev);
+        if (!full_) advance(w);
+    }
+
+    size_t begin() const { return n_; }
+    void end(size_t mark) {
+        if (full_) n_ = mark;
+    }
+
+    // Text that must end the record (closing brackets); fits in the reserve. Nothing is
+    // closed when not even the opening fitted.
+    void close(const char* s) {
+        const size_t len = std::strlen(s);
+        if (!n_ || n_ + len >= cap_) return;
+        std::memcpy(buf_ + n_, s, len + 1);
+        n_ += len;
+    }
+
+    bool full() const { return full_; }
+    size_t size() const { return n_; }
+
+private:
+    void advance(int w) {
+        if (w < 0 || (size_t)w >= limit_ - n_) {
+            full_ = true;
+            if (n_ < cap_) buf_[n_] = 0;
+            return;
+        }
+        n_ += (size_t)w;
+    }
+
+    char* buf_;
+    size_t limit_, cap_, n_;
+    bool full_;
+};
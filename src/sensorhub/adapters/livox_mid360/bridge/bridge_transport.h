@@ -0,0 +1,395 @@
+// Bridge core - output transports shared by livox_bridge and rplidar_bridge
+//
+// BridgeTransport takes serialized records (NDJSON lines, binary frames per bridge_frame.h)
+// and hands each to its consumers: the default route (<P>_UDP_ADDR:<P>_UDP_PORT, the shm
+// ring, stdout) and the subscribers (subscriptions.h), selected by a consumer mask whose
+// bit 0 is the default route and bit 1 + i subscriber slot i. UDP goes through the
+// UdpBatcher lanes (or one sendmsg per consumer with <P>_UDP_FLUSH_US=0), binary messages
+// are fragmented to the shm slot / UDP packing size, and every message gets the next binary
+// seq. Records, bytes and enqueue -> sent latency are counted into the BridgeCounters /
+// LatencyHistogram the bridge attaches.
+//
+// open_from_env() reads the transport settings with the bridge's env prefix ("LIVOX",
+// "RPLIDAR"): _UDP_ADDR, _UDP_PORT, _MCAST_TTL, _MCAST_IF, _UDP_FLUSH_US, _UDP_BATCH,
+// _UDP_MTU, _UDP_LOOPBACK, _BRIDGE_FORMAT, _BRIDGE_STDOUT, _SHM_NAME, _SHM_SLOTS, _SHM_SLOT_BYTES and
+// _SHM_RESUME, documented in livox_bridge.cpp. Everything but the seq counter belongs to
+// one thread (the bridge's emitter); nothing on the record path allocates.
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "bridge_stats.h"
+#include "shm_ring.h"
+#include "subscriptions.h"
+#include "udp_batcher.h"
+
+// getenv("<prefix>_<name>")
+static inline const char* bridge_env(const char* prefix, const char* name) {
+    char key[96];
+    std::snprintf(key, sizeof(key), "%s_%s", prefix, name);
+    return std::getenv(key);
+}
+
+static inline bool bridge_env_flag(const char* prefix, const char* name, bool defv) {
+    const char* v = bridge_env(prefix, name);
+    return v ? std::string(v) == "1" : defv;
+}
+
+class BridgeTransport {
+public:
+    static const uint32_t kRouteDefault = 1;
+    static const size_t kMaxDatagram = 65507;
+    static const size_t kEthernetPayload = 1472;    // 1500 B MTU - IP and UDP headers
+
+    BridgeTransport()
+        : enq_ns(0), sock_(-1), udp_out_(false), stdout_(false), format_(kEncNdjson), flush_ns_(1000000ull),
+          udp_mtu_(kEthernetPayload), shm_oversize_(0), seq_(0), stats_(NULL), lat_sent_(NULL) {
+        std::memset(&dst_, 0, sizeof(dst_));
+        std::memset(unbatched_errors_, 0, sizeof(unbatched_errors_));
+    }
+
+    // Counters and the enqueue -> sent histogram to account into (both optional).
+    void attach(BridgeCounters* stats, LatencyHistogram* lat_sent) {
+        stats_ = stats;
+        lat_sent_ = lat_sent;
+    }
+
+    // Open the socket, batcher and shm ring from the environment. default_format is the
+    // default route's encoding without <P>_BRIDGE_FORMAT. Returns 0, or the exit code after
+    // a message on stderr: 2 for a bad setting, 3 for a system error.
+    int open_from_env(const char* prefix, uint16_t default_port, uint8_t default_format) {
+        const char* p;
+        uint16_t port = default_port;
+        if ((p = bridge_env(prefix, "UDP_PORT")) != NULL) port = (uint16_t)std::atoi(p);
+        udp_out_ = port != 0;
+        stdout_ = bridge_env_flag(prefix, "BRIDGE_STDOUT", false);
+        format_ = default_format;
+        if ((p = bridge_env(prefix, "BRIDGE_FORMAT")) != NULL) {
+            const int format = bridge_encoding_parse(p, std::strlen(p));
+            if (format < 0) {
+                std::cerr << prefix << "_BRIDGE_FORMAT must be ndjson, binary or compressed" << std::endl;
+                return 2;
+            }
+            format_ = (uint8_t)format;
+        }
+
+        if ((p = bridge_env(prefix, "SHM_NAME")) != NULL) {
+            uint32_t slots = 256, slot_bytes = 65536;
+            const char* s;
+            if ((s = bridge_env(prefix, "SHM_SLOTS")) != NULL) slots = (uint32_t)std::atoi(s);
+            if ((s = bridge_env(prefix, "SHM_SLOT_BYTES")) != NULL) slot_bytes = (uint32_t)std::atoi(s);
+            if (!shm_.open(p, slots, slot_bytes, bridge_env_flag(prefix, "SHM_RESUME", true))) {
+                std::perror("shm ring");
+                return 3;
+            }
+            if (shm_.resumed()) std::cerr << "shm ring " << p << ": resumed after seq " << shm_.write_seq() << std::endl;
+        }
+
+        sock_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock_ < 0) { std::perror("udp socket"); return 3; }
+        dst_.sin_family = AF_INET;
+        dst_.sin_addr.s_addr = inet_addr("127.0.0.1");
+        dst_.sin_port = htons(port);
+        if ((p = bridge_env(prefix, "UDP_ADDR")) != NULL) {
+            if (inet_pton(AF_INET, p, &dst_.sin_addr) != 1) {
+                std::cerr << prefix << "_UDP_ADDR must be an IPv4 address" << std::endl;
+                return 2;
+            }
+        }
+        // Multicast destinations (default route or subscribers): one datagram for every receiver
+        int mcast_ttl = 1;
+        if ((p = bridge_env(prefix, "MCAST_TTL")) != NULL) mcast_ttl = std::atoi(p);
+        if (setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_TTL, &mcast_ttl, sizeof(mcast_ttl)) < 0)
+            std::perror("IP_MULTICAST_TTL");
+        if ((p = bridge_env(prefix, "MCAST_IF")) != NULL) {
+            in_addr ifaddr;
+            if (inet_pton(AF_INET, p, &ifaddr) != 1 ||
+                setsockopt(sock_, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr, sizeof(ifaddr)) < 0)
+                std::cerr << prefix << "_MCAST_IF " << p << " not usable; using the routing table" << std::endl;
+        }
+        // Datagram payload size for packing and for binary fragments. Subscribers may be off-host
+        // whatever the default route is, so it stays within an Ethernet frame unless the output
+        // is declared loopback-only, where 64 KB datagrams cost no IP fragmentation.
+        if (bridge_env_flag(prefix, "UDP_LOOPBACK", false)) udp_mtu_ = kMaxDatagram;
+        else {
+            udp_mtu_ = udp_payload_mtu(dst_);
+            if (udp_mtu_ > kEthernetPayload) udp_mtu_ = kEthernetPayload;
+        }
+        if ((p = bridge_env(prefix, "UDP_MTU")) != NULL) {
+            const int mtu = std::atoi(p);
+            if (mtu <= (int)sizeof(BridgeFrameHeader) || mtu > (int)kMaxDatagram) {
+                std::cerr << prefix << "_UDP_MTU must be " << sizeof(BridgeFrameHeader) + 1 << ".." << kMaxDatagram
+                          << std::endl;
+                return 2;
+            }
+            udp_mtu_ = (size_t)mtu;
+        }
+        if ((p = bridge_env(prefix, "UDP_FLUSH_US")) != NULL) flush_ns_ = (uint64_t)std::atoi(p) * 1000ull;
+        if (flush_ns_) {
+            // subscribers get their own lanes, so the batcher is needed even without a default port
+            size_t batch = 32;
+            if ((p = bridge_env(prefix, "UDP_BATCH")) != NULL) batch = (size_t)std::atoi(p);
+            batch_.open(sock_, udp_mtu_, batch, flush_ns_);
+            if (udp_out_) batch_.set_lane(0, dst_);
+        }
+        frag_.resize(max_record_bytes());
+        return 0;
+    }
+
+    void close() {
+        if (sock_ >= 0) ::close(sock_);
+        sock_ = -1;
+        shm_.close();
+    }
+
+    // ---- Consumers ----
+
+    // Consumers of one record of `stream` in encoding `enc`: the default route when it
+    // carries that encoding, plus the subscribers that take it.
+    uint32_t route(BridgeStream stream, uint8_t enc, bool imu_batched = false) {
+        const bool def = SubscriberTable::stream_encoding(stream, format_, imu_batched) == enc;
+        return (def ? kRouteDefault : 0u) | subs_.route(stream, enc, imu_batched);
+    }
+
+    // Add or renew a subscription and point its batcher lane at it; slot or -1 when full.
+    int subscribe(const sockaddr_in& dst, uint32_t streams, uint8_t format, uint32_t decimate,
+        uint64_t expires_ns) {
+        const int slot = subs_.subscribe(dst, streams, format, decimate, expires_ns);
+        if (slot >= 0 && flush_ns_) batch_.set_lane((size_t)slot + 1, dst);
+        return slot;
+    }
+
+    void unsubscribe(int slot) {
+        if (flush_ns_) batch_.close_lane((size_t)slot + 1);
+        subs_.remove(slot);
+    }
+
+    // Drop expired leases; on_expired(slot) runs before each slot is freed.
+    template <typename Fn>
+    void expire(uint64_t now, Fn on_expired) {
+        subs_.expire(now, [this, &on_expired](int slot) {
+            if (flush_ns_) batch_.close_lane((size_t)slot + 1);
+            on_expired(slot);
+        });
+    }
+
+    // ---- Records ----
+
+    // Lines are passed as spans: nothing on this path allocates.
+    void ndjson(const char* line, size_t len, uint32_t mask) {
+        if (!mask) return;
+        if (mask & kRouteDefault) shm_record(line, len);
+        // batched lines are packed, so they carry their terminator; a lone datagram does not
+        udp(mask, line, len, "\n", flush_ns_ ? 1 : 0);
+        sent();
+        if ((mask & kRouteDefault) && stdout_) {
+            std::cout.write(line, (std::streamsize)len).put('\n');   // flushed by flush_stdout()
+        }
+    }
+
+    // Binary frames go to shm/UDP only; stdout stays NDJSON-only. The shm ring takes a whole
+    // message per slot when it fits, UDP is fragmented to the packing size (udp_mtu()), so the
+    // fragments fill the batcher's datagrams instead of going out IP-fragmented. Every consumer
+    // in `mask` gets the same fragments and seq. Returns the seq.
+    uint32_t binary(BridgeFrameHeader h, const void* payload, uint32_t n_records, size_t rec_size, uint32_t mask) {
+        const uint8_t* data = static_cast<const uint8_t*>(payload);
+        return send_binary(h, n_records, rec_size, mask,
+            [data, rec_size](const BridgeFrameHeader&, uint32_t first) { return data + first * rec_size; });
+    }
+
+    // binary() for planar payloads (columnar points, range image rows): plane p holds
+    // n_records * plane_bytes[p] bytes and the planes follow each other. The caller packs the
+    // whole message once; a fragment of records [first, first + n) takes that span of every
+    // plane, copied into the fragment buffer, and a whole-message fragment goes out as is.
+    // shm and UDP therefore share one packing, whatever their fragment sizes.
+    uint32_t binary_planar(BridgeFrameHeader h, const void* payload, uint32_t n_records, const size_t* plane_bytes,
+        size_t n_planes, uint32_t mask) {
+        const uint8_t* data = static_cast<const uint8_t*>(payload);
+        size_t rec_size = 0;
+        for (size_t p = 0; p < n_planes; ++p) rec_size += plane_bytes[p];
+        uint8_t* out = frag_.empty() ? NULL : &frag_[0];
+        return send_binary(h, n_records, rec_size, mask,
+            [data, n_records, plane_bytes, n_planes, out](const BridgeFrameHeader& fh, uint32_t first) {
+                if (fh.point_count == n_records) return data;
+                const uint8_t* plane = data;
+                uint8_t* dst = out;
+                for (size_t p = 0; p < n_planes; ++p) {
+                    std::memcpy(dst, plane + first * plane_bytes[p], fh.point_count * plane_bytes[p]);
+                    dst += fh.point_count * plane_bytes[p];
+                    plane += n_records * plane_bytes[p];
+                }
+                return (const uint8_t*)out;
+            });
+    }
+
+    // One record (a + b) into the shm ring, counted as oversize when it does not fit a slot.
+    void shm_record(const void* a, size_t a_len, const void* b = NULL, size_t b_len = 0) {
+        if (!shm_.is_open()) return;
+        if (!shm_.write(a, a_len, b, b_len)) ++shm_oversize_;
+        else if (stats_) BridgeCounters::inc(stats_->shm_bytes, a_len + b_len);
+    }
+
+    // One record to the UDP consumers in `mask`: queued on their batcher lanes, or one
+    // sendmsg per destination when batching is off.
+    void udp(uint32_t mask, const void* a, size_t a_len, const void* b, size_t b_len) {
+        mask = udp_mask(mask);
+        if (!mask) return;
+        if (flush_ns_) {
+            batch_.add_lanes(mask, a, a_len, b, b_len, now());
+        }
+        else {
+            iovec iov[2];
+            iov[0].iov_base = const_cast<void*>(a);
+            iov[0].iov_len = a_len;
+            iov[1].iov_base = const_cast<void*>(b);
+            iov[1].iov_len = b_len;
+            msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_namelen = sizeof(sockaddr_in);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = b_len ? 2 : 1;
+            for (uint32_t m = mask; m; m &= m - 1) {
+                const size_t lane = (size_t)__builtin_ctz(m);
+                msg.msg_name = const_cast<sockaddr_in*>(lane_dst(lane));
+                if (sendmsg(sock_, &msg, 0) < 0) ++unbatched_errors_[lane];
+            }
+        }
+        if (stats_) BridgeCounters::inc(stats_->udp_bytes, (a_len + b_len) * (size_t)__builtin_popcount(mask));
+        subs_.sent(mask, a_len + b_len);
+    }
+
+    // A record went out: count it and its enqueue -> sent latency (enq_ns, 0 = not caused by
+    // an input event).
+    void sent() {
+        if (stats_) BridgeCounters::inc(stats_->records);
+        if (enq_ns && lat_sent_) lat_sent_->record(now() - enq_ns);
+    }
+
+    // A datagram straight to one address (command replies), outside routing and batching.
+    void reply(const sockaddr_in& dst, const void* buf, size_t len) {
+        if (sock_ >= 0 && dst.sin_port) sendto(sock_, buf, len, 0, (const sockaddr*)&dst, sizeof(dst));
+    }
+
+    void flush_if_due(uint64_t t) { if (flush_ns_) batch_.flush_if_due(t); }
+    void flush() {
+        if (flush_ns_) batch_.flush();
+        flush_stdout();
+    }
+    void flush_stdout() { if (stdout_) std::cout.flush(); }
+
+    // ---- Binary seq (any thread may read it) ----
+    uint32_t next_seq() { return seq_.fetch_add(1, std::memory_order_relaxed); }
+    uint32_t seq() const { return seq_.load(std::memory_order_relaxed); }
+    void set_seq(uint32_t s) { seq_.store(s, std::memory_order_relaxed); }
+
+    SubscriberTable& subs() { return subs_; }
+    const SubscriberTable& subs() const { return subs_; }
+    const UdpBatcher& batcher() const { return batch_; }
+    const ShmRingWriter& shm() const { return shm_; }
+    uint64_t shm_oversize() const { return shm_oversize_; }
+    // UDP send errors of one consumer (bit index: 0 = default route, 1 + slot = subscriber).
+    uint64_t send_errors(size_t lane) const {
+        return lane < UdpBatcher::kLanes ? batch_.lane_errors(lane) + unbatched_errors_[lane] : 0;
+    }
+    size_t udp_mtu() const { return udp_mtu_; }
+    size_t max_record_bytes() const { return shm_.capacity() > kMaxDatagram ? shm_.capacity() : kMaxDatagram; }
+    uint8_t format() const { return format_; }
+    bool batching() const { return flush_ns_ != 0; }
+    bool to_stdout() const { return stdout_; }
+
+    uint64_t enq_ns;          // enqueue time of the input being handled, for sent()
+
+private:
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    const sockaddr_in* lane_dst(size_t lane) const { return lane ? &subs_.at(lane - 1).dst : &dst_; }
+
+    // The UDP consumers of `mask` (the default route only with a UDP port).
+    uint32_t udp_mask(uint32_t mask) const { return udp_out_ ? mask : mask & ~kRouteDefault; }
+
+    // UDP fragment size for rec_size-byte records: the packing size, or the datagram limit for
+    // records too large to fit it (those go out IP-fragmented, one record per fragment).
+    size_t udp_fragment_bytes(size_t rec_size) const {
+        return sizeof(BridgeFrameHeader) + rec_size < udp_mtu_ ? udp_mtu_ : kMaxDatagram;
+    }
+
+    // Fragment one message per transport and send it: slice(fragment_header, first_record)
+    // returns the fragment's payload, valid until the next call. Returns the seq.
+    template <typename Slice>
+    uint32_t send_binary(BridgeFrameHeader h, uint32_t n_records, size_t rec_size, uint32_t mask, Slice slice) {
+        if (!mask) return 0;
+        h.seq = next_seq();
+        if ((mask & kRouteDefault) && shm_.is_open()) {
+            for_each_fragment(h, n_records, rec_size, shm_.capacity(),
+                [this, &slice](const BridgeFrameHeader& fh, uint32_t first) {
+                    shm_record(&fh, sizeof(fh), slice(fh, first), fh.payload_len);
+                });
+        }
+        if (udp_mask(mask)) {
+            for_each_fragment(h, n_records, rec_size, udp_fragment_bytes(rec_size),
+                [this, mask, &slice](const BridgeFrameHeader& fh, uint32_t first) {
+                    udp(mask, &fh, sizeof(fh), slice(fh, first), fh.payload_len);
+                });
+        }
+        sent();
+        return h.seq;
+    }
+
+    // Split a message of rec_size-byte records into fragments whose header + payload fit
+    // `limit` bytes and hand each to sink(header, first_record). All fragments share one seq.
+    template <typename Sink>
+    static void for_each_fragment(const BridgeFrameHeader& base, uint32_t n_records, size_t rec_size,
+        size_t limit, Sink sink) {
+        if (limit <= sizeof(BridgeFrameHeader) + rec_size) return;
+        const uint32_t per_frag = (uint32_t)((limit - sizeof(BridgeFrameHeader)) / rec_size);
+        const uint32_t n_frags = n_records ? (n_records + per_frag - 1) / per_frag : 1;
+        BridgeFrameHeader h = base;
+        h.frag_count = (uint16_t)n_frags;
+        for (uint32_t f = 0; f < n_frags; ++f) {
+            const uint32_t first = f * per_frag;
+            const uint32_t n = (n_records - first < per_frag) ? n_records - first : per_frag;
+            h.frag_index = (uint16_t)f;
+            h.point_count = n;
+            h.payload_len = (uint32_t)(n * rec_size);
+            sink(h, first);
+        }
+    }
+
+    int sock_;
+    bool udp_out_;            // false: no default UDP destination
+    bool stdout_;
+    uint8_t format_;          // BridgeEncoding of the default route
+    uint64_t flush_ns_;       // 0 = no batching
+    size_t udp_mtu_;          // datagram payload size: packing and binary fragments
+    std::vector<uint8_t> frag_;   // binary_planar() fragment, sized at open for the largest
+    sockaddr_in dst_;         // default route
+    UdpBatcher batch_;
+    ShmRingWriter shm_;
+    uint64_t shm_oversize_;
+    uint64_t unbatched_errors_[UdpBatcher::kLanes];   // sendmsg failures without batching, per lane
+    SubscriberTable subs_;
+    std::atomic<uint32_t> seq_;
+    BridgeCounters* stats_;
+    LatencyHistogram* lat_sent_;
+};
@@ -0,0 +1,137 @@
+// Livox MID-360 Bridge - preallocated pool of fixed-size buffers
+//
+// Scan-sized buffers (assembler point buffers, scans in flight to the codec thread) come
+// from one mapping made at startup, so the steady state never calls malloc for them and,
+// with prefault() / mlockall (LIVOX_RT), never takes a page fault on them either. Blocks
+// are cache-line aligned and cache-line multiples; the mapping is hugepage-backed when
+// asked for and the kernel has hugepages reserved (else normal pages, reported by
+// hugepages()).
+//
+// Free blocks form a lock-free LIFO (Treiber stack) of block indices; the head carries a
+// 32-bit tag bumped by every pop and push, so a block popped and pushed back between a
+// thread's load and its CAS cannot be mistaken for the old head (ABA). acquire() and
+// release() may be called from any thread. An empty pool makes acquire() return NULL and
+// counts the miss in exhausted(): the caller falls back (heap buffer, skipped scan) and
+// the counter shows the pool is too small for a malloc-free steady state.
+
+#pragma once
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class BufferPool {
+public:
+    static const size_t kAlign = 64;
+    static const size_t kHugePage = 2u << 20;
+
+    BufferPool()
+        : base_(NULL), map_bytes_(0), block_bytes_(0), blocks_(0), huge_(false), head_(kEmpty),
+          in_use_(0), high_water_(0), exhausted_(0) {}
+    ~BufferPool() { close(); }
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Map `blocks` blocks of at least block_bytes each; false if the mapping fails.
+    bool open(size_t block_bytes, size_t blocks, bool hugepages) {
+        close();
+        if (!block_bytes || !blocks || blocks >= kEmpty) return false;
+        block_bytes_ = (block_bytes + kAlign - 1) & ~(kAlign - 1);
+        const size_t bytes = block_bytes_ * blocks;
+        void* p = MAP_FAILED;
+        huge_ = false;
+#ifdef MAP_HUGETLB
+        if (hugepages) {
+            map_bytes_ = (bytes + kHugePage - 1) & ~(kHugePage - 1);
+            p = mmap(NULL, map_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            huge_ = p != MAP_FAILED;
+        }
+#endif
+        if (p == MAP_FAILED) {
+            map_bytes_ = bytes;
+            p = mmap(NULL, map_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) { map_bytes_ = 0; return false; }
+        }
+        base_ = static_cast<uint8_t*>(p);
+        blocks_ = blocks;
+        next_.reset(new std::atomic<uint32_t>[blocks]);
+        for (size_t i = 0; i < blocks; ++i) next_[i].store(i + 1 < blocks ? (uint32_t)(i + 1) : kEmpty);
+        head_.store(0);
+        in_use_.store(0);
+        return true;
+    }
+
+    void close() {
+        if (base_) munmap(base_, map_bytes_);
+        base_ = NULL;
+        map_bytes_ = 0;
+        blocks_ = 0;
+        head_.store(kEmpty);
+    }
+
+    // Touch every page now, so the first use of a block does not fault (mlockall also
+    // populates, but only in RT mode).
+    void prefault() {
+        for (size_t off = 0; off < map_bytes_; off += 4096) base_[off] = 0;
+    }
+
+    // A free block, or NULL (counted) when all are in use.
+    void* acquire() {
+        uint64_t h = head_.load(std::memory_order_acquire);
+        for (;;) {
+            const uint32_t i = (uint32_t)h;
+            if (i == kEmpty) {
+                exhausted_.fetch_add(1, std::memory_order_relaxed);
+                return NULL;
+            }
+            const uint64_t next = tagged(next_[i].load(std::memory_order_relaxed), h);
+            if (head_.compare_exchange_weak(h, next, std::memory_order_acquire, std::memory_order_acquire)) {
+                const size_t n = in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+                size_t hw = high_water_.load(std::memory_order_relaxed);
+                while (n > hw && !high_water_.compare_exchange_weak(hw, n, std::memory_order_relaxed)) {}
+                return base_ + (size_t)i * block_bytes_;
+            }
+        }
+    }
+
+    // Give back a block from acquire(); NULL is ignored.
+    void release(void* p) {
+        if (!p) return;
+        const uint32_t i = (uint32_t)((static_cast<uint8_t*>(p) - base_) / block_bytes_);
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            next_[i].store((uint32_t)h, std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(h, tagged(i, h), std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+        in_use_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool is_open() const { return base_ != NULL; }
+    size_t block_bytes() const { return block_bytes_; }
+    size_t blocks() const { return blocks_; }
+    bool hugepages() const { return huge_; }
+    size_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+    size_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+    uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+
+private:
+    static const uint32_t kEmpty = 0xFFFFFFFFu;
+
+    // New head value for index i: the old head's tag plus one.
+    static uint64_t tagged(uint32_t i, uint64_t old) { return (((old >> 32) + 1) << 32) | i; }
+
+    uint8_t* base_;
+    size_t map_bytes_;
+    size_t block_bytes_;
+    size_t blocks_;
+    bool huge_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    alignas(64) std::atomic<uint64_t> head_;   // tag << 32 | index of the first free block
+    std::atomic<size_t> in_use_;
+    std::atomic<size_t> high_water_;
+    std::atomic<uint64_t> exhausted_;
+};
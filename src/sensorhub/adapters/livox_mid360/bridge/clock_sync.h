@@ -0,0 +1,169 @@
+// Livox MID-360 Bridge - device clock -> host CLOCK_REALTIME mapping
+//
+// Every packet gives one observation: the device timestamp of its first point and the host
+// CLOCK_REALTIME at callback arrival. host - device = clock offset + transport delay, and
+// the delay is always positive and jittery, so the estimator keeps the minimum offset per
+// window (the least-delayed packet) and fits offset(t) = a + b * t over the last kWindows
+// minima: `a` tracks the offset, `b` the oscillator skew. A jump in device time (power
+// cycle, PTP re-lock, time_type change) restarts the fit.
+//
+// With trust_synced, packets already stamped from gPTP/GPS (time_type 1/2) are mapped with a
+// fixed offset instead (e.g. -37 s when the grandmaster runs TAI), so a PTP-disciplined host
+// clock keeps its sub-microsecond alignment instead of inheriting the transport delay.
+// One mapper per device; not thread-safe.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class ClockMapper {
+public:
+    static const size_t kWindows = 16;
+
+    ClockMapper()
+        : window_ns_(1000000000ull), trust_synced_(false), synced_offset_ns_(0) { reset(); }
+
+    void configure(uint64_t window_ns, bool trust_synced, int64_t synced_offset_ns) {
+        window_ns_ = window_ns ? window_ns : 1000000000ull;
+        trust_synced_ = trust_synced;
+        synced_offset_ns_ = synced_offset_ns;
+    }
+
+    void observe(uint64_t dev_ns, uint64_t host_ns, uint8_t time_type) {
+        const int64_t off = (int64_t)(host_ns - dev_ns);
+        if (n_obs_ && (time_type != time_type_ || dev_ns + kBackwardTolNs < last_dev_ ||
+                       dev_ns > last_dev_ + kForwardJumpNs)) {
+            ++resets_;
+            restart();
+        }
+        if (n_obs_ == 0) {
+            time_type_ = time_type;
+            bucket_start_ = dev_ns;
+            bucket_min_off_ = off;
+            bucket_min_dev_ = dev_ns;
+            base_off_ = off;
+            a_ = 0.0;
+            b_ = 0.0;
+            ref_dev_ = dev_ns;
+        }
+        ++n_obs_;
+        last_dev_ = dev_ns;
+
+        if (off < bucket_min_off_) { bucket_min_off_ = off; bucket_min_dev_ = dev_ns; }
+        if ((int64_t)(dev_ns - bucket_start_) >= (int64_t)window_ns_) {
+            // the first window after a (re)start sees the SDK's start-up burst; skip it
+            if (warm_) push_window(bucket_min_dev_, bucket_min_off_);
+            warm_ = true;
+            bucket_start_ = dev_ns;
+            bucket_min_off_ = off;
+            bucket_min_dev_ = dev_ns;
+        }
+        else if (n_win_ == 0) {
+            base_off_ = bucket_min_off_;   // provisional until the first window closes
+            ref_dev_ = bucket_min_dev_;
+        }
+
+        // mean transport delay above the fitted lower envelope (EWMA, ~64 samples)
+        const double delay = (double)(off - base_off_) - residual_at(dev_ns);
+        delay_ns_ += (delay - delay_ns_) * (1.0 / 64.0);
+    }
+
+    // Device time -> host CLOCK_REALTIME; identity until the first observation.
+    uint64_t map(uint64_t dev_ns, uint8_t time_type) const {
+        if (trust_synced_ && time_type != 0) return dev_ns + (uint64_t)synced_offset_ns_;
+        if (n_obs_ == 0) return dev_ns;
+        return dev_ns + (uint64_t)(base_off_ + (int64_t)residual_at(dev_ns));
+    }
+
+    bool valid() const { return n_obs_ != 0; }
+    int64_t offset_ns() const { return base_off_ + (int64_t)a_; }
+    double skew_ppm() const { return b_ * 1e6; }
+    double delay_ns() const { return delay_ns_; }
+    uint64_t observations() const { return n_obs_; }
+    size_t windows() const { return n_win_; }
+    uint64_t resets() const { return resets_; }
+    uint8_t time_type() const { return time_type_; }
+
+private:
+    static const uint64_t kBackwardTolNs = 100000000ull;      // IMU vs point reordering
+    static const uint64_t kForwardJumpNs = 10000000000ull;    // 10 s gap = new timebase
+
+    void reset() {
+        restart();
+        resets_ = 0;
+    }
+
+    void restart() {
+        n_obs_ = 0;
+        n_win_ = 0;
+        head_ = 0;
+        warm_ = false;
+        base_off_ = 0;
+        a_ = 0.0;
+        b_ = 0.0;
+        ref_dev_ = 0;
+        delay_ns_ = 0.0;
+        last_dev_ = 0;
+        time_type_ = 0;
+    }
+
+    // Fitted offset minus base_off_; kept apart because offsets near the realtime epoch
+    // (~1.7e18 ns) do not fit a double's mantissa at ns resolution.
+    double residual_at(uint64_t dev_ns) const {
+        return a_ + b_ * (double)(int64_t)(dev_ns - ref_dev_);
+    }
+
+    void push_window(uint64_t dev_ns, int64_t off) {
+        win_dev_[head_] = dev_ns;
+        win_off_[head_] = off;
+        head_ = (head_ + 1) % kWindows;
+        if (n_win_ < kWindows) ++n_win_;
+        fit();
+    }
+
+    // Least squares over the window minima, centred on the newest one for precision.
+    void fit() {
+        const size_t newest = (head_ + kWindows - 1) % kWindows;
+        const uint64_t ref = win_dev_[newest];
+        const int64_t off0 = win_off_[newest];
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (size_t i = 0; i < n_win_; ++i) {
+            const double x = (double)(int64_t)(win_dev_[i] - ref);
+            const double y = (double)(win_off_[i] - off0);
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+        }
+        const double n = (double)n_win_;
+        const double den = n * sxx - sx * sx;
+        double b = (n_win_ >= 2 && den > 0) ? (n * sxy - sx * sy) / den : 0.0;
+        if (b > 1e-3 || b < -1e-3) b = 0.0;    // > 1000 ppm is not a crystal, it is a bad fit
+        b_ = b;
+        base_off_ = off0;
+        a_ = (sy - b * sx) / n;
+        ref_dev_ = ref;
+    }
+
+    uint64_t window_ns_;
+    bool trust_synced_;
+    int64_t synced_offset_ns_;
+
+    uint64_t n_obs_;
+    uint64_t resets_;
+    uint8_t time_type_;
+    uint64_t last_dev_;
+    uint64_t bucket_start_;
+    int64_t bucket_min_off_;
+    uint64_t bucket_min_dev_;
+
+    uint64_t win_dev_[kWindows];
+    int64_t win_off_[kWindows];
+    size_t n_win_;
+    size_t head_;
+    bool warm_;
+
+    int64_t base_off_;  // integer part of the offset (ns)
+    double a_;          // offset at ref_dev_ minus base_off_ (ns)
+    double b_;          // skew (ns per ns)
+    uint64_t ref_dev_;
+    double delay_ns_;
+};
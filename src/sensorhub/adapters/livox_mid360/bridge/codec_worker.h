@@ -0,0 +1,162 @@
+// Livox MID-360 Bridge - scan compression off the emitter thread
+//
+// Compressing a scan takes long enough (~1 ms) that doing it inline would delay every
+// other record behind it, so the emitter copies the scan into a buffer of its own (a
+// buffer_pool.h block), points one of a few job slots at it and a worker thread encodes
+// it (scan_codec.h). The emitter picks finished jobs up in
+// submission order from its loop and sends them. Slots form a ring indexed by two counters:
+// the emitter owns `submitted_` / `collected_`, the worker publishes `done_`. A scan that
+// finds every slot busy is not compressed and counted as `busy`, like a full queue drop; one
+// that finds no free pool block is dropped the same way and counted as `pool_exhausted`.
+
+#pragma once
+
+#include <semaphore.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "bridge_stats.h"
+#include "scan_codec.h"
+
+struct CodecJob {
+    BridgeFrameHeader h;             // scan header, seq assigned
+    uint32_t mask;                   // consumers (see SubscriberTable)
+    uint64_t enq_ns;                 // enqueue time of the event that closed the scan
+    const BridgePoint* points;       // the emitter's copy of the scan, kept until collected
+    size_t n_points;
+    void* block;                     // the emitter's handle on that copy
+    std::vector<uint8_t> out;        // encoded blocks, back to back
+    std::vector<CodecBlockRef> blocks;
+};
+
+class CodecWorker {
+public:
+    CodecWorker()
+        : submitted_(0), collected_(0), submitted_pub_(0), done_(0), stop_(false), busy_(0), pool_exhausted_(0),
+          scans_(0), in_bytes_(0), out_bytes_(0) {
+        sem_init(&sem_, 0, 0);
+    }
+
+    ~CodecWorker() {
+        stop();
+        sem_destroy(&sem_);
+    }
+
+    // max_points sizes every slot's output up front, so encoding never reallocates.
+    bool start(uint8_t codec, int level, size_t slots, size_t max_points) {
+        if (!encoder_.configure(codec, level)) return false;
+        jobs_.resize(slots ? slots : 1);
+        for (size_t i = 0; i < jobs_.size(); ++i) {
+            CodecJob& j = jobs_[i];
+            j.points = NULL;
+            j.n_points = 0;
+            j.block = NULL;
+            j.out.reserve(ScanEncoder::max_output(max_points));
+            j.blocks.reserve(max_points / kCodecBlockPoints + 1);
+        }
+        stop_.store(false);
+        thread_ = std::thread(&CodecWorker::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_.store(true);
+        sem_post(&sem_);
+        thread_.join();
+    }
+
+    bool running() const { return thread_.joinable(); }
+    uint8_t codec() const { return encoder_.codec(); }
+    size_t slots() const { return jobs_.size(); }
+
+    // Emitter: a free job to fill, or NULL (counted) when all slots are in flight.
+    CodecJob* claim() {
+        if (submitted_ - collected_ == jobs_.size()) {
+            ++busy_;
+            return NULL;
+        }
+        return &jobs_[submitted_ % jobs_.size()];
+    }
+
+    // Emitter: the claimed job is given up because no buffer was free for its scan; the slot
+    // stays free.
+    void no_buffer() { ++pool_exhausted_; }
+
+    // Emitter: hand the claimed job to the worker.
+    void submit() {
+        ++submitted_;
+        submitted_pub_.store(submitted_, std::memory_order_release);
+        sem_post(&sem_);
+    }
+
+    // Emitter: call fn(job) for every finished job in order; returns how many.
+    template <typename Fn>
+    size_t poll(Fn fn) {
+        const uint64_t done = done_.load(std::memory_order_acquire);
+        size_t n = 0;
+        for (; collected_ < done; ++collected_, ++n) fn(jobs_[collected_ % jobs_.size()]);
+        return n;
+    }
+
+    // Emitter, at shutdown: wait for the jobs in flight and hand them to fn.
+    template <typename Fn>
+    void drain(Fn fn) {
+        while (collected_ < submitted_) {
+            if (!poll(fn)) std::this_thread::yield();
+        }
+    }
+
+    uint64_t busy() const { return busy_; }
+    uint64_t pool_exhausted() const { return pool_exhausted_; }
+    uint64_t scans() const { return scans_.load(std::memory_order_relaxed); }
+    uint64_t in_bytes() const { return in_bytes_.load(std::memory_order_relaxed); }
+    uint64_t out_bytes() const { return out_bytes_.load(std::memory_order_relaxed); }
+    const LatencyHistogram& encode_time() const { return encode_ns_; }
+
+private:
+    static uint64_t thread_cpu_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    void run() {
+        uint64_t done = 0;
+        for (;;) {
+            while (sem_wait(&sem_) != 0) {}
+            const uint64_t target = submitted_pub_.load(std::memory_order_acquire);
+            for (; done < target; ++done) {
+                CodecJob& j = jobs_[done % jobs_.size()];
+                const uint64_t t0 = thread_cpu_ns();
+                encoder_.encode(j.points, j.n_points, &j.out, &j.blocks);
+                encode_ns_.record(thread_cpu_ns() - t0);
+                scans_.fetch_add(1, std::memory_order_relaxed);
+                in_bytes_.fetch_add(j.n_points * sizeof(BridgePoint), std::memory_order_relaxed);
+                out_bytes_.fetch_add(j.out.size(), std::memory_order_relaxed);
+                done_.store(done + 1, std::memory_order_release);
+            }
+            if (stop_.load()) break;
+        }
+    }
+
+    ScanEncoder encoder_;
+    std::vector<CodecJob> jobs_;
+    uint64_t submitted_;                    // emitter
+    uint64_t collected_;                    // emitter
+    std::atomic<uint64_t> submitted_pub_;   // emitter -> worker
+    std::atomic<uint64_t> done_;            // worker -> emitter
+    std::atomic<bool> stop_;
+    sem_t sem_;
+    std::thread thread_;
+    uint64_t busy_;                         // emitter
+    uint64_t pool_exhausted_;               // emitter
+    std::atomic<uint64_t> scans_;
+    std::atomic<uint64_t> in_bytes_;
+    std::atomic<uint64_t> out_bytes_;
+    LatencyHistogram encode_ns_;            // worker is the only writer
+};
@@ -0,0 +1,91 @@
+// Livox MID-360 Bridge - control command parsing and table dispatch
+//
+// A command is one JSON object per datagram, e.g. {"cmd":"set_fov","id":42,"yaw_start":0}.
+// BridgeCommand::parse walks the top-level members once (json_lite.h), keeping spans into
+// the receive buffer; parameter lookups then compare whole keys over that small array, so a
+// key can never match inside another key or a value. Handlers are looked up by exact name
+// in a static table. Nothing is copied or allocated.
+//
+// "id" (optional, non-zero uint32) is the client's request id; the bridge echoes it in the
+// command reply and in every SDK ack the command causes.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "json_lite.h"
+
+struct BridgeCommand {
+    static const size_t kMaxFields = 16;
+
+    JsonValue name;        // "cmd" (kJsonString), kJsonInvalid when missing
+    uint32_t id;           // "id", 0 when absent
+    size_t n_fields;
+    JsonValue keys[kMaxFields];
+    JsonValue vals[kMaxFields];
+
+    // False if buf is not a JSON object. Members past kMaxFields are ignored.
+    bool parse(const char* buf, size_t len) {
+        name.type = kJsonInvalid;
+        id = 0;
+        n_fields = 0;
+        JsonValue root;
+        if (!json_parse(buf, buf + len, &root) || root.type != kJsonObject) return false;
+        JsonIter it(root);
+        JsonValue k, v;
+        while (it.next(&k, &v)) {
+            if (k.equals("cmd")) {
+                if (v.type == kJsonString) name = v;
+            }
+            else if (k.equals("id")) {
+                const double d = json_number(v, 0.0);
+                id = (d > 0 && d <= 4294967295.0) ? (uint32_t)d : 0;
+            }
+            else if (n_fields < kMaxFields) {
+                keys[n_fields] = k;
+                vals[n_fields++] = v;
+            }
+        }
+        return true;
+    }
+
+    bool has_name() const { return name.type == kJsonString; }
+
+    const JsonValue* field(const char* key) const {
+        for (size_t i = 0; i < n_fields; ++i)
+            if (keys[i].equals(key)) return &vals[i];
+        return NULL;
+    }
+
+    // Numeric parameter (true/false read as 1/0); defv when missing or not a number.
+    int int_field(const char* key, int defv) const {
+        const JsonValue* v = field(key);
+        if (!v) return defv;
+        if (v->type == kJsonTrue) return 1;
+        if (v->type == kJsonFalse) return 0;
+        return (int)json_number(*v, (double)defv);
+    }
+
+    // Fractional numeric parameter; defv when missing or not a number.
+    double number_field(const char* key, double defv) const {
+        const JsonValue* v = field(key);
+        return v ? json_number(*v, defv) : defv;
+    }
+
+    // String parameter as a span (escapes left in place); false when missing.
+    bool string_field(const char* key, JsonValue* out) const {
+        const JsonValue* v = field(key);
+        if (!v || v->type != kJsonString) return false;
+        *out = *v;
+        return true;
+    }
+};
+
+// Look up a handler in a static table of { const char* name; ... } entries by exact name.
+template <typename Entry, size_t N>
+static inline const Entry* command_find(const Entry (&table)[N], const JsonValue& name) {
+    for (size_t i = 0; i < N; ++i)
+        if (name.equals(table[i].name)) return &table[i];
+    return NULL;
+}
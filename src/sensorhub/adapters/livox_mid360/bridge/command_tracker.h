@@ -0,0 +1,229 @@
+// Livox MID-360 Bridge - in-flight control request tracking
+//
+// A device command (set_work_mode, set_fov, ...) fans out to every registered lidar at once:
+// one SDK request per device and operation, all issued back to back without waiting for
+// acks. CommandTracker remembers each of them until it settles. A request's SDK client_data
+// tag is (attempt generation << 16 | slot + 1), so an ack is matched to exactly one attempt
+// and the late ack of an attempt that was already retried is ignored.
+//
+// A request that is not acked within the timeout, or fails with a status the caller deems
+// transient (retryable(), e.g. SDK timeout or send failure), is issued again, up to
+// `retries` more times; any other SDK status or a device ret_code != 0 fails it at once.
+// A command can bring its own retry budget and retryable() (a warm-restart config restore
+// keeps retrying while the devices reconnect). When the last request of a command settles,
+// poll() hands the command to `done` exactly once and frees it. Single-threaded: the emitter
+// thread owns the tracker; nothing here allocates or depends on the SDK.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum TrackedState { kReqPending, kReqRetry, kReqOk, kReqFailed, kReqTimedOut };
+
+struct TrackedRequest {
+    uint64_t deadline_ns;    // pending: ack timeout; retry: re-issue time
+    uint32_t handle;
+    int32_t  status;         // last SDK status (0 = success)
+    uint16_t gen;            // attempt generation, part of the tag
+    uint8_t  cmd;            // command slot
+    uint8_t  op;             // caller's operation code
+    uint8_t  state;          // TrackedState
+    uint8_t  attempts;
+    uint8_t  ret_code;       // last device ret_code
+    bool     used;
+};
+
+struct TrackedCommand {
+    uint64_t start_ns;
+    uint32_t id;             // client request id
+    uint32_t devices;
+    uint32_t requests;
+    uint32_t open;           // requests not settled yet
+    uint32_t ok, failed, timed_out;
+    uint32_t retries;        // re-issued attempts over all requests
+    uint8_t  max_retries;    // per request
+    bool     (*retryable)(int32_t status);
+    char     name[24];
+    bool     used;
+};
+
+class CommandTracker {
+public:
+    static const size_t kMaxCommands = 16;
+    static const size_t kMaxRequests = 256;
+    typedef bool (*RetryableFn)(int32_t status);
+
+    CommandTracker() : timeout_ns_(1000000000ull), retries_(2), retryable_(NULL), active_(0), free_(kMaxRequests) {
+        std::memset(cmds_, 0, sizeof(cmds_));
+        std::memset(reqs_, 0, sizeof(reqs_));
+        std::memset(reserved_, 0, sizeof(reserved_));
+    }
+
+    void configure(uint64_t timeout_ns, unsigned retries, RetryableFn retryable) {
+        timeout_ns_ = timeout_ns ? timeout_ns : 1;
+        retries_ = retries > 255 ? 255 : retries;
+        retryable_ = retryable;
+    }
+
+    // Open a command that will add n_requests requests, with the configured retry policy
+    // unless retries >= 0 / retryable are given. Returns its slot, or -1 when the command
+    // table or the request table has no room for it.
+    int begin(uint32_t id, const char* name, uint32_t devices, uint32_t n_requests, uint64_t now,
+        int retries = -1, RetryableFn retryable = NULL) {
+        if (n_requests > free_) return -1;
+        for (size_t i = 0; i < kMaxCommands; ++i) {
+            TrackedCommand& c = cmds_[i];
+            if (c.used) continue;
+            std::memset(&c, 0, sizeof(c));
+            c.used = true;
+            c.id = id;
+            c.devices = devices;
+            c.start_ns = now;
+            c.max_retries = (uint8_t)(retries < 0 ? retries_ : (retries > 255 ? 255 : retries));
+            c.retryable = retryable ? retryable : retryable_;
+            std::strncpy(c.name, name, sizeof(c.name) - 1);
+            free_ -= n_requests;
+            reserved_[i] = n_requests;
+            ++active_;
+            return (int)i;
+        }
+        return -1;
+    }
+
+    // Add one request to command `cmd` and issue it: issue(handle, op, cmd, tag) makes the
+    // SDK call with `tag` as client_data and returns the call's status.
+    template <typename Issue>
+    void add(int cmd, uint32_t handle, uint8_t op, uint64_t now, Issue issue) {
+        TrackedCommand& c = cmds_[cmd];
+        if (c.requests >= reserved_[cmd]) return;
+        for (size_t i = 0; i < kMaxRequests; ++i) {
+            TrackedRequest& r = reqs_[i];
+            if (r.used) continue;
+            const uint16_t gen = r.gen;
+            std::memset(&r, 0, sizeof(r));
+            r.used = true;
+            r.gen = gen;
+            r.cmd = (uint8_t)cmd;
+            r.op = op;
+            r.handle = handle;
+            ++c.requests;
+            ++c.open;
+            send(i, now, issue);
+            return;
+        }
+    }
+
+    // Apply an SDK ack. False if the tag is unknown or its attempt has already settled.
+    bool ack(uint32_t tag, int32_t status, uint8_t ret_code, uint64_t now) {
+        const int i = slot(tag);
+        if (i < 0 || reqs_[i].state != kReqPending) return false;
+        settle(reqs_[i], status, ret_code, now);
+        return true;
+    }
+
+    // Client request id of the command a tag belongs to (0 once it is no longer tracked).
+    uint32_t client_id(uint32_t tag) const {
+        const int i = slot(tag);
+        return i < 0 ? 0 : cmds_[reqs_[i].cmd].id;
+    }
+
+    // Re-issue due retries, time out unacked requests, then pass every command whose
+    // requests have all settled to done(slot, command, tracker) and free it.
+    template <typename Issue, typename Done>
+    void poll(uint64_t now, Issue issue, Done done) {
+        if (!active_) return;
+        for (size_t i = 0; i < kMaxRequests; ++i) {
+            TrackedRequest& r = reqs_[i];
+            if (!r.used || r.deadline_ns > now) continue;
+            if (r.state == kReqRetry) {
+                ++cmds_[r.cmd].retries;
+                send(i, now, issue);
+            }
+            else if (r.state == kReqPending) {
+                if (r.attempts <= cmds_[r.cmd].max_retries) {
+                    ++cmds_[r.cmd].retries;
+                    send(i, now, issue);
+                }
+                else finish(r, kReqTimedOut);
+            }
+        }
+        for (size_t k = 0; k < kMaxCommands; ++k) {
+            TrackedCommand& c = cmds_[k];
+            if (!c.used || c.open) continue;
+            done((int)k, c, *this);
+            for (size_t i = 0; i < kMaxRequests; ++i)
+                if (reqs_[i].used && reqs_[i].cmd == k) {
+                    reqs_[i].used = false;
+                    ++reqs_[i].gen;      // stale tags stop matching
+                }
+            free_ += reserved_[k];
+            c.used = false;
+            --active_;
+        }
+    }
+
+    // Visit the requests of command slot `cmd` (in done: all settled).
+    template <typename Fn>
+    void for_each_request(const TrackedCommand& cmd, Fn fn) const {
+        const size_t k = (size_t)(&cmd - cmds_);
+        for (size_t i = 0; i < kMaxRequests; ++i)
+            if (reqs_[i].used && reqs_[i].cmd == k) fn(reqs_[i]);
+    }
+
+    size_t active() const { return active_; }
+    uint64_t timeout_ns() const { return timeout_ns_; }
+    unsigned retries() const { return retries_; }
+
+private:
+    // Request slot of a live tag, or -1
+    int slot(uint32_t tag) const {
+        const uint32_t i = (tag & 0xFFFFu) - 1;
+        if (i >= kMaxRequests) return -1;
+        const TrackedRequest& r = reqs_[i];
+        return r.used && r.gen == (uint16_t)(tag >> 16) ? (int)i : -1;
+    }
+
+    template <typename Issue>
+    void send(size_t i, uint64_t now, Issue issue) {
+        TrackedRequest& r = reqs_[i];
+        ++r.gen;                         // a new attempt gets a new tag
+        ++r.attempts;
+        r.state = kReqPending;
+        r.deadline_ns = now + timeout_ns_;
+        const uint32_t tag = ((uint32_t)r.gen << 16) | (uint32_t)(i + 1);
+        const int32_t st = issue(r.handle, r.op, (int)r.cmd, tag);
+        if (st != 0 && r.state == kReqPending) settle(r, st, 0, now);   // refused before any ack
+    }
+
+    void settle(TrackedRequest& r, int32_t status, uint8_t ret_code, uint64_t now) {
+        r.status = status;
+        r.ret_code = ret_code;
+        const TrackedCommand& c = cmds_[r.cmd];
+        if (status == 0 && ret_code == 0) finish(r, kReqOk);
+        else if (status != 0 && c.retryable && c.retryable(status) && r.attempts <= c.max_retries) {
+            r.state = kReqRetry;         // back off a quarter timeout before the next attempt
+            r.deadline_ns = now + timeout_ns_ / 4;
+        }
+        else finish(r, kReqFailed);
+    }
+
+    void finish(TrackedRequest& r, TrackedState state) {
+        TrackedCommand& c = cmds_[r.cmd];
+        r.state = (uint8_t)state;
+        --c.open;
+        if (state == kReqOk) ++c.ok;
+        else if (state == kReqFailed) ++c.failed;
+        else ++c.timed_out;
+    }
+
+    uint64_t timeout_ns_;
+    unsigned retries_;
+    RetryableFn retryable_;
+    size_t active_;
+    uint32_t free_;                      // requests not reserved by an open command
+    uint32_t reserved_[kMaxCommands];
+    TrackedCommand cmds_[kMaxCommands];
+    TrackedRequest reqs_[kMaxRequests];
+};
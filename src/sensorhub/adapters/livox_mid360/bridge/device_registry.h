@@ -0,0 +1,101 @@
+// Livox MID-360 Bridge - lock-free device registry
+//
+// Fixed-capacity table of SDK handles. Devices are registered from InfoChangeCallback
+// (claim a slot with CAS, fill in SN/IP, then publish it); everything else - the emitter's
+// data path and the control path walking all devices - only does lock-free reads, so a
+// slow SDK control call can never block packet handling. Slots are never reused: a
+// handle is derived from the device IP and stays valid for the life of the process.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class DeviceRegistry {
+public:
+    static const size_t kCapacity = 16;
+
+    struct Device {
+        uint32_t handle;
+        uint8_t  dev_type;
+        char     sn[17];
+        char     ip[17];
+    };
+
+    DeviceRegistry() : count_(0) {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            state_[i].store(kEmpty, std::memory_order_relaxed);
+            std::memset(&dev_[i], 0, sizeof(Device));
+        }
+    }
+
+    // Register a device; idempotent. Returns its slot, or -1 when the table is full.
+    int add(uint32_t handle, uint8_t dev_type, const char* sn, const char* ip) {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            uint32_t st = state_[i].load(std::memory_order_acquire);
+            if (st == kEmpty &&
+                state_[i].compare_exchange_strong(st, kClaimed, std::memory_order_acq_rel)) {
+                dev_[i].handle = handle;
+                dev_[i].dev_type = dev_type;
+                copy_field(dev_[i].sn, sn);
+                copy_field(dev_[i].ip, ip);
+                state_[i].store(kReady, std::memory_order_release);
+                size_t c = count_.load(std::memory_order_relaxed);
+                while (c < i + 1 && !count_.compare_exchange_weak(c, i + 1, std::memory_order_release)) {}
+                return (int)i;
+            }
+            // Another registration owns this slot; wait for it to publish, then compare.
+            while ((st = state_[i].load(std::memory_order_acquire)) == kClaimed) {}
+            if (dev_[i].handle == handle) return (int)i;
+        }
+        return -1;
+    }
+
+    // Slot of a registered handle, or -1.
+    int find(uint32_t handle) const {
+        const size_t n = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            if (state_[i].load(std::memory_order_acquire) == kReady && dev_[i].handle == handle)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    const Device* at(int slot) const {
+        if (slot < 0 || (size_t)slot >= kCapacity) return NULL;
+        if (state_[slot].load(std::memory_order_acquire) != kReady) return NULL;
+        return &dev_[slot];
+    }
+
+    // Call fn(handle) for every published device.
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        const size_t n = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            if (state_[i].load(std::memory_order_acquire) == kReady) fn(dev_[i].handle);
+        }
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for_each([&n](uint32_t) { ++n; });
+        return n;
+    }
+
+private:
+    enum { kEmpty = 0, kClaimed = 1, kReady = 2 };
+
+    static void copy_field(char* dst, const char* src) {
+        // SDK sn/ip fields are 16 bytes and not necessarily NUL-terminated
+        size_t n = 0;
+        if (src) while (n < 16 && src[n]) ++n;
+        if (n) std::memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+
+    std::atomic<uint32_t> state_[kCapacity];
+    Device dev_[kCapacity];
+    std::atomic<size_t> count_;   // slots [0, count_) may be published
+};
@@ -0,0 +1,73 @@
+// Livox MID-360 Bridge - per-device extrinsics from the SDK2 config
+//
+// Reads `lidar_configs[].ip` + `extrinsic_parameter` (roll/pitch/yaw in degrees, x/y/z in mm)
+// from the same JSON file passed to LivoxLidarSdkInit and maps them by lidar IP. Loaded
+// once at startup; lookups afterwards are read-only.
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "json_lite.h"
+#include "point_transform.h"
+
+class ExtrinsicTable {
+public:
+    static const size_t kCapacity = 16;
+
+    ExtrinsicTable() : n_(0) {}
+
+    // Returns the number of entries loaded, or -1 if the file cannot be read or parsed.
+    int load(const char* path) {
+        n_ = 0;
+        std::string text;
+        if (!read_file(path, &text)) return -1;
+        JsonValue root, list;
+        if (!json_parse(text.data(), text.data() + text.size(), &root)) return -1;
+        if (!json_find(root, "lidar_configs", &list) || list.type != kJsonArray) return 0;
+
+        JsonIter it(list);
+        JsonValue cfg;
+        while (n_ < kCapacity && it.next(&cfg)) {
+            JsonValue ip, ext;
+            if (!json_find(cfg, "ip", &ip) || !json_find(cfg, "extrinsic_parameter", &ext)) continue;
+            Entry& e = entries_[n_++];
+            json_string(ip, e.ip, sizeof(e.ip));
+            e.T = mat34_from_extrinsic(
+                json_find_number(ext, "roll", 0.0), json_find_number(ext, "pitch", 0.0),
+                json_find_number(ext, "yaw", 0.0), json_find_number(ext, "x", 0.0),
+                json_find_number(ext, "y", 0.0), json_find_number(ext, "z", 0.0));
+        }
+        return (int)n_;
+    }
+
+    // Extrinsic for a lidar IP, or NULL if the config does not list it.
+    const Mat34* find(const char* ip) const {
+        for (size_t i = 0; i < n_; ++i)
+            if (std::strcmp(entries_[i].ip, ip) == 0) return &entries_[i].T;
+        return NULL;
+    }
+
+    size_t size() const { return n_; }
+
+private:
+    struct Entry {
+        char  ip[17];
+        Mat34 T;
+    };
+
+    static bool read_file(const char* path, std::string* out) {
+        FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        char buf[4096];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out->append(buf, n);
+        std::fclose(f);
+        return true;
+    }
+
+    Entry entries_[kCapacity];
+    size_t n_;
+};
@@ -0,0 +1,184 @@
+// Livox MID-360 Bridge - per-device scan assembly
+//
+// The SDK hands us one Ethernet packet (~96 points) per callback. FrameAssembler decodes
+// packets into a preallocated scan buffer of BridgePoint (float metres) and tells the
+// caller when the current scan must be closed: time window elapsed, SDK frame_cnt rolled
+// over, or the buffer is full. Each packet goes through SoA columns (point_columns.h):
+// noise-tagged and zero returns are dropped there, before extrinsics would move a zero
+// return to the sensor's mounting point. The buffer is its own, or one the caller lends (a
+// buffer_pool.h block, which must outlive the assembler). One assembler per device handle
+// (or a single shared one in fusion mode, fed from every device); not thread-safe.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "livox_sdk_compat.h"
+#include "bridge_frame.h"
+#include "point_columns.h"
+#include "point_transform.h"
+
+// Per-point spacing within a packet: time_interval (units of 0.1 us) spans all dot_num points.
+static inline uint32_t packet_point_step_ns(const LivoxLidarEthernetPacket* pkt) {
+    return pkt->dot_num ? (uint32_t)((uint64_t)pkt->time_interval * 100u / pkt->dot_num) : 0;
+}
+
+// Decode points [first, first + n) of one packet into c (n <= PointColumns::kBlock). Point
+// i is stamped t_offset_ns + i * step_ns relative to the scan start. Unknown data types
+// decode to nothing.
+static inline size_t decode_packet_columns(const LivoxLidarEthernetPacket* pkt, size_t first, size_t n,
+    PointColumns* c, uint32_t t_offset_ns, uint32_t step_ns = 0) {
+    switch (pkt->data_type) {
+    case kLivoxLidarCartesianCoordinateHighData: {
+        const LivoxLidarCartesianHighRawPoint* p =
+            reinterpret_cast<const LivoxLidarCartesianHighRawPoint*>(pkt->data) + first;
+        for (size_t i = 0; i < n; ++i) {
+            c->x[i] = p[i].x * 0.001f;
+            c->y[i] = p[i].y * 0.001f;
+            c->z[i] = p[i].z * 0.001f;
+            c->refl[i] = p[i].reflectivity;
+            c->tag[i] = p[i].tag;
+        }
+        break;
+    }
+    case kLivoxLidarCartesianCoordinateLowData: {
+        const LivoxLidarCartesianLowRawPoint* p =
+            reinterpret_cast<const LivoxLidarCartesianLowRawPoint*>(pkt->data) + first;
+        for (size_t i = 0; i < n; ++i) {
+            c->x[i] = p[i].x * 0.01f;
+            c->y[i] = p[i].y * 0.01f;
+            c->z[i] = p[i].z * 0.01f;
+            c->refl[i] = p[i].reflectivity;
+            c->tag[i] = p[i].tag;
+        }
+        break;
+    }
+    case kLivoxLidarSphericalCoordinateData: {
+        const LivoxLidarSpherPoint* p =
+            reinterpret_cast<const LivoxLidarSpherPoint*>(pkt->data) + first;
+        const float k = 0.01f * 3.14159265358979f / 180.0f;
+        for (size_t i = 0; i < n; ++i) {
+            const float r = p[i].depth * 0.001f;
+            const float theta = p[i].theta * k;   // zenith
+            const float phi = p[i].phi * k;       // azimuth
+            const float st = std::sin(theta);
+            c->x[i] = r * st * std::cos(phi);
+            c->y[i] = r * st * std::sin(phi);
+            c->z[i] = r * std::cos(theta);
+            c->refl[i] = p[i].reflectivity;
+            c->tag[i] = p[i].tag;
+        }
+        break;
+    }
+    default:
+        return 0;
+    }
+    const uint32_t t0 = t_offset_ns + (uint32_t)first * step_ns;
+    for (size_t i = 0; i < n; ++i) c->t[i] = t0 + (uint32_t)i * step_ns;
+    return n;
+}
+
+class FrameAssembler {
+public:
+    // buf, if given, holds max_points points and stays the caller's.
+    explicit FrameAssembler(size_t max_points, BridgePoint* buf = NULL)
+        : own_(buf ? 0 : max_points), pts_(buf ? buf : own_.data()), cap_(max_points), count_(0),
+          packets_(0), window_ns_(100000000ull),
+          split_on_frame_cnt_(true), start_host_ns_(0), start_dev_ns_(0), start_stamp_ns_(0),
+          end_stamp_ns_(0), frame_cnt_(0), time_type_(0), dropped_(0) {}
+    FrameAssembler(const FrameAssembler&) = delete;   // pts_ may point into own_
+    FrameAssembler& operator=(const FrameAssembler&) = delete;
+
+    void configure(uint64_t window_ns, bool split_on_frame_cnt) {
+        window_ns_ = window_ns;
+        split_on_frame_cnt_ = split_on_frame_cnt;
+    }
+
+    void set_drop(const PointDropConfig& cfg) { drop_ = cfg; }
+
+    // True if the scan in progress must be published before `pkt` is added.
+    bool should_close(const LivoxLidarEthernetPacket* pkt, uint64_t host_ns) const {
+        if (packets_ == 0) return false;
+        if (split_on_frame_cnt_ && pkt->frame_cnt != frame_cnt_) return true;
+        if (window_ns_ && host_ns - start_host_ns_ >= window_ns_) return true;
+        return count_ + pkt->dot_num > cap_;
+    }
+
+    // host_ns is the arrival time (drives the window), stamp_ns the packet's device time
+    // mapped to the host clock (point offsets are relative to the first packet's stamp).
+    // T, if given, moves the packet's points into a common frame (extrinsics / fusion).
+    void add(const LivoxLidarEthernetPacket* pkt, uint64_t host_ns, uint64_t stamp_ns,
+        const Mat34* T = NULL) {
+        if (packets_ == 0) {
+            start_host_ns_ = host_ns;
+            std::memcpy(&start_dev_ns_, pkt->timestamp, sizeof(start_dev_ns_));
+            start_stamp_ns_ = stamp_ns;
+            end_stamp_ns_ = stamp_ns;
+            frame_cnt_ = pkt->frame_cnt;
+            time_type_ = pkt->time_type;
+        }
+        // fused scans mix devices: a packet may be stamped slightly before the first one
+        const uint32_t t_off = stamp_ns > start_stamp_ns_ ? (uint32_t)(stamp_ns - start_stamp_ns_) : 0;
+        const uint32_t step = packet_point_step_ns(pkt);
+        const size_t n = pkt->dot_num < cap_ - count_ ? pkt->dot_num : cap_ - count_;
+        for (size_t first = 0; first < n; first += PointColumns::kBlock) {
+            const size_t cnt = n - first < PointColumns::kBlock ? n - first : PointColumns::kBlock;
+            const size_t got = decode_packet_columns(pkt, first, cnt, &cols_, t_off, step);
+            const size_t kept = drop_points(cols_, got, drop_);
+            dropped_ += got - kept;
+            if (T) transform_xyz(cols_.x, cols_.y, cols_.z, kept, *T);
+            columns_store(cols_, kept, pts_ + count_);
+            count_ += kept;
+        }
+        const uint64_t last = stamp_ns + (n ? (uint64_t)(n - 1) * step : 0);
+        if (last > end_stamp_ns_) end_stamp_ns_ = last;
+        ++packets_;
+    }
+
+    // True if a scan has been open for timeout_ns (its device stopped sending).
+    bool expired(uint64_t host_ns, uint64_t timeout_ns) const {
+        return packets_ != 0 && host_ns >= start_host_ns_ && host_ns - start_host_ns_ >= timeout_ns;
+    }
+
+    void reset() { count_ = 0; packets_ = 0; }
+
+    bool empty() const { return packets_ == 0; }
+    const BridgePoint* points() const { return pts_; }
+    BridgePoint* points() { return pts_; }
+    size_t size() const { return count_; }
+    size_t capacity() const { return cap_; }
+    // Shrink the scan in progress after in-place filtering (n <= size()).
+    void truncate(size_t n) { if (n < count_) count_ = n; }
+    uint32_t packets() const { return packets_; }
+    uint64_t start_host_ns() const { return start_host_ns_; }
+    uint64_t start_device_ns() const { return start_dev_ns_; }
+    uint64_t start_stamp_ns() const { return start_stamp_ns_; }
+    // Stamp of the latest point in the scan (same clock as start_stamp_ns).
+    uint64_t end_stamp_ns() const { return end_stamp_ns_; }
+    uint8_t frame_cnt() const { return frame_cnt_; }
+    uint8_t time_type() const { return time_type_; }
+    // Points discarded by set_drop() since construction.
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    std::vector<BridgePoint> own_;   // sized once, empty when the buffer is lent
+    BridgePoint* pts_;
+    size_t cap_;
+    size_t count_;
+    uint32_t packets_;
+    uint64_t window_ns_;
+    bool split_on_frame_cnt_;
+    uint64_t start_host_ns_;
+    uint64_t start_dev_ns_;
+    uint64_t start_stamp_ns_;
+    uint64_t end_stamp_ns_;
+    uint8_t frame_cnt_;
+    uint8_t time_type_;
+    PointDropConfig drop_;
+    PointColumns cols_;              // one packet block in flight
+    uint64_t dropped_;
+};
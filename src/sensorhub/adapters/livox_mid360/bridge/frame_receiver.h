@@ -0,0 +1,381 @@
+// Livox MID-360 Bridge - client-side receiver for bridge output (Python extension core)
+//
+// The consumer half of the wire format, for livox_frames.cpp: a thread receives binary
+// frames from a UDP port (recvmmsg, optionally joining a multicast group) or the shm ring,
+// reassembles fragmented scans (msg 2; columnar ones column by column) and range images
+// (msg 8, plane by plane) and compressed blocks
+// (msg 5, decoded to BridgePoint) and queues whole messages. The caller pops them with pop(), which blocks on a condvar,
+// so a Python caller waits with the GIL released and pays one call per scan instead of one
+// per datagram. NDJSON lines are skipped (counted). Each FrameRecord owns its payload, so
+// the binding can hand it to numpy without copying.
+//
+// The queue is bounded: when the caller falls behind, the oldest records are dropped and
+// counted, like the bridge's own queues. Datagrams the kernel dropped because the socket's
+// receive buffer was full are counted too (SO_RXQ_OVFL); with the queue depth they are what
+// a consumer reports to the bridge as lag ({"cmd":"lag"}, backpressure.h). With history > 0 every message is also kept in a
+// SampleRing (sample_ring.h) per stream - points (msg 1 / 2 / 5) and IMU (msg 3 / 4) - keyed
+// by stamp_ns, so a reader can ask for the latest scan or the last k without popping; a
+// queue_depth of 0 then keeps history only. Records are shared between queue and history
+// and must not be modified.
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "sample_ring.h"
+#include "scan_codec.h"
+#include "shm_ring.h"
+
+struct FrameRecord {
+    BridgeFrameHeader h;             // first fragment's header; point_count / payload_len are
+                                     // the whole message's, frag_count = 1
+    std::vector<uint8_t> payload;    // point_count records of bridge_point_size(point_format)
+};
+
+typedef std::shared_ptr<const FrameRecord> FrameRecordPtr;
+// history rows: each record's header, as a typed column next to the stamps
+typedef SampleRing<FrameRecord, BridgeFrameHeader> FrameHistory;
+
+class FrameReceiver {
+public:
+    static const size_t kBatch = 32;         // datagrams per recvmmsg
+    static const uint32_t kMaxScanPoints = 1u << 24;
+
+    explicit FrameReceiver(size_t queue_depth = 64, size_t history = 0)
+        : fd_(-1), port_(0), depth_(queue_depth ? queue_depth : history ? 0 : 1), running_(false),
+          next_frag_(0), scan_blocks_(0), datagrams_(0), bytes_(0), records_(0), ndjson_(0), incomplete_(0),
+          bad_blocks_(0), dropped_(0), kernel_drops_(0) {
+        if (history) {
+            points_hist_ = std::make_shared<FrameHistory>(history);
+            imu_hist_ = std::make_shared<FrameHistory>(history);
+        }
+    }
+
+    ~FrameReceiver() {
+        stop();
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    // Bind a UDP port (0 = ephemeral, see port()) and optionally join a multicast group.
+    bool open_udp(uint16_t port, const char* addr = "0.0.0.0", const char* group = NULL, int rcvbuf = 8 << 20) {
+        fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) return false;
+        const int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+        sockaddr_in sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        if (inet_pton(AF_INET, addr, &sa.sin_addr) != 1 || bind(fd_, (const sockaddr*)&sa, sizeof(sa)) != 0)
+            return close_fd();
+        if (group && *group) {
+            ip_mreq mreq;
+            std::memset(&mreq, 0, sizeof(mreq));
+            if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1 ||
+                setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+                return close_fd();
+        }
+        socklen_t len = sizeof(sa);
+        getsockname(fd_, (sockaddr*)&sa, &len);
+        port_ = ntohs(sa.sin_port);
+        return true;
+    }
+
+    // Map the bridge's shm ring (LIVOX_SHM_NAME); false until the bridge has created it.
+    bool open_shm(const std::string& name) { return shm_.open(name); }
+
+    bool start() {
+        if (running_.load() || (fd_ < 0 && !shm_.is_open())) return false;
+        running_.store(true);
+        thread_ = std::thread(&FrameReceiver::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        running_.store(false);
+        thread_.join();
+        cv_.notify_all();
+    }
+
+    // Next whole message, waiting up to timeout_ms (< 0 = forever); empty on timeout or once
+    // stopped.
+    FrameRecordPtr pop(int timeout_ms) {
+        std::unique_lock<std::mutex> lock(mu_);
+        const bool ready = cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms < 0 ? 1 << 30 : timeout_ms),
+            [this] { return !queue_.empty() || !running_.load(); });
+        if (!ready || queue_.empty()) return FrameRecordPtr();
+        FrameRecordPtr r = queue_.front();
+        queue_.pop_front();
+        return r;
+    }
+
+    // Per-stream history (NULL when constructed with history = 0).
+    const std::shared_ptr<FrameHistory>& points_history() const { return points_hist_; }
+    const std::shared_ptr<FrameHistory>& imu_history() const { return imu_hist_; }
+
+    uint16_t port() const { return port_; }
+    bool running() const { return running_.load(); }
+    uint64_t datagrams() const { return datagrams_.load(); }
+    uint64_t bytes() const { return bytes_.load(); }
+    uint64_t records() const { return records_.load(); }
+    uint64_t ndjson() const { return ndjson_.load(); }
+    uint64_t incomplete() const { return incomplete_.load(); }
+    uint64_t bad_blocks() const { return bad_blocks_.load(); }
+    uint64_t dropped() const { return dropped_.load(); }
+    uint64_t shm_lost() const { return shm_.is_open() ? shm_.lost() : 0; }
+    uint64_t kernel_drops() const { return kernel_drops_.load(); }
+
+    // Records waiting in the queue, and its bound.
+    size_t queued() const {
+        std::lock_guard<std::mutex> lock(mu_);
+        return queue_.size();
+    }
+    size_t capacity() const { return depth_; }
+
+private:
+    bool close_fd() {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void run() {
+        std::vector<uint8_t> buf(kBatch * 65536);
+        mmsghdr msgs[kBatch];
+        iovec iov[kBatch];
+        // SO_RXQ_OVFL: each datagram carries the socket's drop count so far
+        uint8_t ctl[kBatch][CMSG_SPACE(sizeof(uint32_t))];
+        while (running_.load(std::memory_order_relaxed)) {
+            if (fd_ < 0) {
+                const size_t n = shm_.read(&buf[0], buf.size());
+                if (n) consume(&buf[0], n);
+                else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            pollfd pfd = { fd_, POLLIN, 0 };
+            if (poll(&pfd, 1, 50) <= 0) continue;
+            std::memset(msgs, 0, sizeof(msgs));
+            for (size_t i = 0; i < kBatch; ++i) {
+                iov[i].iov_base = &buf[i * 65536];
+                iov[i].iov_len = 65536;
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_control = ctl[i];
+                msgs[i].msg_hdr.msg_controllen = sizeof(ctl[i]);
+            }
+            const int n = recvmmsg(fd_, msgs, kBatch, MSG_DONTWAIT, NULL);
+            for (int i = 0; i < n; ++i) {
+                for (cmsghdr* cm = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cm; cm = CMSG_NXTHDR(&msgs[i].msg_hdr, cm)) {
+                    if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SO_RXQ_OVFL) continue;
+                    uint32_t drops;
+                    std::memcpy(&drops, CMSG_DATA(cm), sizeof(drops));
+                    kernel_drops_.store(drops, std::memory_order_relaxed);
+                }
+                consume(&buf[i * 65536], msgs[i].msg_len);
+            }
+        }
+        cv_.notify_all();
+    }
+
+    // One datagram or ring record: NDJSON lines and / or binary messages back to back.
+    void consume(const uint8_t* p, size_t len) {
+        datagrams_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(len, std::memory_order_relaxed);
+        const uint8_t* end = p + len;
+        while (p < end) {
+            if (*p == '{') {
+                const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(p, '\n', (size_t)(end - p)));
+                ndjson_.fetch_add(1, std::memory_order_relaxed);
+                p = nl ? nl + 1 : end;
+                continue;
+            }
+            BridgeFrameHeader h;
+            if ((size_t)(end - p) < sizeof(h)) break;
+            std::memcpy(&h, p, sizeof(h));
+            if (h.magic != kBridgeFrameMagic || h.version != kBridgeFrameVersion ||
+                (size_t)(end - p) < sizeof(h) + h.payload_len)
+                break;
+            const uint8_t* payload = p + sizeof(h);
+            p += sizeof(h) + h.payload_len;
+            if (h.msg_type == kBridgeMsgScanCompressed) add_block(h, payload);
+            else if (h.frag_count > 1) add_fragment(h, payload);
+            else push(h, payload, h.payload_len);
+        }
+    }
+
+    void push(const BridgeFrameHeader& h, const uint8_t* payload, size_t len) {
+        FrameRecord* r = new FrameRecord;
+        r->h = h;
+        r->payload.assign(payload, payload + len);
+        push(r);
+    }
+
+    void push(FrameRecord* r) {
+        r->h.frag_index = 0;
+        r->h.frag_count = 1;
+        r->h.payload_len = (uint32_t)r->payload.size();
+        records_.fetch_add(1, std::memory_order_relaxed);
+        FrameRecordPtr rec(r);
+        if (points_hist_) {
+            FrameHistory* hist = r->h.msg_type == kBridgeMsgImu || r->h.msg_type == kBridgeMsgImuPreint
+                ? imu_hist_.get() : points_hist_.get();
+            hist->push((int64_t)r->h.stamp_ns, rec, r->h);
+        }
+        if (!depth_) return;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (queue_.size() == depth_) {
+                queue_.pop_front();
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            queue_.push_back(std::move(rec));
+        }
+        cv_.notify_one();
+    }
+
+    // Fragments of one message arrive in order and back to back; any gap drops the message.
+    void add_fragment(const BridgeFrameHeader& h, const uint8_t* payload) {
+        if (frag_.get() && (h.seq != frag_->h.seq || h.frag_index != next_frag_)) {
+            incomplete_.fetch_add(1, std::memory_order_relaxed);
+            frag_.reset();
+        }
+        if (!frag_.get()) {
+            if (h.frag_index != 0) return;
+            frag_.reset(new FrameRecord);
+            frag_->h = h;
+            frag_->h.point_count = 0;
+            next_frag_ = 0;
+            frag_points_.clear();
+        }
+        frag_->payload.insert(frag_->payload.end(), payload, payload + h.payload_len);
+        frag_->h.point_count += h.point_count;
+        frag_points_.push_back(h.point_count);
+        if (++next_frag_ == h.frag_count) {
+            const bool joined = h.point_format == kBridgePointXyzrtColumns ? join_columns(frag_.get())
+                              : h.point_format == kBridgeRangeImageRows ? join_range_rows(frag_.get()) : true;
+            if (!joined) {
+                incomplete_.fetch_add(1, std::memory_order_relaxed);
+                frag_.reset();
+                return;
+            }
+            push(frag_.release());
+        }
+    }
+
+    // Columnar fragments each carry their own x[], y[], ... columns; rebuild one set for
+    // the whole scan. False if the payload does not hold the points the headers claim.
+    bool join_columns(FrameRecord* r) {
+        static const size_t kWidth[6] = { 4, 4, 4, 4, 1, 1 };   // x y z t_offset_ns refl tag
+        return join_planar(r, kWidth, 6);
+    }
+
+    // Range image fragments each carry their rows' range plane, then intensity plane.
+    bool join_range_rows(FrameRecord* r) {
+        const size_t rows = r->h.point_count;
+        if (!rows || r->payload.size() % (rows * kBridgeRangePixelBytes)) return false;
+        const size_t w = r->payload.size() / (rows * kBridgeRangePixelBytes);
+        const size_t width[2] = { w * sizeof(float), w };
+        return join_planar(r, width, 2);
+    }
+
+    // Fragments of planar records (plane c holds width[c] bytes per record) joined into one
+    // set of planes for the whole message.
+    bool join_planar(FrameRecord* r, const size_t* width, size_t planes) {
+        size_t rec = 0;
+        for (size_t c = 0; c < planes; ++c) rec += width[c];
+        const size_t total = r->h.point_count;
+        if (r->payload.size() != total * rec) return false;
+        join_.resize(r->payload.size());
+        size_t src = 0, first = 0;
+        for (size_t f = 0; f < frag_points_.size(); ++f) {
+            const size_t n = frag_points_[f];
+            size_t dst = 0;
+            for (size_t c = 0; c < planes; ++c) {
+                if (n) std::memcpy(&join_[dst + first * width[c]], &r->payload[src], n * width[c]);
+                src += n * width[c];
+                dst += total * width[c];
+            }
+            first += n;
+        }
+        r->payload.swap(join_);
+        return true;
+    }
+
+    // Compressed blocks decode on their own and land at first_point, so a lost block leaves
+    // zero points (counted as incomplete) instead of costing the scan. The scan is queued at
+    // its last block, or when the next scan starts.
+    void add_block(const BridgeFrameHeader& h, const uint8_t* payload) {
+        BridgeCodecBlock b;
+        if (h.payload_len >= sizeof(b)) std::memcpy(&b, payload, sizeof(b));
+        if (h.payload_len < sizeof(b) || b.scan_points > kMaxScanPoints) {
+            bad_blocks_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (scan_.get() && h.seq != scan_->h.seq) finish_scan();
+        if (!scan_.get()) {
+            scan_.reset(new FrameRecord);
+            scan_->h = h;
+            scan_->h.msg_type = kBridgeMsgScan;
+            scan_->h.point_format = kBridgePointXyzrt;
+            scan_->h.point_count = b.scan_points;
+            scan_->payload.assign((size_t)b.scan_points * sizeof(BridgePoint), 0);
+            scan_blocks_ = 0;
+            scratch_.resize(kCodecMaxRaw);
+        }
+        BridgePoint* out = scan_->payload.empty() ? NULL : reinterpret_cast<BridgePoint*>(&scan_->payload[0]);
+        if ((uint64_t)b.first_point + h.point_count > scan_->h.point_count ||
+            !scan_codec_decode(payload, h.payload_len, h.point_count, out + b.first_point, &scratch_[0])) {
+            bad_blocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            ++scan_blocks_;
+        }
+        if (h.frag_index + 1 == h.frag_count) finish_scan();
+    }
+
+    void finish_scan() {
+        if (scan_blocks_ != scan_->h.frag_count) incomplete_.fetch_add(1, std::memory_order_relaxed);
+        push(scan_.release());
+    }
+
+    int fd_;
+    uint16_t port_;
+    ShmRingReader shm_;
+    size_t depth_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<FrameRecordPtr> queue_;
+    std::shared_ptr<FrameHistory> points_hist_, imu_hist_;
+
+    // receive thread only
+    std::unique_ptr<FrameRecord> frag_;
+    uint16_t next_frag_;
+    std::vector<uint32_t> frag_points_;   // point_count of each fragment so far
+    std::vector<uint8_t> join_;
+    std::unique_ptr<FrameRecord> scan_;
+    uint32_t scan_blocks_;
+    std::vector<uint8_t> scratch_;
+
+    std::atomic<uint64_t> datagrams_, bytes_, records_, ndjson_, incomplete_, bad_blocks_, dropped_, kernel_drops_;
+};
@@ -0,0 +1,459 @@
+// Livox MID-360 Bridge - GNSS time sync: RMC / UBX time + PPS edges -> SetLivoxLidarRmcSyncTime
+//
+// A receiver on a serial port gives the UTC second twice: a PPS pulse (on a /dev/ppsN line,
+// timestamped by the kernel at the interrupt) marks where the second starts, and a message a
+// few hundred ms later says which second it was - NMEA RMC from any talker (GP, GN, GL...) or
+// UBX NAV-TIMEUTC / NAV-PVT. The lidar latches its own PPS input and needs the RMC for that
+// second as soon as possible after the edge, so the thread here waits on the PPS device and,
+// on edge q, sends the time of the last message (received after edge q0) advanced by q - q0
+// seconds, straight from the edge wakeup. Sending hands the sentence to the thread that owns
+// the SDK requests (the bridge's emitter), which reports back with on_issued(); edge_to_send
+// spans that hop up to the SDK call. This assumes the usual
+// receiver order, pulse first and then the message for it. A message older than kMaxCoast
+// edges is not extrapolated any further.
+//
+// Without a PPS device every RMC / UBX time is forwarded as it completes, at most once per
+// UTC second; the lidar then needs its own PPS wiring, and the reported offset includes the
+// receiver's output delay.
+//
+// offset_ns is host CLOCK_REALTIME at the edge (or at the message) minus the UTC second, so
+// on an NTP/PTP-disciplined host it is the host clock error plus the PPS latency; jitter_ns
+// smooths |offset - previous offset| by 1/16 per second (RFC 3550 interarrival jitter).
+// The sentence sent is always $GPRMC, rebuilt around the time with the receiver's position
+// fields when it gave any. Counters are written by the GNSS thread, except sent, send_failed
+// and edge_to_send, which on_issued() updates from the issuing thread, and acks and the
+// send->ack histogram, which belong to the thread delivering SDK callbacks.
+
+#pragma once
+
+#include <fcntl.h>
+#include <linux/pps.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "bridge_stats.h"
+
+struct GnssConfig {
+    std::string device;      // serial port of the receiver (LIVOX_GNSS_DEVICE)
+    int baud;                // LIVOX_GNSS_BAUD
+    std::string pps;         // /dev/ppsN (LIVOX_GNSS_PPS), empty = no PPS
+
+    GnssConfig() : baud(9600) {}
+};
+
+class GnssTimeSync {
+public:
+    // Hands one RMC sentence on to be sent to every device; false if it had to be dropped
+    // (counted as send_failed). The thread issuing the requests then calls on_issued().
+    typedef bool (*SendFn)(const char* rmc, uint16_t len, void* ctx);
+
+    static const uint32_t kMaxCoast = 2;          // edges a message time may be advanced over
+
+    GnssTimeSync()
+        : serial_fd_(-1), pps_fd_(-1), send_(NULL), ctx_(NULL), stop_(false), len_(0), ubx_need_(0),
+          msg_sec_(0), msg_edge_(0), have_msg_(false), last_sent_sec_(0), edge_seq_(0), have_edge_(false),
+          have_offset_(false), last_offset_(0), jitter_(0.0), edges_(0), rmc_(0), ubx_(0), bad_(0),
+          invalid_(0), unpaired_(0), sent_(0), send_failed_(0), acks_(0), ack_failed_(0), last_utc_(0),
+          offset_ns_(0), jitter_ns_(0), last_send_ns_(0), send_edge_rt_(0) {
+        std::strcpy(pos_, ",,,,,");
+        std::strcpy(tail_, ",,A");
+    }
+
+    ~GnssTimeSync() { stop(); }
+
+    bool start(const GnssConfig& cfg, SendFn send, void* ctx) {
+        serial_fd_ = ::open(cfg.device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (serial_fd_ < 0) return false;
+        configure_serial(cfg.baud);            // not a tty (a FIFO, a test pty pair): as is
+        if (!cfg.pps.empty()) {
+            pps_fd_ = ::open(cfg.pps.c_str(), O_RDWR | O_CLOEXEC);
+            if (pps_fd_ < 0) pps_fd_ = ::open(cfg.pps.c_str(), O_RDONLY | O_CLOEXEC);
+            if (pps_fd_ < 0) {
+                ::close(serial_fd_);
+                serial_fd_ = -1;
+                return false;
+            }
+            // Capture assert edges; drivers with fixed modes refuse this, which is fine
+            pps_kparams params;
+            if (ioctl(pps_fd_, PPS_GETPARAMS, &params) == 0) {
+                params.mode |= PPS_CAPTUREASSERT;
+                ioctl(pps_fd_, PPS_SETPARAMS, &params);
+            }
+        }
+        send_ = send;
+        ctx_ = ctx;
+        stop_.store(false);
+        thread_ = std::thread(&GnssTimeSync::run, this);
+        return true;
+    }
+
+    void stop() {
+        if (thread_.joinable()) {
+            stop_.store(true);
+            thread_.join();
+        }
+        if (serial_fd_ >= 0) ::close(serial_fd_);
+        if (pps_fd_ >= 0) ::close(pps_fd_);
+        serial_fd_ = pps_fd_ = -1;
+    }
+
+    bool running() const { return thread_.joinable(); }
+    bool pps() const { return pps_fd_ >= 0; }
+
+    // Issuing thread, once per sentence handed on: `issued` requests went out to devices and
+    // the SDK refused `failed`.
+    void on_issued(unsigned issued, unsigned failed) {
+        BridgeCounters::inc(sent_, issued);
+        BridgeCounters::inc(send_failed_, failed);
+        last_send_ns_.store(steady_ns(), std::memory_order_relaxed);
+        const uint64_t edge_rt = send_edge_rt_.exchange(0, std::memory_order_relaxed);
+        const uint64_t now = realtime_ns();
+        if (edge_rt && now >= edge_rt) edge_to_send_.record(now - edge_rt);
+    }
+
+    // SDK callback thread: one per request issued by a send.
+    void on_ack(bool ok, uint64_t now_ns) {
+        BridgeCounters::inc(ok ? acks_ : ack_failed_);
+        const uint64_t sent = last_send_ns_.load(std::memory_order_relaxed);
+        if (sent && now_ns >= sent) send_to_ack_.record(now_ns - sent);
+    }
+
+    uint64_t edges() const { return BridgeCounters::get(edges_); }
+    uint64_t rmc() const { return BridgeCounters::get(rmc_); }
+    uint64_t ubx() const { return BridgeCounters::get(ubx_); }
+    uint64_t bad() const { return BridgeCounters::get(bad_); }            // checksum / framing
+    uint64_t invalid() const { return BridgeCounters::get(invalid_); }    // no fix / time not valid
+    uint64_t unpaired() const { return BridgeCounters::get(unpaired_); }  // edges with no usable time
+    uint64_t sent() const { return BridgeCounters::get(sent_); }
+    uint64_t send_failed() const { return BridgeCounters::get(send_failed_); }
+    uint64_t acks() const { return BridgeCounters::get(acks_); }
+    uint64_t ack_failed() const { return BridgeCounters::get(ack_failed_); }
+    int64_t last_utc() const { return last_utc_.load(std::memory_order_relaxed); }
+    int64_t offset_ns() const { return offset_ns_.load(std::memory_order_relaxed); }
+    uint64_t jitter_ns() const { return jitter_ns_.load(std::memory_order_relaxed); }
+    const LatencyHistogram& edge_to_send() const { return edge_to_send_; }
+    const LatencyHistogram& send_to_ack() const { return send_to_ack_; }
+
+    // "$GPRMC,hhmmss.00,A,<pos>,ddmmyy,<tail>*CS\r\n" for unix second `sec`.
+    static size_t format_rmc(int64_t sec, const char* pos, const char* tail, char* out, size_t cap) {
+        const time_t t = (time_t)sec;
+        tm u;
+        gmtime_r(&t, &u);
+        int n = std::snprintf(out, cap, "$GPRMC,%02d%02d%02d.00,A,%s,%02d%02d%02d,%s",
+            u.tm_hour, u.tm_min, u.tm_sec, pos, u.tm_mday, u.tm_mon + 1, u.tm_year % 100, tail);
+        if (n < 0 || (size_t)n + 5 >= cap) return 0;
+        uint8_t cs = 0;
+        for (int i = 1; i < n; ++i) cs ^= (uint8_t)out[i];
+        n += std::snprintf(out + n, cap - n, "*%02X\r\n", cs);
+        return (size_t)n;
+    }
+
+private:
+    static const size_t kLineMax = 256;
+    static const int kPpsWaitMs = 50;          // PPS wait slice: serial is drained in between
+    static const int kSerialWaitMs = 200;
+
+    void configure_serial(int baud) {
+        termios tio;
+        if (tcgetattr(serial_fd_, &tio) != 0) return;
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        speed_t s = B9600;
+        switch (baud) {
+        case 4800: s = B4800; break;
+        case 19200: s = B19200; break;
+        case 38400: s = B38400; break;
+        case 57600: s = B57600; break;
+        case 115200: s = B115200; break;
+        case 230400: s = B230400; break;
+        case 460800: s = B460800; break;
+        case 921600: s = B921600; break;
+        default: break;
+        }
+        cfsetispeed(&tio, s);
+        cfsetospeed(&tio, s);
+        tcsetattr(serial_fd_, TCSANOW, &tio);
+        tcflush(serial_fd_, TCIFLUSH);
+    }
+
+    static uint64_t realtime_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    static uint64_t steady_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    void run() {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            if (pps_fd_ >= 0) {
+                fetch_edge(kPpsWaitMs);
+            }
+            else {
+                pollfd p = { serial_fd_, POLLIN, 0 };
+                if (poll(&p, 1, kSerialWaitMs) <= 0) continue;
+            }
+            drain_serial();
+        }
+    }
+
+    // Latest assert edge; waits up to wait_ms for a new one (0 = just look). Sends the RMC
+    // for every edge not seen before.
+    void fetch_edge(int wait_ms) {
+        pps_fdata fd;
+        std::memset(&fd, 0, sizeof(fd));
+        fd.timeout.sec = 0;
+        fd.timeout.nsec = wait_ms * 1000000;
+        if (ioctl(pps_fd_, PPS_FETCH, &fd) != 0) return;      // ETIMEDOUT, EINTR
+        const uint32_t seq = fd.info.assert_sequence;
+        if (!seq || (have_edge_ && seq == edge_seq_)) return;
+        const uint64_t edge_rt = (uint64_t)fd.info.assert_tu.sec * 1000000000ull + (uint64_t)fd.info.assert_tu.nsec;
+        have_edge_ = true;
+        edge_seq_ = seq;
+        BridgeCounters::inc(edges_);
+        const uint32_t coast = seq - msg_edge_;
+        if (!have_msg_ || coast == 0 || coast > kMaxCoast) {
+            BridgeCounters::inc(unpaired_);
+            return;
+        }
+        const int64_t sec = msg_sec_ + (int64_t)coast;
+        send_edge_rt_.store(edge_rt, std::memory_order_relaxed);
+        send(sec);
+        observe_offset((int64_t)edge_rt - sec * 1000000000ll);
+    }
+
+    // A complete message gave UTC second `sec`.
+    void on_time(int64_t sec) {
+        last_utc_.store(sec, std::memory_order_relaxed);
+        if (pps_fd_ >= 0) {
+            fetch_edge(0);               // an edge during the drain belongs before this message
+            msg_sec_ = sec;
+            msg_edge_ = edge_seq_;
+            have_msg_ = have_edge_;
+            return;
+        }
+        if (sec <= last_sent_sec_) return;      // 5/10 Hz receivers: first message of the second
+        send(sec);
+        observe_offset((int64_t)realtime_ns() - sec * 1000000000ll);
+    }
+
+    void send(int64_t sec) {
+        char rmc[160];
+        const size_t n = format_rmc(sec, pos_, tail_, rmc, sizeof(rmc));
+        if (!n || !send_) {
+            send_edge_rt_.store(0, std::memory_order_relaxed);
+            return;
+        }
+        last_sent_sec_ = sec;
+        if (!send_(rmc, (uint16_t)n, ctx_)) {
+            send_edge_rt_.store(0, std::memory_order_relaxed);
+            BridgeCounters::inc(send_failed_);
+        }
+    }
+
+    void observe_offset(int64_t off) {
+        if (have_offset_) {
+            const double d = (double)(off > last_offset_ ? off - last_offset_ : last_offset_ - off);
+            jitter_ += (d - jitter_) / 16.0;
+            jitter_ns_.store((uint64_t)jitter_, std::memory_order_relaxed);
+        }
+        have_offset_ = true;
+        last_offset_ = off;
+        offset_ns_.store(off, std::memory_order_relaxed);
+    }
+
+    // ---- serial framing: NMEA lines and UBX frames interleaved on one port ----
+    void drain_serial() {
+        uint8_t buf[512];
+        for (;;) {
+            const ssize_t r = ::read(serial_fd_, buf, sizeof(buf));
+            if (r <= 0) return;
+            for (ssize_t i = 0; i < r; ++i) feed(buf[i]);
+        }
+    }
+
+    void feed(uint8_t c) {
+        if (ubx_need_) {                                   // inside a UBX frame
+            line_[len_++] = c;
+            if (len_ == 6) {
+                const size_t payload = (size_t)line_[4] | ((size_t)line_[5] << 8);
+                if (payload + 8 > kLineMax) { BridgeCounters::inc(bad_); reset(); return; }
+                ubx_need_ = payload + 8;
+            }
+            if (len_ == ubx_need_) { parse_ubx(); reset(); }
+            return;
+        }
+        if (len_ == 1 && line_[0] == 0xB5) {
+            if (c == 0x62) { line_[len_++] = c; ubx_need_ = 6; return; }
+            reset();
+        }
+        if (c == '$' || c == 0xB5) {                       // a new frame starts; drop any partial line
+            reset();
+            line_[len_++] = c;
+            return;
+        }
+        if (!len_) return;
+        if (c == '\r' || c == '\n') {
+            line_[len_] = 0;
+            parse_nmea((char*)line_, len_);
+            reset();
+            return;
+        }
+        if (len_ + 1 >= kLineMax) { BridgeCounters::inc(bad_); reset(); return; }
+        line_[len_++] = c;
+    }
+
+    void reset() { len_ = 0; ubx_need_ = 0; }
+
+    static int hex_digit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    static int two_digits(const char* p) {
+        if (p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9') return -1;
+        return (p[0] - '0') * 10 + (p[1] - '0');
+    }
+
+    static int64_t utc_seconds(int year, int mon, int day, int h, int m, int s) {
+        tm u;
+        std::memset(&u, 0, sizeof(u));
+        u.tm_year = year - 1900;
+        u.tm_mon = mon - 1;
+        u.tm_mday = day;
+        u.tm_hour = h;
+        u.tm_min = m;
+        u.tm_sec = s;
+        return (int64_t)timegm(&u);
+    }
+
+    // "$ttRMC,hhmmss.ss,A,lat,N,lon,E,sog,cog,ddmmyy,mv,E[,mode[,nav]]*CS"
+    void parse_nmea(char* s, size_t n) {
+        char* star = (char*)std::memchr(s, '*', n);
+        if (!star || star + 3 > s + n) { BridgeCounters::inc(bad_); return; }
+        uint8_t cs = 0;
+        for (char* p = s + 1; p < star; ++p) cs ^= (uint8_t)*p;
+        const int hi = hex_digit(star[1]), lo = hex_digit(star[2]);
+        if (hi < 0 || lo < 0 || cs != (uint8_t)(hi << 4 | lo)) { BridgeCounters::inc(bad_); return; }
+        *star = 0;
+        if (star - s < 6 || std::memcmp(s + 3, "RMC,", 4) != 0) return;   // other sentences
+        BridgeCounters::inc(rmc_);
+        char* f[16];
+        size_t nf = 0;
+        for (char* p = s; nf < 16;) {
+            f[nf++] = p;
+            char* comma = std::strchr(p, ',');
+            if (!comma) break;
+            *comma = 0;
+            p = comma + 1;
+        }
+        if (nf < 10 || std::strcmp(f[2], "A") != 0 || std::strlen(f[1]) < 6 || std::strlen(f[9]) != 6) {
+            BridgeCounters::inc(invalid_);
+            return;
+        }
+        const int h = two_digits(f[1]), m = two_digits(f[1] + 2), sec = two_digits(f[1] + 4);
+        const int day = two_digits(f[9]), mon = two_digits(f[9] + 2), yy = two_digits(f[9] + 4);
+        if (h < 0 || m < 0 || sec < 0 || day < 1 || mon < 1 || mon > 12 || yy < 0) {
+            BridgeCounters::inc(invalid_);
+            return;
+        }
+        // keep the position / course fields (3..8) and everything after the date for the resend
+        int w = 0;
+        for (size_t i = 3; i <= 8 && w < (int)sizeof(pos_); ++i)
+            w += std::snprintf(pos_ + w, sizeof(pos_) - w, "%s%s", i == 3 ? "" : ",", f[i]);
+        w = 0;
+        tail_[0] = 0;
+        for (size_t i = 10; i < nf && w < (int)sizeof(tail_); ++i)
+            w += std::snprintf(tail_ + w, sizeof(tail_) - w, "%s%s", i == 10 ? "" : ",", f[i]);
+        on_time(utc_seconds(2000 + yy, mon, day, h, m, sec));
+    }
+
+    static uint32_t le32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // B5 62 class id len16 payload ck_a ck_b (Fletcher-8 over class..payload)
+    void parse_ubx() {
+        const size_t payload = len_ - 8;
+        uint8_t a = 0, b = 0;
+        for (size_t i = 2; i < 6 + payload; ++i) { a = (uint8_t)(a + line_[i]); b = (uint8_t)(b + a); }
+        if (a != line_[6 + payload] || b != line_[7 + payload]) { BridgeCounters::inc(bad_); return; }
+        if (line_[2] != 0x01) return;                          // NAV only
+        const uint8_t* p = line_ + 6;
+        int year, mon, day, h, m, s;
+        int32_t nano;
+        if (line_[3] == 0x21 && payload >= 20) {                // NAV-TIMEUTC, valid: bit 2 validUTC
+            BridgeCounters::inc(ubx_);
+            if (!(p[19] & 0x04)) { BridgeCounters::inc(invalid_); return; }
+            nano = (int32_t)le32(p + 8);
+            year = p[12] | (p[13] << 8); mon = p[14]; day = p[15]; h = p[16]; m = p[17]; s = p[18];
+        }
+        else if (line_[3] == 0x07 && payload >= 92) {           // NAV-PVT, valid: validDate | validTime
+            BridgeCounters::inc(ubx_);
+            if ((p[11] & 0x03) != 0x03) { BridgeCounters::inc(invalid_); return; }
+            nano = (int32_t)le32(p + 16);
+            year = p[4] | (p[5] << 8); mon = p[6]; day = p[7]; h = p[8]; m = p[9]; s = p[10];
+        }
+        else {
+            return;
+        }
+        if (mon < 1 || mon > 12 || day < 1) { BridgeCounters::inc(invalid_); return; }
+        // the fix epoch is on the second give or take nano; round to it
+        int64_t sec = utc_seconds(year, mon, day, h, m, s);
+        if (nano >= 500000000) ++sec;
+        else if (nano < -500000000) --sec;
+        std::strcpy(pos_, ",,,,,");
+        std::strcpy(tail_, ",,A");
+        on_time(sec);
+    }
+
+    int serial_fd_;
+    int pps_fd_;
+    SendFn send_;
+    void* ctx_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+
+    // GNSS thread only
+    uint8_t line_[kLineMax];
+    size_t len_;
+    size_t ubx_need_;                  // UBX frame: bytes expected (header first), 0 = NMEA / idle
+    char pos_[96];                     // RMC fields 3..8 of the last sentence, for the resend
+    char tail_[32];                    // RMC fields after the date
+    int64_t msg_sec_;                  // last message's UTC second and the edge it came after
+    uint32_t msg_edge_;
+    bool have_msg_;
+    int64_t last_sent_sec_;
+    uint32_t edge_seq_;
+    bool have_edge_;
+    bool have_offset_;
+    int64_t last_offset_;
+    double jitter_;
+
+    std::atomic<uint64_t> edges_, rmc_, ubx_, bad_, invalid_, unpaired_, sent_, send_failed_;
+    std::atomic<uint64_t> acks_, ack_failed_;         // SDK callback thread
+    std::atomic<int64_t> last_utc_;
+    std::atomic<int64_t> offset_ns_;
+    std::atomic<uint64_t> jitter_ns_;
+    std::atomic<uint64_t> last_send_ns_;              // CLOCK_MONOTONIC of the last SDK call
+    std::atomic<uint64_t> send_edge_rt_;              // PPS edge of the sentence handed on, 0 = none
+    LatencyHistogram edge_to_send_;                   // issuing thread
+    LatencyHistogram send_to_ack_;                    // SDK callback thread
+};
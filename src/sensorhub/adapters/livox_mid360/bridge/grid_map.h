@@ -0,0 +1,370 @@
+// Livox MID-360 Bridge - rolling 2D grid map (ground / height / occupancy) with tile deltas
+//
+// GridMap keeps a square window of tiles x tiles tiles (16 x 16 cells each, bridge_frame.h)
+// centred on the vehicle. Points are placed in a map frame where the vehicle stands at
+// pose (x, y, yaw), set by the grid_pose command (default: the scans' own frame). Tiles are
+// stored by their map coordinates modulo the window (a torus), so when the vehicle moves
+// only the tiles that leave the window are cleared; nothing is copied.
+//
+// Every scan updates the map incrementally. Points are moved into the map frame
+// (point_transform.h) and binned into cell indices and z in cm, 8 at a time with AVX2 or
+// 4 with NEON; points outside the window or the [z_min, z_max] band are skipped. Each
+// cell's per-scan min / max z are then merged into the layers:
+//   ground_cm  lowest z seen while the cell stays in the window
+//   height_cm  highest z of the latest scan that saw the cell (moves by > kHeightStepCm)
+//   occupancy  + kHit for a scan with a point more than obstacle_m above the ground,
+//              - kMiss for a scan that saw only ground (saturating 0..255)
+// A tile whose layers changed is dirty; take_dirty() writes the dirty tiles (and tiles
+// that left the window, flagged cleared) as BridgeGridTile records and resets them, so
+// each delta carries changes only. Sized once by configure(); not thread-safe.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "point_transform.h"
+
+struct GridMapConfig {
+    float cell_m;          // cell edge
+    float size_m;          // window edge, rounded up to a power-of-two number of tiles
+    float obstacle_m;      // above the cell's ground: occupied
+    float z_min;           // map-frame height band; points outside it are ignored
+    float z_max;
+
+    GridMapConfig() : cell_m(0.2f), size_m(51.2f), obstacle_m(0.3f), z_min(-10.0f), z_max(2.0f) {}
+};
+
+class GridMap {
+public:
+    static const size_t kTile = kBridgeGridTileCells;
+    static const size_t kTileCells = kTile * kTile;
+    static const uint8_t kHit = 64;
+    static const uint8_t kMiss = 16;
+    static const int kHeightStepCm = 5;
+
+    GridMap()
+        : tiles_(0), tile_shift_(0), cell_mm_(0), inv_cell_(0), obstacle_cm_(0), ox_(0), oy_(0),
+          gen_(0), scans_(0), published_(0) {}
+
+    // Size the window; false for a nonsensical configuration.
+    bool configure(const GridMapConfig& cfg) {
+        if (!(cfg.cell_m >= 0.01f && cfg.cell_m <= 65.0f) || !(cfg.size_m > 0) || !(cfg.z_max > cfg.z_min))
+            return false;
+        const double tiles = std::ceil(cfg.size_m / (cfg.cell_m * kTile));
+        tiles_ = 1;
+        tile_shift_ = 0;
+        while (tiles_ < tiles && tiles_ < 256) { tiles_ <<= 1; ++tile_shift_; }
+        cfg_ = cfg;
+        cell_mm_ = (uint16_t)std::lround(cfg.cell_m * 1000.0f);
+        inv_cell_ = 1.0f / cfg.cell_m;
+        obstacle_cm_ = (int)std::lround(cfg.obstacle_m * 100.0f);
+        const size_t slots = tiles_ * tiles_, cells = slots * kTileCells;
+        ground_.assign(cells, kBridgeGridUnknown);
+        height_.assign(cells, kBridgeGridUnknown);
+        occ_.assign(cells, 0);
+        smin_.assign(cells, 0);
+        smax_.assign(cells, 0);
+        sgen_.assign(cells, 0);
+        touched_.clear();
+        touched_.reserve(cells);
+        slot_tx_.assign(slots, 0);
+        slot_ty_.assign(slots, 0);
+        known_.assign(slots, 0);
+        dirty_.assign(slots, 0);
+        dirty_list_.clear();
+        dirty_list_.reserve(slots);
+        cleared_.clear();
+        cleared_.reserve(slots);
+        T_ = mat34_identity();
+        set_window(-(int32_t)(tiles_ / 2), -(int32_t)(tiles_ / 2));
+        for (size_t s = 0; s < slots; ++s) {
+            slot_tx_[s] = window_tx(s);
+            slot_ty_[s] = window_ty(s);
+        }
+        return true;
+    }
+
+    bool enabled() const { return tiles_ != 0; }
+
+    // Vehicle pose in the map frame (m, degrees). Tiles that leave the window are cleared
+    // and queued for the next take_dirty().
+    void set_pose(double x, double y, double yaw_deg) {
+        const double yaw = yaw_deg * 3.14159265358979323846 / 180.0;
+        const float c = (float)std::cos(yaw), s = (float)std::sin(yaw);
+        Mat34 T = {{c, -s, 0, (float)x,  s, c, 0, (float)y,  0, 0, 1, 0}};
+        T_ = T;
+        const int32_t cx = (int32_t)std::floor(x * inv_cell_), cy = (int32_t)std::floor(y * inv_cell_);
+        set_window(floor_div(cx, (int32_t)kTile) - (int32_t)(tiles_ / 2),
+                   floor_div(cy, (int32_t)kTile) - (int32_t)(tiles_ / 2));
+        const size_t slots = tiles_ * tiles_;
+        for (size_t sl = 0; sl < slots; ++sl) {
+            const int32_t tx = window_tx(sl), ty = window_ty(sl);
+            if (tx == slot_tx_[sl] && ty == slot_ty_[sl]) continue;
+            if (known_[sl]) {
+                cleared_.push_back(TileCoord(slot_tx_[sl], slot_ty_[sl]));
+                reset_slot(sl);
+            }
+            slot_tx_[sl] = tx;
+            slot_ty_[sl] = ty;
+        }
+    }
+
+    // Queue every tile holding data, for a consumer that starts from nothing.
+    void mark_all() {
+        for (size_t sl = 0; sl < known_.size(); ++sl)
+            if (known_[sl]) mark_dirty(sl);
+    }
+
+    // Merge one scan (points in the scans' frame) into the map.
+    void update(const BridgePoint* pts, size_t n) {
+        if (!enabled()) return;
+        if (++gen_ == 0) {   // generation wrapped: forget stale marks
+            std::fill(sgen_.begin(), sgen_.end(), 0);
+            gen_ = 1;
+        }
+        touched_.clear();
+        const size_t kBlock = 128;
+        float x[kBlock], y[kBlock], z[kBlock];
+        int32_t idx[kBlock];
+        int16_t zc[kBlock];
+        const bool move = !mat34_is_identity(T_);
+        for (size_t base = 0; base < n; base += kBlock) {
+            const size_t cnt = (n - base < kBlock) ? n - base : kBlock;
+            const BridgePoint* p = pts + base;
+            for (size_t i = 0; i < cnt; ++i) { x[i] = p[i].x; y[i] = p[i].y; z[i] = p[i].z; }
+            if (move) transform_xyz(x, y, z, cnt, T_);
+            bin(x, y, z, cnt, idx, zc);
+            for (size_t i = 0; i < cnt; ++i) {
+                const int32_t c = idx[i];
+                if (c < 0) continue;
+                if (sgen_[c] != gen_) {
+                    sgen_[c] = gen_;
+                    smin_[c] = smax_[c] = zc[i];
+                    touched_.push_back((uint32_t)c);
+                }
+                else if (zc[i] < smin_[c]) smin_[c] = zc[i];
+                else if (zc[i] > smax_[c]) smax_[c] = zc[i];
+            }
+        }
+        for (size_t k = 0; k < touched_.size(); ++k) merge(touched_[k]);
+        ++scans_;
+    }
+
+    // Write up to max pending tiles (cleared first, then dirty) to out and reset them;
+    // returns the number written. Call until it returns less than max.
+    size_t take_dirty(BridgeGridTile* out, size_t max) {
+        size_t n = 0;
+        while (n < max && !cleared_.empty()) {
+            BridgeGridTile& t = out[n++];
+            std::memset(&t, 0, sizeof(t));
+            t.tx = cleared_.back().tx;
+            t.ty = cleared_.back().ty;
+            t.cell_mm = cell_mm_;
+            t.flags = kBridgeGridTileCleared;
+            for (size_t i = 0; i < kTileCells; ++i) t.ground_cm[i] = t.height_cm[i] = kBridgeGridUnknown;
+            cleared_.pop_back();
+        }
+        while (n < max && !dirty_list_.empty()) {
+            const uint32_t sl = dirty_list_.back();
+            dirty_list_.pop_back();
+            dirty_[sl] = 0;
+            BridgeGridTile& t = out[n++];
+            t.tx = slot_tx_[sl];
+            t.ty = slot_ty_[sl];
+            t.cell_mm = cell_mm_;
+            t.flags = 0;
+            t.reserved = 0;
+            const size_t c0 = (size_t)sl * kTileCells;
+            std::memcpy(t.ground_cm, &ground_[c0], sizeof(t.ground_cm));
+            std::memcpy(t.height_cm, &height_[c0], sizeof(t.height_cm));
+            std::memcpy(t.occupancy, &occ_[c0], sizeof(t.occupancy));
+        }
+        published_ += n;
+        return n;
+    }
+
+    size_t pending() const { return cleared_.size() + dirty_list_.size(); }
+    size_t tiles_per_side() const { return tiles_; }
+    size_t cells_per_side() const { return tiles_ * kTile; }
+    const GridMapConfig& config() const { return cfg_; }
+    uint64_t scans() const { return scans_; }
+    uint64_t published() const { return published_; }
+
+private:
+    struct TileCoord {
+        int32_t tx, ty;
+        TileCoord(int32_t x, int32_t y) : tx(x), ty(y) {}
+    };
+
+    static int32_t floor_div(int32_t a, int32_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+    // Window [ox_, ox_ + tiles) x [oy_, oy_ + tiles) in tile coordinates.
+    void set_window(int32_t ox, int32_t oy) { ox_ = ox; oy_ = oy; }
+
+    // Tile of the current window stored in slot sl.
+    int32_t window_tx(size_t sl) const {
+        const int32_t m = (int32_t)tiles_ - 1, sx = (int32_t)(sl & (size_t)m);
+        return ox_ + ((sx - ox_) & m);
+    }
+    int32_t window_ty(size_t sl) const {
+        const int32_t m = (int32_t)tiles_ - 1, sy = (int32_t)(sl >> tile_shift_);
+        return oy_ + ((sy - oy_) & m);
+    }
+
+    // Cell index (slot * 256 + row * 16 + column) and z (cm) per point, -1 when outside
+    // the window or the height band.
+    void bin(const float* x, const float* y, const float* z, size_t n, int32_t* idx, int16_t* zc) const {
+        const int32_t cx0 = ox_ * (int32_t)kTile, cy0 = oy_ * (int32_t)kTile;
+        const int32_t cells = (int32_t)(tiles_ * kTile), tmask = (int32_t)tiles_ - 1;
+        const int shift = (int)tile_shift_;
+        const float zlo = cfg_.z_min, zhi = cfg_.z_max;
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256 inv = _mm256_set1_ps(inv_cell_), lo = _mm256_set1_ps(zlo), hi = _mm256_set1_ps(zhi);
+        const __m256 cm = _mm256_set1_ps(100.0f);
+        const __m256i vcx0 = _mm256_set1_epi32(cx0), vcy0 = _mm256_set1_epi32(cy0);
+        const __m256i vcells = _mm256_set1_epi32(cells), vneg = _mm256_set1_epi32(-1);
+        const __m256i v15 = _mm256_set1_epi32(15), vtmask = _mm256_set1_epi32(tmask);
+        for (; i + 8 <= n; i += 8) {
+            const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+            const __m256i fx = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_mul_ps(px, inv)));
+            const __m256i fy = _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_mul_ps(py, inv)));
+            const __m256i dx = _mm256_sub_epi32(fx, vcx0), dy = _mm256_sub_epi32(fy, vcy0);
+            // 0 <= d < cells (out-of-range floats convert to INT_MIN: rejected)
+            __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi32(dx, vneg), _mm256_cmpgt_epi32(vcells, dx));
+            ok = _mm256_and_si256(ok, _mm256_and_si256(_mm256_cmpgt_epi32(dy, vneg), _mm256_cmpgt_epi32(vcells, dy)));
+            const __m256 band = _mm256_and_ps(_mm256_cmp_ps(pz, lo, _CMP_GE_OQ), _mm256_cmp_ps(pz, hi, _CMP_LE_OQ));
+            ok = _mm256_and_si256(ok, _mm256_castps_si256(band));
+            const __m256i sx = _mm256_and_si256(_mm256_srai_epi32(fx, 4), vtmask);
+            const __m256i sy = _mm256_and_si256(_mm256_srai_epi32(fy, 4), vtmask);
+            const __m256i slot = _mm256_add_epi32(_mm256_sll_epi32(sy, _mm_cvtsi32_si128(shift)), sx);
+            const __m256i in = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(fy, v15), 4), _mm256_and_si256(fx, v15));
+            const __m256i c = _mm256_add_epi32(_mm256_slli_epi32(slot, 8), in);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(idx + i), _mm256_blendv_epi8(vneg, c, ok));
+            // the band keeps z within int16 cm for any sane z_min / z_max
+            const __m256i zi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(pz, lo), hi), cm));
+            const __m128i z16 = _mm_packs_epi32(_mm256_castsi256_si128(zi), _mm256_extracti128_si256(zi, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(zc + i), z16);
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        const float32x4_t inv = vdupq_n_f32(inv_cell_), lo = vdupq_n_f32(zlo), hi = vdupq_n_f32(zhi);
+        const float32x4_t cm = vdupq_n_f32(100.0f);
+        const int32x4_t vcx0 = vdupq_n_s32(cx0), vcy0 = vdupq_n_s32(cy0);
+        const uint32x4_t vcells = vdupq_n_u32((uint32_t)cells);
+        const int32x4_t v15 = vdupq_n_s32(15), vtmask = vdupq_n_s32(tmask), vneg = vdupq_n_s32(-1);
+        const int32x4_t vshift = vdupq_n_s32(shift);
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+            // vcvtmq rounds toward minus infinity (floor)
+#if defined(__aarch64__)
+            const int32x4_t fx = vcvtmq_s32_f32(vmulq_f32(px, inv)), fy = vcvtmq_s32_f32(vmulq_f32(py, inv));
+#else
+            const float32x4_t sxf = vmulq_f32(px, inv), syf = vmulq_f32(py, inv);
+            int32x4_t fx = vcvtq_s32_f32(sxf), fy = vcvtq_s32_f32(syf);
+            fx = vsubq_s32(fx, vreinterpretq_s32_u32(vandq_u32(vcltq_f32(sxf, vcvtq_f32_s32(fx)), vdupq_n_u32(1))));
+            fy = vsubq_s32(fy, vreinterpretq_s32_u32(vandq_u32(vcltq_f32(syf, vcvtq_f32_s32(fy)), vdupq_n_u32(1))));
+#endif
+            // unsigned compare: negative offsets wrap past cells
+            const uint32x4_t dx = vreinterpretq_u32_s32(vsubq_s32(fx, vcx0));
+            const uint32x4_t dy = vreinterpretq_u32_s32(vsubq_s32(fy, vcy0));
+            uint32x4_t ok = vandq_u32(vcltq_u32(dx, vcells), vcltq_u32(dy, vcells));
+            ok = vandq_u32(ok, vandq_u32(vcgeq_f32(pz, lo), vcleq_f32(pz, hi)));
+            const int32x4_t sx = vandq_s32(vshrq_n_s32(fx, 4), vtmask);
+            const int32x4_t sy = vandq_s32(vshrq_n_s32(fy, 4), vtmask);
+            const int32x4_t slot = vaddq_s32(vshlq_s32(sy, vshift), sx);
+            const int32x4_t in = vaddq_s32(vshlq_n_s32(vandq_s32(fy, v15), 4), vandq_s32(fx, v15));
+            const int32x4_t c = vaddq_s32(vshlq_n_s32(slot, 8), in);
+            vst1q_s32(idx + i, vbslq_s32(ok, c, vneg));
+            const float32x4_t zf = vmulq_f32(vminq_f32(vmaxq_f32(pz, lo), hi), cm);
+#if defined(__aarch64__)
+            const int32x4_t zi = vcvtnq_s32_f32(zf);
+#else
+            // no round-to-nearest conversion: +-0.5 then truncate (ties away from zero)
+            const uint32x4_t neg = vcltq_f32(zf, vdupq_n_f32(0.0f));
+            const int32x4_t zi = vcvtq_s32_f32(vaddq_f32(zf, vbslq_f32(neg, vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f))));
+#endif
+            vst1_s16(zc + i, vqmovn_s32(zi));
+        }
+#endif
+        for (; i < n; ++i) {
+            idx[i] = -1;
+            const float fxf = std::floor(x[i] * inv_cell_), fyf = std::floor(y[i] * inv_cell_);
+            if (!(z[i] >= zlo && z[i] <= zhi) || !(std::fabs(fxf) < 2e9f) || !(std::fabs(fyf) < 2e9f)) continue;
+            const int32_t fx = (int32_t)fxf, fy = (int32_t)fyf;
+            if ((uint32_t)(fx - cx0) >= (uint32_t)cells || (uint32_t)(fy - cy0) >= (uint32_t)cells) continue;
+            const int32_t slot = (((fy >> 4) & tmask) << shift) + ((fx >> 4) & tmask);
+            idx[i] = (slot << 8) + ((fy & 15) << 4) + (fx & 15);
+            zc[i] = (int16_t)std::lrint(z[i] * 100.0f);   // nearest even, as the vector conversions
+        }
+    }
+
+    // Fold cell c's scan min / max into its layers.
+    void merge(uint32_t c) {
+        const int16_t lo = smin_[c], hi = smax_[c];
+        const int16_t g = ground_[c] == kBridgeGridUnknown || lo < ground_[c] ? lo : ground_[c];
+        bool changed = g != ground_[c];
+        ground_[c] = g;
+        if (height_[c] == kBridgeGridUnknown || std::abs((int)hi - (int)height_[c]) > kHeightStepCm) {
+            height_[c] = hi;
+            changed = true;
+        }
+        const uint8_t o = occ_[c];
+        const uint8_t o2 = (int)hi - (int)g > obstacle_cm_ ? (o > 255 - kHit ? 255 : o + kHit)
+                                                            : (o < kMiss ? 0 : o - kMiss);
+        if (o2 != o) {
+            occ_[c] = o2;
+            changed = true;
+        }
+        if (changed) {
+            const uint32_t sl = c / kTileCells;
+            known_[sl] = 1;
+            mark_dirty(sl);
+        }
+    }
+
+    void mark_dirty(size_t sl) {
+        if (dirty_[sl]) return;
+        dirty_[sl] = 1;
+        dirty_list_.push_back((uint32_t)sl);
+    }
+
+    void reset_slot(size_t sl) {
+        const size_t c0 = sl * kTileCells;
+        std::fill(ground_.begin() + c0, ground_.begin() + c0 + kTileCells, kBridgeGridUnknown);
+        std::fill(height_.begin() + c0, height_.begin() + c0 + kTileCells, kBridgeGridUnknown);
+        std::fill(occ_.begin() + c0, occ_.begin() + c0 + kTileCells, 0);
+        known_[sl] = 0;
+        if (dirty_[sl]) {
+            dirty_[sl] = 0;
+            for (size_t k = 0; k < dirty_list_.size(); ++k)
+                if (dirty_list_[k] == sl) { dirty_list_[k] = dirty_list_.back(); dirty_list_.pop_back(); break; }
+        }
+    }
+
+    GridMapConfig cfg_;
+    size_t tiles_;               // per side, a power of two
+    size_t tile_shift_;          // log2(tiles_)
+    uint16_t cell_mm_;
+    float inv_cell_;
+    int obstacle_cm_;
+    Mat34 T_;                    // scans' frame -> map frame
+    int32_t ox_, oy_;            // window origin tile
+    std::vector<int16_t> ground_, height_;   // per cell, tile-major (slot * 256 + row * 16 + col)
+    std::vector<uint8_t> occ_;
+    std::vector<int16_t> smin_, smax_;       // this scan's z range per cell, valid when sgen_ == gen_
+    std::vector<uint32_t> sgen_;
+    uint32_t gen_;
+    std::vector<uint32_t> touched_;          // cells seen by this scan
+    std::vector<int32_t> slot_tx_, slot_ty_; // tile held by each slot
+    std::vector<uint8_t> known_, dirty_;     // per slot
+    std::vector<uint32_t> dirty_list_;
+    std::vector<TileCoord> cleared_;         // tiles that left the window, not yet sent
+    uint64_t scans_;
+    uint64_t published_;
+};
@@ -0,0 +1,179 @@
+// Livox MID-360 Bridge - per-device IMU history, batching and preintegration
+//
+// ImuChannel keeps the last kHistory samples of one device (stamped on the mapped host
+// clock, see clock_sync.h). Samples not yet emitted form the pending batch; the whole
+// history backs preintegrate(), which integrates gyro/accelerometer over a time interval
+// (normally one scan) into a delta rotation, velocity and position:
+//   q  <- q * exp(w dt),  dv <- dv + R(q) a dt,  dp <- dp + dv dt + 1/2 R(q) a dt^2
+// starting from identity / zero velocity. Accelerations are specific force (gravity is
+// not removed), as usual for preintegration. Each sample is held until the next one
+// (at most kMaxHoldNs), and the interval is clipped to the samples available.
+// rotation_knots() integrates the gyro alone the same way and samples the orientation on a
+// regular grid, for scan deskew (scan_deskew.h).
+// Not thread-safe; the emitter owns all channels.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "bridge_frame.h"
+#include "point_transform.h"
+
+class ImuChannel {
+public:
+    static const size_t kHistory = 1024;                 // ~5 s at 200 Hz
+    static const uint64_t kMaxHoldNs = 20000000ull;      // gap longer than 4 samples: stop
+
+    ImuChannel() : head_(0), size_(0), pending_(0), first_pending_host_ns_(0) {}
+
+    void add(const BridgeImuSample& s, uint64_t host_ns) {
+        ring_[head_] = s;
+        head_ = (head_ + 1) % kHistory;
+        if (size_ < kHistory) ++size_;
+        if (pending_ == 0) first_pending_host_ns_ = host_ns;
+        if (pending_ < kHistory) ++pending_;
+    }
+
+    size_t pending() const { return pending_; }
+    uint64_t first_pending_host_ns() const { return first_pending_host_ns_; }
+
+    // Copy the pending samples (oldest first, at most max) and mark them emitted.
+    size_t take_pending(BridgeImuSample* out, size_t max) {
+        const size_t n = pending_ < max ? pending_ : max;
+        const size_t first = (head_ + kHistory - pending_) % kHistory;
+        for (size_t i = 0; i < n; ++i) out[i] = ring_[(first + i) % kHistory];
+        pending_ -= n;
+        if (pending_) first_pending_host_ns_ = 0;   // remainder is already overdue
+        return n;
+    }
+
+    // Integrate over [t0, t1] (mapped host ns). T, if given, rotates the samples into a
+    // common frame (translation is irrelevant to rates). False if no sample overlaps.
+    bool preintegrate(uint64_t t0, uint64_t t1, const Mat34* T, BridgeImuPreint* out) const {
+        double q[4] = {1, 0, 0, 0};
+        double v[3] = {0, 0, 0}, p[3] = {0, 0, 0};
+        uint32_t used = 0;
+        uint64_t first_ns = 0, last_ns = 0;
+        const size_t oldest = (head_ + kHistory - size_) % kHistory;
+        for (size_t k = 0; k < size_; ++k) {
+            const BridgeImuSample& s = ring_[(oldest + k) % kHistory];
+            uint64_t s_end = s.stamp_ns + kMaxHoldNs;
+            if (k + 1 < size_) {
+                const uint64_t next = ring_[(oldest + k + 1) % kHistory].stamp_ns;
+                if (next > s.stamp_ns && next < s_end) s_end = next;
+            }
+            const uint64_t a = s.stamp_ns > t0 ? s.stamp_ns : t0;
+            const uint64_t b = s_end < t1 ? s_end : t1;
+            if (b <= a) continue;
+            if (!used) first_ns = a;
+            last_ns = b;
+            ++used;
+
+            double w[3] = {s.gx, s.gy, s.gz};
+            double f[3] = {s.ax * kGravity, s.ay * kGravity, s.az * kGravity};
+            if (T) { rotate(T->m, w); rotate(T->m, f); }
+            step(q, v, p, w, f, (double)(b - a) * 1e-9);
+        }
+        if (!used) return false;
+        out->samples = used;
+        out->start_ns = first_ns;
+        out->end_ns = last_ns;
+        for (int i = 0; i < 4; ++i) out->dq[i] = (float)q[i];
+        for (int i = 0; i < 3; ++i) { out->dv[i] = (float)v[i]; out->dp[i] = (float)p[i]; }
+        return true;
+    }
+
+    // Orientation at t0 + k * step_ns relative to t0, for k < n, into q[k] (w, x, y, z).
+    // Time no sample covers counts as no rotation. T as in preintegrate(). Returns the
+    // covered time in ns (0: no sample overlaps and every q[k] is identity).
+    uint64_t rotation_knots(uint64_t t0, uint64_t step_ns, size_t n, const Mat34* T, double (*q)[4]) const {
+        double cur_q[4] = {1, 0, 0, 0};
+        const uint64_t t1 = t0 + (uint64_t)(n ? n - 1 : 0) * step_ns;
+        uint64_t covered = 0;
+        size_t k = 0;
+        const size_t oldest = (head_ + kHistory - size_) % kHistory;
+        for (size_t j = 0; j < size_ && k < n; ++j) {
+            const BridgeImuSample& s = ring_[(oldest + j) % kHistory];
+            uint64_t s_end = s.stamp_ns + kMaxHoldNs;
+            if (j + 1 < size_) {
+                const uint64_t next = ring_[(oldest + j + 1) % kHistory].stamp_ns;
+                if (next > s.stamp_ns && next < s_end) s_end = next;
+            }
+            const uint64_t a = s.stamp_ns > t0 ? s.stamp_ns : t0;
+            const uint64_t b = s_end < t1 ? s_end : t1;
+            if (b <= a) continue;
+            covered += b - a;
+            // knots in the gap before this sample keep the orientation reached so far
+            for (; k < n && t0 + k * step_ns <= a; ++k) copy_q(cur_q, q[k]);
+            double w[3] = {s.gx, s.gy, s.gz};
+            if (T) rotate(T->m, w);
+            uint64_t t = a;
+            for (; k < n && t0 + k * step_ns <= b; ++k) {
+                const uint64_t tk = t0 + k * step_ns;
+                q_step(cur_q, w, (double)(tk - t) * 1e-9);
+                copy_q(cur_q, q[k]);
+                t = tk;
+            }
+            q_step(cur_q, w, (double)(b - t) * 1e-9);
+        }
+        for (; k < n; ++k) copy_q(cur_q, q[k]);
+        return covered;
+    }
+
+private:
+    static constexpr double kGravity = 9.80665;   // SDK accelerometer reports g
+
+    static void rotate(const float* m, double* x) {
+        const double r0 = m[0] * x[0] + m[1] * x[1] + m[2] * x[2];
+        const double r1 = m[4] * x[0] + m[5] * x[1] + m[6] * x[2];
+        const double r2 = m[8] * x[0] + m[9] * x[1] + m[10] * x[2];
+        x[0] = r0; x[1] = r1; x[2] = r2;
+    }
+
+    // Rotate body vector by unit quaternion q (w, x, y, z).
+    static void q_rotate(const double* q, const double* x, double* out) {
+        const double w = q[0], a = q[1], b = q[2], c = q[3];
+        out[0] = (1 - 2 * (b * b + c * c)) * x[0] + 2 * (a * b - w * c) * x[1] + 2 * (a * c + w * b) * x[2];
+        out[1] = 2 * (a * b + w * c) * x[0] + (1 - 2 * (a * a + c * c)) * x[1] + 2 * (b * c - w * a) * x[2];
+        out[2] = 2 * (a * c - w * b) * x[0] + 2 * (b * c + w * a) * x[1] + (1 - 2 * (a * a + b * b)) * x[2];
+    }
+
+    static void copy_q(const double* from, double* to) { for (int i = 0; i < 4; ++i) to[i] = from[i]; }
+
+    static void step(double* q, double* v, double* p, const double* w, const double* f, double dt) {
+        double fw[3];
+        q_rotate(q, f, fw);
+        for (int i = 0; i < 3; ++i) {
+            p[i] += v[i] * dt + 0.5 * fw[i] * dt * dt;
+            v[i] += fw[i] * dt;
+        }
+        q_step(q, w, dt);
+    }
+
+    // q <- q * exp(w dt)
+    static void q_step(double* q, const double* w, double dt) {
+        const double th = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * dt;
+        double e[4];
+        if (th > 1e-9) {
+            const double s = std::sin(th * 0.5) * dt / th;
+            e[0] = std::cos(th * 0.5); e[1] = w[0] * s; e[2] = w[1] * s; e[3] = w[2] * s;
+        }
+        else {
+            e[0] = 1; e[1] = w[0] * dt * 0.5; e[2] = w[1] * dt * 0.5; e[3] = w[2] * dt * 0.5;
+        }
+        const double r0 = q[0] * e[0] - q[1] * e[1] - q[2] * e[2] - q[3] * e[3];
+        const double r1 = q[0] * e[1] + q[1] * e[0] + q[2] * e[3] - q[3] * e[2];
+        const double r2 = q[0] * e[2] - q[1] * e[3] + q[2] * e[0] + q[3] * e[1];
+        const double r3 = q[0] * e[3] + q[1] * e[2] - q[2] * e[1] + q[3] * e[0];
+        const double nrm = 1.0 / std::sqrt(r0 * r0 + r1 * r1 + r2 * r2 + r3 * r3);
+        q[0] = r0 * nrm; q[1] = r1 * nrm; q[2] = r2 * nrm; q[3] = r3 * nrm;
+    }
+
+    BridgeImuSample ring_[kHistory];
+    size_t head_;
+    size_t size_;
+    size_t pending_;
+    uint64_t first_pending_host_ns_;
+};
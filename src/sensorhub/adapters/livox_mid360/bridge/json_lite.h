@@ -0,0 +1,197 @@
+// Livox MID-360 Bridge - minimal zero-allocation JSON reader
+//
+// Works directly on a [begin, end) character range: values are spans into the input,
+// nothing is copied or allocated. Enough for the SDK config file and control commands;
+// not a validating parser (numbers and escapes are checked only as far as needed to skip
+// over them safely).
+//
+//   JsonValue root;
+//   if (json_parse(buf, buf + len, &root) && root.type == kJsonObject) {
+//       JsonValue v;
+//       if (json_find(root, "lidar_configs", &v)) ...
+//       JsonIter it(root); JsonValue key, val;
+//       while (it.next(&key, &val)) ...
+//   }
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+enum JsonType {
+    kJsonInvalid = 0,
+    kJsonObject,
+    kJsonArray,
+    kJsonString,    // span excludes the quotes, escapes left in place
+    kJsonNumber,
+    kJsonTrue,
+    kJsonFalse,
+    kJsonNull,
+};
+
+struct JsonValue {
+    const char* begin;
+    const char* end;
+    JsonType type;
+
+    size_t size() const { return (size_t)(end - begin); }
+    // Exact comparison for strings without escapes (keys, command names)
+    bool equals(const char* s) const {
+        const size_t n = std::strlen(s);
+        return type == kJsonString && size() == n && std::memcmp(begin, s, n) == 0;
+    }
+};
+
+static inline const char* json_skip_ws(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    return p;
+}
+
+// Parse one value starting at *pp; on success *pp points just past it.
+static inline bool json_parse_value(const char** pp, const char* end, JsonValue* out, int depth = 0) {
+    const char* p = json_skip_ws(*pp, end);
+    if (p >= end || depth > 32) return false;
+    const char c = *p;
+    if (c == '"') {
+        const char* q = p + 1;
+        while (q < end && *q != '"') q += (*q == '\\') ? 2 : 1;
+        if (q >= end) return false;
+        out->begin = p + 1;
+        out->end = q;
+        out->type = kJsonString;
+        *pp = q + 1;
+        return true;
+    }
+    if (c == '{' || c == '[') {
+        const char close = (c == '{') ? '}' : ']';
+        const char* q = json_skip_ws(p + 1, end);
+        if (q < end && *q == close) {
+            out->begin = p; out->end = q + 1;
+            out->type = (c == '{') ? kJsonObject : kJsonArray;
+            *pp = q + 1;
+            return true;
+        }
+        for (;;) {
+            JsonValue tmp;
+            if (c == '{') {
+                if (!json_parse_value(&q, end, &tmp, depth + 1) || tmp.type != kJsonString) return false;
+                q = json_skip_ws(q, end);
+                if (q >= end || *q != ':') return false;
+                ++q;
+            }
+            if (!json_parse_value(&q, end, &tmp, depth + 1)) return false;
+            q = json_skip_ws(q, end);
+            if (q >= end) return false;
+            if (*q == ',') { ++q; continue; }
+            if (*q != close) return false;
+            out->begin = p; out->end = q + 1;
+            out->type = (c == '{') ? kJsonObject : kJsonArray;
+            *pp = q + 1;
+            return true;
+        }
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        const char* q = p + 1;
+        while (q < end && (std::strchr("0123456789+-.eE", *q) != NULL) && *q) ++q;
+        out->begin = p; out->end = q; out->type = kJsonNumber;
+        *pp = q;
+        return true;
+    }
+    struct Lit { const char* s; size_t n; JsonType t; };
+    static const Lit lits[] = { {"true", 4, kJsonTrue}, {"false", 5, kJsonFalse}, {"null", 4, kJsonNull} };
+    for (size_t i = 0; i < 3; ++i) {
+        if ((size_t)(end - p) >= lits[i].n && std::memcmp(p, lits[i].s, lits[i].n) == 0) {
+            out->begin = p; out->end = p + lits[i].n; out->type = lits[i].t;
+            *pp = p + lits[i].n;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool json_parse(const char* begin, const char* end, JsonValue* out) {
+    const char* p = begin;
+    return json_parse_value(&p, end, out);
+}
+
+// Iterates the members of an object (key, value) or the elements of an array (value only).
+class JsonIter {
+public:
+    explicit JsonIter(const JsonValue& container)
+        : p_(container.begin + 1), end_(container.end - 1), is_object_(container.type == kJsonObject),
+          ok_(container.type == kJsonObject || container.type == kJsonArray) {}
+
+    bool next(JsonValue* key, JsonValue* val) {
+        if (!ok_) return false;
+        p_ = json_skip_ws(p_, end_);
+        if (p_ >= end_) return false;
+        if (is_object_) {
+            if (!json_parse_value(&p_, end_, key)) return (ok_ = false);
+            p_ = json_skip_ws(p_, end_);
+            if (p_ >= end_ || *p_ != ':') return (ok_ = false);
+            ++p_;
+        }
+        if (!json_parse_value(&p_, end_, val)) return (ok_ = false);
+        p_ = json_skip_ws(p_, end_);
+        if (p_ < end_ && *p_ == ',') ++p_;
+        return true;
+    }
+
+    bool next(JsonValue* val) {
+        JsonValue key;
+        return next(&key, val);
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    bool is_object_;
+    bool ok_;
+};
+
+static inline bool json_find(const JsonValue& obj, const char* key, JsonValue* out) {
+    if (obj.type != kJsonObject) return false;
+    JsonIter it(obj);
+    JsonValue k, v;
+    while (it.next(&k, &v)) {
+        if (k.equals(key)) { *out = v; return true; }
+    }
+    return false;
+}
+
+static inline double json_number(const JsonValue& v, double defv) {
+    if (v.type != kJsonNumber) return defv;
+    char tmp[64];
+    const size_t n = v.size() < sizeof(tmp) - 1 ? v.size() : sizeof(tmp) - 1;
+    std::memcpy(tmp, v.begin, n);
+    tmp[n] = '\0';
+    char* e = NULL;
+    const double d = std::strtod(tmp, &e);
+    return (e != tmp) ? d : defv;
+}
+
+static inline double json_find_number(const JsonValue& obj, const char* key, double defv) {
+    JsonValue v;
+    return json_find(obj, key, &v) ? json_number(v, defv) : defv;
+}
+
+// Copy a string value into buf (NUL-terminated, truncated), resolving simple escapes.
+static inline size_t json_string(const JsonValue& v, char* buf, size_t cap) {
+    if (cap == 0) return 0;
+    size_t n = 0;
+    if (v.type == kJsonString) {
+        for (const char* p = v.begin; p < v.end && n + 1 < cap; ++p) {
+            char c = *p;
+            if (c == '\\' && p + 1 < v.end) {
+                c = *++p;
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+                else if (c == 'r') c = '\r';
+            }
+            buf[n++] = c;
+        }
+    }
+    buf[n] = '\0';
+    return n;
+}
@@ -3,13 +3,135 @@
 //
 // Environment variables:
 //   MID360_CONFIG_PATH : path to SDK2 config JSON (lidar_type: 8)
-//   LIVOX_UDP_PORT     : UDP port to emit NDJSON frames (default 18080)
+//   LIVOX_UDP_PORT     : UDP port to emit NDJSON frames (default 18080, 0 = no UDP output)
+//   LIVOX_UDP_ADDR     : destination address of that output, unicast or multicast (default 127.0.0.1)
+//   LIVOX_MCAST_TTL    : multicast TTL (default 1 = local subnet)
+//   LIVOX_MCAST_IF     : local interface address for multicast output (default: routing table)
+//   LIVOX_SUB_TTL_S    : subscription lease, renewed by every subscribe (default 30, 0 = no expiry)
+//   LIVOX_BACKPRESSURE : "0" turns off per-subscriber backpressure (default on, see backpressure.h):
+//                        a subscriber with send errors or reported lag ({"cmd":"lag"}) gets
+//                        voxel-downsampled scans, then only every Nth scan, until it catches up
+//   LIVOX_BP_WINDOW_MS : backpressure evaluation window (default 500)
+//   LIVOX_BP_RECOVER   : clean windows before a subscriber steps back up a level (default 6)
+//   LIVOX_BP_VOXEL_M   : voxel edge of downsampled scans (m, default 0.2)
+//   LIVOX_BP_SHED      : shed subscribers get every Nth scan / range image (default 4)
 //   LIVOX_CTL_PORT     : UDP port to receive JSON control commands (default 18181)
+//   LIVOX_CMD_TIMEOUT_MS: device commands: ack timeout per SDK request (default 1000)
+//   LIVOX_CMD_RETRIES  : device commands: re-issues of a timed-out request (default 2,
+//                        see command_tracker.h)
+//   LIVOX_STATE_FILE   : warm restart: keep devices, the config applied to them, subscribers
+//                        and the frame seq in this file and restore them at startup
+//                        (default off, see bridge_state.h)
 //   LIVOX_BRIDGE_STDOUT: if "1", also print NDJSON to stdout
+//   LIVOX_BRIDGE_FORMAT: "ndjson" (default), "binary" for point clouds (see bridge_frame.h) or
+//                        "compressed": binary, with scans as compressed blocks (see scan_codec.h)
+//   LIVOX_CODEC        : scan compression, "lz4", "zstd" or "none" (default: lz4 if built in)
+//   LIVOX_CODEC_LEVEL  : zstd level / LZ4 acceleration (default 1)
+//   LIVOX_CODEC_SLOTS  : scans in flight to the compression thread (default 4)
+//   LIVOX_SHM_NAME     : if set, also publish every record into /dev/shm/<name> (see shm_ring.h)
+//   LIVOX_SHM_SLOTS    : shared-memory ring slot count (default 256)
+//   LIVOX_SHM_SLOT_BYTES: shared-memory ring slot size in bytes (default 65536)
+//   LIVOX_SHM_RESUME   : if "1" (default), continue an existing ring of the same geometry, so
+//                        readers see no gap across a restart ("0" = always start a fresh ring)
+//   LIVOX_FRAME_MS     : assemble packets into scans over this window (default 100, 0 = per packet)
+//   LIVOX_FRAME_SPLIT_CNT: if "1" (default), also close a scan when the SDK frame_cnt changes
+//   LIVOX_FRAME_MAX_POINTS: preallocated points per scan buffer (default 65536)
+//   LIVOX_UDP_FLUSH_US : batch UDP records for at most this long (default 1000, 0 = one sendto each)
+//   LIVOX_UDP_BATCH    : datagrams per sendmmsg batch (default 32)
+//   LIVOX_UDP_MTU      : datagram payload size for packing and binary fragments (default: path
+//                        MTU - 28, at most 1472)
+//   LIVOX_UDP_LOOPBACK : if "1", all UDP consumers are on this host: 65507 B datagrams by default
+//   LIVOX_EMIT_CPU     : pin the emitter thread to this CPU (default: unpinned)
+//   LIVOX_EMIT_PRIO    : run the emitter thread SCHED_FIFO at this priority (default: normal)
+//   LIVOX_EMIT_IDLE_US : emitter sleep when all queues are empty (default 100)
+//   LIVOX_QUEUE_DEPTH  : point-packet queue slots between SDK callbacks and emitter (default 4096)
+//   LIVOX_RT           : if "1", real-time memory: mlockall, prefaulted scan pool and emitter
+//                        stack, no heap trimming (see buffer_pool.h)
+//   LIVOX_POOL_BLOCKS  : scan pool blocks (default: one per device assembler + LIVOX_CODEC_SLOTS)
+//   LIVOX_HUGEPAGES    : if "1", back the scan pool with 2 MB hugepages when the kernel has them
+//   LIVOX_STATS_MS     : period of the {"type":"stats"} record (default 1000, 0 = off;
+//                        LIVOX_QUEUE_STATS_MS is accepted as an alias)
+//   LIVOX_FUSION       : if "1", merge all devices into one scan in the common frame, using the
+//                        extrinsic_parameter of each lidar_configs entry in MID360_CONFIG_PATH
+//   LIVOX_EXTRINSICS   : if "1", apply those extrinsics to per-device scans as well
+//   LIVOX_FILTER_RANGE_MIN / LIVOX_FILTER_RANGE_MAX: drop scan points closer / farther (m, default off)
+//   LIVOX_FILTER_ROI   : "xmin,ymin,zmin,xmax,ymax,zmax" (m) crop box applied to scans (default off)
+//   LIVOX_FILTER_NOISE : scan assembly: drop returns the device tags as noise, 0 = off (default),
+//                        1 high, 2 high + moderate, 3 any noise confidence (see point_columns.h)
+//   LIVOX_FILTER_ZERO  : if "1" (scan assembly), drop zero returns (x = y = z = 0)
+//   LIVOX_POINT_LAYOUT : binary scans as "rows" (default, BridgePoint records) or "columns"
+//                        (x[], y[], z[], t_offset_ns[], reflectivity[], tag[], see bridge_frame.h)
+//   LIVOX_VOXEL_M      : voxel-grid downsample scans at this edge length (m, default 0 = off)
+//   LIVOX_CLOCK_WINDOW_MS: device->host clock fit window (default 1000, see clock_sync.h)
+//   LIVOX_CLOCK_TRUST_SYNC: if "1", map gPTP/GPS-stamped packets with a fixed offset instead of the fit
+//   LIVOX_CLOCK_SYNC_OFFSET_NS: that fixed offset (default 0; e.g. -37000000000 for a TAI grandmaster)
+//   LIVOX_GNSS_DEVICE  : GNSS time sync: serial port of a receiver sending NMEA RMC or UBX NAV-PVT /
+//                        NAV-TIMEUTC; its time goes to every lidar as RMC (default off, see gnss_time.h)
+//   LIVOX_GNSS_BAUD    : that port's baud rate (default 9600)
+//   LIVOX_GNSS_PPS     : the receiver's PPS as a kernel PPS device (e.g. /dev/pps0): the RMC is sent
+//                        on each pulse instead of when the message arrives
+//   LIVOX_IMU_BATCH    : binary format only: send IMU as batches of up to N samples (msg 3)
+//                        instead of one NDJSON record per sample (default 0 = NDJSON)
+//   LIVOX_IMU_BATCH_MS : flush a partial IMU batch after this long (default 20)
+//   LIVOX_IMU_PREINT   : if "1" (binary format, scan assembly), follow every scan with its
+//                        preintegrated IMU (msg 4, see imu_channel.h)
+//   LIVOX_DESKEW       : if "1" (scan assembly), rotate every scan's points into the sensor frame
+//                        at the scan start using the device's gyro (see scan_deskew.h)
+//   LIVOX_DESKEW_STEP_US: orientation knot spacing for that (default 1000)
+//   LIVOX_GRID         : if "1" (scan assembly), keep a rolling ground / height / occupancy grid
+//                        map from the scans and send its changed tiles (msg 6, see grid_map.h)
+//   LIVOX_GRID_CELL_M  : grid cell edge (m, default 0.2)
+//   LIVOX_GRID_SIZE_M  : grid window edge, rounded up to a power-of-two tile count (m, default 51.2)
+//   LIVOX_GRID_OBSTACLE_M: height above a cell's ground that marks it occupied (m, default 0.3)
+//   LIVOX_GRID_Z_MIN / LIVOX_GRID_Z_MAX: map-frame height band binned into the grid (m, default -10 / 2)
+//   LIVOX_RANGE_IMAGE  : "<height>x<width>" (scan assembly), e.g. "64x1024": project every scan into
+//                        a spherical range / intensity image and send it (msg 8, see range_image.h)
+//   LIVOX_RANGE_FOV    : "<down>,<up>" vertical field of view of that image (deg, default -7,52)
+//   LIVOX_RANGE_GPU    : "0" projects on the CPU even in a CUDA build (default 1)
+//   LIVOX_RECORD_DIR   : record the session into <dir>/livox_<time>.lvxr (see recorder.h)
+//   LIVOX_RECORD_CHUNK_MB: recording chunk size (default 64)
+//   LIVOX_SOURCE       : input, "sdk" (default), "replay" or "synthetic" (see bridge_source.h);
+//                        builds without the SDK (LIVOX_BRIDGE_NO_SDK) default to "synthetic"
+//   LIVOX_REPLAY       : replay this .lvxr file instead of opening the SDK (implies "replay")
+//   LIVOX_REPLAY_SPEED : replay rate, 1 = real time (default), N = N x, 0 = as fast as possible
+//   LIVOX_REPLAY_LOOP  : if "1", restart the replay at the end instead of exiting
+//   LIVOX_SYNTH_DEVICES: synthetic source: simulated lidars (default 1, see synthetic_source.h)
+//   LIVOX_SYNTH_PPS    : points/s per device (default 200000, 0 = as fast as the queues drain)
+//   LIVOX_SYNTH_POINTS : points per packet (default 96)
+//   LIVOX_SYNTH_FORMAT : SDK point data type, 1 cartesian high (default), 2 low, 3 spherical
+//   LIVOX_SYNTH_IMU_HZ : IMU rate per device (default 200, 0 = off)
+//   LIVOX_SYNTH_PACKETS: stop after this many packets per device (default 0 = run until stopped)
+//   LIVOX_SYNTH_PTP    : if "1", stamp packets as gPTP with host CLOCK_REALTIME
+//
+// Command line (overrides the matching variables):
+//   livox_bridge [--source <sdk|replay|synthetic>] [--record <dir>]
+//                [--replay <file.lvxr> [--speed <x>] [--loop]]
+//
+// Timestamps: records carry the packet's device time mapped to host CLOCK_REALTIME
+// (ts_us / stamp_ns); scan points carry per-point offsets from the SDK time_interval.
+//
+// Threads: SDK callbacks only copy into per-callback SPSC queues; the emitter thread does
+// all assembly, serialization and I/O, so a slow consumer never stalls SDK reception. The
+// main thread is an epoll reactor over the control socket, a signalfd (SIGINT/SIGTERM) and
+// the stats / frame-timeout timerfds; it hands work to the emitter through g_q_ctl.
+// GNSS time sync (LIVOX_GNSS_DEVICE) has a thread of its own that reads the receiver and
+// hands each RMC sentence to the emitter through g_q_gnss; only the emitter issues SDK commands.
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <errno.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <unistd.h>
 
@@ -20,185 +142,1749 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
-// Livox SDK2 headers (your copies)
-#include "livox_lidar_api.h"   // SDK entry points & controls
-#include "livox_lidar_def.h"   // types, enums, packet structs
+// Livox SDK2 headers (your copies), or their stand-in for LIVOX_BRIDGE_NO_SDK builds
+#include "livox_sdk_compat.h"
+
+#include "bridge_frame.h"      // binary point-cloud wire format
+#include "bridge_transport.h"  // UDP / shm / stdout output, shared with rplidar_bridge
+#include "shm_ring.h"          // shared-memory ring transport
+#include "frame_assembler.h"   // packets -> scans
+#include "udp_batcher.h"       // MTU packing + sendmmsg
+#include "spsc_queue.h"        // SDK callbacks -> emitter thread
+#include "device_registry.h"   // lock-free handle table
+#include "extrinsics.h"        // lidar_configs extrinsic_parameter -> Mat34
+#include "scan_filter.h"       // range / ROI / voxel stage on assembled scans
+#include "point_columns.h"     // SoA blocks, noise / zero-return drop
+#include "clock_sync.h"        // device clock -> host CLOCK_REALTIME
+#include "bridge_stats.h"      // counters + latency histograms
+#include "imu_channel.h"       // IMU batching + preintegration
+#include "scan_deskew.h"       // IMU motion compensation of scans
+#include "command_dispatch.h"  // control command parsing
+#include "recorder.h"          // .lvxr session recording
+#include "bridge_source.h"     // input sources: SDK, replay, synthetic
+#include "replay_source.h"
+#include "synthetic_source.h"
+#include "subscriptions.h"     // per-consumer streams, formats, decimation
+#include "scan_codec.h"        // compressed scans (msg 5)
+#include "codec_worker.h"      // scan compression thread
+#include "buffer_pool.h"       // preallocated scan buffers
+#include "grid_map.h"          // rolling ground / height / occupancy grid (msg 6)
+#include "command_tracker.h"   // in-flight device requests, timeouts, retries
+#include "bridge_state.h"      // warm-restart device / subscriber cache
+#include "gnss_time.h"         // GNSS RMC / PPS time sync
+#include "range_image.h"       // spherical range images (msg 8)
+#include "backpressure.h"      // per-subscriber adaptive decimation
 
 using namespace std::chrono;
 
-static std::atomic<bool> g_running(true);
-static int g_udp_sock = -1;
-static sockaddr_in g_udp_dst;
-static uint16_t g_emit_port = 18080;
+static std::atomic<bool> g_emitter_running(true);
 static uint16_t g_ctl_port = 18181;
-static bool g_emit_stdout = false;
 
-static std::vector<uint32_t> g_handles;   // device handles observed via callbacks
-static std::mutex g_handles_mtx;
+// Output transports: the default route (LIVOX_UDP_ADDR:LIVOX_UDP_PORT, shm, stdout) and the
+// subscribers, emitter thread only (the binary seq may be read anywhere). Consumer masks:
+// bit 0 is the default route, bit 1 + i subscriber slot i, which is also its batcher lane.
+static BridgeTransport g_out;
+static SubscriberTable& g_subs = g_out.subs();
+static uint64_t g_sub_ttl_ns = 30000000000ull;
+
+// Backpressure levels of the subscribers; downsampled scans are voxelized into the scratch
+// scan, sized at startup for the largest scan (emitter thread only)
+static BackpressurePolicy g_backpressure;
+static ScanFilter g_bp_filter;
+static std::vector<BridgePoint> g_bp_scan;
+static const uint32_t kRouteDefault = BridgeTransport::kRouteDefault;
+
+// Scan compression for kEncCompressed consumers; jobs are claimed and collected by the emitter
+static CodecWorker g_codec;
+
+// Scan-sized buffers: per-device assembler buffers and the scans in flight to g_codec.
+// LIVOX_RT locks all memory and prefaults, so the steady state neither mallocs nor faults.
+static BufferPool g_scan_pool;
+static bool g_rt = false;
+static const size_t kRtStackBytes = 256u << 10;   // emitter stack prefaulted in RT mode
+
+// Scan assembly: one assembler per device handle (emitter thread only)
+static const size_t kMaxLidars = 8;
+static uint64_t g_frame_window_ns = 100000000ull;
+static bool g_frame_split_cnt = true;
+static size_t g_frame_max_points = 65536;
+static uint32_t g_asm_handles[kMaxLidars];
+static FrameAssembler* g_assemblers[kMaxLidars];
+static size_t g_n_assemblers = 0;
+
+// Extrinsics / fusion. The per-handle transform is resolved lazily through the device
+// registry (handle -> IP -> config entry) and cached; NULL means identity (emitter thread only).
+static bool g_fusion = false;
+static bool g_apply_extrinsics = false;
+static ExtrinsicTable g_extrinsics;
+static FrameAssembler* g_fused_asm = NULL;
+static uint32_t g_fused_sources = 0;          // bit per g_xforms slot in the open scan
+struct DeviceXform {
+    uint32_t handle;
+    const Mat34* T;
+};
+static DeviceXform g_xforms[kMaxLidars];
+static size_t g_n_xforms = 0;
+
+// Filter stage between assembly and publish (emitter thread only); the noise / zero drop
+// runs earlier, per packet in the assemblers
+static ScanFilter g_filter;
+static PointDropConfig g_point_drop;
+
+// Columnar binary scans (LIVOX_POINT_LAYOUT=columns): each scan is transposed once into the
+// scratch buffer, sized at startup for the largest scan (emitter thread only)
+static bool g_columns = false;
+static std::vector<uint8_t> g_col_scratch;
+
+// Grid map fed by every published scan (LIVOX_GRID); deltas are taken into the tile
+// buffer, sized at startup for the whole window (emitter thread only)
+static GridMap g_grid;
+static std::vector<BridgeGridTile> g_grid_tiles;
+
+// Range image of every published scan (LIVOX_RANGE_IMAGE), sent from the image buffer itself
+static RangeImage g_range;
+static LatencyHistogram g_range_project;     // projection time per scan
+
+// One clock mapper per device handle (emitter thread only)
+static uint64_t g_clock_window_ns = 1000000000ull;
+static bool g_clock_trust_sync = false;
+static int64_t g_clock_sync_offset_ns = 0;
+static uint32_t g_clock_handles[kMaxLidars];
+static ClockMapper g_clocks[kMaxLidars];
+static size_t g_n_clocks = 0;
+
+// IMU batching / preintegration: one history per device handle (emitter thread only)
+static size_t g_imu_batch = 0;                // samples per binary batch, 0 = NDJSON per sample
+static uint64_t g_imu_batch_ns = 20000000ull;
+static bool g_imu_preint = false;
+static bool g_deskew = false;                 // rotate scans into their start frame (LIVOX_DESKEW)
+static ScanDeskew g_deskewer;
+static uint32_t g_imu_handles[kMaxLidars];
+static ImuChannel* g_imu[kMaxLidars];
+static size_t g_n_imu = 0;
+
+// Recording (emitter thread only)
+static RecordWriter g_recorder;
+static size_t g_record_chunk_bytes = 64u << 20;
+
+// Set before the source is stopped, so a source waiting for queue room gives up
+static std::atomic<bool> g_source_stopping(false);
+
+// ---- SDK callback -> emitter events ----
+// Each SDK callback type gets its own queue so every queue has exactly one producer
+// (the SDK thread delivering that callback) and one consumer (the emitter thread).
+enum BridgeEventKind { kEvPoints, kEvImu, kEvInfo, kEvAck, kEvGetStats, kEvCmdReply, kEvStatsTick, kEvFlushTick,
+    kEvSubscribe, kEvUnsubscribe, kEvGridPose, kEvGridSnapshot, kEvDeviceCmd, kEvRestore, kEvLag, kEvGnssRmc };
+
+// {"type":"cmd"} reply status
+enum CmdStatus { kCmdStatusOk, kCmdStatusBadRequest, kCmdStatusUnknown, kCmdStatusBadArgs, kCmdStatusFull };
+
+// subscribe / unsubscribe / lag, parsed by the reactor and applied by the emitter
+struct SubRequest {
+    sockaddr_in dst;
+    uint32_t streams;
+    uint32_t decimate;
+    uint32_t id;                 // unsubscribe, lag: subscriber id, 0 = by dst
+    uint8_t format;              // BridgeEncoding
+    uint64_t lost;               // lag: records the consumer lost so far
+    uint32_t queued;             // lag: its receive queue depth / capacity
+    uint32_t capacity;
+};
+
+// SDK requests a device command issues to every lidar (DeviceCommand::ops)
+enum DeviceOp { kOpWorkMode, kOpScanPattern, kOpFovCfg, kOpFovEnable, kOpImuEnable, kOpImuDisable, kOpRmcTime };
+
+static const char* const kDeviceOpNames[] = {
+    "work_mode", "scan_pattern", "fov_cfg", "fov_enable", "imu_enable", "imu_disable", "rmc_time" };
+
+// set_work_mode / set_pattern_mode / set_fov / set_imu_enable / set_time_sync, parsed by the
+// reactor; the emitter fans it out and keeps it for retries
+struct DeviceCommand {
+    uint8_t  ops[2];
+    uint8_t  n_ops;
+    bool     cached;             // warm-restart restore: each device's values from g_state
+    int32_t  value;              // work mode, scan pattern or FoV enable
+    FovCfg   fov;
+    uint16_t rmc_len;
+    char     rmc[128];
+};
+
+static const size_t kMaxPacketBytes = 1536;   // LivoxLidarEthernetPacket header + points
 
-static uint64_t now_us() {
-    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+struct BridgeEvent {
+    uint8_t  kind;
+    uint32_t handle;
+    uint64_t host_ns;            // callback arrival, CLOCK_MONOTONIC
+    uint64_t host_rt_ns;         // callback arrival, CLOCK_REALTIME (clock mapping)
+    uint64_t enq_ns;             // pushed to the queue, CLOCK_MONOTONIC
+    int32_t  status;             // ack; cmd reply: CmdStatus
+    uint8_t  ret_code;           // ack
+    uint16_t error_key;          // ack
+    uint32_t req_id;             // cmd reply, get_stats, device cmd: client request id (0 = none);
+                                 // ack: request tag (command_tracker.h)
+    char     cmd[24];            // cmd reply, device cmd: command name
+    LivoxLidarInfo info;         // info
+    sockaddr_in reply_to;        // get_stats, subscribe / unsubscribe, device cmd
+    SubRequest sub;              // subscribe / unsubscribe / lag
+    DeviceCommand dev;           // device cmd; gnss rmc: rmc / rmc_len only
+    double   pose[3];            // grid_pose: x, y (m), yaw (deg)
+    uint8_t  pkt[kMaxPacketBytes];
+
+    const LivoxLidarEthernetPacket* packet() const {
+        return reinterpret_cast<const LivoxLidarEthernetPacket*>(pkt);
+    }
+};
+
+static SpscQueue<BridgeEvent>* g_q_points = NULL;
+static SpscQueue<BridgeEvent> g_q_imu(1024);
+static SpscQueue<BridgeEvent> g_q_info(64);
+static SpscQueue<BridgeEvent> g_q_ack(256);
+static SpscQueue<BridgeEvent> g_q_ctl(256);    // reactor -> emitter (replies, get_stats, timer ticks)
+static SpscQueue<BridgeEvent> g_q_gnss(4);     // GNSS thread -> emitter (one RMC sentence a second)
+
+// Device commands in flight, each slot's arguments and sender (emitter thread only)
+static CommandTracker g_cmds;
+static DeviceCommand g_cmd_args[CommandTracker::kMaxCommands];
+static sockaddr_in g_cmd_reply_to[CommandTracker::kMaxCommands];
+
+// Warm-restart state (LIVOX_STATE_FILE): loaded before the emitter starts, then emitter
+// thread only. Saved when it changed, at most once a second, and at shutdown.
+static BridgeState g_state;
+static std::string g_state_path;
+static bool g_state_dirty = false;
+static uint64_t g_state_save_ns = 0;        // earliest next save, CLOCK_MONOTONIC
+static const uint64_t kStateSaveIntervalNs = 1000000000ull;
+static const int kRestoreRetries = 20;      // ~5 s of quarter-timeout backoffs while devices reconnect
+
+static int g_emit_cpu = -1;
+static int g_emit_prio = 0;
+static uint64_t g_emit_idle_us = 100;
+static uint64_t g_stats_ns = 1000000000ull;
+
+// Counters and per-stage latency. Each histogram has a single writer: the point / IMU
+// callback threads own their callback->enqueue histogram, the emitter owns the rest.
+static BridgeCounters g_stats;
+static LatencyHistogram g_lat_device;         // device stamp -> callback (emitter)
+static LatencyHistogram g_lat_cb[2];          // callback -> enqueue: [0] point, [1] IMU callback thread
+static LatencyHistogram g_lat_sent;           // enqueue -> handed to shm/UDP (emitter, g_out.enq_ns)
+static uint64_t g_start_ns = 0;
+
+static DeviceRegistry g_devices;   // registered from InfoChangeCallback, read lock-free
+static GnssTimeSync g_gnss;        // LIVOX_GNSS_DEVICE
+
+static uint64_t now_ns() {
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Consumers of one record of `stream` in encoding `enc`: the default route when it carries
+// that encoding (points in LIVOX_BRIDGE_FORMAT, IMU binary only as batches, the rest NDJSON)
+// plus the subscribers that take it.
+static uint32_t route(BridgeStream stream, uint8_t enc) { return g_out.route(stream, enc, g_imu_batch != 0); }
+
+static unsigned popcount32(uint32_t v) {
+    unsigned n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+}
+
+// Lines are built in stack buffers and passed as spans: nothing on this path allocates.
+static void emit_ndjson(const char* line, size_t len, uint32_t mask) { g_out.ndjson(line, len, mask); }
+static void emit_ndjson(const char* line, uint32_t mask) { emit_ndjson(line, std::strlen(line), mask); }
+
+// Binary frames go to shm/UDP only, fragmented per transport (bridge_transport.h). Returns the seq.
+static uint32_t emit_binary(BridgeFrameHeader h, const void* payload, uint32_t n_points, size_t pt_size,
+    uint32_t mask) {
+    return g_out.binary(h, payload, n_points, pt_size, mask);
+}
+
+// emit_binary for a scan in the columnar layout: the scan is transposed once, and each
+// fragment (cut as for 18-byte records) carries the columns of its own points, so a
+// receiver can use every fragment as it arrives.
+static uint32_t emit_scan_columns(BridgeFrameHeader h, const BridgePoint* pts, uint32_t n_points,
+    uint32_t mask) {
+    static const size_t kPlanes[] = { 4, 4, 4, 4, 1, 1 };     // x, y, z, t_offset_ns, reflectivity, tag
+    if (!mask || (size_t)n_points * kBridgeColumnsPointBytes > g_col_scratch.size()) return 0;
+    h.point_format = kBridgePointXyzrtColumns;
+    columns_pack(pts, n_points, g_col_scratch.data());
+    return g_out.binary_planar(h, g_col_scratch.data(), n_points, kPlanes, 6, mask);
+}
+
+// ---- Emitter-side event handlers ----
+// One record per SDK ack, with the client id of the command it belongs to (0 for the late
+// ack of a command already completed); the tracker then settles the request.
+static void on_ack_event(const BridgeEvent& ev) {
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"ack\",\"id\":%u,\"status\":%d,\"handle\":%u,\"ret_code\":%u,\"error_key\":%u}",
+        g_cmds.client_id(ev.req_id), (int)ev.status, ev.handle, ev.ret_code, ev.error_key);
+    emit_ndjson(buf, route(kStreamInfo, kEncNdjson));
+    g_cmds.ack(ev.req_id, ev.status, ev.ret_code, now_ns());
 }
 
-static void emit_ndjson(const std::string& line) {
-    if (g_udp_sock >= 0) {
-        sendto(g_udp_sock, line.c_str(), (int)line.size(), 0,
-            (struct sockaddr*)&g_udp_dst, sizeof(g_udp_dst));
+static const char* const kCmdStatusNames[] = { "ok", "bad_request", "unknown_command", "bad_args", "full" };
+
+static void emit_cmd_reply(uint32_t id, const char* cmd, int status, uint32_t requests) {
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"cmd\",\"id\":%u,\"cmd\":\"%s\",\"status\":\"%s\",\"requests\":%u}",
+        id, cmd, kCmdStatusNames[status], requests);
+    emit_ndjson(buf, route(kStreamInfo, kEncNdjson));
+}
+
+static void on_cmd_reply_event(const BridgeEvent& ev) { emit_cmd_reply(ev.req_id, ev.cmd, ev.status, ev.handle); }
+
+// The aggregated completion of a device command, once every request is acked, failed or
+// timed out: to the info stream and straight back to the sender. "status" is "ok" when every
+// request succeeded, "failed" when none did, else "partial"; "failures" lists the others.
+static void emit_cmd_done(int slot, const TrackedCommand& c, const CommandTracker& t) {
+    static const char* const kStates[] = { "pending", "retry", "ok", "failed", "timeout" };
+    char buf[8192];
+    int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"cmd_done\",\"id\":%u,\"cmd\":\"%s\",\"status\":\"%s\",\"devices\":%u,"
+        "\"requests\":%u,\"ok\":%u,\"failed\":%u,\"timed_out\":%u,\"retries\":%u,\"elapsed_ms\":%.1f,"
+        "\"failures\":[",
+        c.id, c.name, c.ok == c.requests ? "ok" : (c.ok ? "partial" : "failed"), c.devices, c.requests,
+        c.ok, c.failed, c.timed_out, c.retries, (now_ns() - c.start_ns) / 1e6);
+    bool first = true;
+    t.for_each_request(c, [&](const TrackedRequest& r) {
+        if (r.state == kReqOk || n > (int)sizeof(buf) - 160) return;
+        n += std::snprintf(buf + n, sizeof(buf) - n,
+            "%s{\"handle\":%u,\"op\":\"%s\",\"state\":\"%s\",\"status\":%d,\"ret_code\":%u,\"attempts\":%u}",
+            first ? "" : ",", r.handle, kDeviceOpNames[r.op], kStates[r.state], (int)r.status, r.ret_code,
+            r.attempts);
+        first = false;
+    });
+    n += std::snprintf(buf + n, sizeof(buf) - n, "]}");
+    emit_ndjson(buf, (size_t)n, route(kStreamInfo, kEncNdjson));
+    g_out.reply(g_cmd_reply_to[slot], buf, (size_t)n);
+}
+
+static void format_addr(const sockaddr_in& a, char* buf, size_t cap) {
+    if (!inet_ntop(AF_INET, &a.sin_addr, buf, (socklen_t)cap)) std::snprintf(buf, cap, "?");
+}
+
+// Apply a subscribe / unsubscribe and answer the sender directly (it may not be a consumer yet).
+static void on_subscribe_event(const BridgeEvent& ev) {
+    const SubRequest& r = ev.sub;
+    int status = ev.status;
+    uint32_t id = 0;
+    char addr[INET_ADDRSTRLEN];
+    format_addr(r.dst, addr, sizeof(addr));
+    if (status == kCmdStatusOk && ev.kind == kEvSubscribe) {
+        const uint64_t expires = g_sub_ttl_ns ? now_ns() + g_sub_ttl_ns : 0;
+        const bool renew = g_subs.find(r.dst) >= 0;
+        const int slot = g_out.subscribe(r.dst, r.streams, r.format, r.decimate, expires);
+        if (slot < 0) {
+            status = kCmdStatusFull;
+        }
+        else {
+            id = g_subs.at(slot).id;
+            g_state_dirty = true;
+            if (!renew)
+                std::cerr << "subscriber " << id << ": " << addr << ":" << ntohs(r.dst.sin_port)
+                          << " " << bridge_encoding_name(r.format) << ", streams 0x" << std::hex << r.streams
+                          << std::dec << ", decimate " << r.decimate << std::endl;
+        }
     }
-    if (g_emit_stdout) {
-        std::cout << line << std::endl;
+    else if (status == kCmdStatusOk) {
+        const int slot = r.id ? g_subs.find_id(r.id) : g_subs.find(r.dst);
+        if (slot < 0) {
+            status = kCmdStatusBadArgs;
+        }
+        else {
+            id = g_subs.at(slot).id;
+            g_out.unsubscribe(slot);
+            g_state_dirty = true;
+            std::cerr << "subscriber " << id << ": unsubscribed" << std::endl;
+        }
     }
+    char buf[256];
+    const int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"cmd\",\"id\":%u,\"cmd\":\"%s\",\"status\":\"%s\",\"requests\":0,\"sub\":%u,"
+        "\"ttl_s\":%.0f}",
+        ev.req_id, ev.cmd, kCmdStatusNames[status], id, g_sub_ttl_ns / 1e9);
+    g_out.reply(ev.reply_to, buf, (size_t)n);
 }
 
-static void add_handle(uint32_t h) {
-    std::lock_guard<std::mutex> lk(g_handles_mtx);
-    for (size_t i = 0; i < g_handles.size(); ++i)
-        if (g_handles[i] == h) return;
-    g_handles.push_back(h);
+// A consumer's lag report; unknown subscribers are ignored (the lease may have run out).
+static void on_lag_event(const BridgeEvent& ev) {
+    const SubRequest& r = ev.sub;
+    const int slot = r.id ? g_subs.find_id(r.id) : g_subs.find(r.dst);
+    if (slot >= 0) g_backpressure.report((size_t)slot, g_subs.at(slot).id, r.lost, r.queued, r.capacity);
 }
 
-// ---- SDK2 ack callback ----
-static void ControlAckCallback(livox_status status, uint32_t handle,
-    LivoxLidarAsyncControlResponse* resp, void* /*client_data*/) {
+// A subscriber changed backpressure level: one {"type":"backpressure"} record on the stats
+// stream, so a degraded consumer is visible where its numbers are.
+static void on_backpressure(const BackpressureTransition& t) {
+    std::cerr << "subscriber " << t.sub << ": " << subscriber_level_name(t.from) << " -> "
+              << subscriber_level_name(t.to) << " (" << backpressure_reason_name(t.reason) << ")" << std::endl;
+    const uint32_t mask = route(kStreamStats, kEncNdjson);
+    if (!mask) return;
+    char buf[320];
+    std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"backpressure\",\"ts_us\":%" PRIu64 ",\"sub\":%u,\"from\":\"%s\",\"to\":\"%s\","
+        "\"reason\":\"%s\",\"send_errors\":%" PRIu64 ",\"lost\":%" PRIu64 ",\"queued\":%u,\"capacity\":%u}",
+        realtime_ns() / 1000, t.sub, subscriber_level_name(t.from), subscriber_level_name(t.to),
+        backpressure_reason_name(t.reason), t.send_errors, t.lost, t.queued, t.capacity);
+    emit_ndjson(buf, mask);
+}
+
+static void expire_subscribers(uint64_t t) {
+    g_out.expire(t, [](int slot) {
+        std::cerr << "subscriber " << g_subs.at(slot).id << ": lease expired" << std::endl;
+        g_state_dirty = true;
+    });
+}
+
+static void emit_points_binary(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t host_ns,
+    uint64_t stamp_ns, uint32_t mask) {
+    const size_t pt_size = bridge_point_size(pkt->data_type);
+    if (pt_size == 0 || pkt->data_type > kBridgePointSpherical) return;
+
+    BridgeFrameHeader h;
+    bridge_init_header(&h, kBridgeMsgPoints);
+    h.point_format = pkt->data_type;
+    h.time_type = pkt->time_type;
+    h.handle = handle;
+    h.frame_cnt = pkt->frame_cnt;
+    h.host_ts_ns = host_ns;
+    std::memcpy(&h.device_ts_ns, pkt->timestamp, sizeof(h.device_ts_ns));
+    h.stamp_ns = stamp_ns;
+    emit_binary(h, pkt->data, pkt->dot_num, pt_size, mask);
+}
+
+// Cache slot of a handle's transform; -1 while the device is not registered yet (the
+// point callback can run before InfoChangeCallback) or the table is full.
+static int xform_slot(uint32_t handle) {
+    for (size_t i = 0; i < g_n_xforms; ++i)
+        if (g_xforms[i].handle == handle) return (int)i;
+    const DeviceRegistry::Device* dev = g_devices.at(g_devices.find(handle));
+    if (!dev || g_n_xforms == kMaxLidars) return -1;
+    const Mat34* T = g_extrinsics.find(dev->ip);
+    if (T && mat34_is_identity(*T)) T = NULL;
+    g_xforms[g_n_xforms].handle = handle;
+    g_xforms[g_n_xforms].T = T;
+    return (int)g_n_xforms++;
+}
+
+// IMU history for a handle; NULL once all kMaxLidars slots are taken (or, with create
+// false, if the handle has sent no IMU yet).
+static ImuChannel* imu_for(uint32_t handle, bool create) {
+    for (size_t i = 0; i < g_n_imu; ++i)
+        if (g_imu_handles[i] == handle) return g_imu[i];
+    if (!create || g_n_imu == kMaxLidars) return NULL;
+    ImuChannel* ch = new ImuChannel();
+    g_imu_handles[g_n_imu] = handle;
+    g_imu[g_n_imu++] = ch;
+    return ch;
+}
+
+static void emit_imu_batch(uint32_t handle, ImuChannel& ch) {
+    static BridgeImuSample batch[ImuChannel::kHistory];
+    while (ch.pending()) {
+        const size_t n = ch.take_pending(batch, g_imu_batch);
+        BridgeFrameHeader h;
+        bridge_init_header(&h, kBridgeMsgImu);
+        h.point_format = kBridgeImuSample;
+        h.handle = handle;
+        h.host_ts_ns = now_ns();
+        h.stamp_ns = batch[0].stamp_ns;
+        emit_binary(h, batch, (uint32_t)n, sizeof(BridgeImuSample), route(kStreamImu, kEncBinary));
+    }
+}
+
+// Emitter loop: flush partial batches older than LIVOX_IMU_BATCH_MS.
+static void flush_imu_batches(uint64_t t) {
+    for (size_t i = 0; i < g_n_imu; ++i) {
+        ImuChannel& ch = *g_imu[i];
+        // replayed stamps may run ahead of the clock: only flush batches that are really old
+        if (ch.pending() && t >= ch.first_pending_host_ns() && t - ch.first_pending_host_ns() >= g_imu_batch_ns)
+            emit_imu_batch(g_imu_handles[i], ch);
+    }
+}
+
+// IMU history for a scan and the transform into the scan's frame (*T, NULL = identity). A
+// fused scan uses the IMU of its lowest-slot source device, rotated into the common frame
+// by that device's extrinsic.
+static const ImuChannel* scan_imu(uint32_t handle, uint32_t sources, const Mat34** T) {
+    uint32_t imu_handle = handle;
+    *T = NULL;
+    if (sources) {
+        const int slot = __builtin_ctz(sources);
+        imu_handle = g_xforms[slot].handle;
+        *T = g_xforms[slot].T;
+    }
+    else if (g_apply_extrinsics) {
+        const int slot = xform_slot(handle);
+        if (slot >= 0) *T = g_xforms[slot].T;
+    }
+    return imu_for(imu_handle, false);
+}
+
+// Rotate the scan's points into the sensor frame at its start; false without IMU for it.
+static bool deskew_scan(uint32_t handle, FrameAssembler& fa, uint32_t sources) {
+    const Mat34* T;
+    const ImuChannel* ch = scan_imu(handle, sources, &T);
+    if (!ch || !g_deskewer.prepare(*ch, fa.start_stamp_ns(), fa.end_stamp_ns() - fa.start_stamp_ns(), T))
+        return false;
+    g_deskewer.apply(fa.points(), fa.size());
+    return true;
+}
+
+// Preintegrated IMU over the scan just published as `scan_seq`.
+static void emit_scan_preint(uint32_t handle, const FrameAssembler& fa, uint32_t sources, uint32_t scan_seq,
+    uint32_t mask) {
+    const Mat34* T;
+    const ImuChannel* ch = scan_imu(handle, sources, &T);
+    BridgeImuPreint rec;
+    std::memset(&rec, 0, sizeof(rec));
+    if (!ch || !ch->preintegrate(fa.start_stamp_ns(), fa.end_stamp_ns(), T, &rec)) return;
+    rec.scan_seq = scan_seq;
+
+    BridgeFrameHeader h;
+    bridge_init_header(&h, kBridgeMsgImuPreint);
+    h.point_format = kBridgeImuPreint;
+    h.time_type = fa.time_type();
+    h.handle = handle;
+    h.frame_cnt = fa.frame_cnt();
+    h.flags = sources ? kBridgeFlagFused : 0;
+    h.host_ts_ns = fa.start_host_ns();
+    h.device_ts_ns = fa.start_device_ns();
+    h.stamp_ns = rec.start_ns;
+    emit_binary(h, &rec, 1, sizeof(rec), mask);
+}
+
+// Hand a scan to the compression thread; it goes out from the emitter loop when encoded
+// (emit_compressed). With every slot in flight, or no pool block for the copy, the
+// compressed consumers miss this scan.
+static void submit_compressed(const BridgeFrameHeader& h, const BridgePoint* pts, size_t n, uint32_t mask) {
+    CodecJob* job = g_codec.claim();
+    if (!job) return;
+    BridgePoint* copy = static_cast<BridgePoint*>(g_scan_pool.acquire());
+    if (!copy) {
+        g_codec.no_buffer();
+        return;
+    }
+    std::memcpy(copy, pts, n * sizeof(BridgePoint));
+    job->h = h;
+    job->h.msg_type = kBridgeMsgScanCompressed;
+    job->mask = mask;
+    job->enq_ns = g_out.enq_ns;
+    job->points = copy;
+    job->n_points = n;
+    job->block = copy;
+    g_codec.submit();
+}
+
+// One message per block, each to shm and UDP whole (a block fits a datagram).
+static void emit_compressed(const CodecJob& job) {
+    // subscribers may have left or changed format while the scan was being encoded
+    const uint32_t mask = job.mask & (kRouteDefault | g_subs.format_mask(kEncCompressed));
+    if (!mask) return;
+    const uint64_t enq_ns = g_out.enq_ns;
+    g_out.enq_ns = job.enq_ns;
+    BridgeFrameHeader h = job.h;
+    h.frag_count = (uint16_t)job.blocks.size();
+    for (size_t i = 0; i < job.blocks.size(); ++i) {
+        const CodecBlockRef& b = job.blocks[i];
+        const uint8_t* p = &job.out[b.offset];
+        h.frag_index = (uint16_t)i;
+        h.point_count = b.points;
+        h.payload_len = b.len;
+        if (mask & kRouteDefault) g_out.shm_record(&h, sizeof(h), p, b.len);
+        g_out.udp(mask, &h, sizeof(h), p, b.len);
+    }
+    g_out.sent();
+    g_out.enq_ns = enq_ns;
+}
+
+// Finished codec job: send it and recycle its scan copy.
+static void collect_compressed(const CodecJob& job) {
+    emit_compressed(job);
+    g_scan_pool.release(job.block);
+}
+
+// Send the grid's pending tiles as msg 6 (in messages of up to a window's worth) and a
+// {"type":"grid"} summary to NDJSON consumers. stamp_ns: the scan that changed them, 0 when
+// a command did.
+static void emit_grid_delta(uint32_t handle, uint64_t stamp_ns) {
+    const uint32_t bin_mask = route(kStreamGrid, kEncBinary);
+    const uint32_t json_mask = route(kStreamGrid, kEncNdjson);
+    size_t tiles = 0, cleared = 0;
+    while (g_grid.pending()) {
+        // taken even without consumers: a delta only ever carries changes since the last one
+        const size_t n = g_grid.take_dirty(g_grid_tiles.data(), g_grid_tiles.size());
+        for (size_t i = 0; i < n; ++i) cleared += g_grid_tiles[i].flags & kBridgeGridTileCleared;
+        tiles += n;
+        if (!bin_mask) continue;
+        BridgeFrameHeader h;
+        bridge_init_header(&h, kBridgeMsgGridDelta);
+        h.point_format = kBridgeGridTile;
+        h.handle = handle;
+        h.host_ts_ns = now_ns();
+        h.stamp_ns = stamp_ns;
+        emit_binary(h, g_grid_tiles.data(), (uint32_t)n, sizeof(BridgeGridTile), bin_mask);
+    }
+    if (!json_mask || !tiles) return;
     char buf[256];
     std::snprintf(buf, sizeof(buf),
-        "{\"type\":\"ack\",\"status\":%d,\"handle\":%u,\"ret_code\":%u,\"error_key\":%u}",
-        (int)status, handle, resp ? resp->ret_code : 255, resp ? resp->error_key : 0);
-    emit_ndjson(buf);
+        "{\"type\":\"grid\",\"ts_us\":%" PRIu64 ",\"handle\":%u,\"tiles\":%zu,\"cleared\":%zu,"
+        "\"cell_m\":%.3f,\"tiles_per_side\":%zu}",
+        stamp_ns / 1000, handle, tiles, cleared, g_grid.config().cell_m, g_grid.tiles_per_side());
+    emit_ndjson(buf, json_mask);
 }
 
-// ---- Point cloud callback (Ethernet packet) ----
-static void PointCloudCallback(const uint32_t handle, const uint8_t /*dev_type*/,
-    LivoxLidarEthernetPacket* pkt, void* /*client_data*/) {
-    if (!pkt) return;
-    add_handle(handle);
+// Project a scan into the range image and send it as msg 8, rows as records: a fragment
+// that carries the whole image points straight at it (CUDA: the pinned buffer the kernel
+// wrote), smaller ones are repacked. NDJSON consumers get a {"type":"range_image"} summary.
+static void emit_range_image(uint32_t handle, const FrameAssembler& fa, uint8_t flags) {
+    const uint32_t bin_mask = route(kStreamRange, kEncBinary);
+    const uint32_t json_mask = route(kStreamRange, kEncNdjson);
+    if (!(bin_mask | json_mask)) return;
+    const uint64_t t0 = now_ns();
+    g_range.project(fa.points(), fa.size());
+    g_range_project.record(now_ns() - t0);
+    uint32_t seq = 0;
+    if (bin_mask) {
+        BridgeFrameHeader h;
+        bridge_init_header(&h, kBridgeMsgRangeImage);
+        h.point_format = kBridgeRangeImageRows;
+        h.time_type = fa.time_type();
+        h.handle = handle;
+        h.frame_cnt = fa.frame_cnt();
+        h.flags = flags;
+        h.host_ts_ns = fa.start_host_ns();
+        h.device_ts_ns = fa.start_device_ns();
+        h.stamp_ns = fa.start_stamp_ns();
+        // rows as planes: all ranges, then all intensities
+        const size_t planes[2] = { g_range.width() * sizeof(float), g_range.width() };
+        seq = g_out.binary_planar(h, g_range.data(), g_range.height(), planes, 2, bin_mask);
+    }
+    if (!json_mask) return;
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"range_image\",\"ts_us\":%" PRIu64 ",\"handle\":%u,\"seq\":%u,\"height\":%u,"
+        "\"width\":%u,\"fov_up_deg\":%.2f,\"fov_down_deg\":%.2f,\"filled\":%zu}",
+        fa.start_stamp_ns() / 1000, handle, seq, g_range.height(), g_range.width(),
+        g_range.config().fov_up_deg, g_range.config().fov_down_deg, g_range.filled());
+    emit_ndjson(buf, json_mask);
+}
+
+// Binary / compressed copies of one scan (pts: fa's points, or a downsampled version of
+// them) with its preintegrated IMU.
+static void emit_scan(uint32_t handle, const FrameAssembler& fa, const BridgePoint* pts, size_t n,
+    uint8_t flags, uint32_t sources, uint32_t bin_mask, uint32_t z_mask) {
+    if (!(bin_mask | z_mask)) return;
+    BridgeFrameHeader h;
+    bridge_init_header(&h, kBridgeMsgScan);
+    h.point_format = kBridgePointXyzrt;
+    h.time_type = fa.time_type();
+    h.handle = handle;
+    h.frame_cnt = fa.frame_cnt();
+    h.flags = flags;
+    h.reserved = (uint16_t)(fa.packets() > 0xFFFF ? 0xFFFF : fa.packets());
+    h.host_ts_ns = fa.start_host_ns();
+    h.device_ts_ns = fa.start_device_ns();
+    h.stamp_ns = fa.start_stamp_ns();
+    uint32_t seq = g_columns ? emit_scan_columns(h, pts, (uint32_t)n, bin_mask)
+                             : emit_binary(h, pts, (uint32_t)n, sizeof(BridgePoint), bin_mask);
+    if (z_mask) {
+        // the compressed copy is the same scan, so it keeps the seq
+        h.seq = bin_mask ? seq : g_out.next_seq();
+        seq = h.seq;
+        submit_compressed(h, pts, n, z_mask);
+    }
+    if (g_imu_preint) emit_scan_preint(handle, fa, sources, seq, bin_mask | z_mask);
+}
+
+static void publish_scan(uint32_t handle, FrameAssembler& fa, uint32_t sources = 0) {
+    const bool fused = (sources != 0);
+    const size_t raw = fa.size();
+    // deskew first: the filter's ROI and voxels then see the corrected geometry
+    const bool deskewed = g_deskew && deskew_scan(handle, fa, sources);
+    if (g_filter.enabled()) fa.truncate(g_filter.apply(fa.points(), fa.size()));
+    BridgeCounters::inc(g_stats.scans);
+    BridgeCounters::inc(g_stats.points_out, fa.size());
+    // one serialization per encoding that has a consumer, and per backpressure variant
+    const uint32_t bin_mask = route(kStreamPoints, kEncBinary);
+    const uint32_t z_mask = route(kStreamPoints, kEncCompressed);
+    const uint32_t json_mask = route(kStreamPoints, kEncNdjson);
+    const uint32_t reduced = g_bp_scan.empty() ? 0 : g_subs.level_mask(kSubDownsampled);
+    const uint8_t flags = (uint8_t)((fused ? kBridgeFlagFused : 0) | (deskewed ? kBridgeFlagDeskewed : 0));
+    emit_scan(handle, fa, fa.points(), fa.size(), flags, sources, bin_mask & ~reduced, z_mask & ~reduced);
+    if ((bin_mask | z_mask) & reduced) {
+        std::memcpy(g_bp_scan.data(), fa.points(), fa.size() * sizeof(BridgePoint));
+        const size_t n = g_bp_filter.apply(g_bp_scan.data(), fa.size());
+        emit_scan(handle, fa, g_bp_scan.data(), n, (uint8_t)(flags | kBridgeFlagDownsampled), sources,
+            bin_mask & reduced, z_mask & reduced);
+    }
+    if (g_grid.enabled()) {
+        g_grid.update(fa.points(), fa.size());
+        emit_grid_delta(handle, fa.start_stamp_ns());
+    }
+    if (g_range.enabled()) emit_range_image(handle, fa, flags);
+    if (!json_mask) return;
+    char buf[256];
+    int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"scan\",\"ts_us\":%" PRIu64 ",\"handle\":%u,\"n_points\":%u,"
+        "\"packets\":%u,\"seq\":%u",
+        fa.start_stamp_ns() / 1000, handle, (unsigned)fa.size(), fa.packets(), fa.frame_cnt());
+    if (g_filter.enabled()) n += std::snprintf(buf + n, sizeof(buf) - n, ",\"raw_points\":%u", (unsigned)raw);
+    if (deskewed) n += std::snprintf(buf + n, sizeof(buf) - n, ",\"deskewed\":true");
+    if (fused) std::snprintf(buf + n, sizeof(buf) - n, ",\"fused\":true,\"devices\":%u}", popcount32(sources));
+    else       std::snprintf(buf + n, sizeof(buf) - n, "}");
+    emit_ndjson(buf, json_mask);
+}
+
+static void on_fused_points(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t host_ns,
+    uint64_t stamp_ns) {
+    const int slot = xform_slot(handle);
+    if (slot < 0) return;   // cannot place it in the common frame yet
+    FrameAssembler* fa = g_fused_asm;
+    if (fa->should_close(pkt, host_ns)) {
+        publish_scan(kBridgeFusedHandle, *fa, g_fused_sources);
+        fa->reset();
+        g_fused_sources = 0;
+    }
+    fa->add(pkt, host_ns, stamp_ns, g_xforms[slot].T);
+    g_fused_sources |= 1u << slot;
+}
+
+// Find (or create) the assembler for a handle; NULL once all kMaxLidars slots are taken.
+static FrameAssembler* assembler_for(uint32_t handle) {
+    for (size_t i = 0; i < g_n_assemblers; ++i)
+        if (g_asm_handles[i] == handle) return g_assemblers[i];
+    if (g_n_assemblers == kMaxLidars) return NULL;
+    // without a pool block (pool exhausted, counted) the assembler allocates its own
+    BridgePoint* buf = g_scan_pool.is_open() ? static_cast<BridgePoint*>(g_scan_pool.acquire()) : NULL;
+    FrameAssembler* fa = new FrameAssembler(g_frame_max_points, buf);
+    fa->configure(g_frame_window_ns, g_frame_split_cnt);
+    fa->set_drop(g_point_drop);
+    g_asm_handles[g_n_assemblers] = handle;
+    g_assemblers[g_n_assemblers++] = fa;
+    return fa;
+}
+
+// Clock mapper for a handle; NULL once all kMaxLidars slots are taken.
+static ClockMapper* clock_for(uint32_t handle) {
+    for (size_t i = 0; i < g_n_clocks; ++i)
+        if (g_clock_handles[i] == handle) return &g_clocks[i];
+    if (g_n_clocks == kMaxLidars) return NULL;
+    ClockMapper* c = &g_clocks[g_n_clocks];
+    c->configure(g_clock_window_ns, g_clock_trust_sync, g_clock_sync_offset_ns);
+    g_clock_handles[g_n_clocks++] = handle;
+    return c;
+}
+
+// Feed the packet to its device's clock fit and return its device time on the host clock.
+static uint64_t packet_stamp(const BridgeEvent& ev) {
+    const LivoxLidarEthernetPacket* pkt = ev.packet();
+    uint64_t dev_ns;
+    std::memcpy(&dev_ns, pkt->timestamp, sizeof(dev_ns));
+    ClockMapper* c = clock_for(ev.handle);
+    if (!c) return ev.host_rt_ns;
+    c->observe(dev_ns, ev.host_rt_ns, pkt->time_type);
+    const uint64_t stamp = c->map(dev_ns, pkt->time_type);
+    if (ev.host_rt_ns > stamp) g_lat_device.record(ev.host_rt_ns - stamp);
+    return stamp;
+}
+
+static void on_points_event(const BridgeEvent& ev) {
+    const uint32_t handle = ev.handle;
+    const LivoxLidarEthernetPacket* pkt = ev.packet();
+    const uint64_t stamp = packet_stamp(ev);
+    if (g_fused_asm) {
+        on_fused_points(handle, pkt, ev.host_ns, stamp);
+        return;
+    }
+    if (g_frame_window_ns) {
+        if (FrameAssembler* fa = assembler_for(handle)) {
+            const uint64_t t = ev.host_ns;
+            if (fa->should_close(pkt, t)) {
+                publish_scan(handle, *fa);
+                fa->reset();
+            }
+            const int slot = g_apply_extrinsics ? xform_slot(handle) : -1;
+            fa->add(pkt, t, stamp, slot >= 0 ? g_xforms[slot].T : NULL);
+            return;
+        }
+    }
+    // per-packet points are never compressed: compressed consumers get them binary
+    if (const uint32_t mask = route(kStreamPoints, kEncBinary) | route(kStreamPoints, kEncCompressed))
+        emit_points_binary(handle, pkt, ev.host_ns, stamp, mask);
+    const uint32_t mask = route(kStreamPoints, kEncNdjson);
+    if (!mask) return;
     char buf[256];
-    uint64_t ts_us = now_us();
+    uint64_t ts_us = stamp / 1000;
     std::snprintf(buf, sizeof(buf),
         "{\"type\":\"frame\",\"ts_us\":%" PRIu64 ",\"handle\":%u,\"n_points\":%u,"
         "\"data_type\":%u,\"seq\":%u}",
         ts_us, handle, pkt->dot_num, pkt->data_type, pkt->frame_cnt);
-    emit_ndjson(buf);
+    emit_ndjson(buf, mask);
 }
 
-// ---- IMU callback (Ethernet packet carrying LivoxLidarImuRawPoint) ----
-static void ImuCallback(const uint32_t handle, const uint8_t /*dev_type*/,
-    LivoxLidarEthernetPacket* pkt, void* /*client_data*/) {
-    if (!pkt) return;
-    add_handle(handle);
+// Publish scans open for at least `timeout` at time t.
+static void flush_scans(uint64_t t, uint64_t timeout) {
+    if (g_fused_asm) {
+        if (g_fused_asm->expired(t, timeout)) {
+            publish_scan(kBridgeFusedHandle, *g_fused_asm, g_fused_sources);
+            g_fused_asm->reset();
+            g_fused_sources = 0;
+        }
+        return;
+    }
+    for (size_t i = 0; i < g_n_assemblers; ++i) {
+        FrameAssembler& fa = *g_assemblers[i];
+        if (fa.expired(t, timeout)) {
+            publish_scan(g_asm_handles[i], fa);
+            fa.reset();
+        }
+    }
+}
+
+// Frame-timeout tick: publish scans left open for 1.5 windows. Normally a scan is closed
+// by the next packet; this only fires when a device goes quiet, and the extra half window
+// keeps it from splitting scans whose packets are still queued behind the tick.
+static void flush_stale_scans(uint64_t t) {
+    flush_scans(t, g_frame_window_ns + g_frame_window_ns / 2);
+}
+
+static void on_imu_event(const BridgeEvent& ev) {
+    const uint32_t handle = ev.handle;
+    const LivoxLidarEthernetPacket* pkt = ev.packet();
     if (pkt->length >= sizeof(LivoxLidarImuRawPoint)) {
         const LivoxLidarImuRawPoint* imu =
             reinterpret_cast<const LivoxLidarImuRawPoint*>(pkt->data);
+        const uint64_t stamp = packet_stamp(ev);
+        if (g_imu_batch || g_imu_preint || g_deskew) {
+            if (ImuChannel* ch = imu_for(handle, true)) {
+                BridgeImuSample s;
+                s.stamp_ns = stamp;
+                s.gx = imu->gyro_x; s.gy = imu->gyro_y; s.gz = imu->gyro_z;
+                s.ax = imu->acc_x; s.ay = imu->acc_y; s.az = imu->acc_z;
+                ch->add(s, ev.host_ns);
+                if (g_imu_batch && ch->pending() >= g_imu_batch) emit_imu_batch(handle, *ch);
+            }
+        }
+        // NDJSON samples for the consumers not taking batches
+        const uint32_t mask = route(kStreamImu, kEncNdjson);
+        if (!mask) return;
         char buf[256];
-        uint64_t ts_us = now_us();
+        uint64_t ts_us = stamp / 1000;
         std::snprintf(buf, sizeof(buf),
             "{\"type\":\"imu\",\"ts_us\":%" PRIu64 ",\"handle\":%u,"
             "\"ax\":%.6f,\"ay\":%.6f,\"az\":%.6f,\"gx\":%.6f,\"gy\":%.6f,\"gz\":%.6f}",
             ts_us, handle, imu->acc_x, imu->acc_y, imu->acc_z,
             imu->gyro_x, imu->gyro_y, imu->gyro_z);
-        emit_ndjson(buf);
+        emit_ndjson(buf, mask);
     }
 }
 
-// ---- Info change callback (dev_type/SN/IP) ----
-static void InfoChangeCallback(const uint32_t handle, const LivoxLidarInfo* info, void* /*client_data*/) {
-    add_handle(handle);
-    if (!info) return;
+static void on_info_event(const BridgeEvent& ev) {
     char buf[256];
     std::snprintf(buf, sizeof(buf),
         "{\"type\":\"info\",\"handle\":%u,\"dev_type\":%u,\"sn\":\"%.*s\",\"ip\":\"%.*s\"}",
-        handle, info->dev_type, 16, info->sn, 16, info->lidar_ip);
-    emit_ndjson(buf);
+        ev.handle, ev.info.dev_type, 16, ev.info.sn, 16, ev.info.lidar_ip);
+    emit_ndjson(buf, route(kStreamInfo, kEncNdjson));
 }
 
-// ---- Minimal JSON helpers (replace with rapidjson in prod) ----
-static std::string find_str(const std::string& s, const std::string& key) {
-    size_t p = s.find(key); if (p == std::string::npos) return "";
-    p = s.find(':', p);     if (p == std::string::npos) return "";
-    size_t q = s.find('\"', p + 1); if (q == std::string::npos) return "";
-    size_t r = s.find('\"', q + 1); if (r == std::string::npos) return "";
-    return s.substr(q + 1, r - q - 1);
+// Percentiles since the last periodic stats record; `advance` moves that baseline. Sections
+// that do not fit in cap are left out and the record is marked "truncated" (StatsWriter).
+static size_t build_stats(char* buf, size_t cap, bool advance, uint32_t req_id = 0) {
+    static LatencyHistogram::Snapshot prev_device, prev_cb, prev_sent;
+    const uint64_t t = now_ns();
+    StatsWriter w(buf, cap);
+    w.printf("{\"type\":\"stats\"");
+    if (req_id) w.printf(",\"id\":%u", req_id);
+    size_t mark = w.begin();
+    w.printf(
+        ",\"ts_us\":%" PRIu64 ",\"uptime_s\":%.3f,"
+        "\"rx\":{\"point_packets\":%" PRIu64 ",\"points\":%" PRIu64 ",\"imu_packets\":%" PRIu64 ",\"truncated\":%" PRIu64 ",\"short\":%" PRIu64 "},"
+        "\"tx\":{\"records\":%" PRIu64 ",\"scans\":%" PRIu64 ",\"points\":%" PRIu64 ","
+        "\"udp_bytes\":%" PRIu64 ",\"shm_bytes\":%" PRIu64 ",\"udp_datagrams\":%" PRIu64 ",\"udp_syscalls\":%" PRIu64 "},"
+        "\"drops\":{\"points_queue\":%" PRIu64 ",\"imu_queue\":%" PRIu64 ",\"info_queue\":%" PRIu64 ","
+        "\"ack_queue\":%" PRIu64 ",\"udp_send_errors\":%" PRIu64 ",\"shm_oversize\":%" PRIu64 "},"
+        "\"queues\":{\"points\":{\"depth\":%zu,\"high_water\":%zu,\"capacity\":%zu},"
+        "\"imu\":{\"depth\":%zu,\"high_water\":%zu,\"capacity\":%zu}},"
+        "\"latency_us\":{",
+        realtime_ns() / 1000, (t - g_start_ns) / 1e9,
+        BridgeCounters::get(g_stats.point_packets), BridgeCounters::get(g_stats.points),
+        BridgeCounters::get(g_stats.imu_packets), BridgeCounters::get(g_stats.truncated),
+        BridgeCounters::get(g_stats.short_packets),
+        BridgeCounters::get(g_stats.records), BridgeCounters::get(g_stats.scans),
+        BridgeCounters::get(g_stats.points_out), BridgeCounters::get(g_stats.udp_bytes),
+        BridgeCounters::get(g_stats.shm_bytes), g_out.batcher().datagrams(), g_out.batcher().syscalls(),
+        g_q_points->overflows(), g_q_imu.overflows(), g_q_info.overflows(), g_q_ack.overflows(),
+        g_out.batcher().send_errors(), g_out.shm_oversize(),
+        g_q_points->size(), g_q_points->high_water(), g_q_points->capacity(),
+        g_q_imu.size(), g_q_imu.high_water(), g_q_imu.capacity());
+    w.latency("device_to_callback", &g_lat_device, 1, &prev_device, advance);
+    w.printf(",");
+    w.latency("callback_to_enqueue", g_lat_cb, 2, &prev_cb, advance);
+    w.printf(",");
+    w.latency("enqueue_to_sent", &g_lat_sent, 1, &prev_sent, advance);
+    w.printf("}");
+    w.end(mark);
+    if (g_recorder.is_open())
+        w.printf(
+            ",\"record\":{\"records\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"chunks\":%zu,\"dropped\":%" PRIu64 "}",
+            g_recorder.records(), g_recorder.bytes(), g_recorder.chunks(), g_recorder.dropped());
+    if (g_codec.running()) {
+        static LatencyHistogram::Snapshot prev_encode;
+        const uint64_t in = g_codec.in_bytes(), out = g_codec.out_bytes();
+        mark = w.begin();
+        w.printf(
+            ",\"codec\":{\"name\":\"%s\",\"scans\":%" PRIu64 ",\"in_bytes\":%" PRIu64 ",\"out_bytes\":%" PRIu64 ","
+            "\"ratio\":%.2f,\"busy\":%" PRIu64 ",\"pool_exhausted\":%" PRIu64 ",",
+            scan_codec_name(g_codec.codec()), g_codec.scans(), in, out, out ? (double)in / out : 0.0, g_codec.busy(),
+            g_codec.pool_exhausted());
+        w.latency("encode_us", &g_codec.encode_time(), 1, &prev_encode, advance);
+        w.printf("}");
+        w.end(mark);
+    }
+    if (g_gnss.running()) {
+        static LatencyHistogram::Snapshot prev_edge, prev_ack;
+        mark = w.begin();
+        w.printf(
+            ",\"time_sync\":{\"pps\":%s,\"edges\":%" PRIu64 ",\"rmc\":%" PRIu64 ",\"ubx\":%" PRIu64 ","
+            "\"bad\":%" PRIu64 ",\"invalid\":%" PRIu64 ",\"unpaired\":%" PRIu64 ",\"sent\":%" PRIu64 ","
+            "\"send_failed\":%" PRIu64 ",\"acks\":%" PRIu64 ",\"ack_failed\":%" PRIu64 ",\"utc_s\":%" PRId64 ","
+            "\"offset_ns\":%" PRId64 ",\"jitter_ns\":%" PRIu64 ",",
+            g_gnss.pps() ? "true" : "false", g_gnss.edges(), g_gnss.rmc(), g_gnss.ubx(), g_gnss.bad(),
+            g_gnss.invalid(), g_gnss.unpaired(), g_gnss.sent(), g_gnss.send_failed(), g_gnss.acks(),
+            g_gnss.ack_failed(), g_gnss.last_utc(), g_gnss.offset_ns(), g_gnss.jitter_ns());
+        w.latency("edge_to_send_us", &g_gnss.edge_to_send(), 1, &prev_edge, advance);
+        w.printf(",");
+        w.latency("send_to_ack_us", &g_gnss.send_to_ack(), 1, &prev_ack, advance);
+        w.printf("}");
+        w.end(mark);
+    }
+    if (g_deskew)
+        w.printf(
+            ",\"deskew\":{\"scans\":%" PRIu64 ",\"skipped\":%" PRIu64 ",\"partial\":%" PRIu64 "}",
+            g_deskewer.scans(), g_deskewer.skipped(), g_deskewer.partial());
+    if (g_point_drop.enabled()) {
+        uint64_t dropped = g_fused_asm ? g_fused_asm->dropped() : 0;
+        for (size_t i = 0; i < g_n_assemblers; ++i) dropped += g_assemblers[i]->dropped();
+        w.printf(
+            ",\"point_drop\":{\"noise_level\":%u,\"zero\":%s,\"dropped\":%" PRIu64 ",\"isa\":\"%s\"}",
+            g_point_drop.noise_level, g_point_drop.zero ? "true" : "false", dropped, point_transform_isa());
+    }
+    if (g_grid.enabled())
+        w.printf(
+            ",\"grid\":{\"cell_m\":%.3f,\"tiles_per_side\":%zu,\"scans\":%" PRIu64 ",\"tiles_sent\":%" PRIu64 ","
+            "\"isa\":\"%s\"}",
+            g_grid.config().cell_m, g_grid.tiles_per_side(), g_grid.scans(), g_grid.published(),
+            point_transform_isa());
+    if (g_range.enabled()) {
+        static LatencyHistogram::Snapshot prev_project;
+        mark = w.begin();
+        w.printf(
+            ",\"range_image\":{\"height\":%u,\"width\":%u,\"images\":%" PRIu64 ",\"filled\":%zu,"
+            "\"device\":\"%s\",",
+            g_range.height(), g_range.width(), g_range.images(), g_range.filled(), g_range.device());
+        w.latency("project_us", &g_range_project, 1, &prev_project, advance);
+        w.printf("}");
+        w.end(mark);
+    }
+    if (g_scan_pool.is_open())
+        w.printf(
+            ",\"pool\":{\"blocks\":%zu,\"block_bytes\":%zu,\"in_use\":%zu,\"high_water\":%zu,"
+            "\"exhausted\":%" PRIu64 ",\"hugepages\":%s,\"rt\":%s}",
+            g_scan_pool.blocks(), g_scan_pool.block_bytes(), g_scan_pool.in_use(), g_scan_pool.high_water(),
+            g_scan_pool.exhausted(), g_scan_pool.hugepages() ? "true" : "false", g_rt ? "true" : "false");
+    if (g_backpressure.enabled())
+        w.printf(
+            ",\"backpressure\":{\"window_ms\":%" PRIu64 ",\"voxel_m\":%.3f,\"shed_every\":%u,\"degraded\":%u,"
+            "\"transitions\":%" PRIu64 "}",
+            g_backpressure.config().window_ns / 1000000, g_backpressure.config().voxel_m,
+            g_backpressure.config().shed_every, popcount32(g_subs.level_mask(kSubDownsampled)),
+            g_backpressure.transitions());
+    if (g_subs.active()) {
+        static const char* const kStreams[] = { "points", "imu", "info", "stats", "grid", "range" };
+        mark = w.begin();
+        w.printf(",\"subscribers\":[");
+        bool first = true;
+        for (size_t i = 0; i < SubscriberTable::kMax && !w.full(); ++i) {
+            const Subscriber& s = g_subs.at(i);
+            if (!s.active) continue;
+            const size_t entry = w.begin();
+            char addr[INET_ADDRSTRLEN];
+            format_addr(s.dst, addr, sizeof(addr));
+            w.printf("%s{\"sub\":%u,\"addr\":\"%s\",\"port\":%u,\"streams\":\"",
+                first ? "" : ",", s.id, addr, ntohs(s.dst.sin_port));
+            bool first_stream = true;
+            for (size_t k = 0; k < sizeof(kStreams) / sizeof(kStreams[0]); ++k) {
+                if (!(s.streams & (1u << k))) continue;
+                w.printf("%s%s", first_stream ? "" : ",", kStreams[k]);
+                first_stream = false;
+            }
+            w.printf(
+                "\",\"format\":\"%s\",\"decimate\":%u,\"records\":%" PRIu64 ",\"bytes\":%" PRIu64 ","
+                "\"level\":\"%s\",\"transitions\":%" PRIu64 ",\"send_errors\":%" PRIu64 ",\"lost\":%" PRIu64 "}",
+                bridge_encoding_name(s.format), s.decimate, s.records, s.bytes, subscriber_level_name(s.level),
+                g_backpressure.transitions(i, s.id), g_out.send_errors(i + 1), g_backpressure.lost(i, s.id));
+            w.end(entry);
+            first = false;
+        }
+        if (w.begin() != mark) w.close("]");   // unless not even the opening fitted
+    }
+    // a record cut short keeps what fitted and says so
+    w.close(w.full() ? ",\"truncated\":true}" : "}");
+    return w.size();
+}
+
+static void emit_stats() {
+    const uint32_t mask = route(kStreamStats, kEncNdjson);
+    char buf[8192];
+    const size_t n = build_stats(buf, sizeof(buf), true);   // always: it advances the latency baseline
+    emit_ndjson(buf, n, mask);
 }
 
-static int find_int(const std::string& s, const std::string& key, int defv) {
-    size_t p = s.find(key); if (p == std::string::npos) return defv;
-    p = s.find(':', p);     if (p == std::string::npos) return defv;
-    char* end = 0; const char* start = s.c_str() + p + 1;
-    long v = std::strtol(start, &end, 10);
-    return (end != start) ? (int)v : defv;
+static void on_get_stats_event(const BridgeEvent& ev) {
+    char buf[8192];
+    const size_t n = build_stats(buf, sizeof(buf), false, ev.req_id);
+    g_out.reply(ev.reply_to, buf, n);
 }
 
-// ---- Apply function to all handles (C++11-safe) ----
-template <typename Fn>
-static void for_each_handle(Fn fn) {
-    std::lock_guard<std::mutex> lk(g_handles_mtx);
-    for (size_t i = 0; i < g_handles.size(); ++i) {
-        fn(g_handles[i]);
+static void emit_clock_stats() {
+    char buf[1536];
+    int n = std::snprintf(buf, sizeof(buf), "{\"type\":\"clock\",\"ts_us\":%" PRIu64 ",\"devices\":[",
+        realtime_ns() / 1000);
+    for (size_t i = 0; i < g_n_clocks && n < (int)sizeof(buf) - 200; ++i) {
+        const ClockMapper& c = g_clocks[i];
+        n += std::snprintf(buf + n, sizeof(buf) - n,
+            "%s{\"handle\":%u,\"time_type\":%u,\"offset_ns\":%" PRId64 ",\"skew_ppm\":%.3f,"
+            "\"delay_us\":%.1f,\"windows\":%zu,\"resets\":%" PRIu64 "}",
+            i ? "," : "", g_clock_handles[i], c.time_type(), c.offset_ns(), c.skew_ppm(),
+            c.delay_ns() / 1000.0, c.windows(), c.resets());
     }
+    std::snprintf(buf + n, sizeof(buf) - n, "]}");
+    emit_ndjson(buf, route(kStreamStats, kEncNdjson));
+}
+
+// ---- SDK2 callbacks: copy into the per-callback queue and return ----
+// Copy the packet header plus n points of pt_size bytes, truncating to the event slot.
+static void copy_packet(BridgeEvent* ev, const LivoxLidarEthernetPacket* pkt, size_t pt_size, size_t n) {
+    const size_t hdr = offsetof(LivoxLidarEthernetPacket, data);
+    const size_t max_n = pt_size ? (kMaxPacketBytes - hdr) / pt_size : 0;
+    if (n > max_n) n = max_n;
+    std::memcpy(ev->pkt, pkt, hdr + n * pt_size);
+    reinterpret_cast<LivoxLidarEthernetPacket*>(ev->pkt)->dot_num = (uint16_t)n;
+}
+
+static void ControlAckCallback(livox_status status, uint32_t handle,
+    LivoxLidarAsyncControlResponse* resp, void* client_data) {
+    BridgeEvent* ev = g_q_ack.claim();
+    if (!ev) return;
+    ev->kind = kEvAck;
+    ev->handle = handle;
+    ev->host_ns = now_ns();
+    ev->status = (int32_t)status;
+    ev->ret_code = resp ? resp->ret_code : 255;
+    ev->error_key = resp ? resp->error_key : 0;
+    ev->req_id = (uint32_t)reinterpret_cast<uintptr_t>(client_data);
+    ev->enq_ns = ev->host_ns;
+    g_q_ack.commit();
+}
+
+// Same SDK thread as ControlAckCallback, so it shares the ack queue's single producer.
+static void RmcSyncTimeCallback(livox_status status, uint32_t handle,
+    LivoxLidarRmcSyncTimeResponse* resp, void* client_data) {
+    BridgeEvent* ev = g_q_ack.claim();
+    if (!ev) return;
+    ev->kind = kEvAck;
+    ev->handle = handle;
+    ev->host_ns = now_ns();
+    ev->status = (int32_t)status;
+    ev->ret_code = resp ? resp->ret_code : 255;
+    ev->error_key = 0;
+    ev->req_id = (uint32_t)reinterpret_cast<uintptr_t>(client_data);
+    ev->enq_ns = ev->host_ns;
+    g_q_ack.commit();
+}
+
+// GNSS time sync requests bypass the tracker and the ack queue: the emitter issues them for
+// the GNSS thread (see gnss_time.h) and their acks only feed its counters.
+static void GnssRmcCallback(livox_status status, uint32_t,
+    LivoxLidarRmcSyncTimeResponse* resp, void*) {
+    g_gnss.on_ack(status == kLivoxLidarStatusSuccess && resp && resp->ret_code == 0, now_ns());
 }
 
-// ---- Control message handler (adapter -> bridge) ----
-static void handle_command(const std::string& msg) {
-    const std::string cmd = find_str(msg, "cmd");
+// GNSS thread: the sentence goes to the emitter like every other device command
+static bool gnss_send(const char* rmc, uint16_t len, void*) {
+    BridgeEvent* ev;
+    if (len > sizeof(ev->dev.rmc) || !(ev = g_q_gnss.claim())) return false;
+    ev->kind = kEvGnssRmc;
+    ev->enq_ns = 0;
+    std::memcpy(ev->dev.rmc, rmc, len);
+    ev->dev.rmc_len = len;
+    g_q_gnss.commit();
+    return true;
+}
 
-    if (cmd == "set_work_mode") {
-        const LivoxLidarWorkMode wm =
-            (LivoxLidarWorkMode)find_int(msg, "mode", (int)kLivoxLidarNormal);
-        for_each_handle([&](uint32_t h) {
-            SetLivoxLidarWorkMode(h, wm, ControlAckCallback, NULL);
-            });
+// ---- Device commands (emitter thread) ----
+// Restore: device h's last applied value for op, into the command slot's arguments
+static bool cached_args(uint32_t h, uint8_t op, DeviceCommand* a) {
+    const CachedDevice* d = g_state.find(h);
+    if (!d) return false;
+    a->value = op == kOpWorkMode ? d->work_mode : (op == kOpScanPattern ? d->pattern : d->fov_enable);
+    a->fov.yaw_start = d->fov[0];
+    a->fov.yaw_stop = d->fov[1];
+    a->fov.pitch_start = d->fov[2];
+    a->fov.pitch_stop = d->fov[3];
+    a->fov.rsvd = 0;
+    return true;
+}
 
+// One SDK request of command slot `cmd`; the tag rides in client_data back to the ack.
+static int32_t issue_device_op(uint32_t h, uint8_t op, int cmd, uint32_t tag) {
+    DeviceCommand& a = g_cmd_args[cmd];
+    if (a.cached && !cached_args(h, op, &a)) return kLivoxLidarStatusFailure;
+    void* d = reinterpret_cast<void*>((uintptr_t)tag);
+    switch (op) {
+    case kOpWorkMode:    return SetLivoxLidarWorkMode(h, (LivoxLidarWorkMode)a.value, ControlAckCallback, d);
+    case kOpScanPattern: return SetLivoxLidarScanPattern(h, (LivoxLidarScanPattern)a.value, ControlAckCallback, d);
+    case kOpFovCfg:      return SetLivoxLidarFovCfg1(h, &a.fov, ControlAckCallback, d);
+    case kOpFovEnable:   return EnableLivoxLidarFov(h, (uint8_t)a.value, ControlAckCallback, d);
+    case kOpImuEnable:   return EnableLivoxLidarImuData(h, ControlAckCallback, d);
+    case kOpImuDisable:  return DisableLivoxLidarImuData(h, ControlAckCallback, d);
+    case kOpRmcTime:     return SetLivoxLidarRmcSyncTime(h, a.rmc, a.rmc_len, RmcSyncTimeCallback, d);
     }
-    else if (cmd == "set_pattern_mode") {
-        const LivoxLidarScanPattern sp =
-            (LivoxLidarScanPattern)find_int(msg, "pattern_mode",
-                (int)kLivoxLidarScanPatternNoneRepetive);
-        for_each_handle([&](uint32_t h) {
-            SetLivoxLidarScanPattern(h, sp, ControlAckCallback, NULL);
-            });
+    return kLivoxLidarStatusFailure;
+}
+
+// One GNSS RMC sentence to every lidar, drained ahead of the other queues: the lidar wants it
+// as soon after its PPS edge as possible.
+static void on_gnss_rmc_event(const BridgeEvent& ev) {
+    unsigned issued = 0, failed = 0;
+    g_devices.for_each([&](uint32_t h) {
+        if (SetLivoxLidarRmcSyncTime(h, ev.dev.rmc, ev.dev.rmc_len, GnssRmcCallback, NULL) == kLivoxLidarStatusSuccess)
+            ++issued;
+        else
+            ++failed;
+    });
+    g_gnss.on_issued(issued, failed);
+}
 
+// Worth another attempt: the request (or its ack) was lost, not refused
+static bool device_status_retryable(int32_t status) {
+    return status == kLivoxLidarStatusTimeout || status == kLivoxLidarStatusSendFailed;
+}
+
+// Fan a device command out to every registered lidar at once: all requests are issued back
+// to back and tracked; the {"type":"cmd"} reply follows the fan-out, {"type":"cmd_done"}
+// the last ack (or timeout).
+static void on_device_cmd_event(const BridgeEvent& ev) {
+    uint32_t handles[DeviceRegistry::kCapacity];
+    uint32_t n_dev = 0;
+    g_devices.for_each([&](uint32_t h) { if (n_dev < DeviceRegistry::kCapacity) handles[n_dev++] = h; });
+    const uint64_t now = now_ns();
+    const int slot = g_cmds.begin(ev.req_id, ev.cmd, n_dev, n_dev * ev.dev.n_ops, now);
+    if (slot < 0) {
+        emit_cmd_reply(ev.req_id, ev.cmd, kCmdStatusFull, 0);
+        return;
     }
-    else if (cmd == "set_fov") {
-        FovCfg cfg;
-        cfg.yaw_start = find_int(msg, "yaw_start", 0);
-        cfg.yaw_stop = find_int(msg, "yaw_stop", 0);
-        cfg.pitch_start = find_int(msg, "pitch_start", -7);
-        cfg.pitch_stop = find_int(msg, "pitch_stop", 52);
-        cfg.rsvd = 0;
-        const int en = find_int(msg, "enable", 1);
-        for_each_handle([&](uint32_t h) {
-            SetLivoxLidarFovCfg1(h, &cfg, ControlAckCallback, NULL);
-            EnableLivoxLidarFov(h, (uint8_t)en, ControlAckCallback, NULL);
-            });
+    g_cmd_args[slot] = ev.dev;
+    g_cmd_reply_to[slot] = ev.reply_to;
+    // reply first: with the SDK stand-in the acks are queued during the fan-out itself
+    emit_cmd_reply(ev.req_id, ev.cmd, kCmdStatusOk, n_dev * ev.dev.n_ops);
+    for (uint32_t i = 0; i < n_dev; ++i)
+        for (uint8_t k = 0; k < ev.dev.n_ops; ++k)
+            g_cmds.add(slot, handles[i], ev.dev.ops[k], now, issue_device_op);
+}
+
+// ---- Warm restart (LIVOX_STATE_FILE, emitter thread) ----
+// SDK requests that re-apply what the cache knows about d, in a fixed order
+static size_t cached_ops(const CachedDevice& d, uint8_t* ops) {
+    size_t n = 0;
+    if (d.applied & kCfgWorkMode) ops[n++] = kOpWorkMode;
+    if (d.applied & kCfgPattern) ops[n++] = kOpScanPattern;
+    if (d.applied & kCfgFov) ops[n++] = kOpFovCfg;
+    if (d.applied & kCfgFovEnable) ops[n++] = kOpFovEnable;
+    if (d.applied & kCfgImu) ops[n++] = d.imu_enable ? kOpImuEnable : kOpImuDisable;
+    return n;
+}
 
+// Right after a restart a device may not be connected yet: keep trying anything short of a
+// definite refusal
+static bool restore_status_retryable(int32_t status) { return status != kLivoxLidarStatusNotSupported; }
+
+// Re-apply the cached config of these devices, all at once, as one tracked "restore" command
+static void start_restore(const uint32_t* handles, size_t n) {
+    uint8_t ops[8];
+    uint32_t n_req = 0, n_dev = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (const CachedDevice* d = g_state.find(handles[i])) {
+            const size_t k = cached_ops(*d, ops);
+            n_req += (uint32_t)k;
+            n_dev += k ? 1 : 0;
+        }
+    if (!n_req) return;
+    const uint64_t now = now_ns();
+    const int slot = g_cmds.begin(0, "restore", n_dev, n_req, now, kRestoreRetries, restore_status_retryable);
+    if (slot < 0) {
+        emit_cmd_reply(0, "restore", kCmdStatusFull, 0);
+        return;
     }
-    else if (cmd == "set_imu_enable") {
-        const int en = find_int(msg, "enable", 1);
-        for_each_handle([&](uint32_t h) {
-            if (en) EnableLivoxLidarImuData(h, ControlAckCallback, NULL);
-            else    DisableLivoxLidarImuData(h, ControlAckCallback, NULL);
-            });
+    std::memset(&g_cmd_args[slot], 0, sizeof(g_cmd_args[slot]));
+    g_cmd_args[slot].cached = true;
+    std::memset(&g_cmd_reply_to[slot], 0, sizeof(g_cmd_reply_to[slot]));
+    emit_cmd_reply(0, "restore", kCmdStatusOk, n_req);
+    for (size_t i = 0; i < n; ++i)
+        if (const CachedDevice* d = g_state.find(handles[i])) {
+            const size_t k = cached_ops(*d, ops);
+            for (size_t j = 0; j < k; ++j) g_cmds.add(slot, handles[i], ops[j], now, issue_device_op);
+        }
+}
 
+static void on_restore_event() {
+    uint32_t handles[BridgeState::kMaxDevices];
+    for (size_t i = 0; i < g_state.n_devices; ++i) handles[i] = g_state.devices[i].handle;
+    start_restore(handles, g_state.n_devices);
+}
+
+// Keep the cache in step with the devices the source reports. The same SN at a new handle
+// (the unit changed IP) takes its entry over and gets its config re-applied.
+static void cache_device(const BridgeEvent& ev) {
+    char sn[17], ip[17];
+    std::memcpy(sn, ev.info.sn, 16);
+    std::memcpy(ip, ev.info.lidar_ip, 16);
+    sn[16] = ip[16] = '\0';
+    CachedDevice* d = g_state.find(ev.handle);
+    bool moved = false;
+    if (!d && (d = g_state.find_sn(sn)) != NULL) {
+        d->handle = ev.handle;
+        moved = true;
+    }
+    if (!d && (d = g_state.add(ev.handle)) == NULL) return;
+    if (moved || d->dev_type != ev.info.dev_type || std::strcmp(d->sn, sn) || std::strcmp(d->ip, ip)) {
+        d->dev_type = ev.info.dev_type;
+        std::memcpy(d->sn, sn, sizeof(sn));
+        std::memcpy(d->ip, ip, sizeof(ip));
+        g_state_dirty = true;
     }
-    else if (cmd == "set_time_sync") {
-        const std::string rmc = find_str(msg, "rmc");
-        if (!rmc.empty()) {
-            for_each_handle([&](uint32_t h) {
-                SetLivoxLidarRmcSyncTime(h, rmc.c_str(), (uint16_t)rmc.size(), NULL, NULL);
-                });
+    if (moved) start_restore(&ev.handle, 1);
+}
+
+// Note what the successful requests of a finished command set on each device
+static void remember_applied(int slot, const CommandTracker& t, const TrackedCommand& c) {
+    const DeviceCommand& a = g_cmd_args[slot];
+    t.for_each_request(c, [&](const TrackedRequest& r) {
+        if (r.state != kReqOk) return;
+        CachedDevice* d = g_state.add(r.handle);
+        if (!d) return;
+        switch (r.op) {
+        case kOpWorkMode:    d->work_mode = a.value; d->applied |= kCfgWorkMode; break;
+        case kOpScanPattern: d->pattern = a.value; d->applied |= kCfgPattern; break;
+        case kOpFovCfg:
+            d->fov[0] = a.fov.yaw_start;
+            d->fov[1] = a.fov.yaw_stop;
+            d->fov[2] = a.fov.pitch_start;
+            d->fov[3] = a.fov.pitch_stop;
+            d->applied |= kCfgFov;
+            break;
+        case kOpFovEnable:   d->fov_enable = a.value; d->applied |= kCfgFovEnable; break;
+        case kOpImuEnable:
+        case kOpImuDisable:  d->imu_enable = r.op == kOpImuEnable; d->applied |= kCfgImu; break;
+        default: return;     // time sync is not configuration
         }
+        g_state_dirty = true;
+    });
+}
+
+static void on_cmd_done(int slot, const TrackedCommand& c, const CommandTracker& t) {
+    if (!g_state_path.empty() && !g_cmd_args[slot].cached) remember_applied(slot, t, c);
+    emit_cmd_done(slot, c, t);
+}
+
+static void save_state(bool clean) {
+    const uint64_t mono = now_ns(), rt = realtime_ns();
+    g_state.n_subscribers = 0;
+    for (size_t i = 0; i < SubscriberTable::kMax && g_state.n_subscribers < BridgeState::kMaxSubscribers; ++i) {
+        const Subscriber& s = g_subs.at(i);
+        if (!s.active) continue;
+        CachedSubscriber& c = g_state.subscribers[g_state.n_subscribers++];
+        c.addr = s.dst.sin_addr.s_addr;
+        c.port = ntohs(s.dst.sin_port);
+        c.format = s.format;
+        c.streams = s.streams;
+        c.decimate = s.decimate;
+        c.expires_rt_ns = s.expires_ns ? rt + (s.expires_ns > mono ? s.expires_ns - mono : 0) : 0;
+    }
+    g_state.bin_seq = g_out.seq();
+    if (!g_state.save(g_state_path.c_str(), clean))
+        std::cerr << "state file " << g_state_path << ": " << std::strerror(errno) << std::endl;
+    g_state_dirty = false;
+    g_state_save_ns = mono + kStateSaveIntervalNs;
+}
+
+// Also saved once the frame seq ran far enough past the file that a crash gap would not cover it
+static void maybe_save_state(uint64_t t) {
+    const bool seq_due = g_out.seq() - g_state.bin_seq >= BridgeState::kSeqCrashGap / 2;
+    if ((g_state_dirty || seq_due) && t >= g_state_save_ns) save_state(false);
+}
+
+// Before the emitter starts: subscribers whose lease outlived the downtime, and the frame seq
+static void restore_state() {
+    const uint64_t mono = now_ns(), rt = realtime_ns();
+    size_t n_subs = 0;
+    for (size_t i = 0; i < g_state.n_subscribers; ++i) {
+        const CachedSubscriber& c = g_state.subscribers[i];
+        if (c.expires_rt_ns && c.expires_rt_ns <= rt) continue;
+        sockaddr_in dst;
+        std::memset(&dst, 0, sizeof(dst));
+        dst.sin_family = AF_INET;
+        dst.sin_addr.s_addr = c.addr;
+        dst.sin_port = htons(c.port);
+        const int slot = g_out.subscribe(dst, c.streams, c.format, c.decimate,
+            c.expires_rt_ns ? mono + (c.expires_rt_ns - rt) : 0);
+        if (slot < 0) break;
+        ++n_subs;
+    }
+    const uint32_t seq = g_state.bin_seq + (g_state.clean ? 0 : BridgeState::kSeqCrashGap);
+    g_out.set_seq(seq);
+    g_state.bin_seq = seq;
+    std::cerr << "state file " << g_state_path << ": " << g_state.n_devices << " device(s), " << n_subs
+              << " subscriber(s) restored, frame seq " << seq << (g_state.clean ? "" : " (unclean exit)") << std::endl;
+}
+
+// t0 is callback entry; host_ns / host_rt_ns the arrival stamps (t0 and now when live,
+// the recorded ones in replay). pkt->length (header + data) bounds what is read: a packet
+// shorter than its header is dropped, dot_num is clamped to the points it carries, and
+// both count as short.
+static void enqueue_points(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t t0,
+    uint64_t host_ns, uint64_t host_rt_ns) {
+    const size_t hdr = offsetof(LivoxLidarEthernetPacket, data);
+    BridgeCounters::inc(g_stats.point_packets);
+    if (pkt->length < hdr) { BridgeCounters::inc(g_stats.short_packets); return; }
+    const size_t pt_size = bridge_point_size(pkt->data_type);
+    size_t n = pt_size ? pkt->dot_num : 0;
+    if (pt_size && n > (pkt->length - hdr) / pt_size) {
+        n = (pkt->length - hdr) / pt_size;
+        BridgeCounters::inc(g_stats.short_packets);
+    }
+    BridgeCounters::inc(g_stats.points, n);
+    BridgeEvent* ev = g_q_points->claim();
+    if (!ev) return;
+    ev->kind = kEvPoints;
+    ev->handle = handle;
+    ev->host_ns = host_ns;
+    ev->host_rt_ns = host_rt_ns;
+    copy_packet(ev, pkt, pt_size, n);
+    if (ev->packet()->dot_num != n) BridgeCounters::inc(g_stats.truncated);
+    ev->enq_ns = now_ns();
+    g_lat_cb[0].record(ev->enq_ns - t0);
+    g_q_points->commit();
+}
+
+static void PointCloudCallback(const uint32_t handle, const uint8_t /*dev_type*/,
+    LivoxLidarEthernetPacket* pkt, void* /*client_data*/) {
+    if (!pkt) return;
+    const uint64_t t0 = now_ns();
+    enqueue_points(handle, pkt, t0, t0, realtime_ns());
+}
+
+static void enqueue_imu(uint32_t handle, const LivoxLidarEthernetPacket* pkt, uint64_t t0,
+    uint64_t host_ns, uint64_t host_rt_ns) {
+    const size_t len = offsetof(LivoxLidarEthernetPacket, data) + sizeof(LivoxLidarImuRawPoint);
+    BridgeCounters::inc(g_stats.imu_packets);
+    if (pkt->length < len) { BridgeCounters::inc(g_stats.short_packets); return; }
+    BridgeEvent* ev = g_q_imu.claim();
+    if (!ev) return;
+    ev->kind = kEvImu;
+    ev->handle = handle;
+    ev->host_ns = host_ns;
+    ev->host_rt_ns = host_rt_ns;
+    std::memcpy(ev->pkt, pkt, len);
+    ev->enq_ns = now_ns();
+    g_lat_cb[1].record(ev->enq_ns - t0);
+    g_q_imu.commit();
+}
+
+static void ImuCallback(const uint32_t handle, const uint8_t /*dev_type*/,
+    LivoxLidarEthernetPacket* pkt, void* /*client_data*/) {
+    if (!pkt) return;
+    const uint64_t t0 = now_ns();
+    enqueue_imu(handle, pkt, t0, t0, realtime_ns());
+}
+
+static void InfoChangeCallback(const uint32_t handle, const LivoxLidarInfo* info, void* /*client_data*/) {
+    if (!info) return;
+    g_devices.add(handle, info->dev_type, info->sn, info->lidar_ip);
+    BridgeEvent* ev = g_q_info.claim();
+    if (!ev) return;
+    ev->kind = kEvInfo;
+    ev->handle = handle;
+    ev->host_ns = now_ns();
+    ev->info = *info;
+    ev->enq_ns = ev->host_ns;
+    g_q_info.commit();
+}
+
+// ---- Emitter thread: sole owner of assembly, serialization and output ----
+// Record the SDK input exactly as the emitter receives it (after queue truncation).
+static void record_event(const BridgeEvent& ev) {
+    const size_t hdr = offsetof(LivoxLidarEthernetPacket, data);
+    switch (ev.kind) {
+    case kEvPoints:
+        g_recorder.append(kRecPoints, ev.handle, ev.host_ns, ev.host_rt_ns, ev.pkt,
+            hdr + ev.packet()->dot_num * bridge_point_size(ev.packet()->data_type));
+        break;
+    case kEvImu:
+        g_recorder.append(kRecImu, ev.handle, ev.host_ns, ev.host_rt_ns, ev.pkt,
+            hdr + sizeof(LivoxLidarImuRawPoint));
+        break;
+    case kEvInfo:
+        g_recorder.append(kRecInfo, ev.handle, ev.host_ns, ev.host_rt_ns, &ev.info, sizeof(ev.info));
+        break;
+    }
+}
+
+static size_t drain(SpscQueue<BridgeEvent>& q, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        BridgeEvent* ev = q.peek();
+        if (!ev) break;
+        g_out.enq_ns = ev->enq_ns;
+        if (ev->kind <= kEvInfo && g_recorder.is_open()) record_event(*ev);
+        switch (ev->kind) {
+        case kEvPoints:   on_points_event(*ev); break;
+        case kEvImu:      on_imu_event(*ev); break;
+        case kEvInfo:
+            on_info_event(*ev);
+            if (!g_state_path.empty()) cache_device(*ev);
+            break;
+        case kEvAck:      on_ack_event(*ev); break;
+        case kEvGetStats: on_get_stats_event(*ev); break;
+        case kEvCmdReply: on_cmd_reply_event(*ev); break;
+        case kEvStatsTick:
+            emit_stats();
+            if (g_n_clocks) emit_clock_stats();
+            break;
+        case kEvFlushTick: flush_stale_scans(now_ns()); break;
+        case kEvSubscribe:
+        case kEvUnsubscribe: on_subscribe_event(*ev); break;
+        case kEvGridPose:
+            g_grid.set_pose(ev->pose[0], ev->pose[1], ev->pose[2]);
+            emit_grid_delta(0, 0);
+            break;
+        case kEvGridSnapshot:
+            g_grid.mark_all();
+            emit_grid_delta(0, 0);
+            break;
+        case kEvDeviceCmd: on_device_cmd_event(*ev); break;
+        case kEvRestore: on_restore_event(); break;
+        case kEvLag: on_lag_event(*ev); break;
+        case kEvGnssRmc: on_gnss_rmc_event(*ev); break;
+        }
+        g_out.enq_ns = 0;
+        q.pop();
+        ++n;
+    }
+    return n;
+}
+
+static void configure_emitter_thread() {
+    if (g_emit_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(g_emit_cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) std::cerr << "emitter: cannot pin to CPU " << g_emit_cpu << ": " << std::strerror(rc) << std::endl;
+    }
+    if (g_emit_prio > 0) {
+        sched_param sp;
+        std::memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = g_emit_prio;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (rc != 0) std::cerr << "emitter: cannot set SCHED_FIFO " << g_emit_prio << ": " << std::strerror(rc) << std::endl;
+    }
+    if (g_rt) {
+        // fault the stack in now (mlockall keeps it resident), not on the first deep call
+        volatile char stack[kRtStackBytes];
+        for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+    }
+}
+
+static void emitter_thread() {
+    configure_emitter_thread();
+    for (;;) {
+        const bool running = g_emitter_running.load(std::memory_order_relaxed);
+        size_t n = drain(g_q_gnss, 4) + drain(g_q_ctl, 16) + drain(g_q_ack, 64) + drain(g_q_info, 64) + drain(g_q_imu, 256) +
+                   drain(*g_q_points, 1024);
+        if (g_codec.running()) n += g_codec.poll(collect_compressed);
+        const uint64_t t = now_ns();
+        if (g_imu_batch) flush_imu_batches(t);
+        expire_subscribers(t);
+        if (g_subs.active()) g_backpressure.poll(t, g_out, on_backpressure);
+        if (g_cmds.active()) g_cmds.poll(t, issue_device_op, on_cmd_done);
+        if (!g_state_path.empty()) maybe_save_state(t);
+        g_out.flush_if_due(t);
+        if (n == 0) {
+            if (!running) break;
+            g_out.flush_stdout();
+            std::this_thread::sleep_for(microseconds(g_emit_idle_us));
+        }
+    }
+    // shutdown: publish the partial scans and IMU batches still open
+    if (g_frame_window_ns) flush_scans(~0ull, 0);
+    if (g_codec.running()) g_codec.drain(collect_compressed);
+    if (g_imu_batch) flush_imu_batches(~0ull);
+    g_out.flush();
+    if (!g_state_path.empty()) save_state(true);
+}
+
+// ---- Control command handlers (adapter -> bridge) ----
+// Each returns the number of SDK requests it issued, or one of the negative codes below.
+static const int kCmdBadArgs = -1;
+static const int kCmdNoReply = -2;   // answered directly (get_stats, subscribe, device commands)
+
+static int cmd_get_stats(const BridgeCommand& c, const sockaddr_in& src) {
+    // Built by the emitter, which owns the histograms' baselines and the UDP socket
+    if (BridgeEvent* ev = g_q_ctl.claim()) {
+        ev->kind = kEvGetStats;
+        ev->enq_ns = 0;
+        ev->req_id = c.id;
+        ev->reply_to = src;
+        g_q_ctl.commit();
+    }
+    return kCmdNoReply;
+}
+
+static void copy_cmd_name(const BridgeCommand& c, BridgeEvent* ev) {
+    const size_t n = c.has_name() && c.name.size() < sizeof(ev->cmd) ? c.name.size() : 0;
+    if (n) std::memcpy(ev->cmd, c.name.begin, n);
+    ev->cmd[n] = '\0';
+}
+
+// Device commands go to the emitter, which issues them to every lidar (on_device_cmd_event)
+static int post_device_cmd(const BridgeCommand& c, const sockaddr_in& src, const DeviceCommand& d) {
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return kCmdBadArgs;
+    ev->kind = kEvDeviceCmd;
+    ev->enq_ns = 0;
+    ev->req_id = c.id;
+    ev->reply_to = src;
+    ev->dev = d;
+    copy_cmd_name(c, ev);
+    g_q_ctl.commit();
+    return kCmdNoReply;
+}
+
+static DeviceCommand device_cmd(uint8_t op, int32_t value) {
+    DeviceCommand d;
+    std::memset(&d, 0, sizeof(d));
+    d.ops[0] = op;
+    d.n_ops = 1;
+    d.value = value;
+    return d;
+}
+
+static int cmd_set_work_mode(const BridgeCommand& c, const sockaddr_in& src) {
+    return post_device_cmd(c, src, device_cmd(kOpWorkMode, c.int_field("mode", (int)kLivoxLidarNormal)));
+}
+
+static int cmd_set_pattern_mode(const BridgeCommand& c, const sockaddr_in& src) {
+    return post_device_cmd(c, src,
+        device_cmd(kOpScanPattern, c.int_field("pattern_mode", (int)kLivoxLidarScanPatternNoneRepetive)));
+}
+
+static int cmd_set_fov(const BridgeCommand& c, const sockaddr_in& src) {
+    // two SDK requests (and acks) per device
+    DeviceCommand d = device_cmd(kOpFovCfg, c.int_field("enable", 1));
+    d.ops[1] = kOpFovEnable;
+    d.n_ops = 2;
+    d.fov.yaw_start = c.int_field("yaw_start", 0);
+    d.fov.yaw_stop = c.int_field("yaw_stop", 0);
+    d.fov.pitch_start = c.int_field("pitch_start", -7);
+    d.fov.pitch_stop = c.int_field("pitch_stop", 52);
+    d.fov.rsvd = 0;
+    return post_device_cmd(c, src, d);
+}
+
+static int cmd_set_imu_enable(const BridgeCommand& c, const sockaddr_in& src) {
+    return post_device_cmd(c, src, device_cmd(c.int_field("enable", 1) ? kOpImuEnable : kOpImuDisable, 0));
+}
+
+static int cmd_set_time_sync(const BridgeCommand& c, const sockaddr_in& src) {
+    JsonValue rmc;
+    if (!c.string_field("rmc", &rmc) || rmc.size() == 0) return kCmdBadArgs;
+    DeviceCommand d = device_cmd(kOpRmcTime, 0);
+    d.rmc_len = (uint16_t)json_string(rmc, d.rmc, sizeof(d.rmc));
+    return post_device_cmd(c, src, d);
+}
+
+// Destination of a subscription: "addr" / "port", each defaulting to the sender's.
+static bool sub_destination(const BridgeCommand& c, const sockaddr_in& src, sockaddr_in* dst) {
+    *dst = src;
+    JsonValue v;
+    if (c.string_field("addr", &v)) {
+        char buf[INET_ADDRSTRLEN];
+        json_string(v, buf, sizeof(buf));
+        if (inet_pton(AF_INET, buf, &dst->sin_addr) != 1) return false;
+    }
+    const int port = c.int_field("port", ntohs(src.sin_port));
+    if (port <= 0 || port > 65535) return false;
+    dst->sin_port = htons((uint16_t)port);
+    return true;
+}
+
+// The subscriber table belongs to the emitter; it applies the request and replies to the sender.
+static void post_subscription(const BridgeCommand& c, uint8_t kind, const sockaddr_in& src,
+    const SubRequest& r, bool ok) {
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return;
+    ev->kind = kind;
+    ev->enq_ns = 0;
+    ev->req_id = c.id;
+    ev->status = ok ? kCmdStatusOk : kCmdStatusBadArgs;
+    ev->reply_to = src;
+    ev->sub = r;
+    copy_cmd_name(c, ev);
+    g_q_ctl.commit();
+}
+
+static int cmd_subscribe(const BridgeCommand& c, const sockaddr_in& src) {
+    SubRequest r;
+    std::memset(&r, 0, sizeof(r));
+    bool ok = sub_destination(c, src, &r.dst);
+    JsonValue v;
+    r.streams = c.string_field("streams", &v) ? bridge_stream_mask(v.begin, v.size()) : (uint32_t)kStreamAll;
+    r.format = g_out.format();
+    if (c.string_field("format", &v)) {
+        const int format = bridge_encoding_parse(v.begin, v.size());
+        if (format < 0) ok = false;
+        else r.format = (uint8_t)format;
+    }
+    const int decimate = c.int_field("decimate", 1);
+    r.decimate = decimate > 0 ? (uint32_t)decimate : 0;
+    post_subscription(c, kEvSubscribe, src, r, ok && r.streams && r.decimate);
+    return kCmdNoReply;
+}
+
+// {"cmd":"lag","lost":n,"queued":n,"capacity":n} from a subscriber (by "sub", else by
+// addr / port like unsubscribe), see backpressure.h. Answered like any other command.
+static int cmd_lag(const BridgeCommand& c, const sockaddr_in& src) {
+    SubRequest r;
+    std::memset(&r, 0, sizeof(r));
+    const int id = c.int_field("sub", 0);
+    r.id = id > 0 ? (uint32_t)id : 0;
+    const double lost = c.number_field("lost", 0.0);
+    const int queued = c.int_field("queued", 0), capacity = c.int_field("capacity", 0);
+    if (!sub_destination(c, src, &r.dst) || lost < 0 || queued < 0 || capacity < 0) return kCmdBadArgs;
+    r.lost = (uint64_t)lost;
+    r.queued = (uint32_t)queued;
+    r.capacity = (uint32_t)capacity;
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return kCmdBadArgs;
+    ev->kind = kEvLag;
+    ev->enq_ns = 0;
+    ev->sub = r;
+    g_q_ctl.commit();
+    return 0;
+}
+
+static int cmd_unsubscribe(const BridgeCommand& c, const sockaddr_in& src) {
+    SubRequest r;
+    std::memset(&r, 0, sizeof(r));
+    const int id = c.int_field("sub", 0);
+    r.id = id > 0 ? (uint32_t)id : 0;
+    const bool ok = sub_destination(c, src, &r.dst);
+    post_subscription(c, kEvUnsubscribe, src, r, ok);
+    return kCmdNoReply;
+}
+
+// The grid belongs to the emitter: pose changes and snapshots are posted to it.
+// g_grid.enabled() is fixed before the reactor starts.
+static int cmd_grid_pose(const BridgeCommand& c, const sockaddr_in&) {
+    if (!g_grid.enabled()) return kCmdBadArgs;
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return kCmdBadArgs;
+    ev->kind = kEvGridPose;
+    ev->enq_ns = 0;
+    ev->pose[0] = c.number_field("x", 0.0);
+    ev->pose[1] = c.number_field("y", 0.0);
+    ev->pose[2] = c.number_field("yaw", 0.0);
+    g_q_ctl.commit();
+    return 0;
+}
+
+static int cmd_grid_snapshot(const BridgeCommand&, const sockaddr_in&) {
+    if (!g_grid.enabled()) return kCmdBadArgs;
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return kCmdBadArgs;
+    ev->kind = kEvGridSnapshot;
+    ev->enq_ns = 0;
+    g_q_ctl.commit();
+    return 0;
+}
+
+struct CommandEntry {
+    const char* name;
+    int (*fn)(const BridgeCommand& c, const sockaddr_in& src);
+};
+
+static const CommandEntry kCommands[] = {
+    { "get_stats",        cmd_get_stats },
+    { "set_work_mode",    cmd_set_work_mode },
+    { "set_pattern_mode", cmd_set_pattern_mode },
+    { "set_fov",          cmd_set_fov },
+    { "set_imu_enable",   cmd_set_imu_enable },
+    { "set_time_sync",    cmd_set_time_sync },
+    { "subscribe",        cmd_subscribe },
+    { "unsubscribe",      cmd_unsubscribe },
+    { "lag",              cmd_lag },
+    { "grid_pose",        cmd_grid_pose },
+    { "grid_snapshot",    cmd_grid_snapshot },
+};
+
+// Queue the {"type":"cmd"} reply; the emitter owns the output transports.
+static void post_cmd_reply(const BridgeCommand& c, uint8_t status, int requests) {
+    BridgeEvent* ev = g_q_ctl.claim();
+    if (!ev) return;
+    ev->kind = kEvCmdReply;
+    ev->enq_ns = 0;
+    ev->req_id = c.id;
+    ev->status = status;
+    ev->handle = requests > 0 ? (uint32_t)requests : 0;
+    copy_cmd_name(c, ev);
+    g_q_ctl.commit();
+}
+
+static void handle_command(const char* msg, size_t len, const sockaddr_in& src) {
+    BridgeCommand c;
+    if (!c.parse(msg, len) || !c.has_name()) {
+        post_cmd_reply(c, kCmdStatusBadRequest, 0);
+        return;
+    }
+    const CommandEntry* e = command_find(kCommands, c.name);
+    if (!e) {
+        post_cmd_reply(c, kCmdStatusUnknown, 0);
+        return;
     }
+    const int r = e->fn(c, src);
+    if (r == kCmdNoReply) return;
+    post_cmd_reply(c, r == kCmdBadArgs ? kCmdStatusBadArgs : kCmdStatusOk, r);
 }
 
-// ---- Control listener thread ----
-static void control_thread() {
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) { std::perror("control socket"); return; }
+// ---- Reactor (main thread) ----
+// One epoll loop owns the control socket, a signalfd (SIGINT/SIGTERM) and the stats and
+// frame-timeout timerfds, so commands are handled as soon as they arrive and shutdown never
+// waits on a timeout or a datagram. It is the only producer of g_q_ctl.
+static int open_control_socket() {
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) { std::perror("control socket"); return -1; }
 
     sockaddr_in addr;
     std::memset(&addr, 0, sizeof(addr));
@@ -209,76 +1895,531 @@ static void control_thread() {
     if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         std::perror("control bind");
         close(sock);
-        return;
+        return -1;
+    }
+    return sock;
+}
+
+// Periodic timerfd, or -1 when period_ns is 0 or the timer cannot be created.
+static int open_timer(uint64_t period_ns) {
+    if (!period_ns) return -1;
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) { std::perror("timerfd"); return -1; }
+    itimerspec its;
+    its.it_interval.tv_sec = (time_t)(period_ns / 1000000000ull);
+    its.it_interval.tv_nsec = (long)(period_ns % 1000000000ull);
+    its.it_value = its.it_interval;
+    timerfd_settime(fd, 0, &its, NULL);
+    return fd;
+}
+
+static void post_tick(uint8_t kind) {
+    if (BridgeEvent* ev = g_q_ctl.claim()) {
+        ev->kind = kind;
+        ev->enq_ns = 0;
+        g_q_ctl.commit();
     }
+}
 
+static void drain_control(int sock) {
     char buf[4096];
-    while (g_running.load()) {
+    for (;;) {
         sockaddr_in src; socklen_t sl = sizeof(src);
-        int n = recvfrom(sock, buf, sizeof(buf) - 1, 0, (struct sockaddr*)&src, &sl);
-        if (n > 0) {
-            buf[n] = '\0';
-            handle_command(std::string(buf));
+        const ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr*)&src, &sl);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) std::perror("control recvfrom");
+            return;
         }
-        else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (n > 0) handle_command(buf, (size_t)n, src);
+    }
+}
+
+static bool epoll_watch(int ep, int fd) {
+    if (fd < 0) return true;
+    epoll_event e;
+    std::memset(&e, 0, sizeof(e));
+    e.events = EPOLLIN;
+    e.data.fd = fd;
+    return epoll_ctl(ep, EPOLL_CTL_ADD, fd, &e) == 0;
+}
+
+// Runs until SIGINT/SIGTERM arrives on sig_fd; returns the signal number (0 on error).
+static int run_reactor(int sig_fd, int ctl_fd) {
+    const int stats_fd = open_timer(g_stats_ns);
+    const int flush_fd = open_timer(g_frame_window_ns / 2);
+    const int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0 || !epoll_watch(ep, sig_fd) || !epoll_watch(ep, ctl_fd) || !epoll_watch(ep, stats_fd) ||
+        !epoll_watch(ep, flush_fd)) {
+        std::perror("epoll");
+        return 0;
+    }
+
+    int sig = 0;
+    while (!sig) {
+        epoll_event ev[8];
+        const int n = epoll_wait(ep, ev, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            const int fd = ev[i].data.fd;
+            if (fd == sig_fd) {
+                signalfd_siginfo si;
+                if (read(sig_fd, &si, sizeof(si)) == (ssize_t)sizeof(si)) sig = (int)si.ssi_signo;
+            }
+            else if (fd == ctl_fd) {
+                drain_control(ctl_fd);
+            }
+            else {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations)) continue;
+                post_tick(fd == stats_fd ? kEvStatsTick : kEvFlushTick);
+            }
         }
     }
-    close(sock);
+    close(ep);
+    if (stats_fd >= 0) close(stats_fd);
+    if (flush_fd >= 0) close(flush_fd);
+    return sig;
+}
+
+// ---- Input sources ----
+// Sink shared by the replay and synthetic sources: the same enqueue path as the SDK callbacks.
+static void sink_info(uint32_t handle, const LivoxLidarInfo* info) { InfoChangeCallback(handle, info, NULL); }
+
+// Sources running faster than real time are paced by the emitter: wait for room instead
+// of dropping.
+static bool sink_wait_for_room(bool imu) {
+    const SpscQueue<BridgeEvent>& q = imu ? g_q_imu : *g_q_points;
+    while (q.size() >= q.capacity()) {
+        if (g_source_stopping.load(std::memory_order_relaxed) || !g_emitter_running.load(std::memory_order_relaxed))
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// Out of input: stop the bridge through the reactor's signalfd like a normal shutdown
+static void sink_finished() { kill(getpid(), SIGTERM); }
+
+static BridgeSourceSink source_sink() {
+    BridgeSourceSink s;
+    s.points = enqueue_points;
+    s.imu = enqueue_imu;
+    s.info = sink_info;
+    s.wait_for_room = sink_wait_for_room;
+    s.finished = sink_finished;
+    return s;
 }
 
-// ---- Signal ----
-static void on_sigint(int) { g_running.store(false); }
+// Live devices: the SDK calls PointCloudCallback / ImuCallback / InfoChangeCallback itself.
+class SdkSource : public BridgeSource {
+public:
+    explicit SdkSource(const char* cfg_path) : cfg_path_(cfg_path), started_(false) {}
+    ~SdkSource() { stop(); }
+
+    const char* name() const { return "sdk"; }
+
+    bool start(const BridgeSourceSink&) {
+        // Init SDK2 (host_ip inferred from JSON; pass "")
+        if (!LivoxLidarSdkInit(cfg_path_, "", NULL)) {
+            std::cerr << "LivoxLidarSdkInit failed." << std::endl;
+            return false;
+        }
+        // Register callbacks
+        SetLivoxLidarPointCloudCallBack(PointCloudCallback, NULL);
+        SetLivoxLidarImuDataCallback(ImuCallback, NULL);
+        SetLivoxLidarInfoChangeCallback(InfoChangeCallback, NULL);
+
+        // Start SDK worker
+        if (!LivoxLidarSdkStart()) {
+            std::cerr << "LivoxLidarSdkStart failed." << std::endl;
+            LivoxLidarSdkUninit();
+            return false;
+        }
+        started_ = true;
+        return true;
+    }
+
+    void stop() {
+        if (started_) LivoxLidarSdkUninit();
+        started_ = false;
+    }
+
+private:
+    const char* cfg_path_;
+    bool started_;
+};
+
+static void usage() {
+    std::cerr << "usage: livox_bridge [--source <sdk|replay|synthetic>] [--record <dir>]\n"
+                 "                    [--replay <file.lvxr> [--speed <x>] [--loop]]" << std::endl;
+}
 
 // ---- Main ----
-int main(int /*argc*/, char** /*argv*/) {
-    signal(SIGINT, on_sigint);
+// livox_bridge_bench runs the bridge in forked children and calls this instead.
+#ifdef LIVOX_BRIDGE_BENCH
+int livox_bridge_main(int argc, char** argv) {
+#else
+int main(int argc, char** argv) {
+#endif
+    // Block the shutdown signals before any thread exists (emitter, SDK) so they are all
+    // delivered to the reactor's signalfd
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    const int sig_fd = signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sig_fd < 0) { std::perror("signalfd"); return 3; }
+    g_start_ns = now_ns();
 
+    const char* record_dir = std::getenv("LIVOX_RECORD_DIR");
+    const char* source_name = std::getenv("LIVOX_SOURCE");
+    const char* replay_path = std::getenv("LIVOX_REPLAY");
+    double replay_speed = 1.0;                // 0 = as fast as the queues drain
+    if (const char* p = std::getenv("LIVOX_REPLAY_SPEED")) replay_speed = std::atof(p);
+    bool replay_loop = (std::getenv("LIVOX_REPLAY_LOOP") && std::string(std::getenv("LIVOX_REPLAY_LOOP")) == "1");
+    if (const char* p = std::getenv("LIVOX_RECORD_CHUNK_MB")) g_record_chunk_bytes = (size_t)std::atoi(p) << 20;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--source" && i + 1 < argc) source_name = argv[++i];
+        else if (a == "--record" && i + 1 < argc) record_dir = argv[++i];
+        else if (a == "--replay" && i + 1 < argc) replay_path = argv[++i];
+        else if (a == "--speed" && i + 1 < argc) replay_speed = std::atof(argv[++i]);
+        else if (a == "--loop") replay_loop = true;
+        else { usage(); return 2; }
+    }
+    if (replay_path && !*replay_path) replay_path = NULL;
+    if (!source_name || !*source_name) {
+#ifdef LIVOX_BRIDGE_NO_SDK
+        source_name = replay_path ? "replay" : "synthetic";
+#else
+        source_name = replay_path ? "replay" : "sdk";
+#endif
+    }
+    const std::string source_kind = source_name;
+    if (source_kind != "sdk" && source_kind != "replay" && source_kind != "synthetic") {
+        std::cerr << "LIVOX_SOURCE must be sdk, replay or synthetic" << std::endl;
+        return 2;
+    }
+    if (source_kind == "replay" && !replay_path) {
+        std::cerr << "the replay source needs LIVOX_REPLAY or --replay <file.lvxr>" << std::endl;
+        return 2;
+    }
+
+    // Only the SDK needs the config; other sources read it for extrinsics if it is set
     const char* cfg_path = std::getenv("MID360_CONFIG_PATH");
-    if (!cfg_path || std::strlen(cfg_path) == 0) {
+    if (!cfg_path) cfg_path = "";
+    if (!*cfg_path && source_kind == "sdk") {
         std::cerr << "MID360_CONFIG_PATH env var is required (SDK2 JSON)." << std::endl;
         return 2;
     }
-    if (const char* p = std::getenv("LIVOX_UDP_PORT")) g_emit_port = (uint16_t)std::atoi(p);
     if (const char* p = std::getenv("LIVOX_CTL_PORT")) g_ctl_port = (uint16_t)std::atoi(p);
-    g_emit_stdout = (std::getenv("LIVOX_BRIDGE_STDOUT") &&
-        std::string(std::getenv("LIVOX_BRIDGE_STDOUT")) == "1");
-
-    // UDP emitter
-    g_udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (g_udp_sock < 0) { std::perror("udp socket"); return 3; }
-    std::memset(&g_udp_dst, 0, sizeof(g_udp_dst));
-    g_udp_dst.sin_family = AF_INET;
-    g_udp_dst.sin_addr.s_addr = inet_addr("127.0.0.1");
-    g_udp_dst.sin_port = htons(g_emit_port);
-
-    // Init SDK2 (host_ip inferred from JSON; pass "")
-    if (!LivoxLidarSdkInit(cfg_path, "", NULL)) {
-        std::cerr << "LivoxLidarSdkInit failed." << std::endl;
-        return 4;
+    if (const char* p = std::getenv("LIVOX_FRAME_MS")) g_frame_window_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    if (const char* p = std::getenv("LIVOX_FRAME_SPLIT_CNT")) g_frame_split_cnt = std::string(p) == "1";
+    if (const char* p = std::getenv("LIVOX_FRAME_MAX_POINTS")) g_frame_max_points = (size_t)std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_EMIT_CPU")) g_emit_cpu = std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_EMIT_PRIO")) g_emit_prio = std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_EMIT_IDLE_US")) g_emit_idle_us = (uint64_t)std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_QUEUE_STATS_MS")) g_stats_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    if (const char* p = std::getenv("LIVOX_STATS_MS")) g_stats_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    g_fusion = (std::getenv("LIVOX_FUSION") && std::string(std::getenv("LIVOX_FUSION")) == "1");
+    g_apply_extrinsics = (std::getenv("LIVOX_EXTRINSICS") &&
+        std::string(std::getenv("LIVOX_EXTRINSICS")) == "1");
+    if ((g_fusion || g_apply_extrinsics) && *cfg_path) {
+        const int n = g_extrinsics.load(cfg_path);
+        if (n < 0) std::cerr << "extrinsics: cannot parse " << cfg_path << ", using identity" << std::endl;
+        else std::cerr << "extrinsics: " << n << " lidar(s) from " << cfg_path
+                       << " (" << point_transform_isa() << ")" << std::endl;
+    }
+    if (g_fusion) {
+        if (!g_frame_window_ns) {
+            std::cerr << "LIVOX_FUSION needs a scan window; using LIVOX_FRAME_MS=100" << std::endl;
+            g_frame_window_ns = 100000000ull;
+        }
+        // Units are not frame-synchronized: close fused scans on the window only
+        const size_t units = g_extrinsics.size() ? g_extrinsics.size() : 2;
+        g_fused_asm = new FrameAssembler(g_frame_max_points * units);
+        g_fused_asm->configure(g_frame_window_ns, false);
+    }
+    if (const char* p = std::getenv("LIVOX_FILTER_NOISE")) {
+        const int level = std::atoi(p);
+        if (level < 0 || level > 3) {
+            std::cerr << "LIVOX_FILTER_NOISE must be 0..3" << std::endl;
+            return 2;
+        }
+        g_point_drop.noise_level = (uint8_t)level;
     }
-    // Register callbacks
-    SetLivoxLidarPointCloudCallBack(PointCloudCallback, NULL);
-    SetLivoxLidarImuDataCallback(ImuCallback, NULL);
-    SetLivoxLidarInfoChangeCallback(InfoChangeCallback, NULL);
+    g_point_drop.zero = (std::getenv("LIVOX_FILTER_ZERO") && std::string(std::getenv("LIVOX_FILTER_ZERO")) == "1");
+    if (g_point_drop.enabled() && !g_frame_window_ns)
+        std::cerr << "LIVOX_FILTER_NOISE / LIVOX_FILTER_ZERO need LIVOX_FRAME_MS > 0; per-packet points are not filtered"
+                  << std::endl;
+    if (g_fused_asm) g_fused_asm->set_drop(g_point_drop);
+    if (const char* p = std::getenv("LIVOX_POINT_LAYOUT")) {
+        const std::string layout(p);
+        if (layout != "rows" && layout != "columns") {
+            std::cerr << "LIVOX_POINT_LAYOUT must be rows or columns" << std::endl;
+            return 2;
+        }
+        g_columns = layout == "columns";
+    }
+    if (const char* p = std::getenv("LIVOX_CLOCK_WINDOW_MS")) g_clock_window_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    g_clock_trust_sync = (std::getenv("LIVOX_CLOCK_TRUST_SYNC") &&
+        std::string(std::getenv("LIVOX_CLOCK_TRUST_SYNC")) == "1");
+    if (const char* p = std::getenv("LIVOX_CLOCK_SYNC_OFFSET_NS")) g_clock_sync_offset_ns = std::atoll(p);
+    GnssConfig gnss;
+    if (const char* p = std::getenv("LIVOX_GNSS_DEVICE")) gnss.device = p;
+    if (const char* p = std::getenv("LIVOX_GNSS_BAUD")) gnss.baud = std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_GNSS_PPS")) gnss.pps = p;
+
+    if (const char* p = std::getenv("LIVOX_IMU_BATCH")) g_imu_batch = (size_t)std::atoi(p);
+    if (const char* p = std::getenv("LIVOX_IMU_BATCH_MS")) g_imu_batch_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    g_imu_preint = (std::getenv("LIVOX_IMU_PREINT") && std::string(std::getenv("LIVOX_IMU_PREINT")) == "1");
+    if (g_imu_batch > ImuChannel::kHistory) g_imu_batch = ImuChannel::kHistory;
+    // batches and preintegration go to binary consumers: the default route with
+    // LIVOX_BRIDGE_FORMAT=binary / compressed and such subscribers, NDJSON ones keep per-sample IMU
+    if (g_imu_preint && !g_frame_window_ns) {
+        std::cerr << "LIVOX_IMU_PREINT needs LIVOX_FRAME_MS > 0; disabled" << std::endl;
+        g_imu_preint = false;
+    }
+    g_deskew = (std::getenv("LIVOX_DESKEW") && std::string(std::getenv("LIVOX_DESKEW")) == "1");
+    if (g_deskew && !g_frame_window_ns) {
+        std::cerr << "LIVOX_DESKEW needs LIVOX_FRAME_MS > 0; disabled" << std::endl;
+        g_deskew = false;
+    }
+    if (const char* p = std::getenv("LIVOX_DESKEW_STEP_US")) g_deskewer.configure((uint32_t)std::atoi(p) * 1000u);
+    if (const char* p = std::getenv("LIVOX_SUB_TTL_S")) g_sub_ttl_ns = (uint64_t)std::atoi(p) * 1000000000ull;
+    {
+        const char* t = std::getenv("LIVOX_CMD_TIMEOUT_MS");
+        const char* r = std::getenv("LIVOX_CMD_RETRIES");
+        const int timeout_ms = t ? std::atoi(t) : 1000;
+        const int retries = r ? std::atoi(r) : 2;
+        g_cmds.configure((uint64_t)(timeout_ms > 0 ? timeout_ms : 1000) * 1000000ull,
+            retries > 0 ? (unsigned)retries : 0, device_status_retryable);
+    }
+    if (std::getenv("LIVOX_GRID") && std::string(std::getenv("LIVOX_GRID")) == "1") {
+        GridMapConfig gc;
+        if (const char* p = std::getenv("LIVOX_GRID_CELL_M")) gc.cell_m = (float)std::atof(p);
+        if (const char* p = std::getenv("LIVOX_GRID_SIZE_M")) gc.size_m = (float)std::atof(p);
+        if (const char* p = std::getenv("LIVOX_GRID_OBSTACLE_M")) gc.obstacle_m = (float)std::atof(p);
+        if (const char* p = std::getenv("LIVOX_GRID_Z_MIN")) gc.z_min = (float)std::atof(p);
+        if (const char* p = std::getenv("LIVOX_GRID_Z_MAX")) gc.z_max = (float)std::atof(p);
+        if (!g_frame_window_ns) {
+            std::cerr << "LIVOX_GRID needs LIVOX_FRAME_MS > 0; disabled" << std::endl;
+        }
+        else if (!g_grid.configure(gc)) {
+            std::cerr << "LIVOX_GRID_*: cell 0.01..65 m, size > 0 and z_max > z_min required" << std::endl;
+            return 2;
+        }
+        else {
+            g_grid_tiles.resize(g_grid.tiles_per_side() * g_grid.tiles_per_side());
+        }
+    }
+
+    // Largest scan: the block size of the scan pool and the codec's output reservation
+    const size_t scan_points = g_fused_asm ? g_fused_asm->capacity() : g_frame_max_points;
+
+    if (const char* p = std::getenv("LIVOX_RANGE_IMAGE")) {
+        RangeImageConfig rc;
+        if (std::sscanf(p, "%ux%u", &rc.height, &rc.width) != 2) rc.height = 0;
+        if (const char* f = std::getenv("LIVOX_RANGE_FOV"))
+            if (std::sscanf(f, "%f,%f", &rc.fov_down_deg, &rc.fov_up_deg) != 2) rc.height = 0;
+        if (const char* g = std::getenv("LIVOX_RANGE_GPU")) rc.gpu = std::string(g) != "0";
+        if (!g_frame_window_ns) {
+            std::cerr << "LIVOX_RANGE_IMAGE needs LIVOX_FRAME_MS > 0; disabled" << std::endl;
+        }
+        else if (!g_range.configure(rc, scan_points)) {
+            std::cerr << "LIVOX_RANGE_IMAGE: <height>x<width> up to 4096x8192 and LIVOX_RANGE_FOV down < up required"
+                      << std::endl;
+            return 2;
+        }
+        else if (rc.gpu && !g_range.gpu()) {
+            std::cerr << "range image: no CUDA device or build, projecting on the CPU (" << g_range.device() << ")"
+                      << std::endl;
+        }
+    }
+
+    // Scan compression: started with scan assembly, for the default route or any subscriber
+    // that asks for "compressed" (per-packet points go out binary to those consumers)
+    if (g_frame_window_ns) {
+        int codec = scan_codec_default();
+        if (const char* p = std::getenv("LIVOX_CODEC")) {
+            codec = scan_codec_parse(p);
+            if (codec < 0 || !scan_codec_available((uint8_t)codec)) {
+                std::cerr << "LIVOX_CODEC: " << p << " is not built in (have: none"
+                          << (scan_codec_available(kCodecLz4) ? ", lz4" : "")
+                          << (scan_codec_available(kCodecZstd) ? ", zstd" : "") << ")" << std::endl;
+                return 2;
+            }
+        }
+        int level = 1;
+        size_t slots = 4;
+        if (const char* p = std::getenv("LIVOX_CODEC_LEVEL")) level = std::atoi(p);
+        if (const char* p = std::getenv("LIVOX_CODEC_SLOTS")) slots = (size_t)std::atoi(p);
+        if (!g_codec.start((uint8_t)codec, level, slots, scan_points)) {
+            std::cerr << "scan codec: cannot start " << scan_codec_name((uint8_t)codec) << std::endl;
+            return 3;
+        }
+    }
+
+    ScanFilterConfig fc;
+    if (const char* p = std::getenv("LIVOX_FILTER_RANGE_MIN")) fc.range_min = (float)std::atof(p);
+    if (const char* p = std::getenv("LIVOX_FILTER_RANGE_MAX")) fc.range_max = (float)std::atof(p);
+    if (const char* p = std::getenv("LIVOX_VOXEL_M")) fc.voxel = (float)std::atof(p);
+    if (const char* p = std::getenv("LIVOX_FILTER_ROI")) {
+        fc.roi = std::sscanf(p, "%f,%f,%f,%f,%f,%f", &fc.roi_min[0], &fc.roi_min[1], &fc.roi_min[2],
+            &fc.roi_max[0], &fc.roi_max[1], &fc.roi_max[2]) == 6;
+        if (!fc.roi) std::cerr << "LIVOX_FILTER_ROI must be xmin,ymin,zmin,xmax,ymax,zmax; ignored" << std::endl;
+    }
+    g_filter.configure(fc);
+    g_filter.reserve(scan_points);
 
-    // Start SDK worker
-    if (!LivoxLidarSdkStart()) {
-        std::cerr << "LivoxLidarSdkStart failed." << std::endl;
-        LivoxLidarSdkUninit();
-        return 5;
+    {
+        BackpressureConfig bc;
+        if (const char* p = std::getenv("LIVOX_BACKPRESSURE")) bc.enabled = std::string(p) != "0";
+        if (const char* p = std::getenv("LIVOX_BP_WINDOW_MS")) bc.window_ns = (uint64_t)std::atoi(p) * 1000000ull;
+        if (const char* p = std::getenv("LIVOX_BP_RECOVER")) bc.recover_windows = (uint32_t)std::atoi(p);
+        if (const char* p = std::getenv("LIVOX_BP_VOXEL_M")) bc.voxel_m = (float)std::atof(p);
+        if (const char* p = std::getenv("LIVOX_BP_SHED")) bc.shed_every = (uint32_t)std::atoi(p);
+        if (!bc.window_ns || !bc.recover_windows || bc.shed_every < 2 || !(bc.voxel_m > 0.0f)) {
+            std::cerr << "LIVOX_BP_*: window and recover > 0, shed >= 2 and voxel > 0 required" << std::endl;
+            return 2;
+        }
+        bc.downsample = g_frame_window_ns != 0;
+        g_backpressure.configure(bc);
+        g_subs.set_shed_every(bc.shed_every);
+        if (bc.enabled && bc.downsample) {
+            ScanFilterConfig vc;
+            vc.voxel = bc.voxel_m;
+            g_bp_filter.configure(vc);
+            g_bp_filter.reserve(scan_points);
+            g_bp_scan.resize(scan_points);
+        }
+    }
+
+    // Scan pool: a block per device assembler (the fused one is preallocated) and per codec slot
+    g_rt = (std::getenv("LIVOX_RT") && std::string(std::getenv("LIVOX_RT")) == "1");
+    const bool hugepages = (std::getenv("LIVOX_HUGEPAGES") && std::string(std::getenv("LIVOX_HUGEPAGES")) == "1");
+    size_t pool_blocks = 0;
+    if (g_frame_window_ns) pool_blocks = (g_fused_asm ? 0 : kMaxLidars) + (g_codec.running() ? g_codec.slots() : 0);
+    if (const char* p = std::getenv("LIVOX_POOL_BLOCKS")) pool_blocks = (size_t)std::atoi(p);
+    if (pool_blocks && scan_points) {
+        if (!g_scan_pool.open(scan_points * sizeof(BridgePoint), pool_blocks, hugepages)) {
+            std::perror("scan pool");
+            return 3;
+        }
+        if (hugepages && !g_scan_pool.hugepages())
+            std::cerr << "scan pool: no hugepages reserved (vm.nr_hugepages), using normal pages" << std::endl;
+        if (g_rt) g_scan_pool.prefault();
+    }
+    size_t queue_depth = 4096;
+    if (const char* p = std::getenv("LIVOX_QUEUE_DEPTH")) queue_depth = (size_t)std::atoi(p);
+    g_q_points = new SpscQueue<BridgeEvent>(queue_depth);
+
+    // Output transports: shm ring (optional), UDP socket and batcher
+    g_out.attach(&g_stats, &g_lat_sent);
+    if (const int rc = g_out.open_from_env("LIVOX", 18080, kEncNdjson)) return rc;
+    if (g_columns) g_col_scratch.resize(scan_points * kBridgeColumnsPointBytes);
+
+    // Warm restart: subscribers (their lanes need the batcher) and the frame seq
+    if (const char* p = std::getenv("LIVOX_STATE_FILE")) {
+        g_state_path = p;
+        if (g_state.load(p)) restore_state();
+        g_state_dirty = true;        // written once the emitter runs, "clean":false until shutdown
     }
 
-    // Control listener thread
-    std::thread ctl(control_thread);
+    if (record_dir && *record_dir) {
+        if (!g_recorder.open(record_dir, g_record_chunk_bytes)) {
+            std::perror("record");
+            return 3;
+        }
+        std::cerr << "recording to " << g_recorder.path() << std::endl;
+    }
+    SdkSource sdk(cfg_path);
+    ReplaySource replay;
+    SyntheticSource synthetic;
+    BridgeSource* source = &sdk;
+    if (source_kind == "replay") {
+        if (!replay.open(replay_path, replay_speed, replay_loop)) return 3;
+        source = &replay;
+    }
+    else if (source_kind == "synthetic") {
+        SyntheticConfig sc;
+        if (const char* p = std::getenv("LIVOX_SYNTH_DEVICES")) sc.devices = (size_t)std::atoi(p);
+        if (const char* p = std::getenv("LIVOX_SYNTH_PPS")) sc.point_rate = std::atof(p);
+        if (const char* p = std::getenv("LIVOX_SYNTH_POINTS")) sc.points_per_packet = (uint16_t)std::atoi(p);
+        if (const char* p = std::getenv("LIVOX_SYNTH_FORMAT")) sc.data_type = (uint8_t)std::atoi(p);
+        if (const char* p = std::getenv("LIVOX_SYNTH_IMU_HZ")) sc.imu_hz = std::atof(p);
+        if (const char* p = std::getenv("LIVOX_SYNTH_PACKETS")) sc.packets = (uint64_t)std::atoll(p);
+        sc.ptp = (std::getenv("LIVOX_SYNTH_PTP") && std::string(std::getenv("LIVOX_SYNTH_PTP")) == "1");
+        if (!synthetic.configure(sc)) return 2;
+        std::cerr << "synthetic source: " << sc.devices << " device(s) at "
+                  << (sc.point_rate > 0 ? std::to_string((uint64_t)sc.point_rate) + " points/s"
+                                        : std::string("queue speed")) << std::endl;
+        source = &synthetic;
+    }
 
-    // Run until SIGINT
-    while (g_running.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // RT mode: everything above is allocated; lock it and whatever is mapped later (thread
+    // stacks, SDK buffers) into RAM, and keep freed heap memory instead of returning it
+    if (g_rt) {
+#ifdef __GLIBC__
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+#endif
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            std::perror("LIVOX_RT: mlockall (needs CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK)");
     }
 
-    LivoxLidarSdkUninit();
-    if (ctl.joinable()) ctl.join();
-    if (g_udp_sock >= 0) close(g_udp_sock);
+    // Emitter first, so no callback ever finds a queue without a consumer
+    std::thread emitter(emitter_thread);
+
+    if (!source->start(source_sink())) {
+        g_emitter_running.store(false);
+        emitter.join();
+        return 4;
+    }
+
+    // GNSS time sync: devices appear in g_devices as the source discovers them
+    if (!gnss.device.empty()) {
+        if (!g_gnss.start(gnss, gnss_send, NULL)) {
+            std::perror(("GNSS time sync: " + gnss.device + (gnss.pps.empty() ? "" : " / " + gnss.pps)).c_str());
+            g_source_stopping.store(true);
+            source->stop();
+            g_emitter_running.store(false);
+            emitter.join();
+            return 3;
+        }
+        std::cerr << "GNSS time sync: " << gnss.device << " at " << gnss.baud << " baud, "
+                  << (gnss.pps.empty() ? std::string("no PPS (RMC sent on arrival)") : "PPS " + gnss.pps) << std::endl;
+    }
+
+    // Re-apply the cached config as soon as the source runs, without waiting for discovery
+    if (g_state.n_devices) {
+        if (BridgeEvent* ev = g_q_ctl.claim()) {
+            ev->kind = kEvRestore;
+            ev->enq_ns = 0;
+            g_q_ctl.commit();
+        }
+    }
+
+    // Control, timers and signals, until SIGINT/SIGTERM (or the source runs out)
+    const int ctl_fd = open_control_socket();
+    const int sig = run_reactor(sig_fd, ctl_fd);
+    if (sig) std::cerr << "livox_bridge: " << strsignal(sig) << ", shutting down" << std::endl;
+
+    if (ctl_fd >= 0) close(ctl_fd);
+    close(sig_fd);
+    g_gnss.stop();
+    g_source_stopping.store(true);
+    source->stop();
+    g_emitter_running.store(false);   // drains whatever the source queued before stopping
+    emitter.join();
+    g_codec.stop();
+    g_recorder.close();
+    g_out.close();
     return 0;
 }
@@ -0,0 +1,367 @@
+// Livox MID-360 Bridge - benchmark harness (no SDK or device needed)
+//
+// For each output transport a forked child runs the whole bridge (livox_bridge.cpp built
+// with LIVOX_BRIDGE_NO_SDK) on the synthetic source (synthetic_source.h), while this process
+// consumes its output like a client would:
+//
+//   ndjson   NDJSON records over UDP          (LIVOX_BRIDGE_FORMAT=ndjson)
+//   binary   binary frames over UDP           (LIVOX_BRIDGE_FORMAT=binary)
+//   shm      binary frames through the ring   (LIVOX_SHM_NAME, UDP output off)
+//   compressed  compressed scans over UDP     (LIVOX_BRIDGE_FORMAT=compressed, with
+//            --frame-ms > 0 only: per-packet points stay binary); every block is decoded
+//
+// Reported per transport: delivered points/s and MB/s, the share of generated points that
+// arrived, end-to-end latency percentiles (generation -> received by this process; the
+// synthetic devices are stamped gPTP with host CLOCK_REALTIME and the bridge trusts the
+// stamp) and the bridge process CPU time (user + system, synthetic generator included) per
+// million points; blocks that fail to decode count as lost. With --frame-ms > 0 records are scans and latency counts from the scan's
+// first point, so it includes the scan window. With --pps 0 the generator runs as fast as
+// the bridge drains (throughput only; latency is not meaningful on the virtual timeline).
+//
+// Any other LIVOX_* variable in the environment is passed to the bridge unchanged, e.g.
+// LIVOX_UDP_FLUSH_US=0 to compare unbatched sends.
+//
+//   livox_bridge_bench [--seconds 5] [--devices 1] [--pps 200000] [--frame-ms 0]
+//                      [--transports ndjson,binary,shm[,compressed]] [--port 18280] [--verbose]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "bridge_stats.h"
+#include "scan_codec.h"
+#include "shm_ring.h"
+
+int livox_bridge_main(int argc, char** argv);
+
+namespace {
+
+struct BenchOptions {
+    double seconds;
+    unsigned devices;
+    double pps;
+    unsigned frame_ms;
+    unsigned points_per_packet;
+    uint16_t port;
+    bool verbose;
+    std::vector<std::string> transports;
+
+    BenchOptions()
+        : seconds(5.0), devices(1), pps(200000.0), frame_ms(0), points_per_packet(96), port(18280),
+          verbose(false) {}
+};
+
+struct Tally {
+    uint64_t records;       // point / scan records (whole messages)
+    uint64_t points;
+    uint64_t bytes;         // everything received, incl. IMU / info / stats
+    uint64_t seq_gaps;      // binary messages missing from the seq sequence
+    uint64_t bad_blocks;    // compressed blocks that did not decode
+    uint64_t first_ns, last_ns;
+    uint32_t next_seq;
+    bool have_seq;
+    LatencyHistogram lat;
+
+    Tally()
+        : records(0), points(0), bytes(0), seq_gaps(0), bad_blocks(0), first_ns(0), last_ns(0), next_seq(0),
+          have_seq(false) {}
+};
+
+uint64_t mono_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t rt_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void note_record(Tally& t, uint64_t points, uint64_t stamp_ns) {
+    const uint64_t now = rt_ns();
+    ++t.records;
+    t.points += points;
+    if (now > stamp_ns) t.lat.record(now - stamp_ns);
+}
+
+uint64_t json_u64(const char* line, const char* end, const char* key) {
+    const size_t klen = std::strlen(key);
+    for (const char* p = line; p + klen < end; ++p)
+        if (std::memcmp(p, key, klen) == 0) return std::strtoull(p + klen, NULL, 10);
+    return 0;
+}
+
+void consume_ndjson_line(Tally& t, const char* line, const char* end) {
+    static const char kFrame[] = "{\"type\":\"frame\"", kScan[] = "{\"type\":\"scan\"";
+    const size_t n = (size_t)(end - line);
+    if ((n > sizeof(kFrame) && std::memcmp(line, kFrame, sizeof(kFrame) - 1) == 0) ||
+        (n > sizeof(kScan) && std::memcmp(line, kScan, sizeof(kScan) - 1) == 0))
+        note_record(t, json_u64(line, end, "\"n_points\":"), json_u64(line, end, "\"ts_us\":") * 1000);
+}
+
+// One datagram or ring record: NDJSON lines and/or binary messages, back to back.
+void consume(Tally& t, const uint8_t* p, size_t len) {
+    const uint64_t now = mono_ns();
+    if (!t.first_ns) t.first_ns = now;
+    t.last_ns = now;
+    t.bytes += len;
+    const uint8_t* end = p + len;
+    while (p < end) {
+        if (*p == '{') {
+            const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(p, '\n', (size_t)(end - p)));
+            const uint8_t* line_end = nl ? nl : end;
+            consume_ndjson_line(t, reinterpret_cast<const char*>(p), reinterpret_cast<const char*>(line_end));
+            p = nl ? nl + 1 : end;
+            continue;
+        }
+        BridgeFrameHeader h;
+        if ((size_t)(end - p) < sizeof(h)) break;
+        std::memcpy(&h, p, sizeof(h));
+        if (h.magic != kBridgeFrameMagic || (size_t)(end - p) < sizeof(h) + h.payload_len) break;
+        p += sizeof(h) + h.payload_len;
+        if (h.frag_index == 0) {
+            if (t.have_seq && h.seq > t.next_seq) t.seq_gaps += h.seq - t.next_seq;
+            if (!t.have_seq || h.seq >= t.next_seq) t.next_seq = h.seq + 1;
+            t.have_seq = true;
+        }
+        if (h.msg_type == kBridgeMsgScanCompressed) {
+            static BridgePoint pts[kCodecBlockPoints];
+            static uint8_t scratch[kCodecMaxRaw];
+            if (!scan_codec_decode(p - h.payload_len, h.payload_len, h.point_count, pts, scratch)) {
+                ++t.bad_blocks;
+                continue;
+            }
+        }
+        else if (h.msg_type != kBridgeMsgPoints && h.msg_type != kBridgeMsgScan) {
+            continue;
+        }
+        // a message counts as received (and for latency) when its last fragment arrives
+        if (h.frag_index + 1 == h.frag_count) note_record(t, h.point_count, h.stamp_ns);
+        else t.points += h.point_count;
+    }
+}
+
+double pct_us(const LatencyHistogram::Snapshot& s, double q) {
+    const uint64_t v = s.percentile(q);
+    return (v < s.max ? v : s.max) / 1000.0;
+}
+
+int open_receiver(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { std::perror("bench socket"); return -1; }
+    int rcvbuf = 32 << 20;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::perror("bench bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void set_env(const char* k, const std::string& v) { setenv(k, v.c_str(), 1); }
+
+// Child: configure the bridge through its environment and run it in-process.
+int run_bridge_child(const BenchOptions& o, const std::string& transport, const std::string& shm_name,
+    uint64_t packets) {
+    if (!o.verbose) {
+        const int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) { dup2(devnull, 2); close(devnull); }
+    }
+    set_env("LIVOX_SOURCE", "synthetic");
+    set_env("LIVOX_SYNTH_DEVICES", std::to_string(o.devices));
+    set_env("LIVOX_SYNTH_PPS", std::to_string(o.pps));
+    set_env("LIVOX_SYNTH_POINTS", std::to_string(o.points_per_packet));
+    set_env("LIVOX_SYNTH_PACKETS", std::to_string(packets));
+    set_env("LIVOX_SYNTH_PTP", "1");
+    set_env("LIVOX_CLOCK_TRUST_SYNC", "1");
+    set_env("LIVOX_CLOCK_SYNC_OFFSET_NS", "0");
+    set_env("LIVOX_FRAME_MS", std::to_string(o.frame_ms));
+    set_env("LIVOX_STATS_MS", "0");
+    set_env("LIVOX_CTL_PORT", std::to_string(o.port + 1));
+    set_env("LIVOX_BRIDGE_FORMAT", transport == "shm" ? "binary" : transport);
+    if (transport == "shm") {
+        set_env("LIVOX_UDP_PORT", "0");
+        set_env("LIVOX_SHM_NAME", shm_name);
+        set_env("LIVOX_SHM_SLOTS", "16384");
+        // a whole scan per slot when assembling, one packet otherwise
+        set_env("LIVOX_SHM_SLOT_BYTES", o.frame_ms ? std::to_string(1310720u * o.devices) : "4096");
+        if (o.frame_ms) set_env("LIVOX_SHM_SLOTS", "256");
+    }
+    else {
+        set_env("LIVOX_UDP_PORT", std::to_string(o.port));
+        unsetenv("LIVOX_SHM_NAME");
+    }
+    char arg0[] = "livox_bridge";
+    char* argv[] = { arg0, NULL };
+    return livox_bridge_main(1, argv);
+}
+
+bool run_transport(const BenchOptions& o, const std::string& transport) {
+    const double rate = o.pps > 0 ? o.pps : 200000.0;
+    const uint64_t packets = (uint64_t)(rate * o.seconds / o.points_per_packet);
+    const uint64_t expected = packets * o.points_per_packet * o.devices;
+    const std::string shm_name = "livox_bench_" + std::to_string(getpid());
+
+    int fd = -1;
+    if (transport != "shm" && (fd = open_receiver(o.port)) < 0) return false;
+
+    // Fork while this process is still single-threaded; the child owns a fresh bridge.
+    std::cout.flush();
+    const pid_t child = fork();
+    if (child < 0) { std::perror("fork"); return false; }
+    if (child == 0) {
+        if (fd >= 0) close(fd);
+        _exit(run_bridge_child(o, transport, shm_name, packets));
+    }
+
+    Tally t;
+    ShmRingReader ring;
+    static uint8_t bufs[64][65536];
+    mmsghdr msgs[64];
+    iovec iov[64];
+    for (int i = 0; i < 64; ++i) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = sizeof(bufs[i]);
+        std::memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    static std::vector<uint8_t> rec(4u << 20);
+
+    rusage ru;
+    std::memset(&ru, 0, sizeof(ru));
+    int status = 0;
+    bool exited = false;
+    uint64_t quiet_since = 0;
+    const uint64_t t_begin = mono_ns();
+    for (;;) {
+        size_t got = 0;
+        if (fd >= 0) {
+            const int n = recvmmsg(fd, msgs, 64, MSG_DONTWAIT, NULL);
+            for (int i = 0; i < n; ++i) consume(t, bufs[i], msgs[i].msg_len);
+            if (n > 0) got = (size_t)n;
+            else if (!exited) {
+                pollfd pfd = { fd, POLLIN, 0 };
+                poll(&pfd, 1, 10);
+            }
+        }
+        else {
+            if (!ring.is_open()) ring.open(shm_name, true);
+            for (size_t len; ring.is_open() && got < 4096 && (len = ring.read(rec.data(), rec.size())) != 0; ++got)
+                consume(t, rec.data(), len);
+            if (!got && !exited) {
+                timespec ts = { 0, 50000 };
+                nanosleep(&ts, NULL);
+            }
+        }
+        if (!exited && wait4(child, &status, WNOHANG, &ru) == child) exited = true;
+        if (exited) {
+            // drain what is still in flight, then stop after 200 ms of silence
+            const uint64_t now = mono_ns();
+            if (got) quiet_since = 0;
+            else if (!quiet_since) quiet_since = now;
+            else if (now - quiet_since > 200000000ull) break;
+        }
+        else if (mono_ns() - t_begin > (uint64_t)((o.seconds + 30) * 1e9)) {
+            std::cerr << transport << ": bridge did not finish, killing it" << std::endl;
+            kill(child, SIGKILL);
+        }
+    }
+    if (fd >= 0) close(fd);
+    const uint64_t ring_lost = ring.lost();
+    ring.close();
+    shm_unlink(("/" + shm_name).c_str());
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << transport << ": bridge exited with status " << status << std::endl;
+        return false;
+    }
+
+    LatencyHistogram::Snapshot s;
+    t.lat.snapshot(&s);
+    const double span = t.last_ns > t.first_ns ? (t.last_ns - t.first_ns) / 1e9 : 0.0;
+    const double cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    // latency columns: bucket upper bounds (~6%), capped at the exact max; none on the
+    // virtual timeline of --pps 0
+    char lat[64];
+    if (o.pps > 0)
+        std::snprintf(lat, sizeof(lat), "%9.1f %9.1f %9.1f %9.1f", pct_us(s, 0.50), pct_us(s, 0.99),
+            pct_us(s, 0.999), s.max / 1000.0);
+    else
+        std::snprintf(lat, sizeof(lat), "%9s %9s %9s %9s", "-", "-", "-", "-");
+    std::printf("%-10s %12.0f %9.1f %8.2f%% %s %8.3f %10.1f %8" PRIu64 "\n",
+        transport.c_str(), span > 0 ? t.points / span : 0.0, span > 0 ? t.bytes / span / 1e6 : 0.0,
+        expected ? 100.0 * t.points / expected : 0.0, lat,
+        cpu, expected ? cpu * 1000.0 / (expected / 1e6) : 0.0, t.seq_gaps + ring_lost + t.bad_blocks);
+    std::fflush(stdout);
+    return true;
+}
+
+void usage() {
+    std::cerr << "usage: livox_bridge_bench [--seconds <s>] [--devices <n>] [--pps <points/s, 0 = max>]\n"
+                 "                          [--frame-ms <ms>] [--points <per packet>]\n"
+                 "                          [--transports ndjson,binary,shm,compressed] [--port <udp>] [--verbose]"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions o;
+    std::string transports;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--seconds" && i + 1 < argc) o.seconds = std::atof(argv[++i]);
+        else if (a == "--devices" && i + 1 < argc) o.devices = (unsigned)std::atoi(argv[++i]);
+        else if (a == "--pps" && i + 1 < argc) o.pps = std::atof(argv[++i]);
+        else if (a == "--frame-ms" && i + 1 < argc) o.frame_ms = (unsigned)std::atoi(argv[++i]);
+        else if (a == "--points" && i + 1 < argc) o.points_per_packet = (unsigned)std::atoi(argv[++i]);
+        else if (a == "--transports" && i + 1 < argc) transports = argv[++i];
+        else if (a == "--port" && i + 1 < argc) o.port = (uint16_t)std::atoi(argv[++i]);
+        else if (a == "--verbose") o.verbose = true;
+        else { usage(); return 2; }
+    }
+    // compressed is binary for per-packet records, so by default only run it on scans
+    if (transports.empty()) transports = o.frame_ms ? "ndjson,binary,shm,compressed" : "ndjson,binary,shm";
+    for (size_t b = 0; b <= transports.size();) {
+        size_t e = transports.find(',', b);
+        if (e == std::string::npos) e = transports.size();
+        const std::string tr = transports.substr(b, e - b);
+        if (tr != "ndjson" && tr != "binary" && tr != "shm" && tr != "compressed") { usage(); return 2; }
+        o.transports.push_back(tr);
+        b = e + 1;
+    }
+    if (o.seconds <= 0 || o.devices < 1 || o.points_per_packet < 1) { usage(); return 2; }
+
+    std::printf("livox_bridge_bench: %u device(s), %s, %s, %.1f s per transport\n", o.devices,
+        o.pps > 0 ? (std::to_string((uint64_t)o.pps) + " points/s each").c_str() : "max rate",
+        o.frame_ms ? (std::to_string(o.frame_ms) + " ms scans").c_str() : "per-packet records", o.seconds);
+    std::printf("%-10s %12s %9s %9s %9s %9s %9s %9s %8s %10s %8s\n", "transport", "points/s", "MB/s",
+        "delivered", "p50_us", "p99_us", "p999_us", "max_us", "cpu_s", "cpu_ms/Mpt", "lost");
+    bool ok = true;
+    for (size_t i = 0; i < o.transports.size(); ++i) ok = run_transport(o, o.transports[i]) && ok;
+    return ok ? 0 : 1;
+}
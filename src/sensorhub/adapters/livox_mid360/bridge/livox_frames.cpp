@@ -0,0 +1,210 @@
+// Livox MID-360 Bridge - Python extension: bridge output as numpy arrays
+//
+//   import livox_frames
+//   rx = livox_frames.Receiver(queue_depth=64)
+//   rx.open_udp(0)                  # or rx.open_shm("livox"); then subscribe rx.port
+//   rx.start()
+//   hdr, pts = rx.recv(100)         # bridge_frame.FrameHeader, structured array (or None)
+//
+// Receiving, reassembly and decoding run on a C++ thread (frame_receiver.h); recv() waits
+// with the GIL released. Every array is a view over the record's own buffer (freed with
+// the array, no copy), with the dtype bridge_frame.POINT_DTYPES gives its point_format:
+// scans and compressed scans are POINT_XYZRT, per-packet points keep the SDK layout, IMU
+// batches / preint their records. Columnar scans (LIVOX_POINT_LAYOUT=columns) come back as
+// bridge_frame.PointColumns over the record's buffer, one contiguous array per field, and
+// range images (LIVOX_RANGE_IMAGE) as bridge_frame.RangeImage, its range_m / intensity
+// (height, width) arrays views of the same buffer.
+// Headers are bridge_frame.FrameHeader for the whole message (frag_count 1); compressed
+// scans come back as msg 2.
+//
+//   rx = livox_frames.Receiver(queue_depth=0, history=256)   # history only, no recv()
+//   ring = rx.points_history        # livox_frames.SampleRing (sample_ring.h), or rx.imu_history
+//   ring.latest()                   # (stamp_ns, (hdr, pts)) of the newest scan, or None
+//   ring.last(10)                   # the 10 newest, oldest first
+//   seq, new = ring.since(seq)      # entries appended since the last call
+//   ring.stamps()                   # int64 stamp column in slot order, a view (no copy)
+//   ring.rows()                     # the records' headers in the same order, raw bytes;
+//                                   # bridge_frame.header_column(ring) types them
+//
+// The receive thread fills the history itself, so keeping it costs Python nothing per
+// message; records in it are shared and their arrays are read-only.
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "frame_receiver.h"
+
+namespace py = pybind11;
+
+namespace {
+
+// bridge_frame.FrameHeader / POINT_DTYPES / PointColumns / RangeImage; never freed, they
+// must outlive the interpreter's module teardown
+py::object* g_header_type = NULL;
+py::object* g_dtypes = NULL;
+py::object* g_columns_type = NULL;
+py::object* g_range_type = NULL;
+
+py::object header_tuple(const BridgeFrameHeader& h) {
+    return (*g_header_type)(py::bytes(reinterpret_cast<const char*>(&h), 4), h.version, h.msg_type,
+        h.point_format, h.time_type, h.handle, h.seq, h.frag_index, h.frag_count, h.point_count, h.payload_len,
+        h.frame_cnt, h.flags, h.reserved, h.host_ts_ns, h.device_ts_ns, h.stamp_ns);
+}
+
+// The record's payload as a uint8 array that keeps the record alive.
+py::array_t<uint8_t> raw_bytes(const FrameRecordPtr& rec) {
+    if (rec->payload.empty()) return py::array_t<uint8_t>(0);
+    py::capsule owner(new FrameRecordPtr(rec), [](void* p) { delete static_cast<FrameRecordPtr*>(p); });
+    return py::array_t<uint8_t>({ (py::ssize_t)rec->payload.size() }, { (py::ssize_t)1 }, rec->payload.data(), owner);
+}
+
+// (header, array) sharing the record; records of an unknown point_format come back as bytes.
+py::object to_python(const FrameRecordPtr& rec, bool shared) {
+    py::object hdr = header_tuple(rec->h);
+    if (rec->h.point_format == kBridgeRangeImageRows) {
+        const size_t rows = rec->h.point_count;
+        const size_t width = rows ? rec->payload.size() / (rows * kBridgeRangePixelBytes) : 0;
+        py::object image = (*g_range_type)(raw_bytes(rec), rows, width);
+        if (shared) image.attr("setflags")(false);
+        return py::make_tuple(hdr, image);
+    }
+    if (rec->h.point_format == kBridgePointXyzrtColumns) {
+        const size_t n = rec->payload.size() / kBridgeColumnsPointBytes;
+        py::object cols = (*g_columns_type)(raw_bytes(rec), n);
+        if (shared) cols.attr("setflags")(false);
+        return py::make_tuple(hdr, cols);
+    }
+    py::object dtype = g_dtypes->attr("get")(rec->h.point_format);
+    if (dtype.is_none())
+        return py::make_tuple(hdr, py::bytes(reinterpret_cast<const char*>(rec->payload.data()), rec->payload.size()));
+    py::dtype dt = py::reinterpret_borrow<py::dtype>(dtype);
+    const py::ssize_t item = dt.itemsize();
+    const py::ssize_t n = item ? (py::ssize_t)rec->payload.size() / item : 0;
+    if (!n) return py::make_tuple(hdr, py::array(dt, std::vector<py::ssize_t>{ 0 }));
+    py::capsule owner(new FrameRecordPtr(rec), [](void* p) { delete static_cast<FrameRecordPtr*>(p); });
+    py::array arr(dt, { n }, { item }, rec->payload.data(), owner);
+    if (shared) arr.attr("flags").attr("writeable") = false;
+    return py::make_tuple(hdr, arr);
+}
+
+py::object entry_to_python(const FrameHistory::Entry& e) {
+    return py::make_tuple(e.stamp_ns, to_python(e.value, true));
+}
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    const int e = errno;
+    throw std::runtime_error(what + ": " + (e ? std::strerror(e) : "failed"));
+}
+
+}  // namespace
+
+PYBIND11_MODULE(livox_frames, m) {
+    m.doc() = "livox_bridge frames as zero-copy numpy arrays (see frame_receiver.h)";
+    py::module_ bf = py::module_::import("sensorhub.adapters.livox_mid360.bridge_frame");
+    g_header_type = new py::object(bf.attr("FrameHeader"));
+    g_dtypes = new py::object(bf.attr("POINT_DTYPES"));
+    g_columns_type = new py::object(bf.attr("PointColumns"));
+    g_range_type = new py::object(bf.attr("RangeImage"));
+
+    py::class_<FrameHistory, std::shared_ptr<FrameHistory>>(m, "SampleRing")
+        .def("latest",
+            [](const FrameHistory& ring) -> py::object {
+                FrameHistory::Entry e;
+                if (!ring.latest(&e)) return py::none();
+                return entry_to_python(e);
+            },
+            "Newest entry as (stamp_ns, (FrameHeader, array)), or None")
+        .def("last",
+            [](const FrameHistory& ring, size_t k) {
+                std::vector<FrameHistory::Entry> got;
+                ring.last(k, &got);
+                py::list out;
+                for (size_t i = 0; i < got.size(); ++i) out.append(entry_to_python(got[i]));
+                return out;
+            },
+            py::arg("k"), "Up to k newest entries, oldest first")
+        .def("since",
+            [](const FrameHistory& ring, uint64_t after) {
+                std::vector<FrameHistory::Entry> got;
+                const uint64_t head = ring.since(after, &got);
+                py::list out;
+                for (size_t i = 0; i < got.size(); ++i) out.append(entry_to_python(got[i]));
+                return py::make_tuple(head, out);
+            },
+            py::arg("after"), "(seq, entries after seq `after`, oldest first); pass seq back next time")
+        .def("stamps",
+            [](const std::shared_ptr<FrameHistory>& ring) {
+                py::array_t<int64_t> arr({ (py::ssize_t)ring->capacity() }, { (py::ssize_t)sizeof(int64_t) },
+                    ring->stamps(), py::cast(ring));
+                arr.attr("flags").attr("writeable") = false;
+                return arr;
+            },
+            "stamp_ns column in slot order ((seq - 1) % capacity), a read-only view")
+        .def("rows",
+            [](const std::shared_ptr<FrameHistory>& ring) {
+                py::array_t<uint8_t> arr({ (py::ssize_t)(ring->capacity() * sizeof(BridgeFrameHeader)) },
+                    { (py::ssize_t)1 }, reinterpret_cast<const uint8_t*>(ring->rows()), py::cast(ring));
+                arr.attr("flags").attr("writeable") = false;
+                return arr;
+            },
+            "Header column (BridgeFrameHeader per slot, same order as stamps()) as read-only bytes")
+        .def("__len__", &FrameHistory::size)
+        .def_property_readonly("capacity", &FrameHistory::capacity)
+        .def_property_readonly("seq", &FrameHistory::seq);
+
+    py::class_<FrameReceiver>(m, "Receiver")
+        .def(py::init<size_t, size_t>(), py::arg("queue_depth") = 64, py::arg("history") = 0)
+        .def("open_udp",
+            [](FrameReceiver& r, uint16_t port, const std::string& addr, const std::string& group, int rcvbuf) {
+                errno = 0;
+                if (!r.open_udp(port, addr.c_str(), group.c_str(), rcvbuf))
+                    throw_errno("open_udp " + addr + ":" + std::to_string(port));
+            },
+            py::arg("port"), py::arg("addr") = "0.0.0.0", py::arg("group") = "", py::arg("rcvbuf") = 8 << 20,
+            "Bind a UDP port (0 = ephemeral), optionally joining a multicast group")
+        .def("open_shm",
+            [](FrameReceiver& r, const std::string& name) {
+                errno = 0;
+                if (!r.open_shm(name)) throw_errno("open_shm " + name);
+            },
+            py::arg("name"), "Map the bridge's shared-memory ring (LIVOX_SHM_NAME)")
+        .def("start", &FrameReceiver::start)
+        .def("stop", &FrameReceiver::stop, py::call_guard<py::gil_scoped_release>())
+        .def("recv",
+            [](FrameReceiver& r, int timeout_ms) -> py::object {
+                FrameRecordPtr rec;
+                {
+                    py::gil_scoped_release release;
+                    rec = r.pop(timeout_ms);
+                }
+                if (!rec) return py::none();
+                return to_python(rec, (bool)r.points_history());
+            },
+            py::arg("timeout_ms") = 100,
+            "Next whole message as (FrameHeader, numpy array), or None after timeout_ms (< 0 = wait)")
+        .def_property_readonly("points_history", &FrameReceiver::points_history,
+            "SampleRing of points / scans, None without history")
+        .def_property_readonly("imu_history", &FrameReceiver::imu_history, "SampleRing of IMU batches / preint")
+        .def_property_readonly("port", &FrameReceiver::port)
+        .def_property_readonly("running", &FrameReceiver::running)
+        .def("stats", [](const FrameReceiver& r) {
+            py::dict d;
+            d["datagrams"] = r.datagrams();
+            d["bytes"] = r.bytes();
+            d["records"] = r.records();
+            d["ndjson"] = r.ndjson();
+            d["incomplete"] = r.incomplete();
+            d["bad_blocks"] = r.bad_blocks();
+            d["dropped"] = r.dropped();
+            d["shm_lost"] = r.shm_lost();
+            d["kernel_drops"] = r.kernel_drops();
+            d["queued"] = r.queued();
+            d["capacity"] = r.capacity();
+            return d;
+        });
+}
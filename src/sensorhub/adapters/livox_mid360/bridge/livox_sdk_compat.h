@@ -0,0 +1,180 @@
+// Livox MID-360 Bridge - Livox SDK2 headers, or a stand-in when built without the SDK
+//
+// Normally this just includes the SDK. With LIVOX_BRIDGE_NO_SDK (livox_bridge_bench, CI) it
+// declares the subset of livox_lidar_def.h the bridge uses - the packed packet / point / IMU
+// layouts are the MID-360 wire format and must match the SDK exactly - and stubs for the SDK
+// entry points: LivoxLidarSdkInit fails, and every control request is acked at once with
+// kLivoxLidarStatusNotConnected, so a command still gets one ack per request issued.
+// The bridge then runs only on the synthetic and replay sources (bridge_source.h).
+
+#pragma once
+
+#ifndef LIVOX_BRIDGE_NO_SDK
+
+#include "livox_lidar_api.h"   // SDK entry points & controls
+#include "livox_lidar_def.h"   // types, enums, packet structs
+
+#else
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t livox_status;
+
+enum {
+    kLivoxLidarStatusSendFailed = -9,
+    kLivoxLidarStatusHandlerImplNotExist = -8,
+    kLivoxLidarStatusInvalidHandle = -7,
+    kLivoxLidarStatusTimeout = -6,
+    kLivoxLidarStatusNotSupported = -5,
+    kLivoxLidarStatusNotConnected = -4,
+    kLivoxLidarStatusChannelNotExist = -3,
+    kLivoxLidarStatusFailure = -1,
+    kLivoxLidarStatusSuccess = 0,
+};
+
+typedef enum {
+    kLivoxLidarImuData = 0,
+    kLivoxLidarCartesianCoordinateHighData = 0x01,
+    kLivoxLidarCartesianCoordinateLowData = 0x02,
+    kLivoxLidarSphericalCoordinateData = 0x03,
+} LivoxLidarPointDataType;
+
+typedef enum {
+    kLivoxLidarNormal = 0x01,
+    kLivoxLidarWakeUp = 0x02,
+    kLivoxLidarSleep = 0x03,
+    kLivoxLidarError = 0x04,
+    kLivoxLidarPowerOnSelfTest = 0x05,
+    kLivoxLidarMotorStarting = 0x06,
+    kLivoxLidarMotorStoping = 0x07,
+    kLivoxLidarUpgrade = 0x08,
+} LivoxLidarWorkMode;
+
+typedef enum {
+    kLivoxLidarScanPatternNoneRepetive = 0x00,
+    kLivoxLidarScanPatternRepetive = 0x01,
+    kLivoxLidarScanPatternRepetiveLowFrameRate = 0x02,
+} LivoxLidarScanPattern;
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  version;
+    uint16_t length;
+    uint16_t time_interval;   // 0.1 us
+    uint16_t dot_num;
+    uint16_t udp_cnt;
+    uint8_t  frame_cnt;
+    uint8_t  data_type;
+    uint8_t  time_type;
+    uint8_t  rsvd[12];
+    uint32_t crc32;
+    uint8_t  timestamp[8];
+    uint8_t  data[1];
+} LivoxLidarEthernetPacket;
+
+typedef struct {
+    int32_t x;   // mm
+    int32_t y;
+    int32_t z;
+    uint8_t reflectivity;
+    uint8_t tag;
+} LivoxLidarCartesianHighRawPoint;
+
+typedef struct {
+    int16_t x;   // cm
+    int16_t y;
+    int16_t z;
+    uint8_t reflectivity;
+    uint8_t tag;
+} LivoxLidarCartesianLowRawPoint;
+
+typedef struct {
+    uint32_t depth;
+    uint16_t theta;
+    uint16_t phi;
+    uint8_t  reflectivity;
+    uint8_t  tag;
+} LivoxLidarSpherPoint;
+
+typedef struct {
+    float gyro_x;
+    float gyro_y;
+    float gyro_z;
+    float acc_x;
+    float acc_y;
+    float acc_z;
+} LivoxLidarImuRawPoint;
+
+typedef struct {
+    uint8_t dev_type;
+    char    sn[16];
+    char    lidar_ip[16];
+} LivoxLidarInfo;
+
+typedef struct {
+    uint8_t  ret_code;
+    uint16_t error_key;
+} LivoxLidarAsyncControlResponse;
+
+typedef struct {
+    uint8_t ret_code;
+} LivoxLidarRmcSyncTimeResponse;
+
+typedef struct {
+    int32_t  yaw_start;
+    int32_t  yaw_stop;
+    int32_t  pitch_start;
+    int32_t  pitch_stop;
+    uint32_t rsvd;
+} FovCfg;
+#pragma pack(pop)
+
+typedef void (*LivoxLidarPointCloudCallBack)(const uint32_t handle, const uint8_t dev_type,
+    LivoxLidarEthernetPacket* data, void* client_data);
+typedef void (*LivoxLidarImuDataCallback)(const uint32_t handle, const uint8_t dev_type,
+    LivoxLidarEthernetPacket* data, void* client_data);
+typedef void (*LivoxLidarInfoChangeCallback)(const uint32_t handle, const LivoxLidarInfo* info,
+    void* client_data);
+typedef void (*LivoxLidarAsyncControlCallback)(livox_status status, uint32_t handle,
+    LivoxLidarAsyncControlResponse* response, void* client_data);
+typedef void (*LivoxLidarRmcSyncTimeCallBack)(livox_status status, uint32_t handle,
+    LivoxLidarRmcSyncTimeResponse* response, void* client_data);
+
+static inline bool LivoxLidarSdkInit(const char*, const char*, const void*) { return false; }
+static inline bool LivoxLidarSdkStart() { return false; }
+static inline void LivoxLidarSdkUninit() {}
+static inline void SetLivoxLidarPointCloudCallBack(LivoxLidarPointCloudCallBack, void*) {}
+static inline void SetLivoxLidarImuDataCallback(LivoxLidarImuDataCallback, void*) {}
+static inline void SetLivoxLidarInfoChangeCallback(LivoxLidarInfoChangeCallback, void*) {}
+
+static inline livox_status livox_compat_ack(uint32_t handle, LivoxLidarAsyncControlCallback cb, void* client_data) {
+    if (cb) cb(kLivoxLidarStatusNotConnected, handle, NULL, client_data);
+    return kLivoxLidarStatusNotConnected;
+}
+
+static inline livox_status SetLivoxLidarWorkMode(uint32_t h, LivoxLidarWorkMode, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status SetLivoxLidarScanPattern(uint32_t h, LivoxLidarScanPattern, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status SetLivoxLidarFovCfg1(uint32_t h, FovCfg*, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status EnableLivoxLidarFov(uint32_t h, uint8_t, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status EnableLivoxLidarImuData(uint32_t h, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status DisableLivoxLidarImuData(uint32_t h, LivoxLidarAsyncControlCallback cb, void* d) {
+    return livox_compat_ack(h, cb, d);
+}
+static inline livox_status SetLivoxLidarRmcSyncTime(uint32_t h, const char*, uint16_t,
+    LivoxLidarRmcSyncTimeCallBack cb, void* d) {
+    if (cb) cb(kLivoxLidarStatusNotConnected, h, NULL, d);
+    return kLivoxLidarStatusNotConnected;
+}
+
+#endif
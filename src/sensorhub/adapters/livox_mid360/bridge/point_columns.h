@@ -0,0 +1,155 @@
+// Livox MID-360 Bridge - columnar (SoA) point blocks and the noise / zero-return drop
+//
+// PointColumns holds up to kBlock points as separate x, y, z, t_offset_ns, reflectivity
+// and tag columns. The assembler decodes each SDK packet (~96 interleaved points) into one,
+// drops unwanted returns with drop_points(), applies extrinsics with point_transform.h's
+// kernel on the contiguous columns, and only then stores the survivors as BridgePoint.
+// columns_pack() writes BridgePoint records in the columnar wire layout
+// (kBridgePointXyzrtColumns, bridge_frame.h).
+//
+// The MID-360 tag byte grades each return: bits 0-1 spatial-position confidence, bits 2-3
+// intensity confidence (rain, fog, dust), each 0 = normal, 1 / 2 / 3 = high / moderate /
+// low confidence that the point is noise. Drop level L discards a point when either field
+// is in [1, L]; zero returns (x = y = z = 0, no echo) are discarded separately. The keep
+// mask is computed 8 lanes at a time with AVX2, 4 with NEON (scalar fallback, see
+// point_transform_isa()) and the columns are compacted in the same pass.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bridge_frame.h"
+#include "point_transform.h"
+
+struct PointDropConfig {
+    uint8_t noise_level;   // 0 = keep tagged points, 1..3 = drop tag fields in [1, level]
+    bool    zero;          // drop x = y = z = 0 returns
+
+    PointDropConfig() : noise_level(0), zero(false) {}
+    bool enabled() const { return noise_level != 0 || zero; }
+};
+
+struct PointColumns {
+    static const size_t kBlock = 128;
+    float    x[kBlock];
+    float    y[kBlock];
+    float    z[kBlock];
+    uint32_t t[kBlock];
+    uint8_t  refl[kBlock];
+    uint8_t  tag[kBlock];
+};
+
+// Keep bit of one point (the scalar path and the vector tails).
+static inline unsigned point_keep(const PointColumns& c, size_t i, const PointDropConfig& cfg) {
+    const unsigned s = c.tag[i] & 3u, q = (c.tag[i] >> 2) & 3u;
+    const bool noise = (s - 1u) < cfg.noise_level || (q - 1u) < cfg.noise_level;
+    const bool zero = cfg.zero && c.x[i] == 0.0f && c.y[i] == 0.0f && c.z[i] == 0.0f;
+    return !(noise || zero);
+}
+
+// Move the points of group [i, i + w) whose bit is set in `keep` down to *o.
+static inline void point_compact(PointColumns& c, size_t i, size_t w, unsigned keep, size_t* o) {
+    size_t d = *o;
+    for (size_t j = 0; j < w; ++j) {
+        // branch-free: always store, advance only over kept points
+        c.x[d] = c.x[i + j];
+        c.y[d] = c.y[i + j];
+        c.z[d] = c.z[i + j];
+        c.t[d] = c.t[i + j];
+        c.refl[d] = c.refl[i + j];
+        c.tag[d] = c.tag[i + j];
+        d += (keep >> j) & 1u;
+    }
+    *o = d;
+}
+
+// Drop noise-tagged and zero returns from c[0, n) in place; returns the points kept.
+static inline size_t drop_points(PointColumns& c, size_t n, const PointDropConfig& cfg) {
+    if (!cfg.enabled()) return n;
+    size_t i = 0, o = 0;
+#if defined(__AVX2__)
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i zero_i = _mm256_setzero_si256();
+    const __m256i level = _mm256_set1_epi32(cfg.noise_level + 1);
+    const __m256 zero_f = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        long long t8;
+        std::memcpy(&t8, c.tag + i, 8);
+        const __m256i tag = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(t8));
+        const __m256i s = _mm256_and_si256(tag, three);
+        const __m256i q = _mm256_and_si256(_mm256_srli_epi32(tag, 2), three);
+        // 0 < field < level + 1
+        const __m256i ns = _mm256_and_si256(_mm256_cmpgt_epi32(s, zero_i), _mm256_cmpgt_epi32(level, s));
+        const __m256i nq = _mm256_and_si256(_mm256_cmpgt_epi32(q, zero_i), _mm256_cmpgt_epi32(level, q));
+        __m256 drop = _mm256_castsi256_ps(_mm256_or_si256(ns, nq));
+        if (cfg.zero) {
+            const __m256 zx = _mm256_cmp_ps(_mm256_loadu_ps(c.x + i), zero_f, _CMP_EQ_OQ);
+            const __m256 zy = _mm256_cmp_ps(_mm256_loadu_ps(c.y + i), zero_f, _CMP_EQ_OQ);
+            const __m256 zz = _mm256_cmp_ps(_mm256_loadu_ps(c.z + i), zero_f, _CMP_EQ_OQ);
+            drop = _mm256_or_ps(drop, _mm256_and_ps(_mm256_and_ps(zx, zy), zz));
+        }
+        const unsigned keep = ~(unsigned)_mm256_movemask_ps(drop) & 0xFFu;
+        if (keep == 0xFFu && o == i) o += 8;   // nothing dropped so far: no moves
+        else point_compact(c, i, 8, keep, &o);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint32x4_t three = vdupq_n_u32(3);
+    const uint32x4_t zero_u = vdupq_n_u32(0);
+    const uint32x4_t level = vdupq_n_u32(cfg.noise_level + 1u);
+    const float32x4_t zero_f = vdupq_n_f32(0.0f);
+    const uint32x4_t bit = { 1, 2, 4, 8 };
+    for (; i + 4 <= n; i += 4) {
+        uint32_t t4;
+        std::memcpy(&t4, c.tag + i, 4);
+        const uint32x4_t tag = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(t4))));
+        const uint32x4_t s = vandq_u32(tag, three);
+        const uint32x4_t q = vandq_u32(vshrq_n_u32(tag, 2), three);
+        const uint32x4_t ns = vandq_u32(vcgtq_u32(s, zero_u), vcltq_u32(s, level));
+        const uint32x4_t nq = vandq_u32(vcgtq_u32(q, zero_u), vcltq_u32(q, level));
+        uint32x4_t drop = vorrq_u32(ns, nq);
+        if (cfg.zero) {
+            const uint32x4_t zx = vceqq_f32(vld1q_f32(c.x + i), zero_f);
+            const uint32x4_t zy = vceqq_f32(vld1q_f32(c.y + i), zero_f);
+            const uint32x4_t zz = vceqq_f32(vld1q_f32(c.z + i), zero_f);
+            drop = vorrq_u32(drop, vandq_u32(vandq_u32(zx, zy), zz));
+        }
+        const uint32x4_t kb = vbicq_u32(bit, drop);
+        const unsigned keep = vgetq_lane_u32(kb, 0) | vgetq_lane_u32(kb, 1) | vgetq_lane_u32(kb, 2) |
+            vgetq_lane_u32(kb, 3);
+        if (keep == 0xFu && o == i) o += 4;
+        else point_compact(c, i, 4, keep, &o);
+    }
+#endif
+    for (; i < n; ++i) point_compact(c, i, 1, point_keep(c, i, cfg), &o);
+    return o;
+}
+
+// Store c[0, n) as BridgePoint records.
+static inline void columns_store(const PointColumns& c, size_t n, BridgePoint* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i].x = c.x[i];
+        out[i].y = c.y[i];
+        out[i].z = c.z[i];
+        out[i].t_offset_ns = c.t[i];
+        out[i].reflectivity = c.refl[i];
+        out[i].tag = c.tag[i];
+        out[i].reserved = 0;
+    }
+}
+
+// Write n BridgePoint records as one kBridgePointXyzrtColumns payload of
+// n * kBridgeColumnsPointBytes bytes (out unaligned is fine).
+static inline void columns_pack(const BridgePoint* pts, size_t n, uint8_t* out) {
+    uint8_t* refl = out + 16 * n;
+    uint8_t* tag = refl + n;
+    for (size_t i = 0; i < n; ++i) {
+        std::memcpy(out + 4 * i, &pts[i].x, 4);
+        std::memcpy(out + 4 * (n + i), &pts[i].y, 4);
+        std::memcpy(out + 4 * (2 * n + i), &pts[i].z, 4);
+        std::memcpy(out + 4 * (3 * n + i), &pts[i].t_offset_ns, 4);
+        refl[i] = pts[i].reflectivity;
+        tag[i] = pts[i].tag;
+    }
+}
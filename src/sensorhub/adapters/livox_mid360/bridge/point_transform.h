@@ -0,0 +1,130 @@
+// Livox MID-360 Bridge - rigid transforms for point clouds
+//
+// Mat34 is a row-major 3x4 [R | t] matrix: p' = R * p + t. The kernels work on SoA
+// x/y/z columns and are vectorized with AVX2 (+FMA) on x86 and NEON on ARM (Orin), with
+// a scalar fallback; the ISA is picked at compile time (see LIVOX_BRIDGE_NATIVE in
+// CMakeLists.txt). transform_points() applies a Mat34 to BridgePoint (AoS) in place by
+// staging small blocks through SoA scratch columns.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "bridge_frame.h"
+
+struct Mat34 {
+    float m[12];   // r00 r01 r02 tx | r10 r11 r12 ty | r20 r21 r22 tz
+};
+
+static inline Mat34 mat34_identity() {
+    Mat34 T = {{1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0}};
+    return T;
+}
+
+static inline bool mat34_is_identity(const Mat34& T) {
+    const Mat34 I = mat34_identity();
+    for (int i = 0; i < 12; ++i)
+        if (T.m[i] != I.m[i]) return false;
+    return true;
+}
+
+// Livox extrinsic_parameter convention: roll/pitch/yaw in degrees, R = Rz(yaw) Ry(pitch) Rx(roll),
+// translation in millimetres.
+static inline Mat34 mat34_from_extrinsic(double roll_deg, double pitch_deg, double yaw_deg,
+    double x_mm, double y_mm, double z_mm) {
+    const double d2r = 3.14159265358979323846 / 180.0;
+    const double cr = std::cos(roll_deg * d2r), sr = std::sin(roll_deg * d2r);
+    const double cp = std::cos(pitch_deg * d2r), sp = std::sin(pitch_deg * d2r);
+    const double cy = std::cos(yaw_deg * d2r), sy = std::sin(yaw_deg * d2r);
+    Mat34 T;
+    T.m[0] = (float)(cy * cp);  T.m[1] = (float)(cy * sp * sr - sy * cr);  T.m[2] = (float)(cy * sp * cr + sy * sr);
+    T.m[4] = (float)(sy * cp);  T.m[5] = (float)(sy * sp * sr + cy * cr);  T.m[6] = (float)(sy * sp * cr - cy * sr);
+    T.m[8] = (float)(-sp);      T.m[9] = (float)(cp * sr);                 T.m[10] = (float)(cp * cr);
+    T.m[3] = (float)(x_mm * 0.001);
+    T.m[7] = (float)(y_mm * 0.001);
+    T.m[11] = (float)(z_mm * 0.001);
+    return T;
+}
+
+static inline const char* point_transform_isa() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// In-place p' = T p over n points stored as separate x, y, z columns.
+static inline void transform_xyz(float* x, float* y, float* z, size_t n, const Mat34& T) {
+    const float* m = T.m;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 r00 = _mm256_set1_ps(m[0]), r01 = _mm256_set1_ps(m[1]), r02 = _mm256_set1_ps(m[2]), tx = _mm256_set1_ps(m[3]);
+    const __m256 r10 = _mm256_set1_ps(m[4]), r11 = _mm256_set1_ps(m[5]), r12 = _mm256_set1_ps(m[6]), ty = _mm256_set1_ps(m[7]);
+    const __m256 r20 = _mm256_set1_ps(m[8]), r21 = _mm256_set1_ps(m[9]), r22 = _mm256_set1_ps(m[10]), tz = _mm256_set1_ps(m[11]);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+#if defined(__FMA__)
+        const __m256 ox = _mm256_fmadd_ps(r02, pz, _mm256_fmadd_ps(r01, py, _mm256_fmadd_ps(r00, px, tx)));
+        const __m256 oy = _mm256_fmadd_ps(r12, pz, _mm256_fmadd_ps(r11, py, _mm256_fmadd_ps(r10, px, ty)));
+        const __m256 oz = _mm256_fmadd_ps(r22, pz, _mm256_fmadd_ps(r21, py, _mm256_fmadd_ps(r20, px, tz)));
+#else
+        const __m256 ox = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r00, px), _mm256_mul_ps(r01, py)), _mm256_add_ps(_mm256_mul_ps(r02, pz), tx));
+        const __m256 oy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r10, px), _mm256_mul_ps(r11, py)), _mm256_add_ps(_mm256_mul_ps(r12, pz), ty));
+        const __m256 oz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r20, px), _mm256_mul_ps(r21, py)), _mm256_add_ps(_mm256_mul_ps(r22, pz), tz));
+#endif
+        _mm256_storeu_ps(x + i, ox);
+        _mm256_storeu_ps(y + i, oy);
+        _mm256_storeu_ps(z + i, oz);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t r00 = vdupq_n_f32(m[0]), r01 = vdupq_n_f32(m[1]), r02 = vdupq_n_f32(m[2]), tx = vdupq_n_f32(m[3]);
+    const float32x4_t r10 = vdupq_n_f32(m[4]), r11 = vdupq_n_f32(m[5]), r12 = vdupq_n_f32(m[6]), ty = vdupq_n_f32(m[7]);
+    const float32x4_t r20 = vdupq_n_f32(m[8]), r21 = vdupq_n_f32(m[9]), r22 = vdupq_n_f32(m[10]), tz = vdupq_n_f32(m[11]);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+#if defined(__aarch64__)
+        const float32x4_t ox = vfmaq_f32(vfmaq_f32(vfmaq_f32(tx, r00, px), r01, py), r02, pz);
+        const float32x4_t oy = vfmaq_f32(vfmaq_f32(vfmaq_f32(ty, r10, px), r11, py), r12, pz);
+        const float32x4_t oz = vfmaq_f32(vfmaq_f32(vfmaq_f32(tz, r20, px), r21, py), r22, pz);
+#else
+        const float32x4_t ox = vmlaq_f32(vmlaq_f32(vmlaq_f32(tx, r00, px), r01, py), r02, pz);
+        const float32x4_t oy = vmlaq_f32(vmlaq_f32(vmlaq_f32(ty, r10, px), r11, py), r12, pz);
+        const float32x4_t oz = vmlaq_f32(vmlaq_f32(vmlaq_f32(tz, r20, px), r21, py), r22, pz);
+#endif
+        vst1q_f32(x + i, ox);
+        vst1q_f32(y + i, oy);
+        vst1q_f32(z + i, oz);
+    }
+#endif
+    for (; i < n; ++i) {
+        const float px = x[i], py = y[i], pz = z[i];
+        x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+        y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+        z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+    }
+}
+
+// In-place transform of BridgePoint records (one SDK packet is ~96 points, so a 128-point
+// block usually covers a whole packet).
+static inline void transform_points(BridgePoint* pts, size_t n, const Mat34& T) {
+    const size_t kBlock = 128;
+    float x[kBlock], y[kBlock], z[kBlock];
+    for (size_t base = 0; base < n; base += kBlock) {
+        const size_t cnt = (n - base < kBlock) ? n - base : kBlock;
+        BridgePoint* p = pts + base;
+        for (size_t i = 0; i < cnt; ++i) { x[i] = p[i].x; y[i] = p[i].y; z[i] = p[i].z; }
+        transform_xyz(x, y, z, cnt, T);
+        for (size_t i = 0; i < cnt; ++i) { p[i].x = x[i]; p[i].y = y[i]; p[i].z = z[i]; }
+    }
+}
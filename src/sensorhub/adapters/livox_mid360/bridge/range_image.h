@@ -0,0 +1,270 @@
+// Livox MID-360 Bridge - spherical range image of each scan
+//
+// RangeImage projects a scan onto a height x width grid of azimuth (columns) and elevation
+// (rows), the usual input of range-image segmentation networks:
+//   col = floor((1 - az / pi) / 2 * width)       az = atan2(y, x): column 0 looks backwards,
+//                                                columns run clockwise seen from above
+//   row = floor((fov_up - el) / (fov_up - fov_down) * height)   el = atan2(z, hypot(x, y)):
+//                                                row 0 is the top of the field of view
+// Each pixel keeps the nearest return: range (m, float32, 0 = empty) and its reflectivity.
+// The image is planar, range[height][width] followed by intensity[height][width] (uint8),
+// so a whole image is two dense arrays a reader can wrap without copying.
+//
+// Angles come from a polynomial atan2 (max error ~1e-5 rad, far below a pixel) evaluated 8
+// points at a time with AVX2 or 4 with NEON on AArch64; points are then scattered with a
+// scalar nearest-wins compare. Built with LIVOX_BRIDGE_CUDA (CMake finds a CUDA compiler,
+// e.g. on Jetson Orin) the projection runs in range_image_cuda.cu instead, and the image
+// lives in mapped pinned host memory the kernel writes directly: no device -> host copy.
+// Sized once by configure(); not thread-safe.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bridge_frame.h"
+#include "point_transform.h"
+#include "range_image_cuda.h"
+
+struct RangeImageConfig {
+    uint32_t height;
+    uint32_t width;
+    float fov_up_deg;        // elevation of the top edge of row 0
+    float fov_down_deg;      // elevation of the bottom edge of the last row
+    bool gpu;                // use the CUDA kernel when built with it
+
+    // MID-360: 360 deg x -7..52 deg
+    RangeImageConfig() : height(64), width(1024), fov_up_deg(52.0f), fov_down_deg(-7.0f), gpu(true) {}
+};
+
+// atan2 on the polynomial shared by all paths (the CUDA kernel has its own copy).
+static inline float range_image_atan2(float y, float x) {
+    const float ax = std::fabs(x), ay = std::fabs(y);
+    const float mx = ax > ay ? ax : ay, mn = ax > ay ? ay : ax;
+    const float a = mx > 0.0f ? mn / mx : 0.0f, s = a * a;
+    float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f +
+                   s * (0.05265332f + s * -0.01172120f)))));
+    if (ay > ax) r = 1.57079637f - r;
+    if (x < 0.0f) r = 3.14159274f - r;
+    return y < 0.0f ? -r : r;
+}
+
+class RangeImage {
+public:
+    static const size_t kPixelBytes = kBridgeRangePixelBytes;
+
+    RangeImage() : images_(0), filled_(0), gpu_(false), image_(NULL)
+#if defined(LIVOX_BRIDGE_CUDA)
+        , cuda_(NULL)
+#endif
+    { std::memset(&p_, 0, sizeof(p_)); }
+
+    ~RangeImage() {
+#if defined(LIVOX_BRIDGE_CUDA)
+        if (cuda_) range_image_cuda_close(cuda_);
+#endif
+    }
+
+    // Size the image; false for a nonsensical configuration. max_points bounds a scan
+    // (the GPU staging buffer). A row must fit one UDP datagram, hence width <= 8192.
+    bool configure(const RangeImageConfig& cfg, size_t max_points) {
+        if (!cfg.height || !cfg.width || cfg.height > 4096 || cfg.width > 8192 || !(cfg.fov_up_deg > cfg.fov_down_deg))
+            return false;
+        cfg_ = cfg;
+        const float d2r = 3.14159265358979323846f / 180.0f;
+        p_.height = cfg.height;
+        p_.width = cfg.width;
+        p_.fov_up = cfg.fov_up_deg * d2r;
+        p_.inv_fov = 1.0f / ((cfg.fov_up_deg - cfg.fov_down_deg) * d2r);
+#if defined(LIVOX_BRIDGE_CUDA)
+        if (cfg.gpu) cuda_ = range_image_cuda_open(max_points, p_, &image_);
+        gpu_ = cuda_ != NULL;
+#else
+        (void)max_points;
+#endif
+        if (!gpu_) {
+            host_.assign(pixels() * kPixelBytes, 0);
+            image_ = host_.data();
+        }
+        return true;
+    }
+
+    bool enabled() const { return image_ != NULL; }
+
+    // Project one scan, replacing the previous image.
+    void project(const BridgePoint* pts, size_t n) {
+#if defined(LIVOX_BRIDGE_CUDA)
+        if (gpu_ && range_image_cuda_project(cuda_, pts, n)) {
+            count_filled();
+            ++images_;
+            return;
+        }
+#endif
+        float* range = range_buf();
+        uint8_t* inten = intensity_buf();
+        std::memset(image_, 0, pixels() * kPixelBytes);
+        const size_t kBlock = 128;
+        float x[kBlock], y[kBlock], z[kBlock], r[kBlock];
+        int32_t idx[kBlock];
+        for (size_t base = 0; base < n; base += kBlock) {
+            const size_t cnt = (n - base < kBlock) ? n - base : kBlock;
+            const BridgePoint* p = pts + base;
+            for (size_t i = 0; i < cnt; ++i) { x[i] = p[i].x; y[i] = p[i].y; z[i] = p[i].z; }
+            bin(x, y, z, cnt, idx, r);
+            for (size_t i = 0; i < cnt; ++i) {
+                const int32_t c = idx[i];
+                if (c < 0) continue;
+                if (range[c] == 0.0f || r[i] < range[c]) {
+                    range[c] = r[i];
+                    inten[c] = p[i].reflectivity;
+                }
+            }
+        }
+        count_filled();
+        ++images_;
+    }
+
+    const uint8_t* data() const { return image_; }
+    const float* ranges() const { return reinterpret_cast<const float*>(image_); }
+    const uint8_t* intensities() const { return image_ + pixels() * sizeof(float); }
+    uint32_t height() const { return p_.height; }
+    uint32_t width() const { return p_.width; }
+    size_t pixels() const { return (size_t)p_.height * p_.width; }
+    size_t row_bytes() const { return (size_t)p_.width * kPixelBytes; }
+    const RangeImageConfig& config() const { return cfg_; }
+    uint64_t images() const { return images_; }
+    size_t filled() const { return filled_; }         // non-empty pixels of the last image
+    bool gpu() const { return gpu_; }
+    const char* device() const { return gpu_ ? "cuda" : point_transform_isa(); }
+
+private:
+    float* range_buf() { return reinterpret_cast<float*>(image_); }
+    uint8_t* intensity_buf() { return image_ + pixels() * sizeof(float); }
+
+    void count_filled() {
+        const float* range = ranges();
+        size_t f = 0;
+        for (size_t i = 0, n = pixels(); i < n; ++i) f += range[i] != 0.0f;
+        filled_ = f;
+    }
+
+    // Pixel index (row * width + col) and range per point, -1 outside the vertical field of
+    // view or for zero returns.
+    void bin(const float* x, const float* y, const float* z, size_t n, int32_t* idx, float* r) const {
+        const float fw = (float)p_.width, fh = (float)p_.height;
+        const float col_k = -0.5f / 3.14159274f * fw, col_0 = 0.5f * fw;
+        const float row_k = -p_.inv_fov * fh, row_0 = p_.fov_up * p_.inv_fov * fh;
+        const int32_t wmax = (int32_t)p_.width - 1;
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256 sign = _mm256_set1_ps(-0.0f), zero = _mm256_setzero_ps(), tiny = _mm256_set1_ps(1e-6f);
+        const __m256 c0 = _mm256_set1_ps(0.99997726f), c1 = _mm256_set1_ps(-0.33262347f);
+        const __m256 c2 = _mm256_set1_ps(0.19354346f), c3 = _mm256_set1_ps(-0.11643287f);
+        const __m256 c4 = _mm256_set1_ps(0.05265332f), c5 = _mm256_set1_ps(-0.01172120f);
+        const __m256 half_pi = _mm256_set1_ps(1.57079637f), pi = _mm256_set1_ps(3.14159274f);
+        const __m256 vcol_k = _mm256_set1_ps(col_k), vcol_0 = _mm256_set1_ps(col_0);
+        const __m256 vrow_k = _mm256_set1_ps(row_k), vrow_0 = _mm256_set1_ps(row_0), vfh = _mm256_set1_ps(fh);
+        const __m256i vw = _mm256_set1_epi32((int32_t)p_.width), vwmax = _mm256_set1_epi32(wmax);
+        const __m256i vneg = _mm256_set1_epi32(-1), vzero = _mm256_setzero_si256();
+        for (; i + 8 <= n; i += 8) {
+            const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+            const __m256 rxy2 = _mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py));
+            const __m256 rxy = _mm256_sqrt_ps(rxy2);
+            const __m256 rng = _mm256_sqrt_ps(_mm256_add_ps(rxy2, _mm256_mul_ps(pz, pz)));
+            // azimuth: atan2(y, x), elevation: atan2(z, hypot(x, y))
+            __m256 ang[2];
+            const __m256 ys[2] = { py, pz }, xs[2] = { px, rxy };
+            for (int k = 0; k < 2; ++k) {
+                const __m256 ax = _mm256_andnot_ps(sign, xs[k]), ay = _mm256_andnot_ps(sign, ys[k]);
+                const __m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+                const __m256 a = _mm256_div_ps(mn, _mm256_max_ps(mx, tiny)), s = _mm256_mul_ps(a, a);
+                __m256 p = _mm256_add_ps(c4, _mm256_mul_ps(s, c5));
+                p = _mm256_add_ps(c3, _mm256_mul_ps(s, p));
+                p = _mm256_add_ps(c2, _mm256_mul_ps(s, p));
+                p = _mm256_add_ps(c1, _mm256_mul_ps(s, p));
+                p = _mm256_add_ps(c0, _mm256_mul_ps(s, p));
+                __m256 t = _mm256_mul_ps(a, p);
+                t = _mm256_blendv_ps(t, _mm256_sub_ps(half_pi, t), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+                t = _mm256_blendv_ps(t, _mm256_sub_ps(pi, t), _mm256_cmp_ps(xs[k], zero, _CMP_LT_OQ));
+                ang[k] = _mm256_or_ps(t, _mm256_and_ps(ys[k], sign));
+            }
+            const __m256 u = _mm256_add_ps(_mm256_mul_ps(ang[0], vcol_k), vcol_0);
+            const __m256 v = _mm256_add_ps(_mm256_mul_ps(ang[1], vrow_k), vrow_0);
+            const __m256 ok = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, vfh, _CMP_LT_OQ)),
+                                            _mm256_cmp_ps(rng, tiny, _CMP_GT_OQ));
+            __m256i col = _mm256_cvttps_epi32(u);
+            col = _mm256_min_epi32(_mm256_max_epi32(col, vzero), vwmax);
+            const __m256i row = _mm256_cvttps_epi32(_mm256_max_ps(v, zero));
+            const __m256i c = _mm256_add_epi32(_mm256_mullo_epi32(row, vw), col);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(idx + i), _mm256_blendv_epi8(vneg, c, _mm256_castps_si256(ok)));
+            _mm256_storeu_ps(r + i, rng);
+        }
+#elif defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+        const float32x4_t zero = vdupq_n_f32(0.0f), tiny = vdupq_n_f32(1e-6f);
+        const float32x4_t c0 = vdupq_n_f32(0.99997726f), c1 = vdupq_n_f32(-0.33262347f);
+        const float32x4_t c2 = vdupq_n_f32(0.19354346f), c3 = vdupq_n_f32(-0.11643287f);
+        const float32x4_t c4 = vdupq_n_f32(0.05265332f), c5 = vdupq_n_f32(-0.01172120f);
+        const float32x4_t half_pi = vdupq_n_f32(1.57079637f), pi = vdupq_n_f32(3.14159274f);
+        const float32x4_t vcol_k = vdupq_n_f32(col_k), vcol_0 = vdupq_n_f32(col_0);
+        const float32x4_t vrow_k = vdupq_n_f32(row_k), vrow_0 = vdupq_n_f32(row_0), vfh = vdupq_n_f32(fh);
+        const int32x4_t vw = vdupq_n_s32((int32_t)p_.width), vwmax = vdupq_n_s32(wmax);
+        const int32x4_t vneg = vdupq_n_s32(-1), vzero = vdupq_n_s32(0);
+        const uint32x4_t sign = vdupq_n_u32(0x80000000u);
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+            const float32x4_t rxy2 = vfmaq_f32(vmulq_f32(px, px), py, py);
+            const float32x4_t rxy = vsqrtq_f32(rxy2);
+            const float32x4_t rng = vsqrtq_f32(vfmaq_f32(rxy2, pz, pz));
+            float32x4_t ang[2];
+            const float32x4_t ys[2] = { py, pz }, xs[2] = { px, rxy };
+            for (int k = 0; k < 2; ++k) {
+                const float32x4_t ax = vabsq_f32(xs[k]), ay = vabsq_f32(ys[k]);
+                const float32x4_t mx = vmaxq_f32(ax, ay), mn = vminq_f32(ax, ay);
+                const float32x4_t a = vdivq_f32(mn, vmaxq_f32(mx, tiny)), s = vmulq_f32(a, a);
+                float32x4_t p = vfmaq_f32(c4, s, c5);
+                p = vfmaq_f32(c3, s, p);
+                p = vfmaq_f32(c2, s, p);
+                p = vfmaq_f32(c1, s, p);
+                p = vfmaq_f32(c0, s, p);
+                float32x4_t t = vmulq_f32(a, p);
+                t = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(half_pi, t), t);
+                t = vbslq_f32(vcltq_f32(xs[k], zero), vsubq_f32(pi, t), t);
+                ang[k] = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(t),
+                                                         vandq_u32(vreinterpretq_u32_f32(ys[k]), sign)));
+            }
+            const float32x4_t u = vfmaq_f32(vcol_0, ang[0], vcol_k);
+            const float32x4_t v = vfmaq_f32(vrow_0, ang[1], vrow_k);
+            const uint32x4_t ok = vandq_u32(vandq_u32(vcgeq_f32(v, zero), vcltq_f32(v, vfh)), vcgtq_f32(rng, tiny));
+            int32x4_t col = vcvtq_s32_f32(u);                  // truncates, like the scalar cast
+            col = vminq_s32(vmaxq_s32(col, vzero), vwmax);
+            const int32x4_t row = vcvtq_s32_f32(vmaxq_f32(v, zero));
+            vst1q_s32(idx + i, vbslq_s32(ok, vmlaq_s32(col, row, vw), vneg));
+            vst1q_f32(r + i, rng);
+        }
+#endif
+        for (; i < n; ++i) {
+            idx[i] = -1;
+            const float rxy = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+            r[i] = std::sqrt(rxy * rxy + z[i] * z[i]);
+            const float v = range_image_atan2(z[i], rxy) * row_k + row_0;
+            if (!(v >= 0.0f && v < fh) || !(r[i] > 1e-6f)) continue;
+            int32_t col = (int32_t)(range_image_atan2(y[i], x[i]) * col_k + col_0);
+            col = col < 0 ? 0 : (col > wmax ? wmax : col);
+            idx[i] = (int32_t)v * (int32_t)p_.width + col;
+        }
+    }
+
+    RangeImageConfig cfg_;
+    RangeImageParams p_;
+    uint64_t images_;
+    size_t filled_;
+    bool gpu_;
+    uint8_t* image_;                 // host_ or the CUDA pinned buffer
+    std::vector<uint8_t> host_;
+#if defined(LIVOX_BRIDGE_CUDA)
+    RangeImageCuda* cuda_;
+#endif
+};
@@ -0,0 +1,116 @@
+// Livox MID-360 Bridge - range image projection on the GPU (LIVOX_BRIDGE_CUDA)
+//
+// The CUDA side of range_image.h, for Jetson Orin. The scan is copied into a mapped pinned
+// staging buffer (on Orin host and GPU share DRAM, so the kernel reads it in place), one
+// thread per point projects it and keeps the nearest return per pixel with a 64-bit
+// atomicMin on (range bits << 32 | reflectivity) - positive floats order like their bit
+// patterns - and a second pass unpacks the keys straight into the image, itself mapped
+// pinned host memory: the emitter publishes it without a cudaMemcpy. Same projection and
+// atan2 polynomial as the CPU paths.
+
+#include <cuda_runtime.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "range_image_cuda.h"
+
+struct RangeImageCuda {
+    RangeImageParams p;
+    size_t max_points;
+    BridgePoint* pts_host;           // staging, mapped pinned
+    BridgePoint* pts_dev;
+    unsigned long long* keys;        // one per pixel, device memory
+    uint8_t* image_host;             // range[h][w] float32, intensity[h][w] uint8, mapped pinned
+    uint8_t* image_dev;
+    cudaStream_t stream;
+};
+
+namespace {
+
+const unsigned long long kEmptyKey = ~0ull;
+
+__device__ float atan2_poly(float y, float x) {
+    const float ax = fabsf(x), ay = fabsf(y);
+    const float mx = fmaxf(ax, ay), mn = fminf(ax, ay);
+    const float a = mx > 0.0f ? mn / mx : 0.0f, s = a * a;
+    float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f +
+                   s * (0.05265332f + s * -0.01172120f)))));
+    if (ay > ax) r = 1.57079637f - r;
+    if (x < 0.0f) r = 3.14159274f - r;
+    return y < 0.0f ? -r : r;
+}
+
+__global__ void project_kernel(const BridgePoint* pts, unsigned n, RangeImageParams p, unsigned long long* keys) {
+    const unsigned i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= n) return;
+    const BridgePoint q = pts[i];
+    const float rxy = sqrtf(q.x * q.x + q.y * q.y);
+    const float r = sqrtf(rxy * rxy + q.z * q.z);
+    const float fh = (float)p.height, fw = (float)p.width;
+    const float v = (p.fov_up - atan2_poly(q.z, rxy)) * p.inv_fov * fh;
+    if (!(v >= 0.0f && v < fh) || !(r > 1e-6f)) return;
+    int col = (int)((0.5f - atan2_poly(q.y, q.x) * (0.5f / 3.14159274f)) * fw);
+    col = min(max(col, 0), (int)p.width - 1);
+    const unsigned long long key = ((unsigned long long)__float_as_uint(r) << 32) | q.reflectivity;
+    atomicMin(&keys[(unsigned)v * p.width + col], key);
+}
+
+__global__ void unpack_kernel(const unsigned long long* keys, unsigned pixels, uint8_t* image) {
+    const unsigned i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= pixels) return;
+    const unsigned long long k = keys[i];
+    float* range = reinterpret_cast<float*>(image);
+    uint8_t* inten = image + (size_t)pixels * sizeof(float);
+    range[i] = k == kEmptyKey ? 0.0f : __uint_as_float((unsigned)(k >> 32));
+    inten[i] = k == kEmptyKey ? 0 : (uint8_t)(k & 0xFF);
+}
+
+bool check(cudaError_t e, const char* what) {
+    if (e == cudaSuccess) return true;
+    std::fprintf(stderr, "range image (cuda): %s: %s\n", what, cudaGetErrorString(e));
+    return false;
+}
+
+}  // namespace
+
+RangeImageCuda* range_image_cuda_open(size_t max_points, const RangeImageParams& p, uint8_t** image) {
+    int devices = 0;
+    if (cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0) return NULL;
+    if (!check(cudaSetDeviceFlags(cudaDeviceMapHost), "cudaSetDeviceFlags")) return NULL;
+    RangeImageCuda* c = new RangeImageCuda();
+    c->p = p;
+    c->max_points = max_points;
+    const size_t pixels = (size_t)p.height * p.width;
+    if (check(cudaHostAlloc((void**)&c->pts_host, max_points * sizeof(BridgePoint), cudaHostAllocMapped), "points") &&
+        check(cudaHostGetDevicePointer((void**)&c->pts_dev, c->pts_host, 0), "points map") &&
+        check(cudaMalloc((void**)&c->keys, pixels * sizeof(unsigned long long)), "keys") &&
+        check(cudaHostAlloc((void**)&c->image_host, pixels * kBridgeRangePixelBytes, cudaHostAllocMapped), "image") &&
+        check(cudaHostGetDevicePointer((void**)&c->image_dev, c->image_host, 0), "image map") &&
+        check(cudaStreamCreateWithFlags(&c->stream, cudaStreamNonBlocking), "stream")) {
+        *image = c->image_host;
+        return c;
+    }
+    range_image_cuda_close(c);
+    return NULL;
+}
+
+bool range_image_cuda_project(RangeImageCuda* c, const BridgePoint* pts, size_t n) {
+    if (n > c->max_points) return false;      // larger than any scan the bridge assembles
+    const unsigned pixels = c->p.height * c->p.width;
+    const unsigned threads = 256;
+    if (n) std::memcpy(c->pts_host, pts, n * sizeof(BridgePoint));
+    cudaMemsetAsync(c->keys, 0xFF, (size_t)pixels * sizeof(unsigned long long), c->stream);
+    if (n) project_kernel<<<(unsigned)((n + threads - 1) / threads), threads, 0, c->stream>>>(c->pts_dev, (unsigned)n, c->p, c->keys);
+    unpack_kernel<<<(pixels + threads - 1) / threads, threads, 0, c->stream>>>(c->keys, pixels, c->image_dev);
+    return check(cudaStreamSynchronize(c->stream), "project");
+}
+
+void range_image_cuda_close(RangeImageCuda* c) {
+    if (!c) return;
+    if (c->stream) cudaStreamDestroy(c->stream);
+    if (c->image_host) cudaFreeHost(c->image_host);
+    if (c->keys) cudaFree(c->keys);
+    if (c->pts_host) cudaFreeHost(c->pts_host);
+    delete c;
+}
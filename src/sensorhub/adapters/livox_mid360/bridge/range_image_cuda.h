@@ -0,0 +1,29 @@
+// Livox MID-360 Bridge - range image projection constants and the CUDA entry points
+//
+// Kept apart from range_image.h so range_image_cuda.cu compiles without the CPU kernels'
+// SIMD headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bridge_frame.h"
+
+// Projection constants shared by the CPU paths and the CUDA kernel.
+struct RangeImageParams {
+    uint32_t height;
+    uint32_t width;
+    float fov_up;            // rad
+    float inv_fov;           // 1 / (fov_up - fov_down), rad^-1
+};
+
+#if defined(LIVOX_BRIDGE_CUDA)
+// range_image_cuda.cu. open() allocates the image (pinned, mapped) and a point staging
+// buffer of max_points, NULL without a usable GPU; project() fills the image and returns
+// once it is complete, false if the GPU failed (the caller then projects on the CPU).
+struct RangeImageCuda;
+RangeImageCuda* range_image_cuda_open(size_t max_points, const RangeImageParams& p, uint8_t** image);
+bool range_image_cuda_project(RangeImageCuda* c, const BridgePoint* pts, size_t n);
+void range_image_cuda_close(RangeImageCuda* c);
+#endif
@@ -0,0 +1,343 @@
+// Livox MID-360 Bridge - session recording (.lvxr): append-only, chunked, indexed
+//
+// A recording holds the bridge's inputs (SDK point / IMU packets and device info, with
+// their host arrival times), so replaying it re-runs assembly, clock mapping, filtering
+// and fusion exactly like live data. rplidar_bridge records the raw bytes it reads from
+// the device instead (kRecDeviceBytes), which replay through its protocol decoder.
+//
+//   offset 0           RecFileHeader, padded to kRecHeaderBytes
+//   kRecHeaderBytes    chunk 0: RecChunkHeader, then records
+//   + chunk_bytes      chunk 1 ...
+//   index_offset       RecIndexEntry[n_chunks] (written on close)
+//
+// Each record is a RecordHeader + payload, padded to 8 bytes. Chunks are preallocated
+// with fallocate and written through a shared mapping, so appending is a memcpy with no
+// syscall; a full chunk is handed to writeback with sync_file_range and unmapped. The chunk
+// header (used bytes, record count, time span) is kept current on every append, so a file
+// cut short by a crash is still readable chunk by chunk without the index.
+// Little-endian, packed; readers must mirror these structs. Not thread-safe.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char     kRecFileMagic[4] = { 'L', 'V', 'X', 'R' };
+static const char     kRecChunkMagic[4] = { 'L', 'V', 'X', 'C' };
+static const uint32_t kRecVersion = 1;
+static const size_t   kRecHeaderBytes = 4096;     // keeps chunks page-aligned for mmap
+
+enum RecordKind {
+    kRecPoints = 1,    // LivoxLidarEthernetPacket, points in SDK layout
+    kRecImu = 2,       // LivoxLidarEthernetPacket + LivoxLidarImuRawPoint
+    kRecInfo = 3,      // LivoxLidarInfo
+    kRecDeviceBytes = 4, // bytes read from a serial / UDP device in one read (rplidar_bridge)
+};
+
+#pragma pack(push, 1)
+struct RecFileHeader {
+    char     magic[4];        // "LVXR"
+    uint32_t version;
+    uint64_t chunk_bytes;
+    uint64_t created_rt_ns;   // CLOCK_REALTIME at open
+    uint64_t index_offset;    // 0 until the recording is closed cleanly
+    uint32_t n_chunks;        // valid with index_offset
+    uint32_t reserved;
+};
+
+struct RecChunkHeader {
+    char     magic[4];        // "LVXC"
+    uint32_t index;
+    uint64_t used;            // bytes in this chunk including this header
+    uint64_t first_host_ns;
+    uint64_t last_host_ns;
+    uint32_t records;
+    uint32_t sealed;          // 1 once the chunk is complete
+    uint8_t  reserved[24];
+};
+
+struct RecordHeader {
+    uint32_t len;             // payload bytes (record is padded to 8 after the payload)
+    uint8_t  kind;            // RecordKind
+    uint8_t  reserved[3];
+    uint32_t handle;          // SDK device handle
+    uint32_t reserved2;
+    uint64_t host_ns;         // arrival, CLOCK_MONOTONIC
+    uint64_t host_rt_ns;      // arrival, CLOCK_REALTIME
+};
+
+struct RecIndexEntry {
+    uint64_t offset;          // chunk offset in the file
+    uint64_t used;
+    uint64_t first_host_ns;
+    uint64_t last_host_ns;
+    uint32_t records;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RecFileHeader) == 40, "RecFileHeader must stay 40 bytes");
+static_assert(sizeof(RecChunkHeader) == 64, "RecChunkHeader must stay 64 bytes");
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader must stay 32 bytes");
+static_assert(sizeof(RecIndexEntry) == 40, "RecIndexEntry must stay 40 bytes");
+
+static inline size_t rec_align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+class RecordWriter {
+public:
+    RecordWriter()
+        : fd_(-1), chunk_bytes_(0), base_(NULL), chunk_(NULL), chunk_off_(0), records_(0),
+          bytes_(0), dropped_(0) {}
+    ~RecordWriter() { close(); }
+
+    // Create <dir>/<prefix>_<UTC time>.lvxr. chunk_bytes is rounded up to the page size.
+    bool open(const char* dir, size_t chunk_bytes, const char* prefix = "livox") {
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        chunk_bytes_ = (chunk_bytes + page - 1) / page * page;
+        if (chunk_bytes_ < page * 16) chunk_bytes_ = page * 16;
+
+        char name[64];
+        const time_t now = time(NULL);
+        tm utc;
+        gmtime_r(&now, &utc);
+        strftime(name, sizeof(name), "_%Y%m%d-%H%M%S.lvxr", &utc);
+        path_ = std::string(dir) + "/" + prefix + name;
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd_ < 0) return false;
+
+        RecFileHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, kRecFileMagic, 4);
+        h.version = kRecVersion;
+        h.chunk_bytes = chunk_bytes_;
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        h.created_rt_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        std::vector<uint8_t> page0(kRecHeaderBytes, 0);
+        std::memcpy(page0.data(), &h, sizeof(h));
+        if (pwrite(fd_, page0.data(), page0.size(), 0) != (ssize_t)page0.size() || !start_chunk(0)) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    // Append one record; false (and counted as dropped) if it cannot be written.
+    bool append(uint8_t kind, uint32_t handle, uint64_t host_ns, uint64_t host_rt_ns,
+        const void* payload, size_t len) {
+        if (fd_ < 0) return false;
+        const size_t need = rec_align8(sizeof(RecordHeader) + len);
+        if (need > chunk_bytes_ - sizeof(RecChunkHeader)) { ++dropped_; return false; }
+        if (chunk_->used + need > chunk_bytes_) {
+            const uint32_t next = chunk_->index + 1;
+            seal_chunk();
+            if (!start_chunk(next)) { ++dropped_; close(); return false; }
+        }
+        uint8_t* p = base_ + chunk_->used;
+        RecordHeader* r = reinterpret_cast<RecordHeader*>(p);
+        std::memset(r, 0, sizeof(*r));
+        r->len = (uint32_t)len;
+        r->kind = kind;
+        r->handle = handle;
+        r->host_ns = host_ns;
+        r->host_rt_ns = host_rt_ns;
+        std::memcpy(p + sizeof(RecordHeader), payload, len);
+        if (chunk_->records == 0) chunk_->first_host_ns = host_ns;
+        chunk_->last_host_ns = host_ns;
+        ++chunk_->records;
+        chunk_->used += need;     // last: a reader never sees a half-written record as used
+        ++records_;
+        bytes_ += need;
+        return true;
+    }
+
+    // Seal the open chunk, trim the preallocated tail, write the index and sync.
+    void close() {
+        if (fd_ < 0) return;
+        if (chunk_) seal_chunk();
+        const RecIndexEntry& last = index_.back();
+        const uint64_t index_off = rec_align8(last.offset + last.used);
+        if (ftruncate(fd_, (off_t)index_off) == 0) {
+            const size_t n = index_.size() * sizeof(RecIndexEntry);
+            if (pwrite(fd_, index_.data(), n, (off_t)index_off) == (ssize_t)n) {
+                RecFileHeader h;
+                if (pread(fd_, &h, sizeof(h), 0) == (ssize_t)sizeof(h)) {
+                    h.index_offset = index_off;
+                    h.n_chunks = (uint32_t)index_.size();
+                    pwrite(fd_, &h, sizeof(h), 0);
+                }
+            }
+        }
+        fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    uint64_t records() const { return records_; }
+    uint64_t bytes() const { return bytes_; }
+    uint64_t dropped() const { return dropped_; }
+    size_t chunks() const { return index_.size() + (chunk_ ? 1 : 0); }
+
+private:
+    bool start_chunk(uint32_t index) {
+        const off_t off = (off_t)(kRecHeaderBytes + (uint64_t)index * chunk_bytes_);
+        int rc = fallocate(fd_, 0, off, (off_t)chunk_bytes_);
+        if (rc != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) rc = ftruncate(fd_, off + (off_t)chunk_bytes_);
+        if (rc != 0) return false;
+        void* m = mmap(NULL, chunk_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, off);
+        if (m == MAP_FAILED) return false;
+        base_ = static_cast<uint8_t*>(m);
+        chunk_off_ = (uint64_t)off;
+        chunk_ = reinterpret_cast<RecChunkHeader*>(base_);
+        std::memset(chunk_, 0, sizeof(*chunk_));
+        std::memcpy(chunk_->magic, kRecChunkMagic, 4);
+        chunk_->index = index;
+        chunk_->used = sizeof(RecChunkHeader);
+        return true;
+    }
+
+    void seal_chunk() {
+        chunk_->sealed = 1;
+        RecIndexEntry e;
+        std::memset(&e, 0, sizeof(e));
+        e.offset = chunk_off_;
+        e.used = chunk_->used;
+        e.first_host_ns = chunk_->first_host_ns;
+        e.last_host_ns = chunk_->last_host_ns;
+        e.records = chunk_->records;
+        index_.push_back(e);
+        // start writeback now instead of at munmap/fsync time, without waiting for it
+        sync_file_range(fd_, (off_t)chunk_off_, (off_t)chunk_->used, SYNC_FILE_RANGE_WRITE);
+        munmap(base_, chunk_bytes_);
+        base_ = NULL;
+        chunk_ = NULL;
+    }
+
+    int fd_;
+    std::string path_;
+    size_t chunk_bytes_;
+    uint8_t* base_;
+    RecChunkHeader* chunk_;
+    uint64_t chunk_off_;
+    std::vector<RecIndexEntry> index_;   // grows once per chunk
+    uint64_t records_;
+    uint64_t bytes_;
+    uint64_t dropped_;
+};
+
+// Read-only view of a recording: the whole file is mapped once, records are read in place.
+class RecordReader {
+public:
+    struct Record {
+        const RecordHeader* h;
+        const uint8_t* payload;
+    };
+
+    RecordReader() : fd_(-1), map_(NULL), size_(0), hdr_(NULL), chunk_(0), pos_(0) {}
+    ~RecordReader() { close(); }
+
+    bool open(const char* path) {
+        fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) return false;
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || (size_t)st.st_size < kRecHeaderBytes) { close(); return false; }
+        size_ = (size_t)st.st_size;
+        void* m = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (m == MAP_FAILED) { map_ = NULL; close(); return false; }
+        map_ = static_cast<const uint8_t*>(m);
+        madvise(const_cast<uint8_t*>(map_), size_, MADV_SEQUENTIAL);
+        hdr_ = reinterpret_cast<const RecFileHeader*>(map_);
+        if (std::memcmp(hdr_->magic, kRecFileMagic, 4) != 0 || hdr_->version != kRecVersion ||
+            hdr_->chunk_bytes == 0) { close(); return false; }
+        load_chunks();
+        rewind();
+        return true;
+    }
+
+    void close() {
+        if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+        if (fd_ >= 0) ::close(fd_);
+        map_ = NULL;
+        fd_ = -1;
+        chunks_.clear();
+    }
+
+    // True if the file was closed cleanly (index present).
+    bool indexed() const { return hdr_ && hdr_->index_offset != 0; }
+    size_t chunks() const { return chunks_.size(); }
+    uint64_t records() const {
+        uint64_t n = 0;
+        for (size_t i = 0; i < chunks_.size(); ++i) n += chunks_[i].records;
+        return n;
+    }
+
+    void rewind() { chunk_ = 0; pos_ = sizeof(RecChunkHeader); }
+
+    // Next record in file order; false at the end (or at the first damaged record).
+    bool next(Record* out) {
+        while (chunk_ < chunks_.size()) {
+            const RecIndexEntry& c = chunks_[chunk_];
+            if (pos_ + sizeof(RecordHeader) <= c.used) {
+                const uint8_t* p = map_ + c.offset + pos_;
+                const RecordHeader* h = reinterpret_cast<const RecordHeader*>(p);
+                const size_t len = rec_align8(sizeof(RecordHeader) + h->len);
+                if (pos_ + len > c.used) { chunk_ = chunks_.size(); return false; }
+                out->h = h;
+                out->payload = p + sizeof(RecordHeader);
+                pos_ += len;
+                return true;
+            }
+            ++chunk_;
+            pos_ = sizeof(RecChunkHeader);
+        }
+        return false;
+    }
+
+private:
+    void load_chunks() {
+        chunks_.clear();
+        if (indexed() && hdr_->index_offset + (uint64_t)hdr_->n_chunks * sizeof(RecIndexEntry) <= size_) {
+            const RecIndexEntry* e = reinterpret_cast<const RecIndexEntry*>(map_ + hdr_->index_offset);
+            for (uint32_t i = 0; i < hdr_->n_chunks; ++i)
+                if (e[i].offset + e[i].used <= size_) chunks_.push_back(e[i]);
+            return;
+        }
+        // no index (writer did not close): walk the chunk headers
+        for (uint64_t off = kRecHeaderBytes; off + sizeof(RecChunkHeader) <= size_; off += hdr_->chunk_bytes) {
+            const RecChunkHeader* c = reinterpret_cast<const RecChunkHeader*>(map_ + off);
+            if (std::memcmp(c->magic, kRecChunkMagic, 4) != 0) break;
+            RecIndexEntry e;
+            std::memset(&e, 0, sizeof(e));
+            e.offset = off;
+            e.used = c->used;
+            if (e.used > hdr_->chunk_bytes || off + e.used > size_) e.used = size_ - off;
+            e.first_host_ns = c->first_host_ns;
+            e.last_host_ns = c->last_host_ns;
+            e.records = c->records;
+            chunks_.push_back(e);
+        }
+    }
+
+    int fd_;
+    const uint8_t* map_;
+    size_t size_;
+    const RecFileHeader* hdr_;
+    std::vector<RecIndexEntry> chunks_;
+    size_t chunk_;
+    uint64_t pos_;
+};
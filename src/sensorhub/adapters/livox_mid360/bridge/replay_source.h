@@ -0,0 +1,124 @@
+// Livox MID-360 Bridge - replay source: feeds a .lvxr recording (recorder.h) to the bridge
+//
+// Records keep their recorded arrival times: CLOCK_MONOTONIC shifted so the first record
+// lands at replay start (scan windows and host_ts_ns behave as recorded at any speed),
+// CLOCK_REALTIME unchanged (clock mapping, so stamps reproduce the original session).
+// speed 1 keeps the recorded pacing, N replays N times faster, 0 as fast as the bridge
+// drains its queues. A loop continues the monotonic timeline past the previous pass.
+// Records too short for the packet they claim to hold (a truncated or corrupt recording)
+// are skipped and counted: the sink copies the header plus dot_num points from the payload.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "bridge_frame.h"
+#include "bridge_source.h"
+#include "recorder.h"
+
+class ReplaySource : public BridgeSource {
+public:
+    ReplaySource() : speed_(1.0), loop_(false), stop_(false), skipped_(0) {}
+    ~ReplaySource() { stop(); }
+
+    bool open(const char* path, double speed, bool loop) {
+        if (!reader_.open(path)) {
+            std::cerr << "cannot open recording " << path << std::endl;
+            return false;
+        }
+        speed_ = speed;
+        loop_ = loop;
+        std::cerr << "replaying " << path << ": " << reader_.records() << " records, "
+                  << reader_.chunks() << " chunks" << (reader_.indexed() ? "" : " (no index, recovered)")
+                  << ", speed " << speed_ << std::endl;
+        return true;
+    }
+
+    const char* name() const { return "replay"; }
+
+    bool start(const BridgeSourceSink& sink) {
+        sink_ = sink;
+        stop_.store(false);
+        thread_ = std::thread(&ReplaySource::run, this);
+        return true;
+    }
+
+    void stop() {
+        stop_.store(true);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t kPacketHeader = offsetof(LivoxLidarEthernetPacket, data);
+
+    static bool points_fit(const RecordHeader& h, const LivoxLidarEthernetPacket* pkt) {
+        return h.len >= kPacketHeader &&
+               h.len >= kPacketHeader + (size_t)pkt->dot_num * bridge_point_size(pkt->data_type);
+    }
+
+    static bool imu_fits(const RecordHeader& h) {
+        return h.len >= kPacketHeader + sizeof(LivoxLidarImuRawPoint);
+    }
+
+    void run() {
+        const uint64_t t_start = source_now_ns();
+        uint64_t n = 0, shift = 0, last_host = 0;
+        bool more = true;
+        do {
+            reader_.rewind();
+            RecordReader::Record r;
+            uint64_t rec0 = 0, wall0 = 0;
+            while (more && !stop_.load(std::memory_order_relaxed) && reader_.next(&r)) {
+                const RecordHeader& h = *r.h;
+                if (!wall0) {
+                    rec0 = h.host_ns;
+                    wall0 = source_now_ns();
+                    shift = (wall0 > last_host ? wall0 : last_host + 1) - rec0;
+                }
+                const uint64_t host_ns = h.host_ns + shift;
+                if (host_ns > last_host) last_host = host_ns;
+                if (speed_ > 0 && h.host_ns > rec0)
+                    source_sleep_until_ns(wall0 + (uint64_t)((double)(h.host_ns - rec0) / speed_));
+                const LivoxLidarEthernetPacket* pkt = reinterpret_cast<const LivoxLidarEthernetPacket*>(r.payload);
+                switch (h.kind) {
+                case kRecPoints:
+                    if (!points_fit(h, pkt)) { skipped_.fetch_add(1, std::memory_order_relaxed); break; }
+                    if (speed_ <= 0 && !sink_.wait_for_room(false)) { more = false; break; }
+                    sink_.points(h.handle, pkt, source_now_ns(), host_ns, h.host_rt_ns);
+                    break;
+                case kRecImu:
+                    if (!imu_fits(h)) { skipped_.fetch_add(1, std::memory_order_relaxed); break; }
+                    if (speed_ <= 0 && !sink_.wait_for_room(true)) { more = false; break; }
+                    sink_.imu(h.handle, pkt, source_now_ns(), host_ns, h.host_rt_ns);
+                    break;
+                case kRecInfo:
+                    if (h.len >= sizeof(LivoxLidarInfo))
+                        sink_.info(h.handle, reinterpret_cast<const LivoxLidarInfo*>(r.payload));
+                    break;
+                }
+                ++n;
+            }
+        } while (more && loop_ && !stop_.load(std::memory_order_relaxed));
+
+        const double secs = (source_now_ns() - t_start) / 1e9;
+        std::cerr << "replay: " << n << " records in " << secs << " s ("
+                  << (uint64_t)(secs > 0 ? n / secs : 0) << " records/s)";
+        if (skipped()) std::cerr << ", " << skipped() << " skipped as shorter than their packet";
+        std::cerr << std::endl;
+        if (!stop_.load()) sink_.finished();
+    }
+
+    RecordReader reader_;
+    double speed_;
+    bool loop_;
+    std::atomic<bool> stop_;
+    std::atomic<uint64_t> skipped_;
+    BridgeSourceSink sink_;
+    std::thread thread_;
+};
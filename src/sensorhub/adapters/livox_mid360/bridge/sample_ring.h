@@ -0,0 +1,129 @@
+// Livox MID-360 Bridge - typed sample ring (Python extension core)
+//
+// Fixed-capacity history of (int64 stamp_ns, Row, shared_ptr<const T>) written by one thread
+// and read by any number without a lock, for livox_frames.SampleRing: the receive thread
+// appends every message and a Python caller reads latest() / last(k) without the sensor
+// adapter ever holding a per-sample dict. Stamps and rows are typed columns - contiguous
+// int64 and a plain struct per slot (for bridge records, their BridgeFrameHeader) - so the
+// binding hands them to numpy with no copy; the value is the payload the row describes.
+//
+// Writer: slot_seq = kWriting, fence, store stamp, row and value, slot_seq = seq (release),
+//         head = seq (release).
+// Reader: wants seq s; slot_seq == s, load stamp, row and value, fence, re-check
+//         slot_seq == s (seqlock, as in shm_ring.h). A mismatch means the writer lapped the
+//         reader and the entry is skipped. Values are shared_ptr loads, so an entry the
+//         reader got stays valid after the writer overwrites its slot.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Row type of a ring without a row column.
+struct SampleRingNoRow {};
+
+template <typename T, typename Row = SampleRingNoRow>
+class SampleRing {
+public:
+    static const uint64_t kWriting = ~0ull;
+
+    struct Entry {
+        int64_t stamp_ns;
+        Row row;
+        std::shared_ptr<const T> value;
+    };
+
+    explicit SampleRing(size_t capacity)
+        : cap_(capacity ? capacity : 1), stamps_(new std::atomic<int64_t>[cap_]),
+          seqs_(new std::atomic<uint64_t>[cap_]), rows_(new Row[cap_]), values_(cap_), head_(0) {
+        static_assert(sizeof(std::atomic<int64_t>) == sizeof(int64_t), "stamp column must be plain int64");
+        for (size_t i = 0; i < cap_; ++i) {
+            stamps_[i].store(0, std::memory_order_relaxed);
+            seqs_[i].store(0, std::memory_order_relaxed);
+        }
+        std::memset(static_cast<void*>(rows_.get()), 0, cap_ * sizeof(Row));
+    }
+
+    // Writer thread only.
+    uint64_t push(int64_t stamp_ns, std::shared_ptr<const T> value, const Row& row = Row()) {
+        const uint64_t seq = head_.load(std::memory_order_relaxed) + 1;
+        const size_t i = (size_t)((seq - 1) % cap_);
+        seqs_[i].store(kWriting, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        stamps_[i].store(stamp_ns, std::memory_order_relaxed);
+        std::memcpy(static_cast<void*>(&rows_[i]), &row, sizeof(Row));
+        std::atomic_store(&values_[i], std::move(value));
+        seqs_[i].store(seq, std::memory_order_release);
+        head_.store(seq, std::memory_order_release);
+        return seq;
+    }
+
+    // Newest entry; false while the ring is empty.
+    bool latest(Entry* out) const {
+        for (;;) {
+            const uint64_t seq = head_.load(std::memory_order_acquire);
+            if (!seq) return false;
+            if (read(seq, out)) return true;
+        }
+    }
+
+    // Up to k newest entries, oldest first; entries overwritten while reading are skipped.
+    size_t last(size_t k, std::vector<Entry>* out) const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t n = k < head ? k : head;
+        collect(head - n + 1, head, out);
+        return out->size();
+    }
+
+    // Entries after seq `after`, oldest first (those already overwritten are gone); returns
+    // the seq to pass next time, so a follower sees every entry once.
+    uint64_t since(uint64_t after, std::vector<Entry>* out) const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        collect(after < head ? after + 1 : head + 1, head, out);
+        return head;
+    }
+
+    size_t capacity() const { return cap_; }
+    uint64_t seq() const { return head_.load(std::memory_order_acquire); }
+    size_t size() const {
+        const uint64_t h = seq();
+        return h < cap_ ? (size_t)h : cap_;
+    }
+    // Stamp column in slot order (slot = (seq - 1) % capacity), for a zero-copy view.
+    const int64_t* stamps() const { return reinterpret_cast<const int64_t*>(stamps_.get()); }
+    // Row column in the same slot order; a slot being rewritten may be torn, check its stamp
+    // and seq against an entry read through latest() / last() when that matters.
+    const Row* rows() const { return rows_.get(); }
+
+private:
+    void collect(uint64_t first, uint64_t head, std::vector<Entry>* out) const {
+        out->clear();
+        if (head >= cap_ && first < head - cap_ + 1) first = head - cap_ + 1;
+        if (first > head) return;
+        out->reserve((size_t)(head - first + 1));
+        Entry e;
+        for (uint64_t seq = first; seq <= head; ++seq)
+            if (read(seq, &e)) out->push_back(std::move(e));
+    }
+
+    bool read(uint64_t seq, Entry* out) const {
+        const size_t i = (size_t)((seq - 1) % cap_);
+        if (seqs_[i].load(std::memory_order_acquire) != seq) return false;
+        out->stamp_ns = stamps_[i].load(std::memory_order_relaxed);
+        std::memcpy(static_cast<void*>(&out->row), &rows_[i], sizeof(Row));
+        out->value = std::atomic_load(&values_[i]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seqs_[i].load(std::memory_order_relaxed) == seq;
+    }
+
+    size_t cap_;
+    std::unique_ptr<std::atomic<int64_t>[]> stamps_;
+    std::unique_ptr<std::atomic<uint64_t>[]> seqs_;
+    std::unique_ptr<Row[]> rows_;
+    std::vector<std::shared_ptr<const T> > values_;
+    std::atomic<uint64_t> head_;
+};
@@ -0,0 +1,336 @@
+// Livox MID-360 Bridge - compressed scan encoding (msg 5) and its decoder
+//
+// For links where raw scans do not fit (Wi-Fi, LTE), a scan is cut into blocks of up to
+// kCodecBlockPoints points. Every block is one kBridgeMsgScanCompressed message, decodable
+// on its own, so a lost datagram costs one block and not the scan. frag_index / frag_count
+// number the blocks, point_count is the block's points, and all blocks share the scan's seq
+// and stamps. The payload is a BridgeCodecBlock followed by the block's columns, compressed
+// with LZ4 (block format) or zstd (one frame), or stored as-is when that does not help.
+//
+// Columns, for n points in scan order (t_offset_ns lossless, reserved dropped):
+//   x, y, z   coordinates rounded to 1 mm; the delta to the previous point, zigzag
+//             coded to uint16 and split into a low-byte plane and a high-byte plane
+//             (2n bytes each axis). 0xFFFF means "escaped": that delta is the next int32
+//             in the escape list.
+//   t         the t_offset_ns delta to the previous point (uint32, wraps), 4 byte planes
+//   refl, tag n bytes each
+//   escapes   n_escapes int32 deltas, all x escapes first, then y, then z
+// Deltas start from 0 at each block. Near-constant time steps and small coordinate steps
+// become runs of equal bytes in the planes, which is what LZ4 / zstd compress well.
+//
+// Decoding needs only this header and bridge_frame.h (plus liblz4 / libzstd for those
+// codecs); bridge_frame.py / scan_codec.py mirror it in Python. LIVOX_BRIDGE_HAVE_LZ4 and
+// LIVOX_BRIDGE_HAVE_ZSTD say which libraries were found at build time.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef LIVOX_BRIDGE_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "bridge_frame.h"
+
+enum BridgeCodec {
+    kCodecNone = 0,   // columns stored uncompressed
+    kCodecLz4 = 1,
+    kCodecZstd = 2,
+};
+
+#pragma pack(push, 1)
+struct BridgeCodecBlock {
+    uint8_t  codec;          // BridgeCodec of the data that follows
+    uint8_t  quant;          // coordinate unit, 0 = 1 mm
+    uint16_t reserved;
+    uint32_t first_point;    // index of the block's first point in the scan
+    uint32_t scan_points;    // points in the whole scan
+    uint32_t raw_len;        // column bytes before compression
+    uint32_t n_escapes;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BridgeCodecBlock) == 20, "BridgeCodecBlock must stay 20 bytes");
+
+// 12 column bytes per point plus at most 3 escapes keep a block well under one datagram
+static const size_t kCodecBlockPoints = 2048;
+static const size_t kCodecMaxRaw = kCodecBlockPoints * 24;
+static const uint16_t kCodecEscape = 0xFFFF;
+
+static inline const char* scan_codec_name(uint8_t codec) {
+    switch (codec) {
+    case kCodecNone: return "none";
+    case kCodecLz4:  return "lz4";
+    case kCodecZstd: return "zstd";
+    default:         return "?";
+    }
+}
+
+// Whether this build can encode / decode `codec`.
+static inline bool scan_codec_available(uint8_t codec) {
+    switch (codec) {
+    case kCodecNone: return true;
+#ifdef LIVOX_BRIDGE_HAVE_LZ4
+    case kCodecLz4:  return true;
+#endif
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+    case kCodecZstd: return true;
+#endif
+    default:         return false;
+    }
+}
+
+// "lz4" / "zstd" / "none" -> BridgeCodec, -1 if unknown.
+static inline int scan_codec_parse(const char* s) {
+    for (uint8_t c = kCodecNone; c <= kCodecZstd; ++c)
+        if (std::strcmp(s, scan_codec_name(c)) == 0) return c;
+    return -1;
+}
+
+// Best codec this build has: LZ4 (fastest), else zstd, else none.
+static inline uint8_t scan_codec_default() {
+    if (scan_codec_available(kCodecLz4)) return kCodecLz4;
+    if (scan_codec_available(kCodecZstd)) return kCodecZstd;
+    return kCodecNone;
+}
+
+struct CodecBlockRef {
+    uint32_t offset;         // BridgeCodecBlock + data in the output buffer
+    uint32_t len;
+    uint32_t points;
+};
+
+class ScanEncoder {
+public:
+    ScanEncoder() : codec_(kCodecNone), level_(1), raw_(kCodecMaxRaw) {
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+        zctx_ = NULL;
+#endif
+        for (int a = 0; a < 3; ++a) esc_[a].reserve(kCodecBlockPoints);
+    }
+
+    ~ScanEncoder() {
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+        if (zctx_) ZSTD_freeCCtx(zctx_);
+#endif
+    }
+
+    // level: LZ4 acceleration (1 = default, higher = faster, larger) or zstd level.
+    // False if the codec is not built in.
+    bool configure(uint8_t codec, int level) {
+        if (!scan_codec_available(codec)) return false;
+        codec_ = codec;
+        level_ = level;
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+        if (codec == kCodecZstd && !zctx_) zctx_ = ZSTD_createCCtx();
+        if (codec == kCodecZstd && !zctx_) return false;
+#endif
+        return true;
+    }
+
+    uint8_t codec() const { return codec_; }
+
+    // Largest output encode() can produce for n points (to reserve it up front).
+    static size_t max_output(size_t n) {
+        const size_t n_blocks = n ? (n + kCodecBlockPoints - 1) / kCodecBlockPoints : 1;
+        return n_blocks * (sizeof(BridgeCodecBlock) + bound(kCodecMaxRaw));
+    }
+
+    // Encode n points as blocks appended to *out (cleared first); one ref per block.
+    void encode(const BridgePoint* pts, size_t n, std::vector<uint8_t>* out, std::vector<CodecBlockRef>* blocks) {
+        out->clear();
+        blocks->clear();
+        const size_t n_blocks = n ? (n + kCodecBlockPoints - 1) / kCodecBlockPoints : 1;
+        for (size_t k = 0; k < n_blocks; ++k) {
+            const size_t first = k * kCodecBlockPoints;
+            const size_t m = n - first < kCodecBlockPoints ? n - first : kCodecBlockPoints;
+            CodecBlockRef ref;
+            ref.offset = (uint32_t)out->size();
+            ref.points = (uint32_t)m;
+            ref.len = (uint32_t)encode_block(pts + first, m, (uint32_t)first, (uint32_t)n, out);
+            blocks->push_back(ref);
+        }
+    }
+
+private:
+    static size_t bound(size_t raw_len) {
+        size_t b = raw_len;
+#ifdef LIVOX_BRIDGE_HAVE_LZ4
+        const size_t lb = (size_t)LZ4_compressBound((int)raw_len);
+        if (lb > b) b = lb;
+#endif
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+        const size_t zb = ZSTD_compressBound(raw_len);
+        if (zb > b) b = zb;
+#endif
+        return b;
+    }
+
+    static uint16_t zigzag(int32_t d) { return (uint16_t)(((uint32_t)d << 1) ^ (uint32_t)(d >> 31)); }
+
+    static int32_t to_mm(float v) {
+        const float mm = v * 1000.0f;
+        if (!(mm > -1.0e9f && mm < 1.0e9f)) return 0;   // NaN / beyond 1000 km: deltas must fit int32
+        return (int32_t)lrintf(mm);
+    }
+
+    // Columns of one block into raw_; returns raw_len and sets *n_escapes.
+    size_t build_columns(const BridgePoint* p, size_t n, uint32_t* n_escapes) {
+        uint8_t* raw = &raw_[0];
+        for (int a = 0; a < 3; ++a) esc_[a].clear();
+        int32_t prev[3] = { 0, 0, 0 };
+        uint32_t prev_t = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const int32_t q[3] = { to_mm(p[i].x), to_mm(p[i].y), to_mm(p[i].z) };
+            for (int a = 0; a < 3; ++a) {
+                const int64_t d = (int64_t)q[a] - prev[a];
+                prev[a] = q[a];
+                uint16_t zz = kCodecEscape;
+                if (d >= -32767 && d <= 32767) zz = zigzag((int32_t)d);
+                else esc_[a].push_back((int32_t)d);
+                raw[(2 * a) * n + i] = (uint8_t)zz;
+                raw[(2 * a + 1) * n + i] = (uint8_t)(zz >> 8);
+            }
+            const uint32_t dt = p[i].t_offset_ns - prev_t;
+            prev_t = p[i].t_offset_ns;
+            raw[6 * n + i] = (uint8_t)dt;
+            raw[7 * n + i] = (uint8_t)(dt >> 8);
+            raw[8 * n + i] = (uint8_t)(dt >> 16);
+            raw[9 * n + i] = (uint8_t)(dt >> 24);
+            raw[10 * n + i] = p[i].reflectivity;
+            raw[11 * n + i] = p[i].tag;
+        }
+        size_t len = 12 * n;
+        for (int a = 0; a < 3; ++a) {
+            if (esc_[a].empty()) continue;
+            std::memcpy(raw + len, &esc_[a][0], esc_[a].size() * sizeof(int32_t));
+            len += esc_[a].size() * sizeof(int32_t);
+        }
+        *n_escapes = (uint32_t)(esc_[0].size() + esc_[1].size() + esc_[2].size());
+        return len;
+    }
+
+    size_t encode_block(const BridgePoint* p, size_t n, uint32_t first, uint32_t scan_points, std::vector<uint8_t>* out) {
+        BridgeCodecBlock b;
+        std::memset(&b, 0, sizeof(b));
+        b.first_point = first;
+        b.scan_points = scan_points;
+        b.raw_len = (uint32_t)build_columns(p, n, &b.n_escapes);
+
+        const size_t at = out->size();
+        out->resize(at + sizeof(b) + bound(b.raw_len));
+        uint8_t* dst = &(*out)[at + sizeof(b)];
+        const size_t cap = out->size() - at - sizeof(b);
+        (void)cap;   // only the compressors use it
+        size_t len = 0;
+#ifdef LIVOX_BRIDGE_HAVE_LZ4
+        if (codec_ == kCodecLz4 && b.raw_len) {
+            const int r = LZ4_compress_fast(reinterpret_cast<const char*>(&raw_[0]), reinterpret_cast<char*>(dst),
+                (int)b.raw_len, (int)cap, level_ > 0 ? level_ : 1);
+            if (r > 0) len = (size_t)r;
+        }
+#endif
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+        if (codec_ == kCodecZstd && b.raw_len) {
+            const size_t r = ZSTD_compressCCtx(zctx_, dst, cap, &raw_[0], b.raw_len, level_);
+            if (!ZSTD_isError(r)) len = r;
+        }
+#endif
+        if (len && len < b.raw_len) {
+            b.codec = codec_;
+        }
+        else {
+            b.codec = kCodecNone;
+            len = b.raw_len;
+            if (len) std::memcpy(dst, &raw_[0], len);
+        }
+        std::memcpy(&(*out)[at], &b, sizeof(b));
+        out->resize(at + sizeof(b) + len);
+        return sizeof(b) + len;
+    }
+
+    uint8_t codec_;
+    int level_;
+    std::vector<uint8_t> raw_;
+    std::vector<int32_t> esc_[3];
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+    ZSTD_CCtx* zctx_;
+#endif
+};
+
+// Decode one msg 5 payload (BridgeCodecBlock + data, `len` bytes) of `n` points (the frame's
+// point_count) into out[0..n). scratch must hold kCodecMaxRaw bytes. False if the block is
+// malformed or its codec is not built in; out[i].reserved is 0.
+static inline bool scan_codec_decode(const uint8_t* payload, size_t len, uint32_t n, BridgePoint* out,
+    uint8_t* scratch) {
+    if (len < sizeof(BridgeCodecBlock) || n > kCodecBlockPoints) return false;
+    BridgeCodecBlock b;
+    std::memcpy(&b, payload, sizeof(b));
+    const uint8_t* data = payload + sizeof(b);
+    const size_t data_len = len - sizeof(b);
+    if (b.quant != 0 || b.raw_len > kCodecMaxRaw || b.n_escapes > 3 * (size_t)n ||
+        b.raw_len != 12 * (size_t)n + 4 * (size_t)b.n_escapes)
+        return false;
+
+    const uint8_t* raw = scratch;
+    switch (b.codec) {
+    case kCodecNone:
+        if (data_len != b.raw_len) return false;
+        raw = data;
+        break;
+#ifdef LIVOX_BRIDGE_HAVE_LZ4
+    case kCodecLz4:
+        if (LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(scratch),
+                (int)data_len, (int)b.raw_len) != (int)b.raw_len)
+            return false;
+        break;
+#endif
+#ifdef LIVOX_BRIDGE_HAVE_ZSTD
+    case kCodecZstd:
+        if (ZSTD_decompress(scratch, b.raw_len, data, data_len) != b.raw_len) return false;
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    const uint8_t* esc = raw + 12 * (size_t)n;
+    uint32_t k = 0;
+    for (int a = 0; a < 3; ++a) {
+        const uint8_t* lo = raw + (2 * a) * (size_t)n;
+        const uint8_t* hi = raw + (2 * a + 1) * (size_t)n;
+        int32_t v = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint16_t zz = (uint16_t)(lo[i] | (hi[i] << 8));
+            int32_t d;
+            if (zz == kCodecEscape) {
+                if (k == b.n_escapes) return false;
+                std::memcpy(&d, esc + 4 * (size_t)k++, sizeof(d));
+            }
+            else {
+                d = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+            }
+            v += d;
+            float* f = a == 0 ? &out[i].x : a == 1 ? &out[i].y : &out[i].z;
+            *f = (float)v * 0.001f;
+        }
+    }
+    if (k != b.n_escapes) return false;
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        t += (uint32_t)raw[6 * n + i] | ((uint32_t)raw[7 * n + i] << 8) | ((uint32_t)raw[8 * n + i] << 16) |
+             ((uint32_t)raw[9 * n + i] << 24);
+        out[i].t_offset_ns = t;
+        out[i].reflectivity = raw[10 * n + i];
+        out[i].tag = raw[11 * n + i];
+        out[i].reserved = 0;
+    }
+    return true;
+}
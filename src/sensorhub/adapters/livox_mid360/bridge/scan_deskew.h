@@ -0,0 +1,118 @@
+// Livox MID-360 Bridge - IMU scan deskew (motion compensation)
+//
+// A scan is ~100 ms of the non-repetitive pattern; while the unit turns, points sampled
+// late in the scan are rotated against the early ones. ScanDeskew takes the device's IMU
+// history (imu_channel.h), integrates the gyro over the scan into orientation knots every
+// step_ns, and moves every point into the sensor frame at the scan start:
+//   p' = R(t) p,  R(t) = orientation at the point's stamp relative to the scan stamp
+// with R(t) interpolated linearly between the two knots around t (error ~ (w step)^2, far
+// below the range noise for 1 ms knots). Rotation only: translation would need velocity,
+// which accelerometer integration cannot give without drift.
+//
+// Points are processed in runs sharing a knot interval; each run is staged through SoA
+// columns and rotated twice by point_transform.h's SIMD kernel (knot k, and knot k+1 minus
+// knot k), then blended per point. Not thread-safe; the emitter owns it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bridge_frame.h"
+#include "imu_channel.h"
+#include "point_transform.h"
+
+class ScanDeskew {
+public:
+    static const size_t kMaxKnots = 1024;
+
+    ScanDeskew()
+        : step_ns_(1000000), cur_step_ns_(1000000), n_knots_(0), scans_(0), skipped_(0), partial_(0) {}
+
+    void configure(uint32_t step_ns) { step_ns_ = step_ns ? step_ns : 1000000; }
+
+    // Knots for the scan [t0, t0 + span_ns] from ch (T rotates its gyro into the points'
+    // frame, or NULL). False, counted as skipped, when no IMU sample overlaps the scan.
+    bool prepare(const ImuChannel& ch, uint64_t t0, uint64_t span_ns, const Mat34* T) {
+        uint64_t step = step_ns_;
+        if (span_ns / step + 2 > kMaxKnots) step = span_ns / (kMaxKnots - 2) + 1;
+        const size_t n = (size_t)(span_ns / step) + 2;
+        const uint64_t covered = ch.rotation_knots(t0, step, n, T, q_);
+        if (!covered) {
+            ++skipped_;
+            return false;
+        }
+        if (covered < span_ns) ++partial_;
+        for (size_t k = 0; k < n; ++k) knots_[k] = rotation_matrix(q_[k]);
+        n_knots_ = n;
+        cur_step_ns_ = step;
+        ++scans_;
+        return true;
+    }
+
+    // Rotate pts (t_offset_ns relative to the scan start) with the prepared knots.
+    void apply(BridgePoint* pts, size_t n) const {
+        const size_t kBlock = 128;
+        float x[kBlock], y[kBlock], z[kBlock], dx[kBlock], dy[kBlock], dz[kBlock], f[kBlock];
+        size_t i = 0;
+        while (i < n) {
+            const size_t k = knot(pts[i].t_offset_ns);
+            size_t cnt = 0;
+            for (; i + cnt < n && cnt < kBlock && knot(pts[i + cnt].t_offset_ns) == k; ++cnt) {
+                const BridgePoint& p = pts[i + cnt];
+                x[cnt] = dx[cnt] = p.x;
+                y[cnt] = dy[cnt] = p.y;
+                z[cnt] = dz[cnt] = p.z;
+                f[cnt] = (float)(p.t_offset_ns - k * cur_step_ns_) / (float)cur_step_ns_;
+            }
+            Mat34 d;
+            for (int j = 0; j < 12; ++j) d.m[j] = knots_[k + 1].m[j] - knots_[k].m[j];
+            transform_xyz(x, y, z, cnt, knots_[k]);
+            transform_xyz(dx, dy, dz, cnt, d);
+            BridgePoint* p = pts + i;
+            for (size_t j = 0; j < cnt; ++j) {
+                p[j].x = x[j] + f[j] * dx[j];
+                p[j].y = y[j] + f[j] * dy[j];
+                p[j].z = z[j] + f[j] * dz[j];
+            }
+            i += cnt;
+        }
+    }
+
+    uint64_t scans() const { return scans_; }
+    uint64_t skipped() const { return skipped_; }
+    // Scans deskewed with IMU gaps (uncovered time assumed not rotating).
+    uint64_t partial() const { return partial_; }
+
+private:
+    // Interval [k, k + 1] holding offset t (the last one for points past the span).
+    size_t knot(uint32_t t) const {
+        const size_t k = (size_t)(t / cur_step_ns_);
+        return k + 1 < n_knots_ ? k : n_knots_ - 2;
+    }
+
+    static Mat34 rotation_matrix(const double* q) {
+        const double w = q[0], a = q[1], b = q[2], c = q[3];
+        Mat34 R;
+        R.m[0] = (float)(1 - 2 * (b * b + c * c));
+        R.m[1] = (float)(2 * (a * b - w * c));
+        R.m[2] = (float)(2 * (a * c + w * b));
+        R.m[4] = (float)(2 * (a * b + w * c));
+        R.m[5] = (float)(1 - 2 * (a * a + c * c));
+        R.m[6] = (float)(2 * (b * c - w * a));
+        R.m[8] = (float)(2 * (a * c - w * b));
+        R.m[9] = (float)(2 * (b * c + w * a));
+        R.m[10] = (float)(1 - 2 * (a * a + b * b));
+        R.m[3] = R.m[7] = R.m[11] = 0;
+        return R;
+    }
+
+    uint64_t step_ns_;       // configured knot spacing
+    uint64_t cur_step_ns_;   // the prepared scan's (wider past kMaxKnots steps)
+    size_t n_knots_;
+    double q_[kMaxKnots][4];
+    Mat34 knots_[kMaxKnots];
+    uint64_t scans_;
+    uint64_t skipped_;
+    uint64_t partial_;
+};
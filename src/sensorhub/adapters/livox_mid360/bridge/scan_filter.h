@@ -0,0 +1,158 @@
+// Livox MID-360 Bridge - per-scan filter stage (range, ROI box, voxel-grid downsample)
+//
+// Runs on an assembled scan in place, just before it is published. Points outside
+// [range_min, range_max] or outside the ROI box are dropped; the survivors are then
+// optionally merged per voxel (centroid of x/y/z, other fields from the first point).
+// The voxel table is open-addressed, sized once by reserve() and invalidated per scan with
+// a generation counter, so filtering a scan never allocates. Not thread-safe.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bridge_frame.h"
+
+struct ScanFilterConfig {
+    float range_min;       // metres, 0 = no lower bound
+    float range_max;       // metres, 0 = no upper bound
+    bool  roi;             // crop to the [roi_min, roi_max] box
+    float roi_min[3];
+    float roi_max[3];
+    float voxel;           // voxel edge in metres, 0 = no downsampling
+
+    ScanFilterConfig() : range_min(0), range_max(0), roi(false), voxel(0) {
+        for (int i = 0; i < 3; ++i) { roi_min[i] = 0; roi_max[i] = 0; }
+    }
+
+    bool enabled() const { return range_min > 0 || range_max > 0 || roi || voxel > 0; }
+};
+
+class ScanFilter {
+public:
+    ScanFilter() : mask_(0), gen_(0), scans_(0), points_in_(0), points_out_(0) {}
+
+    void configure(const ScanFilterConfig& cfg) { cfg_ = cfg; }
+    const ScanFilterConfig& config() const { return cfg_; }
+    bool enabled() const { return cfg_.enabled(); }
+
+    // Size the voxel table for scans of up to max_points; call at startup, never per scan.
+    void reserve(size_t max_points) {
+        if (cfg_.voxel <= 0 || max_points <= acc_.size()) return;
+        size_t n = 16;
+        while (n < max_points * 2) n <<= 1;
+        slots_.assign(n, Slot());
+        mask_ = n - 1;
+        acc_.resize(max_points);
+        gen_ = 0;
+    }
+
+    // Filter pts[0, n) in place; returns the number of points kept.
+    size_t apply(BridgePoint* pts, size_t n) {
+        ++scans_;
+        points_in_ += n;
+        n = crop(pts, n);
+        if (cfg_.voxel > 0 && n <= acc_.size()) n = voxelize(pts, n);
+        points_out_ += n;
+        return n;
+    }
+
+    uint64_t scans() const { return scans_; }
+    uint64_t points_in() const { return points_in_; }
+    uint64_t points_out() const { return points_out_; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t gen;      // slot is live only when gen == gen_
+        uint32_t index;    // output point index of this voxel
+        Slot() : key(0), gen(0), index(0) {}
+    };
+
+    struct Accum {
+        float sx, sy, sz;
+        uint32_t n;
+    };
+
+    size_t crop(BridgePoint* pts, size_t n) const {
+        const bool range = cfg_.range_min > 0 || cfg_.range_max > 0;
+        if (!range && !cfg_.roi) return n;
+        const float rmin2 = cfg_.range_min * cfg_.range_min;
+        const float rmax2 = cfg_.range_max > 0 ? cfg_.range_max * cfg_.range_max : HUGE_VALF;
+        size_t out = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const BridgePoint& p = pts[i];
+            if (range) {
+                const float r2 = p.x * p.x + p.y * p.y + p.z * p.z;
+                if (r2 < rmin2 || r2 > rmax2) continue;
+            }
+            if (cfg_.roi &&
+                (p.x < cfg_.roi_min[0] || p.x > cfg_.roi_max[0] ||
+                 p.y < cfg_.roi_min[1] || p.y > cfg_.roi_max[1] ||
+                 p.z < cfg_.roi_min[2] || p.z > cfg_.roi_max[2])) continue;
+            if (out != i) pts[out] = p;
+            ++out;
+        }
+        return out;
+    }
+
+    static uint64_t voxel_key(int32_t ix, int32_t iy, int32_t iz) {
+        // 21 bits per axis: +-1M voxels, i.e. +-10 km at 1 cm
+        const uint64_t m = (1u << 21) - 1;
+        return ((uint64_t)(ix & m) << 42) | ((uint64_t)(iy & m) << 21) | (uint64_t)(iz & m);
+    }
+
+    size_t voxelize(BridgePoint* pts, size_t n) {
+        if (++gen_ == 0) {           // generation wrapped: stale slots could alias, wipe once
+            for (size_t i = 0; i <= mask_; ++i) slots_[i].gen = 0;
+            gen_ = 1;
+        }
+        const float inv = 1.0f / cfg_.voxel;
+        size_t out = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const BridgePoint p = pts[i];
+            const uint64_t key = voxel_key((int32_t)std::floor(p.x * inv),
+                (int32_t)std::floor(p.y * inv), (int32_t)std::floor(p.z * inv));
+            size_t h = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+            for (;;) {
+                Slot& s = slots_[h];
+                if (s.gen != gen_) {
+                    // new voxel: out <= i, so writing pts[out] never clobbers unread input
+                    s.key = key;
+                    s.gen = gen_;
+                    s.index = (uint32_t)out;
+                    pts[out] = p;
+                    Accum& a = acc_[out];
+                    a.sx = p.x; a.sy = p.y; a.sz = p.z; a.n = 1;
+                    ++out;
+                    break;
+                }
+                if (s.key == key) {
+                    Accum& a = acc_[s.index];
+                    a.sx += p.x; a.sy += p.y; a.sz += p.z; ++a.n;
+                    break;
+                }
+                h = (h + 1) & mask_;
+            }
+        }
+        for (size_t i = 0; i < out; ++i) {
+            const Accum& a = acc_[i];
+            if (a.n > 1) {
+                const float k = 1.0f / (float)a.n;
+                pts[i].x = a.sx * k; pts[i].y = a.sy * k; pts[i].z = a.sz * k;
+            }
+        }
+        return out;
+    }
+
+    ScanFilterConfig cfg_;
+    std::vector<Slot> slots_;     // power-of-two open-addressing table, load factor <= 0.5
+    std::vector<Accum> acc_;      // per output voxel
+    size_t mask_;
+    uint32_t gen_;
+    uint64_t scans_;
+    uint64_t points_in_;
+    uint64_t points_out_;
+};
@@ -0,0 +1,238 @@
+// Livox MID-360 Bridge - shared-memory ring transport
+//
+// Single-producer / multi-reader ring of fixed-size slots in a POSIX shm segment
+// (/dev/shm/<name>). The bridge writes; any number of readers map the segment read-only
+// and track their own cursor, so adding a reader costs the producer nothing.
+//
+// Segment layout (little-endian):
+//   0    ShmRingHeader (128 B; write_seq sits on its own cache line)
+//   128  slot[0] ... slot[slot_count-1], each slot_size bytes:
+//          0   u64 seq   record sequence (1-based), kShmSlotWriting while being written
+//          8   u32 len   payload bytes
+//          12  u32 rsvd
+//          16  payload   binary frame (bridge_frame.h) or one NDJSON line
+//
+// Writer: slot.seq = WRITING, fence, copy payload, slot.seq = seq (release),
+//         write_seq = seq (release).
+// Reader: wants seq r; if write_seq - r >= slot_count it was overrun. Otherwise check
+//         slot.seq == r, copy, re-check slot.seq == r (seqlock) - a mismatch means the
+//         producer lapped the reader mid-copy and the record is counted as lost.
+//
+// A restarted writer that opens with `resume` keeps an existing ring of the same geometry
+// and continues after its write_seq, so mapped readers just see a pause: no resync, no
+// reopen. A slot left kShmSlotWriting by a crash is the next one written, which readers
+// never reach before write_seq does. Any other geometry starts a fresh ring.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+static const uint32_t kShmRingMagic = 0x5258564Cu;   // "LVXR"
+static const uint32_t kShmRingVersion = 1;
+static const uint64_t kShmSlotWriting = ~0ull;
+static const size_t   kShmHeaderBytes = 128;
+static const size_t   kShmSlotHeaderBytes = 16;
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;      // power of two
+    uint32_t slot_size;       // stride in bytes, including the 16-byte slot header
+    uint32_t data_offset;     // offset of slot[0]
+    uint32_t producer_pid;
+    uint8_t  pad0[64 - 24];
+    std::atomic<uint64_t> write_seq;   // last published seq (0 = none yet)
+    uint8_t  pad1[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> seq;
+    uint32_t len;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ShmRingHeader) == kShmHeaderBytes, "ShmRingHeader must stay 128 bytes");
+static_assert(sizeof(ShmSlotHeader) == kShmSlotHeaderBytes, "ShmSlotHeader must stay 16 bytes");
+
+class ShmRingWriter {
+public:
+    ShmRingWriter() : base_(NULL), map_len_(0), hdr_(NULL), seq_(0), resumed_(false) {}
+    ~ShmRingWriter() { close(); }
+
+    // name: shm object name without leading '/'; slot_count rounded up to a power of two,
+    // slot_bytes rounded up to a 64-byte multiple (payload capacity is slot_bytes - 16).
+    // resume: continue an existing ring of this geometry (see resumed()).
+    bool open(const std::string& name, uint32_t slot_count, uint32_t slot_bytes, bool resume = false) {
+        uint32_t n = 1;
+        while (n < slot_count) n <<= 1;
+        const uint32_t stride = (slot_bytes + 63u) & ~63u;
+        map_len_ = kShmHeaderBytes + (size_t)n * stride;
+        name_ = "/" + name;
+
+        int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        const bool same_size = fstat(fd, &st) == 0 && (size_t)st.st_size == map_len_;
+        if (!same_size && ftruncate(fd, (off_t)map_len_) != 0) { ::close(fd); return false; }
+        void* p = mmap(NULL, map_len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        base_ = static_cast<uint8_t*>(p);
+        hdr_ = reinterpret_cast<ShmRingHeader*>(base_);
+
+        resumed_ = resume && same_size && hdr_->magic == kShmRingMagic && hdr_->version == kShmRingVersion &&
+                   hdr_->slot_count == n && hdr_->slot_size == stride && hdr_->data_offset == kShmHeaderBytes;
+        if (resumed_) {
+            seq_ = hdr_->write_seq.load(std::memory_order_acquire);
+            hdr_->producer_pid = (uint32_t)getpid();
+            return true;
+        }
+
+        // Fresh geometry: readers seeing write_seq go backwards resync to the new stream.
+        hdr_->magic = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        for (uint32_t i = 0; i < n; ++i)
+            slot(i, stride)->seq.store(0, std::memory_order_relaxed);
+        hdr_->write_seq.store(0, std::memory_order_relaxed);
+        hdr_->version = kShmRingVersion;
+        hdr_->slot_count = n;
+        hdr_->slot_size = stride;
+        hdr_->data_offset = (uint32_t)kShmHeaderBytes;
+        hdr_->producer_pid = (uint32_t)getpid();
+        std::atomic_thread_fence(std::memory_order_release);
+        hdr_->magic = kShmRingMagic;
+        seq_ = 0;
+        return true;
+    }
+
+    void close() {
+        if (base_) munmap(base_, map_len_);
+        base_ = NULL;
+        hdr_ = NULL;
+    }
+
+    bool is_open() const { return base_ != NULL; }
+    size_t capacity() const { return hdr_ ? hdr_->slot_size - kShmSlotHeaderBytes : 0; }
+
+    // Publish one record made of two pieces (e.g. frame header + points). Returns false
+    // if the record does not fit in a slot.
+    bool write(const void* a, size_t a_len, const void* b = NULL, size_t b_len = 0) {
+        if (!hdr_ || a_len + b_len > capacity()) return false;
+        const uint64_t seq = ++seq_;
+        ShmSlotHeader* s = slot((uint32_t)(seq - 1) & (hdr_->slot_count - 1), hdr_->slot_size);
+        s->seq.store(kShmSlotWriting, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(s) + kShmSlotHeaderBytes;
+        std::memcpy(dst, a, a_len);
+        if (b_len) std::memcpy(dst + a_len, b, b_len);
+        s->len = (uint32_t)(a_len + b_len);
+        s->seq.store(seq, std::memory_order_release);
+        hdr_->write_seq.store(seq, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t write_seq() const { return seq_; }
+    bool resumed() const { return resumed_; }     // open() continued an existing ring
+
+private:
+    ShmSlotHeader* slot(uint32_t i, uint32_t stride) {
+        return reinterpret_cast<ShmSlotHeader*>(base_ + kShmHeaderBytes + (size_t)i * stride);
+    }
+
+    uint8_t* base_;
+    size_t map_len_;
+    ShmRingHeader* hdr_;
+    uint64_t seq_;
+    bool resumed_;
+    std::string name_;
+};
+
+// Reader side, same protocol as shm_ring.py: maps the segment read-only, keeps its own
+// cursor and counts records lost to overruns.
+class ShmRingReader {
+public:
+    ShmRingReader() : base_(NULL), map_len_(0), hdr_(NULL), cursor_(1), lost_(0), resyncs_(0) {}
+    ~ShmRingReader() { close(); }
+
+    // False if the segment does not exist or is not (yet) an initialized ring.
+    bool open(const std::string& name, bool from_start = false) {
+        close();
+        int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < kShmHeaderBytes) { ::close(fd); return false; }
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        base_ = static_cast<const uint8_t*>(p);
+        map_len_ = (size_t)st.st_size;
+        hdr_ = reinterpret_cast<const ShmRingHeader*>(base_);
+        if (hdr_->magic != kShmRingMagic || hdr_->version != kShmRingVersion ||
+            kShmHeaderBytes + (size_t)hdr_->slot_count * hdr_->slot_size > map_len_) {
+            close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        cursor_ = from_start ? 1 : hdr_->write_seq.load(std::memory_order_acquire) + 1;
+        return true;
+    }
+
+    void close() {
+        if (base_) munmap(const_cast<uint8_t*>(base_), map_len_);
+        base_ = NULL;
+        hdr_ = NULL;
+    }
+
+    bool is_open() const { return base_ != NULL; }
+
+    // Copy the next record into out (truncated to cap). Returns its length, or 0 when the
+    // reader has caught up with the producer.
+    size_t read(void* out, size_t cap) {
+        for (;;) {
+            const uint64_t ws = hdr_->write_seq.load(std::memory_order_acquire);
+            if (ws + 1 < cursor_) {           // producer restarted with a fresh ring
+                ++resyncs_;
+                cursor_ = ws + 1;
+            }
+            if (cursor_ > ws) return 0;
+            if (ws - cursor_ >= hdr_->slot_count) {
+                const uint64_t skip_to = ws - hdr_->slot_count + 1;
+                lost_ += skip_to - cursor_;
+                cursor_ = skip_to;
+            }
+            const ShmSlotHeader* s = slot((uint32_t)(cursor_ - 1) & (hdr_->slot_count - 1));
+            const uint64_t seq = cursor_++;
+            if (s->seq.load(std::memory_order_acquire) != seq) { ++lost_; continue; }
+            size_t n = s->len;
+            if (n > cap) n = cap;
+            std::memcpy(out, reinterpret_cast<const uint8_t*>(s) + kShmSlotHeaderBytes, n);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->seq.load(std::memory_order_relaxed) != seq) { ++lost_; continue; }
+            return n;
+        }
+    }
+
+    uint64_t lost() const { return lost_; }
+    uint64_t resyncs() const { return resyncs_; }
+
+private:
+    const ShmSlotHeader* slot(uint32_t i) const {
+        return reinterpret_cast<const ShmSlotHeader*>(base_ + hdr_->data_offset + (size_t)i * hdr_->slot_size);
+    }
+
+    const uint8_t* base_;
+    size_t map_len_;
+    const ShmRingHeader* hdr_;
+    uint64_t cursor_;
+    uint64_t lost_;
+    uint64_t resyncs_;
+};
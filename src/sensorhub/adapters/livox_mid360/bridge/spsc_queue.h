@@ -0,0 +1,84 @@
+// Livox MID-360 Bridge - wait-free single-producer / single-consumer queue
+//
+// Fixed-capacity ring of preallocated T slots. The producer claims a slot, fills it in
+// place and commits; the consumer peeks and pops. Neither side ever blocks or allocates:
+// a full queue makes claim() return NULL and bumps the overflow counter.
+// Head and tail live on separate cache lines; each side caches the other's index so the
+// shared line is only touched when the cached view runs out.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class SpscQueue {
+public:
+    // capacity is rounded up to a power of two; one slot stays empty to tell full from empty.
+    explicit SpscQueue(size_t capacity)
+        : mask_(0), head_(0), cached_tail_(0), tail_(0), cached_head_(0), overflows_(0),
+          high_water_(0) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        buf_.resize(n);
+        mask_ = n - 1;
+    }
+
+    // ---- producer ----
+    T* claim() {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - cached_head_ >= mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (t - cached_head_ >= mask_) {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+                return NULL;
+            }
+        }
+        return &buf_[t & mask_];
+    }
+
+    void commit() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- consumer ----
+    T* peek() {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (h == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (h == cached_tail_) return NULL;
+            // depth as seen by the consumer each time it catches up with the producer
+            const size_t depth = cached_tail_ - h;
+            if (depth > high_water_.load(std::memory_order_relaxed))
+                high_water_.store(depth, std::memory_order_relaxed);
+        }
+        return &buf_[h & mask_];
+    }
+
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- either side (approximate while running) ----
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return mask_; }
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+    size_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_;
+    char pad0_[64];
+    std::atomic<size_t> head_;       // consumer-owned
+    size_t cached_tail_;
+    char pad1_[64];
+    std::atomic<size_t> tail_;       // producer-owned
+    size_t cached_head_;
+    char pad2_[64];
+    std::atomic<uint64_t> overflows_;
+    std::atomic<size_t> high_water_;
+};
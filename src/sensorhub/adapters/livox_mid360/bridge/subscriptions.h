@@ -0,0 +1,248 @@
+// Livox MID-360 Bridge - per-consumer subscriptions
+//
+// Besides the default route (LIVOX_UDP_ADDR:LIVOX_UDP_PORT, shm, stdout in LIVOX_BRIDGE_FORMAT
+// with every stream) consumers may register their own UDP destination with
+//   {"cmd":"subscribe","streams":"points,imu","format":"binary","decimate":5,"addr":..,"port":..}
+// (format ndjson, binary or compressed: binary with scans as msg 5, see scan_codec.h)
+// and get only the streams they asked for. Routing is a bitmask over consumers: bit 0 is the
+// default route, bit 1 + i subscriber slot i. The emitter serializes a record once per
+// encoding that has a consumer and hands the mask to the transports, so N subscribers cost
+// N datagrams in the same sendmmsg batch, not N serializations. A multicast addr serves any
+// number of receivers with one datagram.
+//
+// Decimation keeps every Nth points / IMU record per subscriber (scans or packets, samples
+// or batches), so binary seq numbers jump by N; info and stats records are never dropped.
+// On top of that each subscriber has a backpressure level (backpressure.h decides it): at
+// kSubShed only every shed_every-th scan / range image is offered to it.
+// Subscriptions are leases: they expire ttl after the last subscribe from the same
+// destination, so a consumer that dies stops costing bandwidth. Emitter thread only.
+
+#pragma once
+
+#include <netinet/in.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum BridgeStream {
+    kStreamPoints = 1,   // frames / scans (+ scan preintegration)
+    kStreamImu = 2,      // IMU samples / batches
+    kStreamInfo = 4,     // device info, acks, command replies
+    kStreamStats = 8,    // stats and clock records
+    kStreamGrid = 16,    // grid map deltas (grid_map.h, LIVOX_GRID)
+    kStreamRange = 32,   // range images (range_image.h, LIVOX_RANGE_IMAGE)
+    kStreamAll = 63,
+};
+
+// How a consumer takes points; IMU is binary batches for binary / compressed consumers
+// when the bridge batches IMU, grid deltas and range images are binary for them, info and
+// stats are always NDJSON.
+enum BridgeEncoding {
+    kEncNdjson = 0,
+    kEncBinary = 1,
+    kEncCompressed = 2,      // scans as compressed blocks, everything else as kEncBinary
+};
+
+static inline const char* bridge_encoding_name(uint8_t enc) {
+    return enc == kEncBinary ? "binary" : enc == kEncCompressed ? "compressed" : "ndjson";
+}
+
+// "ndjson" / "binary" / "compressed" -> BridgeEncoding, -1 if unknown.
+static inline int bridge_encoding_parse(const char* s, size_t len) {
+    for (uint8_t e = kEncNdjson; e <= kEncCompressed; ++e) {
+        const char* name = bridge_encoding_name(e);
+        if (std::strlen(name) == len && std::memcmp(s, name, len) == 0) return e;
+    }
+    return -1;
+}
+
+// "points,imu" / "all" -> stream mask; 0 if a name is unknown or the list is empty.
+static inline uint32_t bridge_stream_mask(const char* s, size_t len) {
+    static const char* const kNames[] = { "points", "imu", "info", "stats", "grid", "range" };
+    uint32_t mask = 0;
+    size_t i = 0;
+    while (i < len) {
+        size_t j = i;
+        while (j < len && s[j] != ',') ++j;
+        const size_t n = j - i;
+        uint32_t bit = 0;
+        if (n == 3 && std::memcmp(s + i, "all", 3) == 0) bit = kStreamAll;
+        for (size_t k = 0; k < sizeof(kNames) / sizeof(kNames[0]) && !bit; ++k)
+            if (std::strlen(kNames[k]) == n && std::memcmp(s + i, kNames[k], n) == 0) bit = 1u << k;
+        if (!bit) return 0;
+        mask |= bit;
+        i = j + 1;
+    }
+    return mask;
+}
+
+// Backpressure level of a subscriber (see backpressure.h)
+enum SubscriberLevel {
+    kSubFull = 0,         // everything it subscribed to
+    kSubDownsampled = 1,  // scans voxel-downsampled
+    kSubShed = 2,         // downsampled, and only every Nth scan / range image
+};
+
+static inline const char* subscriber_level_name(uint8_t level) {
+    static const char* const kNames[] = { "full", "downsampled", "shed" };
+    return level <= kSubShed ? kNames[level] : "?";
+}
+
+struct Subscriber {
+    bool active;
+    uint32_t id;                 // client-visible id, unique for the bridge's lifetime
+    sockaddr_in dst;
+    uint32_t streams;            // BridgeStream mask
+    uint8_t format;              // BridgeEncoding
+    uint32_t decimate;           // keep every Nth points / IMU record
+    uint64_t expires_ns;         // 0 = never
+    uint64_t seen[2];            // points / IMU records offered, for decimation
+    uint8_t level;               // SubscriberLevel
+    uint64_t shed[2];            // points / range records offered at kSubShed
+    uint64_t records;
+    uint64_t bytes;
+};
+
+class SubscriberTable {
+public:
+    static const size_t kMax = 16;
+
+    SubscriberTable() : next_id_(1), n_active_(0), next_expiry_(0), shed_every_(1) {
+        std::memset(subs_, 0, sizeof(subs_));
+    }
+
+    // Add or renew the subscription of dst; returns its slot, or -1 when the table is full.
+    int subscribe(const sockaddr_in& dst, uint32_t streams, uint8_t format, uint32_t decimate,
+        uint64_t expires_ns) {
+        int slot = find(dst);
+        if (slot < 0) {
+            for (size_t i = 0; i < kMax && slot < 0; ++i)
+                if (!subs_[i].active) slot = (int)i;
+            if (slot < 0) return -1;
+            Subscriber& s = subs_[slot];
+            std::memset(&s, 0, sizeof(s));
+            s.active = true;
+            s.id = next_id_++;
+            s.dst = dst;
+            ++n_active_;
+        }
+        Subscriber& s = subs_[slot];
+        s.streams = streams;
+        s.format = format;
+        s.decimate = decimate ? decimate : 1;
+        s.expires_ns = expires_ns;
+        update_expiry();
+        return slot;
+    }
+
+    void remove(int slot) {
+        if (slot < 0 || slot >= (int)kMax || !subs_[slot].active) return;
+        subs_[slot].active = false;
+        --n_active_;
+        update_expiry();
+    }
+
+    // Slot of the subscriber with this id / destination, -1 if none.
+    int find_id(uint32_t id) const {
+        for (size_t i = 0; i < kMax; ++i)
+            if (subs_[i].active && subs_[i].id == id) return (int)i;
+        return -1;
+    }
+
+    int find(const sockaddr_in& dst) const {
+        for (size_t i = 0; i < kMax; ++i)
+            if (subs_[i].active && subs_[i].dst.sin_addr.s_addr == dst.sin_addr.s_addr &&
+                subs_[i].dst.sin_port == dst.sin_port)
+                return (int)i;
+        return -1;
+    }
+
+    // Drop leases that ran out; calls on_expired(slot) before freeing each slot.
+    template <typename Fn>
+    void expire(uint64_t now_ns, Fn on_expired) {
+        if (!next_expiry_ || now_ns < next_expiry_) return;
+        for (size_t i = 0; i < kMax; ++i) {
+            if (subs_[i].active && subs_[i].expires_ns && subs_[i].expires_ns <= now_ns) {
+                on_expired((int)i);
+                subs_[i].active = false;
+                --n_active_;
+            }
+        }
+        update_expiry();
+    }
+
+    // Consumer mask (bit 1 + slot) for one record of `stream` in encoding `enc`, advancing
+    // the decimation counters of the subscribers it is offered to (see stream_encoding).
+    uint32_t route(BridgeStream stream, uint8_t enc, bool imu_batched = false) {
+        if (!n_active_) return 0;
+        const int k = __builtin_ctz((unsigned)stream);
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kMax; ++i) {
+            Subscriber& s = subs_[i];
+            if (!s.active || !(s.streams & stream)) continue;
+            if (stream_encoding(stream, s.format, imu_batched) != enc) continue;
+            if (stream <= kStreamImu && s.seen[k]++ % s.decimate) continue;
+            if (s.level >= kSubShed && (stream == kStreamPoints || stream == kStreamRange) &&
+                s.shed[stream == kStreamRange]++ % shed_every_)
+                continue;
+            mask |= 2u << i;
+        }
+        return mask;
+    }
+
+    // Account one record of `bytes` sent through consumer mask `mask` (bit 0 ignored).
+    void sent(uint32_t mask, size_t bytes) {
+        for (mask >>= 1; mask; mask &= mask - 1) {
+            Subscriber& s = subs_[__builtin_ctz(mask)];
+            ++s.records;
+            s.bytes += bytes;
+        }
+    }
+
+    // Backpressure: a subscriber's level, and how many scans a shed one takes (every Nth).
+    void set_level(size_t slot, uint8_t level) { subs_[slot].level = level; }
+    void set_shed_every(uint32_t n) { shed_every_ = n ? n : 1; }
+
+    // Consumers (bit 1 + slot) at `level` or above.
+    uint32_t level_mask(uint8_t level) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kMax; ++i)
+            if (subs_[i].active && subs_[i].level >= level) mask |= 2u << i;
+        return mask;
+    }
+
+    // Consumers (bit 1 + slot) currently subscribed in `format`.
+    uint32_t format_mask(uint8_t format) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kMax; ++i)
+            if (subs_[i].active && subs_[i].format == format) mask |= 2u << i;
+        return mask;
+    }
+
+    // Encoding in which a consumer of `format` takes records of `stream`.
+    static uint8_t stream_encoding(BridgeStream stream, uint8_t format, bool imu_batched) {
+        if (stream == kStreamPoints) return format;
+        if (stream == kStreamImu && format != kEncNdjson && imu_batched) return kEncBinary;
+        if ((stream == kStreamGrid || stream == kStreamRange) && format != kEncNdjson) return kEncBinary;
+        return kEncNdjson;
+    }
+
+    const Subscriber& at(size_t slot) const { return subs_[slot]; }
+    size_t active() const { return n_active_; }
+
+private:
+    void update_expiry() {
+        next_expiry_ = 0;
+        for (size_t i = 0; i < kMax; ++i)
+            if (subs_[i].active && subs_[i].expires_ns &&
+                (!next_expiry_ || subs_[i].expires_ns < next_expiry_))
+                next_expiry_ = subs_[i].expires_ns;
+    }
+
+    Subscriber subs_[kMax];
+    uint32_t next_id_;
+    size_t n_active_;
+    uint64_t next_expiry_;       // earliest lease end, 0 = none
+    uint32_t shed_every_;
+};
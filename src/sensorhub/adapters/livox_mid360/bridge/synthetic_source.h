@@ -0,0 +1,267 @@
+// Livox MID-360 Bridge - synthetic source: generated MID-360-like devices, no hardware
+//
+// Drives the bridge exactly like the SDK would (device-info update, then point packets and
+// IMU samples per device) for benchmarks, CI and demos. The scene is a 20 x 12 x 4.5 m room
+// seen from its centre through a non-repetitive pattern over the MID-360 field of view
+// (360 deg x -7..52 deg); about 1% of the returns are empty (zero range) and 1% are tagged
+// as dust (intensity noise, high confidence). One 100 ms scan of packets is built once at
+// start and replayed with fresh headers, so generating a packet costs a header update plus
+// the enqueue copy, like an SDK callback.
+//
+// point_rate > 0 paces each device at that many points/s on real time. point_rate 0 runs
+// as fast as the bridge drains its queues on a virtual timeline at the MID-360 rate
+// (200k points/s): arrival and device times advance as if paced, so scan windows and
+// stamps stay realistic while throughput is limited only by the bridge.
+//
+// Device clocks free-run (boot-relative, 20 ppm fast) like an unsynchronized MID-360, or,
+// with ptp, are stamped as gPTP with host CLOCK_REALTIME at generation; with
+// LIVOX_CLOCK_TRUST_SYNC=1 a record's stamp is then its generation time, which is what
+// livox_bridge_bench measures end-to-end latency from.
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bridge_source.h"
+
+struct SyntheticConfig {
+    size_t   devices;             // simulated lidars, 1..kMaxDevices
+    double   point_rate;          // points/s per device; 0 = as fast as the queues drain
+    uint16_t points_per_packet;   // 96 on the MID-360
+    uint8_t  data_type;           // LivoxLidarPointDataType 1..3
+    double   imu_hz;              // IMU samples/s per device (0 = no IMU)
+    uint64_t packets;             // point packets per device before finishing (0 = until stopped)
+    bool     ptp;                 // gPTP time_type, stamped with host CLOCK_REALTIME
+
+    SyntheticConfig()
+        : devices(1), point_rate(200000.0), points_per_packet(96),
+          data_type(kLivoxLidarCartesianCoordinateHighData), imu_hz(200.0), packets(0), ptp(false) {}
+};
+
+class SyntheticSource : public BridgeSource {
+public:
+    static const size_t kMaxDevices = 8;
+    static const size_t kScanPoints = 20000;            // 100 ms at 200k points/s
+    static const uint16_t kMaxPointsPerPacket = 1024;
+
+    SyntheticSource() : stop_(false), stride_(0), n_templates_(0), pt_size_(0) {}
+    ~SyntheticSource() { stop(); }
+
+    // False if the configuration is unusable.
+    bool configure(const SyntheticConfig& cfg) {
+        cfg_ = cfg;
+        if (cfg_.devices < 1 || cfg_.devices > kMaxDevices) {
+            std::cerr << "synthetic: devices must be 1.." << kMaxDevices << std::endl;
+            return false;
+        }
+        if (cfg_.points_per_packet < 1 || cfg_.points_per_packet > kMaxPointsPerPacket) {
+            std::cerr << "synthetic: points per packet must be 1.." << kMaxPointsPerPacket << std::endl;
+            return false;
+        }
+        switch (cfg_.data_type) {
+        case kLivoxLidarCartesianCoordinateHighData: pt_size_ = sizeof(LivoxLidarCartesianHighRawPoint); break;
+        case kLivoxLidarCartesianCoordinateLowData:  pt_size_ = sizeof(LivoxLidarCartesianLowRawPoint); break;
+        case kLivoxLidarSphericalCoordinateData:     pt_size_ = sizeof(LivoxLidarSpherPoint); break;
+        default:
+            std::cerr << "synthetic: data type must be 1 (cartesian high), 2 (low) or 3 (spherical)" << std::endl;
+            return false;
+        }
+        build_templates();
+        return true;
+    }
+
+    const char* name() const { return "synthetic"; }
+
+    bool start(const BridgeSourceSink& sink) {
+        if (!n_templates_) return false;
+        sink_ = sink;
+        stop_.store(false);
+        thread_ = std::thread(&SyntheticSource::run, this);
+        return true;
+    }
+
+    void stop() {
+        stop_.store(true);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    // SDK-style handle of device d: its IPv4 address (192.168.1.100 + d) in network order.
+    static uint32_t device_handle(size_t d) {
+        return 192u | (168u << 8) | (1u << 16) | ((uint32_t)(100 + d) << 24);
+    }
+
+private:
+    static const uint64_t kFrameNs = 100000000ull;       // frame_cnt period (10 Hz)
+    static const uint64_t kBootNs = 5000000000ull;       // free-running device clock at start
+    static constexpr double kNominalRate = 200000.0;     // points/s, virtual timeline
+
+    uint8_t* tpl(size_t i) { return &templates_[i * stride_]; }
+
+    static size_t header_bytes() { return offsetof(LivoxLidarEthernetPacket, data); }
+
+    // Point j of a scan: golden-ratio sequences spread the rays over the field of view, the
+    // range is where the ray leaves the room box.
+    void make_point(size_t j, uint8_t* out) const {
+        const double kPi = 3.14159265358979323846;
+        const double u = std::fmod((double)j * 0.6180339887498949, 1.0);
+        const double v = std::fmod((double)j * 0.7548776662466927 + 0.5, 1.0);
+        const double az = 2.0 * kPi * u;
+        const double el = (-7.0 + 59.0 * v) * kPi / 180.0;
+        const double dx = std::cos(el) * std::cos(az), dy = std::cos(el) * std::sin(az), dz = std::sin(el);
+        double r = 1e9;
+        uint8_t refl = 80;                                   // walls
+        if (std::fabs(dx) > 1e-9) r = std::fmin(r, 10.0 / std::fabs(dx));
+        if (std::fabs(dy) > 1e-9) r = std::fmin(r, 6.0 / std::fabs(dy));
+        if (dz < -1e-9 && -1.5 / dz < r) { r = -1.5 / dz; refl = 30; }   // floor
+        if (dz > 1e-9 && 3.0 / dz < r) { r = 3.0 / dz; refl = 50; }      // ceiling
+        if (j % 97 == 13) r = 0;                             // no return
+        const uint8_t tag = j % 89 == 7 ? 0x04 : 0;          // high-confidence dust (point_columns.h)
+        const double x = r * dx, y = r * dy, z = r * dz;
+        switch (cfg_.data_type) {
+        case kLivoxLidarCartesianCoordinateHighData: {
+            LivoxLidarCartesianHighRawPoint p;
+            p.x = (int32_t)std::lround(x * 1000.0);
+            p.y = (int32_t)std::lround(y * 1000.0);
+            p.z = (int32_t)std::lround(z * 1000.0);
+            p.reflectivity = r > 0 ? refl : 0;
+            p.tag = tag;
+            std::memcpy(out, &p, sizeof(p));
+            break;
+        }
+        case kLivoxLidarCartesianCoordinateLowData: {
+            LivoxLidarCartesianLowRawPoint p;
+            p.x = (int16_t)std::lround(x * 100.0);
+            p.y = (int16_t)std::lround(y * 100.0);
+            p.z = (int16_t)std::lround(z * 100.0);
+            p.reflectivity = r > 0 ? refl : 0;
+            p.tag = tag;
+            std::memcpy(out, &p, sizeof(p));
+            break;
+        }
+        default: {
+            LivoxLidarSpherPoint p;
+            p.depth = (uint32_t)std::lround(r * 1000.0);
+            p.theta = (uint16_t)std::lround((90.0 - el * 180.0 / kPi) * 100.0);   // zenith
+            p.phi = (uint16_t)std::lround(az * 180.0 / kPi * 100.0);
+            p.reflectivity = r > 0 ? refl : 0;
+            p.tag = tag;
+            std::memcpy(out, &p, sizeof(p));
+            break;
+        }
+        }
+    }
+
+    void build_templates() {
+        const size_t ppp = cfg_.points_per_packet;
+        n_templates_ = (kScanPoints + ppp - 1) / ppp;
+        stride_ = (header_bytes() + ppp * pt_size_ + 7) & ~(size_t)7;
+        templates_.assign(n_templates_ * stride_, 0);
+        const double rate = cfg_.point_rate > 0 ? cfg_.point_rate : kNominalRate;
+        const double interval = 1e7 * ppp / rate;           // 0.1 us units
+        for (size_t i = 0; i < n_templates_; ++i) {
+            LivoxLidarEthernetPacket* p = reinterpret_cast<LivoxLidarEthernetPacket*>(tpl(i));
+            p->version = 0;
+            p->length = (uint16_t)(header_bytes() + ppp * pt_size_);
+            p->time_interval = (uint16_t)(interval < 65535.0 ? interval : 65535.0);
+            p->dot_num = (uint16_t)ppp;
+            p->data_type = cfg_.data_type;
+            for (size_t k = 0; k < ppp; ++k) make_point(i * ppp + k, p->data + k * pt_size_);
+        }
+        std::memset(imu_pkt_, 0, sizeof(imu_pkt_));
+        LivoxLidarEthernetPacket* ip = reinterpret_cast<LivoxLidarEthernetPacket*>(imu_pkt_);
+        ip->length = (uint16_t)(header_bytes() + sizeof(LivoxLidarImuRawPoint));
+        ip->dot_num = 1;
+        ip->data_type = kLivoxLidarImuData;
+        LivoxLidarImuRawPoint imu;
+        std::memset(&imu, 0, sizeof(imu));
+        imu.acc_z = 1.0f;                                    // at rest, z up
+        std::memcpy(ip->data, &imu, sizeof(imu));
+    }
+
+    uint64_t device_ns(size_t d, uint64_t host_ns, uint64_t rt_ns, uint64_t t_start) const {
+        if (cfg_.ptp) return rt_ns;
+        const uint64_t dt = host_ns - t_start;
+        return kBootNs + d * 1300000000ull + dt + dt / 50000;   // + 20 ppm
+    }
+
+    void announce() {
+        for (size_t d = 0; d < cfg_.devices; ++d) {
+            LivoxLidarInfo info;
+            std::memset(&info, 0, sizeof(info));
+            info.dev_type = 9;   // MID-360
+            std::snprintf(info.sn, sizeof(info.sn), "SYNTH%010u", (unsigned)(d + 1));
+            std::snprintf(info.lidar_ip, sizeof(info.lidar_ip), "192.168.1.%u", (unsigned)(100 + d));
+            sink_.info(device_handle(d), &info);
+        }
+    }
+
+    void run() {
+        announce();
+        const bool paced = cfg_.point_rate > 0;
+        const double rate = paced ? cfg_.point_rate : kNominalRate;
+        const uint64_t period = (uint64_t)(1e9 * cfg_.points_per_packet / rate);   // per device
+        const uint64_t imu_period = cfg_.imu_hz > 0 ? (uint64_t)(1e9 / cfg_.imu_hz) : 0;
+        const uint64_t t_start = source_now_ns(), rt_start = source_realtime_ns();
+        uint64_t next_imu = t_start, k = 0, points = 0;
+        const uint8_t time_type = cfg_.ptp ? 1 : 0;
+
+        while (!stop_.load(std::memory_order_relaxed) && (!cfg_.packets || k < cfg_.packets)) {
+            uint64_t host_ns, rt_ns;
+            if (paced) {
+                source_sleep_until_ns(t_start + k * period);
+                host_ns = source_now_ns();
+                rt_ns = source_realtime_ns();
+            }
+            else {
+                host_ns = t_start + k * period;
+                rt_ns = rt_start + k * period;
+            }
+            LivoxLidarEthernetPacket* p = reinterpret_cast<LivoxLidarEthernetPacket*>(tpl(k % n_templates_));
+            p->udp_cnt = (uint16_t)k;
+            p->time_type = time_type;
+            for (size_t d = 0; d < cfg_.devices; ++d) {
+                const uint64_t dev = device_ns(d, host_ns, rt_ns, t_start);
+                std::memcpy(p->timestamp, &dev, sizeof(dev));
+                p->frame_cnt = (uint8_t)((dev - (cfg_.ptp ? 0 : kBootNs)) / kFrameNs);
+                if (!paced && !sink_.wait_for_room(false)) return;
+                sink_.points(device_handle(d), p, source_now_ns(), host_ns, rt_ns);
+            }
+            points += cfg_.points_per_packet * cfg_.devices;
+            for (; imu_period && next_imu <= host_ns; next_imu += imu_period) {
+                LivoxLidarEthernetPacket* ip = reinterpret_cast<LivoxLidarEthernetPacket*>(imu_pkt_);
+                ip->time_type = time_type;
+                const uint64_t t_imu = next_imu, rt_imu = rt_ns - (host_ns - next_imu);
+                for (size_t d = 0; d < cfg_.devices; ++d) {
+                    const uint64_t dev = device_ns(d, t_imu, rt_imu, t_start);
+                    std::memcpy(ip->timestamp, &dev, sizeof(dev));
+                    if (!paced && !sink_.wait_for_room(true)) return;
+                    sink_.imu(device_handle(d), ip, source_now_ns(), t_imu, rt_imu);
+                }
+            }
+            ++k;
+        }
+
+        const double secs = (source_now_ns() - t_start) / 1e9;
+        std::cerr << "synthetic: " << cfg_.devices << " device(s), " << k * cfg_.devices << " packets, "
+                  << points << " points in " << secs << " s ("
+                  << (uint64_t)(secs > 0 ? points / secs : 0) << " points/s)" << std::endl;
+        if (!stop_.load()) sink_.finished();
+    }
+
+    SyntheticConfig cfg_;
+    std::atomic<bool> stop_;
+    BridgeSourceSink sink_;
+    std::thread thread_;
+    std::vector<uint8_t> templates_;
+    size_t stride_;
+    size_t n_templates_;
+    size_t pt_size_;
+    alignas(8) uint8_t imu_pkt_[64];
+};
@@ -0,0 +1,26 @@
+// Livox MID-360 Bridge - minimal test harness for the header-only modules (tests/test_*.cpp)
+//
+// Each test is one executable run by ctest: CHECK() reports a failed condition and keeps
+// going, main() returns test_exit(), non-zero when any check failed. No framework, no
+// allocation beyond what the code under test does.
+
+#pragma once
+
+#include <cstdio>
+
+static int g_test_failures = 0;
+static int g_test_checks = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        ++g_test_checks;                                                                \
+        if (!(cond)) {                                                                  \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++g_test_failures;                                                          \
+        }                                                                               \
+    } while (0)
+
+static inline int test_exit(const char* name) {
+    std::printf("%s: %d checks, %d failed\n", name, g_test_checks, g_test_failures);
+    return g_test_failures ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+// bridge_state.h: save -> load round trip, and state files the bridge must start cold from
+// (missing, other version, truncated, not JSON) or load only the usable entries of.
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bridge_state.h"
+#include "tests/bridge_test.h"
+
+static std::string g_dir;
+
+static std::string path(const char* name) { return g_dir + "/" + name; }
+
+static void write_file(const std::string& p, const std::string& body) {
+    FILE* f = std::fopen(p.c_str(), "wb");
+    if (!f) return;
+    std::fwrite(body.data(), 1, body.size(), f);
+    std::fclose(f);
+}
+
+static std::string read_file(const std::string& p) {
+    std::string s;
+    FILE* f = std::fopen(p.c_str(), "rb");
+    if (!f) return s;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+    std::fclose(f);
+    return s;
+}
+
+static void round_trip() {
+    BridgeState st;
+    CachedDevice* d = st.add(0x1234);
+    CHECK(d != NULL && st.add(0x1234) == d);
+    d->dev_type = 9;
+    std::strcpy(d->sn, "47MDL9A0020103");
+    std::strcpy(d->ip, "192.168.1.12");
+    d->applied = kCfgWorkMode | kCfgFov;
+    d->work_mode = 1;
+    const int32_t fov[4] = { 0, 360, -7, 52 };
+    std::memcpy(d->fov, fov, sizeof(fov));
+    CachedSubscriber& s = st.subscribers[st.n_subscribers++];
+    inet_pton(AF_INET, "127.0.0.1", &s.addr);
+    s.port = 19001;
+    s.streams = 3;
+    s.format = 1;
+    s.decimate = 2;
+    s.expires_rt_ns = 1760000000000000000ull;
+    st.bin_seq = 123456;
+
+    const std::string p = path("state.json");
+    CHECK(st.save(p.c_str(), true));
+    CHECK(access((p + ".tmp").c_str(), F_OK) != 0);
+
+    BridgeState in;
+    CHECK(in.load(p.c_str()));
+    CHECK(in.clean && in.bin_seq == 123456);
+    CHECK(in.n_devices == 1 && in.n_subscribers == 1);
+    const CachedDevice* e = in.find(0x1234);
+    CHECK(e && e == in.find_sn("47MDL9A0020103") && !in.find_sn(""));
+    if (e) {
+        CHECK(e->dev_type == 9 && std::strcmp(e->ip, "192.168.1.12") == 0);
+        CHECK(e->applied == (kCfgWorkMode | kCfgFov) && e->work_mode == 1);
+        CHECK(std::memcmp(e->fov, fov, sizeof(fov)) == 0);
+    }
+    const CachedSubscriber& t = in.subscribers[0];
+    CHECK(t.addr == s.addr && t.port == 19001 && t.streams == 3 && t.format == 1 && t.decimate == 2);
+    CHECK(t.expires_rt_ns == s.expires_rt_ns);
+
+    CHECK(st.save(p.c_str(), false));
+    CHECK(in.load(p.c_str()) && !in.clean);
+
+    // a save that cannot be written leaves nothing behind
+    const std::string nodir = path("missing/state.json");
+    CHECK(!st.save(nodir.c_str(), true));
+    CHECK(access((nodir + ".tmp").c_str(), F_OK) != 0);
+}
+
+static void cold_start() {
+    BridgeState st;
+    st.add(1);
+    st.bin_seq = 9;
+    st.clean = true;
+
+    CHECK(!st.load(path("absent.json").c_str()));
+    CHECK(st.n_devices == 0 && st.bin_seq == 0 && !st.clean);     // nothing of the previous state
+
+    const char* refused[] = {
+        "",
+        "not json",
+        "[]",
+        "{\"clean\":true,\"bin_seq\":5}",                         // no version
+        "{\"version\":2,\"clean\":true,\"bin_seq\":5}",
+        "{\"version\":\"1\",\"clean\":true,\"bin_seq\":5}",
+        "{\"version\":1,\"clean\":true,\"bin_seq\":5,\"devices\":[{\"handle\":1",   // cut short
+        "\x01\x02\xff",
+    };
+    const std::string p = path("bad.json");
+    for (size_t i = 0; i < sizeof(refused) / sizeof(refused[0]); ++i) {
+        write_file(p, refused[i]);
+        st.add(1);
+        CHECK(!st.load(p.c_str()));
+        CHECK(st.n_devices == 0 && st.n_subscribers == 0 && st.bin_seq == 0);
+    }
+
+    // a good file cut anywhere is refused, never half loaded
+    BridgeState full;
+    for (uint32_t h = 1; h <= 3; ++h) std::strcpy(full.add(h)->sn, "SN");
+    const std::string good = path("good.json");
+    CHECK(full.save(good.c_str(), true));
+    const std::string body = read_file(good);
+    size_t accepted = 0;
+    for (size_t cut = 0; cut + 2 < body.size(); ++cut) {    // body ends "}\n"
+        write_file(p, body.substr(0, cut));
+        if (st.load(p.c_str())) ++accepted;
+    }
+    CHECK(accepted == 0);
+
+    // larger than kMaxFileBytes: the read stops there, which is a truncated document
+    std::string big = "{\"version\":1,\"devices\":[";
+    while (big.size() < BridgeState::kMaxFileBytes) big += "{\"handle\":1},";
+    big += "{\"handle\":1}]}";
+    write_file(p, big);
+    CHECK(!st.load(p.c_str()));
+}
+
+static void bad_entries() {
+    const std::string p = path("entries.json");
+    std::string doc = "{\"version\":1,\"clean\":false,\"bin_seq\":7,\"devices\":["
+        "{\"handle\":0,\"sn\":\"zero\"},{\"handle\":-3},{\"handle\":4294967296},\"str\",3,"
+        "{\"handle\":5,\"sn\":\"AN_SN_LONGER_THAN_SIXTEEN_BYTES\",\"ip\":\"10.0.0.1\",\"fov\":[1,2]}";
+    for (int h = 100; h < 130; ++h) doc += ",{\"handle\":" + std::to_string(h) + "}";
+    doc += "],\"subscribers\":[{\"port\":1,\"streams\":1},{\"addr\":\"not.an.ip\",\"port\":1,\"streams\":1},"
+           "{\"addr\":\"10.0.0.2\",\"port\":0,\"streams\":1},{\"addr\":\"10.0.0.2\",\"port\":70000,\"streams\":1},"
+           "{\"addr\":\"10.0.0.2\",\"port\":5,\"streams\":0},[],"
+           "{\"addr\":\"10.0.0.3\",\"port\":6,\"streams\":1}]}";
+    write_file(p, doc);
+
+    BridgeState st;
+    CHECK(st.load(p.c_str()));
+    CHECK(!st.clean && st.bin_seq == 7);
+    CHECK(st.n_devices == BridgeState::kMaxDevices);        // the rest of the list is dropped
+    CHECK(!st.find(0) && st.find(5) && !st.find(129));
+    const CachedDevice* d = st.find(5);
+    if (d) {
+        CHECK(std::strlen(d->sn) == sizeof(d->sn) - 1);     // truncated, terminated
+        CHECK(d->fov[0] == 1 && d->fov[1] == 2 && d->fov[2] == 0);
+    }
+    CHECK(st.n_subscribers == 1);
+    in_addr a;
+    inet_pton(AF_INET, "10.0.0.3", &a);
+    CHECK(st.subscribers[0].addr == a.s_addr && st.subscribers[0].port == 6);
+}
+
+int main() {
+    char tmpl[] = "/tmp/bridge_state_test.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    g_dir = tmpl;
+    round_trip();
+    cold_start();
+    bad_entries();
+    const char* files[] = { "state.json", "bad.json", "good.json", "entries.json" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) std::remove(path(files[i]).c_str());
+    rmdir(g_dir.c_str());
+    return test_exit("bridge_state");
+}
@@ -0,0 +1,164 @@
+// bridge_transport.h: binary messages fragmented per transport (UDP at the packing size, shm
+// at the slot size), planar payloads sliced from one packing, and the UDP size settings.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bridge_transport.h"
+#include "point_columns.h"
+#include "tests/bridge_test.h"
+
+static const size_t kColumnPlanes[] = { 4, 4, 4, 4, 1, 1 };
+
+static std::vector<BridgePoint> make_points(size_t n) {
+    std::vector<BridgePoint> pts(n);
+    for (size_t i = 0; i < n; ++i) {
+        pts[i].x = (float)i;
+        pts[i].y = -(float)i;
+        pts[i].z = 0.5f * (float)i;
+        pts[i].t_offset_ns = (uint32_t)(1000 * i);
+        pts[i].reflectivity = (uint8_t)i;
+        pts[i].tag = (uint8_t)(i % 4);
+        pts[i].reserved = 0;
+    }
+    return pts;
+}
+
+// Checks one message's fragments as they arrive: in order, sized within `limit`, and each
+// payload the columns of exactly its own points.
+struct FragmentCheck {
+    const std::vector<BridgePoint>* pts;
+    size_t limit;
+    uint32_t next_point, frags;
+
+    FragmentCheck(const std::vector<BridgePoint>* p, size_t l) : pts(p), limit(l), next_point(0), frags(0) {}
+
+    void record(const uint8_t* p, size_t len) {
+        BridgeFrameHeader h;
+        CHECK(len >= sizeof(h) && len <= limit);
+        if (len < sizeof(h)) return;
+        std::memcpy(&h, p, sizeof(h));
+        CHECK(h.payload_len == len - sizeof(h) && h.point_count * kBridgeColumnsPointBytes == h.payload_len);
+        CHECK(h.frag_index == frags && h.point_format == kBridgePointXyzrtColumns);
+        if (h.payload_len != len - sizeof(h) || next_point + h.point_count > pts->size()) return;
+        std::vector<uint8_t> want(h.payload_len);
+        columns_pack(pts->data() + next_point, h.point_count, want.data());
+        CHECK(std::memcmp(p + sizeof(h), want.data(), want.size()) == 0);
+        next_point += h.point_count;
+        ++frags;
+    }
+};
+
+static int udp_receiver(uint16_t* port) {
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in a;
+    std::memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(a);
+    if (fd < 0 || bind(fd, (const sockaddr*)&a, sizeof(a)) != 0 || getsockname(fd, (sockaddr*)&a, &len) != 0) {
+        std::perror("udp receiver");
+        return -1;
+    }
+    *port = ntohs(a.sin_port);
+    return fd;
+}
+
+static void planar_fragments(int rx, uint16_t port, const std::string& shm_name) {
+    setenv("TTEST_UDP_PORT", std::to_string(port).c_str(), 1);
+    setenv("TTEST_UDP_FLUSH_US", "0", 1);
+    setenv("TTEST_UDP_MTU", "512", 1);
+    setenv("TTEST_SHM_NAME", shm_name.c_str(), 1);
+    setenv("TTEST_SHM_SLOTS", "16", 1);
+    setenv("TTEST_SHM_SLOT_BYTES", "4096", 1);
+    BridgeTransport out;
+    CHECK(out.open_from_env("TTEST", 0, kEncBinary) == 0);
+    CHECK(out.udp_mtu() == 512);
+    ShmRingReader ring;
+    CHECK(ring.open(shm_name, true));
+
+    const std::vector<BridgePoint> pts = make_points(700);
+    std::vector<uint8_t> packed(pts.size() * kBridgeColumnsPointBytes);
+    columns_pack(&pts[0], pts.size(), &packed[0]);
+    BridgeFrameHeader h;
+    bridge_init_header(&h, kBridgeMsgScan);
+    h.point_format = kBridgePointXyzrtColumns;
+    const uint32_t seq = out.binary_planar(h, &packed[0], (uint32_t)pts.size(), kColumnPlanes, 6,
+        BridgeTransport::kRouteDefault);
+
+    // UDP: 512 B datagrams, one fragment each with batching off
+    FragmentCheck udp(&pts, 512);
+    std::vector<uint8_t> buf(65536);
+    ssize_t n;
+    while ((n = recv(rx, &buf[0], buf.size(), MSG_DONTWAIT)) > 0) udp.record(&buf[0], (size_t)n);
+    CHECK(udp.next_point == pts.size() && udp.frags > 1);
+
+    // shm: the same message cut at the slot size
+    FragmentCheck shm(&pts, out.shm().capacity());
+    size_t len;
+    while (ring.is_open() && (len = ring.read(&buf[0], buf.size())) > 0) shm.record(&buf[0], len);
+    CHECK(shm.next_point == pts.size() && shm.frags > 1 && shm.frags < udp.frags);
+    CHECK(out.shm_oversize() == 0 && out.seq() == seq + 1);
+
+    // a message that fits goes out whole, straight from the caller's buffer
+    FragmentCheck whole(&pts, 512);
+    std::vector<BridgePoint> few(pts.begin(), pts.begin() + 20);
+    columns_pack(&few[0], few.size(), &packed[0]);
+    out.binary_planar(h, &packed[0], (uint32_t)few.size(), kColumnPlanes, 6, BridgeTransport::kRouteDefault);
+    while ((n = recv(rx, &buf[0], buf.size(), MSG_DONTWAIT)) > 0) whole.record(&buf[0], (size_t)n);
+    CHECK(whole.frags == 1 && whole.next_point == few.size());
+
+    out.close();
+    ring.close();
+    shm_unlink(("/" + shm_name).c_str());
+    unsetenv("TTEST_SHM_NAME");
+}
+
+static void udp_sizes() {
+    setenv("TTEST_UDP_PORT", "0", 1);
+    unsetenv("TTEST_UDP_FLUSH_US");
+    unsetenv("TTEST_UDP_MTU");
+    {
+        BridgeTransport out;
+        CHECK(out.open_from_env("TTEST", 0, kEncBinary) == 0);
+        CHECK(out.udp_mtu() <= BridgeTransport::kEthernetPayload);     // loopback route, still capped
+        CHECK(out.batcher().mtu() == out.udp_mtu());
+        out.close();
+    }
+    setenv("TTEST_UDP_LOOPBACK", "1", 1);
+    {
+        BridgeTransport out;
+        CHECK(out.open_from_env("TTEST", 0, kEncBinary) == 0);
+        CHECK(out.udp_mtu() == BridgeTransport::kMaxDatagram);
+        out.close();
+    }
+    const char* refused[] = { "0", "20", "65508" };
+    for (size_t i = 0; i < sizeof(refused) / sizeof(refused[0]); ++i) {
+        setenv("TTEST_UDP_MTU", refused[i], 1);
+        BridgeTransport out;
+        CHECK(out.open_from_env("TTEST", 0, kEncBinary) == 2);
+        out.close();
+    }
+    unsetenv("TTEST_UDP_MTU");
+    unsetenv("TTEST_UDP_LOOPBACK");
+}
+
+int main() {
+    uint16_t port = 0;
+    const int rx = udp_receiver(&port);
+    CHECK(rx >= 0);
+    if (rx >= 0) {
+        planar_fragments(rx, port, "bridge_transport_test." + std::to_string(getpid()));
+        ::close(rx);
+    }
+    udp_sizes();
+    return test_exit("bridge_transport");
+}
@@ -0,0 +1,93 @@
+// command_dispatch.h: command parsing, parameter lookup and table dispatch, including
+// datagrams that are not commands at all.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "command_dispatch.h"
+#include "tests/bridge_test.h"
+
+struct Handler {
+    const char* name;
+    int code;
+};
+
+static const Handler kTable[] = { { "set_fov", 1 }, { "set_mode", 2 }, { "stats", 3 } };
+
+// The datagram lives in its own exact-size buffer, as a received one does.
+struct Datagram {
+    std::vector<char> buf;
+    BridgeCommand cmd;
+
+    bool parse(const std::string& s) {
+        buf.assign(s.begin(), s.end());
+        return cmd.parse(buf.empty() ? NULL : &buf[0], buf.size());
+    }
+};
+
+static void commands() {
+    Datagram d;
+    CHECK(d.parse("{\"cmd\":\"set_fov\",\"id\":42,\"yaw_start\":-10,\"pitch\":1.5,\"on\":true,\"off\":false,"
+                  "\"name\":\"a\\\"b\",\"lst\":[1]}"));
+    CHECK(d.cmd.has_name() && d.cmd.name.equals("set_fov"));
+    CHECK(d.cmd.id == 42);
+    CHECK(d.cmd.n_fields == 6);
+    CHECK(d.cmd.int_field("yaw_start", 0) == -10);
+    CHECK(d.cmd.number_field("pitch", 0) == 1.5);
+    CHECK(d.cmd.int_field("on", 7) == 1);
+    CHECK(d.cmd.int_field("off", 7) == 0);
+    CHECK(d.cmd.int_field("missing", 7) == 7);
+    CHECK(d.cmd.int_field("name", 7) == 7);            // a string is not a number
+    CHECK(d.cmd.int_field("lst", 7) == 7);
+    CHECK(d.cmd.field("cmd") == NULL && d.cmd.field("id") == NULL);
+    JsonValue s;
+    CHECK(d.cmd.string_field("name", &s) && s.size() == 4);
+    CHECK(!d.cmd.string_field("pitch", &s));
+    CHECK(!d.cmd.string_field("yaw", &s));             // whole keys only, never a prefix
+
+    const Handler* h = command_find(kTable, d.cmd.name);
+    CHECK(h && h->code == 1);
+
+    // "id" is a non-zero uint32 or nothing
+    const char* bad_ids[] = { "{\"cmd\":\"stats\",\"id\":0}", "{\"cmd\":\"stats\",\"id\":-1}",
+        "{\"cmd\":\"stats\",\"id\":4294967296}", "{\"cmd\":\"stats\",\"id\":\"7\"}",
+        "{\"cmd\":\"stats\",\"id\":null}" };
+    for (size_t i = 0; i < sizeof(bad_ids) / sizeof(bad_ids[0]); ++i) {
+        CHECK(d.parse(bad_ids[i]));
+        CHECK(d.cmd.id == 0);
+    }
+    CHECK(d.parse("{\"cmd\":\"stats\",\"id\":4294967295}") && d.cmd.id == 4294967295u);
+}
+
+static void not_commands() {
+    Datagram d;
+    // not a JSON object: refused, and nothing from an earlier command survives
+    CHECK(d.parse("{\"cmd\":\"stats\",\"id\":5,\"x\":1}"));
+    const char* bad[] = { "", "[]", "\"set_fov\"", "42", "{\"cmd\":\"stats\"", "{\"cmd\":}", "{cmd:1}",
+        "{\"cmd\":\"stats\",}", "\x01\x02\xff" };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        CHECK(!d.parse(bad[i]));
+        CHECK(!d.cmd.has_name() && d.cmd.id == 0 && d.cmd.n_fields == 0);
+    }
+
+    // an object without a usable name parses but dispatches nowhere
+    CHECK(d.parse("{\"cmd\":3}") && !d.cmd.has_name());
+    CHECK(command_find(kTable, d.cmd.name) == NULL);
+    CHECK(d.parse("{}") && !d.cmd.has_name());
+    CHECK(d.parse("{\"cmd\":\"set\"}") && command_find(kTable, d.cmd.name) == NULL);
+    CHECK(d.parse("{\"cmd\":\"set_fovx\"}") && command_find(kTable, d.cmd.name) == NULL);
+
+    // members past kMaxFields are dropped, not written past the arrays
+    std::string many = "{\"cmd\":\"stats\"";
+    for (int i = 0; i < 40; ++i) many += ",\"k" + std::to_string(i) + "\":" + std::to_string(i);
+    many += "}";
+    CHECK(d.parse(many) && d.cmd.n_fields == BridgeCommand::kMaxFields);
+    CHECK(d.cmd.int_field("k15", -1) == 15 && d.cmd.int_field("k16", -1) == -1);
+}
+
+int main() {
+    commands();
+    not_commands();
+    return test_exit("command_dispatch");
+}
@@ -0,0 +1,237 @@
+// gnss_time.h: NMEA RMC and UBX NAV time through the real serial path (a FIFO stands in for
+// the port, no PPS), checking what is forwarded to the lidar and what is counted as bad
+// (checksum / framing) or invalid (no fix, impossible fields).
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gnss_time.h"
+#include "tests/bridge_test.h"
+
+struct Sent {
+    GnssTimeSync* gnss;
+    std::mutex mu;
+    std::vector<std::string> rmc;
+};
+
+// Issues at once, as the bridge's emitter does after its queue hop: one device, no refusal
+static bool on_send(const char* rmc, uint16_t len, void* ctx) {
+    Sent* s = static_cast<Sent*>(ctx);
+    std::lock_guard<std::mutex> lock(s->mu);
+    s->rmc.push_back(std::string(rmc, len));
+    s->gnss->on_issued(1, 0);
+    return true;
+}
+
+static std::string nmea(const std::string& body) {
+    uint8_t cs = 0;
+    for (size_t i = 0; i < body.size(); ++i) cs ^= (uint8_t)body[i];
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X\r\n", cs);
+    return "$" + body + tail;
+}
+
+static std::string ubx(uint8_t cls, uint8_t id, const std::vector<uint8_t>& payload) {
+    std::string f;
+    f += (char)0xB5;
+    f += (char)0x62;
+    f += (char)cls;
+    f += (char)id;
+    f += (char)(payload.size() & 0xFF);
+    f += (char)(payload.size() >> 8);
+    f.append(payload.begin(), payload.end());
+    uint8_t a = 0, b = 0;
+    for (size_t i = 2; i < f.size(); ++i) { a = (uint8_t)(a + (uint8_t)f[i]); b = (uint8_t)(b + a); }
+    f += (char)a;
+    f += (char)b;
+    return f;
+}
+
+static std::vector<uint8_t> nav_timeutc(int year, int mon, int day, int h, int m, int s, int32_t nano, uint8_t valid) {
+    std::vector<uint8_t> p(20, 0);
+    std::memcpy(&p[8], &nano, 4);
+    p[12] = (uint8_t)year;
+    p[13] = (uint8_t)(year >> 8);
+    p[14] = (uint8_t)mon; p[15] = (uint8_t)day; p[16] = (uint8_t)h; p[17] = (uint8_t)m; p[18] = (uint8_t)s;
+    p[19] = valid;
+    return p;
+}
+
+static std::vector<uint8_t> nav_pvt(int year, int mon, int day, int h, int m, int s, uint8_t valid) {
+    std::vector<uint8_t> p(92, 0);
+    p[4] = (uint8_t)year;
+    p[5] = (uint8_t)(year >> 8);
+    p[6] = (uint8_t)mon; p[7] = (uint8_t)day; p[8] = (uint8_t)h; p[9] = (uint8_t)m; p[10] = (uint8_t)s;
+    p[11] = valid;
+    return p;
+}
+
+static int64_t utc(int year, int mon, int day, int h, int m, int s) {
+    tm u;
+    std::memset(&u, 0, sizeof(u));
+    u.tm_year = year - 1900; u.tm_mon = mon - 1; u.tm_mday = day; u.tm_hour = h; u.tm_min = m; u.tm_sec = s;
+    return (int64_t)timegm(&u);
+}
+
+class Port {
+public:
+    Port(GnssTimeSync* gnss, int fd) : gnss_(gnss), fd_(fd) {}
+
+    // Write bytes and wait until the GNSS thread has counted `events` messages in total
+    // (rmc + ubx + bad: every framed message adds exactly one, other sentences none).
+    bool feed(const std::string& bytes, uint64_t events) {
+        if (::write(fd_, bytes.data(), bytes.size()) != (ssize_t)bytes.size()) return false;
+        for (int i = 0; i < 300; ++i) {
+            if (gnss_->rmc() + gnss_->ubx() + gnss_->bad() >= events) return true;
+            usleep(10000);
+        }
+        return false;
+    }
+
+    // Bytes that are expected to count nothing
+    bool write_only(const std::string& bytes) {
+        return ::write(fd_, bytes.data(), bytes.size()) == (ssize_t)bytes.size();
+    }
+
+private:
+    GnssTimeSync* gnss_;
+    int fd_;
+};
+
+static bool checksum_ok(const std::string& s) {
+    const size_t star = s.find('*');
+    if (s.empty() || s[0] != '$' || star == std::string::npos || star + 5 != s.size()) return false;
+    uint8_t cs = 0;
+    for (size_t i = 1; i < star; ++i) cs ^= (uint8_t)s[i];
+    char hex[3];
+    std::snprintf(hex, sizeof(hex), "%02X", cs);
+    return s.compare(star + 1, 2, hex) == 0 && s.compare(star + 3, 2, "\r\n") == 0;
+}
+
+static void format() {
+    char out[160];
+    const size_t n = GnssTimeSync::format_rmc(utc(2024, 6, 15, 12, 0, 1), ",,,,,", ",,A", out, sizeof(out));
+    CHECK(n > 0 && std::string(out, n) == nmea("GPRMC,120001.00,A,,,,,,,150624,,,A"));
+    CHECK(GnssTimeSync::format_rmc(0, ",,,,,", ",,A", out, 20) == 0);    // does not fit: nothing
+}
+
+static void serial(const std::string& fifo) {
+    GnssTimeSync gnss;
+    Sent sent;
+    sent.gnss = &gnss;
+    GnssConfig cfg;
+    cfg.device = fifo;
+    CHECK(gnss.start(cfg, on_send, &sent));
+    CHECK(!gnss.pps());
+    const int fd = ::open(fifo.c_str(), O_WRONLY | O_CLOEXEC);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    Port port(&gnss, fd);
+    uint64_t events = 0;
+
+    // a valid RMC from any talker is forwarded as $GPRMC with its position and tail fields
+    const std::string pos = "4807.038,N,01131.000,E,022.4,084.4";
+    CHECK(port.feed(nmea("GNRMC,120000.00,A," + pos + ",150624,003.1,W,A"), ++events));
+    CHECK(gnss.rmc() == 1 && gnss.bad() == 0 && gnss.invalid() == 0);
+    CHECK(gnss.last_utc() == utc(2024, 6, 15, 12, 0, 0));
+
+    // checksum and framing failures: counted bad, nothing parsed
+    std::string wrong = nmea("GNRMC,120001.00,A," + pos + ",150624,003.1,W,A");
+    wrong[wrong.size() - 3] = wrong[wrong.size() - 3] == '0' ? '1' : '0';
+    CHECK(port.feed(wrong, ++events));
+    CHECK(port.feed("$GNRMC,120001.00,A," + pos + ",150624,003.1,W,A\r\n", ++events));    // no checksum
+    CHECK(port.feed("$GNRMC,120001.00,A,,,,,,,150624,,*4\r\n", ++events));                  // one hex digit
+    CHECK(port.feed("$GNRMC,120001.00,A,,,,,,,150624,,*ZZ\r\n", ++events));
+    CHECK(port.feed("$" + std::string(300, 'A') + "\r\n", ++events));                       // over kLineMax
+    CHECK(gnss.bad() == 5 && gnss.rmc() == 1);
+
+    // well framed but no usable time: counted invalid, not forwarded
+    const char* invalid[] = {
+        "GNRMC,120002.00,V," "4807.038,N,01131.000,E,022.4,084.4" ",150624,003.1,W,N",   // no fix
+        "GNRMC,120002.00,A,,,,,,,1506,,",                                                 // short date
+        "GNRMC,120002.00,A,,,,,,,151324,,",                                               // month 13
+        "GNRMC,120002.00,A,,,,,,,000624,,",                                               // day 0
+        "GNRMC,12000,A,,,,,,,150624,,",                                                   // short time
+        "GNRMC,1200xx.00,A,,,,,,,150624,,",
+        "GNRMC,120002.00,A,,,",                                                           // too few fields
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) CHECK(port.feed(nmea(invalid[i]), ++events));
+    CHECK(gnss.invalid() == sizeof(invalid) / sizeof(invalid[0]));
+
+    // other sentences are checked and skipped; a partial line is dropped at the next '$'
+    CHECK(port.write_only(nmea("GPGGA,120002.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,")));
+    CHECK(port.write_only("$GNRMC,120002.00,A,"));
+    const uint64_t rmc_before = gnss.rmc();
+    CHECK(port.feed(nmea("GNRMC,120003.00,A,,,,,,,150624,,"), ++events));
+    CHECK(gnss.rmc() == rmc_before + 1 && gnss.bad() == 5);
+    CHECK(gnss.last_utc() == utc(2024, 6, 15, 12, 0, 3));
+
+    // the same second again (5/10 Hz receivers) is not sent twice; lowercase hex is accepted
+    std::string again = nmea("GNRMC,120003.50,A,,,,,,,150624,,");
+    for (size_t i = again.find('*'); i < again.size(); ++i) again[i] = (char)std::tolower(again[i]);
+    CHECK(port.feed(again, ++events));
+    CHECK(gnss.bad() == 5);
+
+    // UBX NAV-TIMEUTC / NAV-PVT between NMEA lines, nano rounded to the nearest second
+    CHECK(port.feed(ubx(0x01, 0x21, nav_timeutc(2024, 6, 15, 12, 0, 4, 600000000, 0x07)), ++events));
+    CHECK(gnss.ubx() == 1 && gnss.last_utc() == utc(2024, 6, 15, 12, 0, 5));
+    CHECK(port.feed(ubx(0x01, 0x07, nav_pvt(2024, 6, 15, 12, 0, 6, 0x03)), ++events));
+    CHECK(gnss.ubx() == 2 && gnss.last_utc() == utc(2024, 6, 15, 12, 0, 6));
+
+    const uint64_t invalid_before = gnss.invalid();
+    CHECK(port.feed(ubx(0x01, 0x21, nav_timeutc(2024, 6, 15, 12, 0, 7, 0, 0x03)), ++events));   // !validUTC
+    CHECK(port.feed(ubx(0x01, 0x07, nav_pvt(2024, 6, 15, 12, 0, 7, 0x01)), ++events));          // date only
+    CHECK(port.feed(ubx(0x01, 0x21, nav_timeutc(2024, 0, 15, 12, 0, 7, 0, 0x07)), ++events));   // month 0
+    CHECK(gnss.invalid() == invalid_before + 3);
+
+    std::string corrupt = ubx(0x01, 0x21, nav_timeutc(2024, 6, 15, 12, 0, 8, 0, 0x07));
+    corrupt[10] ^= 0x01;
+    CHECK(port.feed(corrupt, ++events));                                                       // Fletcher fails
+    CHECK(port.feed(std::string("\xB5\x62\x01\x21\xFF\x00", 6), ++events));                   // length > kLineMax
+    CHECK(gnss.bad() == 7 && gnss.ubx() == 5);
+    // non-NAV classes are framed and skipped; the stream carries on after all of the above
+    CHECK(port.write_only(ubx(0x05, 0x01, std::vector<uint8_t>(2, 0))));
+    CHECK(port.feed(nmea("GNRMC,120009.00,A,,,,,,,150624,,"), ++events));
+    CHECK(gnss.last_utc() == utc(2024, 6, 15, 12, 0, 9) && gnss.bad() == 7);
+
+    gnss.stop();
+    ::close(fd);
+
+    // forwarded: 12:00:00 (with position), :03, :05, :06, :09, each a valid $GPRMC
+    std::lock_guard<std::mutex> lock(sent.mu);
+    CHECK(sent.rmc.size() == 5);
+    CHECK(gnss.sent() == sent.rmc.size());
+    for (size_t i = 0; i < sent.rmc.size(); ++i) CHECK(checksum_ok(sent.rmc[i]));
+    if (sent.rmc.size() == 5) {
+        CHECK(sent.rmc[0] == nmea("GPRMC,120000.00,A," + pos + ",150624,003.1,W,A"));
+        CHECK(sent.rmc[2] == nmea("GPRMC,120005.00,A,,,,,,,150624,,,A"));       // UBX: no position
+        CHECK(sent.rmc[4].compare(0, 16, "$GPRMC,120009.00") == 0);
+    }
+}
+
+int main() {
+    char tmpl[] = "/tmp/gnss_time_test.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const std::string fifo = std::string(tmpl) + "/serial";
+    if (mkfifo(fifo.c_str(), 0600) != 0) {
+        std::perror("mkfifo");
+        return 1;
+    }
+    format();
+    serial(fifo);
+    std::remove(fifo.c_str());
+    rmdir(tmpl);
+    return test_exit("gnss_time");
+}
@@ -0,0 +1,92 @@
+// json_lite.h: well-formed documents, and malformed input rejected without reading past the
+// end of the range (every case is parsed from an exact-size heap copy, no terminator).
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "json_lite.h"
+#include "tests/bridge_test.h"
+
+static bool parse(const std::string& s, JsonValue* out) {
+    std::vector<char> buf(s.begin(), s.end());
+    const char* b = buf.empty() ? NULL : &buf[0];
+    const bool ok = json_parse(b, b + buf.size(), out);
+    out->begin = out->end = NULL;     // spans die with buf
+    return ok;
+}
+
+static bool parses(const std::string& s) {
+    JsonValue v;
+    return parse(s, &v);
+}
+
+static void well_formed() {
+    const std::string doc = "{\"a\": 1.5, \"s\":\"x\\\"y\", \"arr\":[1, -2e3, true, false, null, {}], \"o\":{\"k\":[]}}";
+    JsonValue root, v;
+    CHECK(json_parse(doc.data(), doc.data() + doc.size(), &root));
+    CHECK(root.type == kJsonObject);
+    CHECK(root.end == doc.data() + doc.size());
+    CHECK(json_find_number(root, "a", 0) == 1.5);
+    CHECK(json_find_number(root, "missing", 7) == 7);
+    CHECK(json_find_number(root, "s", 7) == 7);        // not a number: default
+    CHECK(json_find(root, "s", &v) && v.type == kJsonString);
+    char s[8];
+    CHECK(json_string(v, s, sizeof(s)) == 3 && std::strcmp(s, "x\"y") == 0);
+    CHECK(json_string(v, s, 2) == 1 && std::strcmp(s, "x") == 0);    // truncated, terminated
+    CHECK(json_find(root, "arr", &v) && v.type == kJsonArray);
+    JsonIter it(v);
+    JsonValue x;
+    const JsonType want[] = { kJsonNumber, kJsonNumber, kJsonTrue, kJsonFalse, kJsonNull, kJsonObject };
+    size_t n = 0;
+    while (it.next(&x)) {
+        CHECK(n < 6 && x.type == want[n]);
+        if (n == 1) CHECK(json_number(x, 0) == -2000);
+        ++n;
+    }
+    CHECK(n == 6);
+    CHECK(!json_find(v, "a", &x));                      // arrays have no keys
+    CHECK(json_find(root, "o", &v) && json_find(v, "k", &x) && x.type == kJsonArray);
+
+    // a key is compared whole, never as a prefix or inside a value
+    const std::string keys = "{\"ab\":1,\"x\":\"a\",\"a\":2}";
+    CHECK(json_parse(keys.data(), keys.data() + keys.size(), &root));
+    CHECK(json_find_number(root, "a", 0) == 2);
+}
+
+static void malformed() {
+    const char* bad[] = {
+        "", " ", "{", "}", "[", "{\"a\"", "{\"a\":", "{\"a\":1", "{\"a\" 1}", "{\"a\":1,}", "{1:2}",
+        "{\"a\":1 \"b\":2}", "[1,2", "[1 2]", "[,]", "\"abc", "\"abc\\", "\"\\\"", "tru", "nul", "fals",
+        "{\"a\":tru}", "{\"a\":[}", "@", "{\"a\":\"b\\\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        if (parses(bad[i])) std::fprintf(stderr, "accepted: %s\n", bad[i]);
+        CHECK(!parses(bad[i]));
+    }
+
+    // nesting is bounded: 32 levels parse, a deeper document is refused (no unbounded recursion)
+    CHECK(parses(std::string(32, '[') + std::string(32, ']')));
+    CHECK(!parses(std::string(40, '[') + std::string(40, ']')));
+    CHECK(!parses(std::string(100000, '[')));
+
+    // a lone sign scans as a number token but does not convert
+    JsonValue v;
+    CHECK(parse("-", &v) && v.type == kJsonNumber);
+    const std::string minus = "-";
+    CHECK(json_parse(minus.data(), minus.data() + 1, &v) && json_number(v, 3.0) == 3.0);
+
+    // an iterator over a container it cannot walk stops instead of running on
+    JsonValue num;
+    const std::string one = "1";
+    CHECK(json_parse(one.data(), one.data() + 1, &num));
+    JsonIter it(num);
+    JsonValue k, x;
+    CHECK(!it.next(&k, &x));
+}
+
+int main() {
+    well_formed();
+    malformed();
+    return test_exit("json_lite");
+}
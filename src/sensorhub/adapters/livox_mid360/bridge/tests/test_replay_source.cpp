@@ -0,0 +1,90 @@
+// replay_source.h: a recording with records too short for the packets they claim to hold
+// (truncated or corrupt .lvxr) replays the intact records and skips the rest.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "replay_source.h"
+#include "tests/bridge_test.h"
+
+static const size_t kHdr = offsetof(LivoxLidarEthernetPacket, data);
+
+static std::atomic<int> g_points(0), g_imu(0), g_info(0);
+static std::atomic<bool> g_finished(false);
+
+static void on_points(uint32_t, const LivoxLidarEthernetPacket* pkt, uint64_t, uint64_t, uint64_t) {
+    CHECK(pkt->dot_num == 4);
+    ++g_points;
+}
+static void on_imu(uint32_t, const LivoxLidarEthernetPacket*, uint64_t, uint64_t, uint64_t) { ++g_imu; }
+static void on_info(uint32_t, const LivoxLidarInfo*) { ++g_info; }
+static bool on_wait(bool) { return true; }
+static void on_finished() { g_finished.store(true); }
+
+// A packet of n points in format `type`, recorded with `len` payload bytes
+static void append_points(RecordWriter* w, uint64_t t, uint8_t type, uint16_t n, size_t len) {
+    std::vector<uint8_t> buf(kHdr + 64 * 14, 0);
+    LivoxLidarEthernetPacket* pkt = reinterpret_cast<LivoxLidarEthernetPacket*>(&buf[0]);
+    pkt->data_type = type;
+    pkt->dot_num = n;
+    pkt->length = (uint16_t)(kHdr + n * bridge_point_size(type));
+    CHECK(w->append(kRecPoints, 1, t, t, &buf[0], len));
+}
+
+int main() {
+    char tmpl[] = "/tmp/replay_source_test.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::string path;
+    {
+        RecordWriter w;
+        CHECK(w.open(tmpl, 1 << 16));
+        path = w.path();
+        const size_t high = bridge_point_size(kBridgePointCartesianHigh);
+        uint64_t t = 1000;
+        append_points(&w, t++, kBridgePointCartesianHigh, 4, kHdr + 4 * high);        // intact
+        append_points(&w, t++, kBridgePointCartesianHigh, 4, kHdr + 4 * high - 1);    // one byte short
+        append_points(&w, t++, kBridgePointCartesianHigh, 60, kHdr + 4 * high);       // dot_num lies
+        append_points(&w, t++, kBridgePointCartesianHigh, 4, kHdr - 1);               // header cut
+        std::vector<uint8_t> imu(kHdr + sizeof(LivoxLidarImuRawPoint), 0);
+        CHECK(w.append(kRecImu, 1, t, t, &imu[0], imu.size()));                        // intact
+        ++t;
+        CHECK(w.append(kRecImu, 1, t, t, &imu[0], imu.size() - 1));                    // short
+        ++t;
+        LivoxLidarInfo info;
+        std::memset(&info, 0, sizeof(info));
+        CHECK(w.append(kRecInfo, 1, t, t, &info, sizeof(info)));
+        ++t;
+        CHECK(w.append(kRecInfo, 1, t, t, &info, sizeof(info) - 1));                   // short: ignored
+        w.close();
+    }
+
+    ReplaySource replay;
+    CHECK(replay.open(path.c_str(), 0.0, false));
+    BridgeSourceSink sink;
+    sink.points = on_points;
+    sink.imu = on_imu;
+    sink.info = on_info;
+    sink.wait_for_room = on_wait;
+    sink.finished = on_finished;
+    CHECK(replay.start(sink));
+    for (int i = 0; i < 500 && !g_finished.load(); ++i) usleep(10000);
+    replay.stop();
+
+    CHECK(g_finished.load());
+    CHECK(g_points.load() == 1 && g_imu.load() == 1 && g_info.load() == 1);
+    CHECK(replay.skipped() == 4);
+
+    std::remove(path.c_str());
+    rmdir(tmpl);
+    return test_exit("replay_source");
+}
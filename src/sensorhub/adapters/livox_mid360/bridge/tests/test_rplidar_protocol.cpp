@@ -0,0 +1,184 @@
+// rplidar_protocol.h: request framing, and the decoder on answers split anywhere, line noise,
+// records that fail their check bits / checksum and descriptors it cannot hold.
+
+#include <cstring>
+#include <vector>
+
+#include "rplidar_protocol.h"
+#include "tests/bridge_test.h"
+
+struct Sink {
+    std::vector<RplidarNode> nodes;
+    int infos, healths;
+    RplidarInfo info;
+    RplidarHealth health;
+
+    Sink() : infos(0), healths(0) {}
+    void on_info(const RplidarInfo& i) { info = i; ++infos; }
+    void on_health(const RplidarHealth& h) { health = h; ++healths; }
+    void on_node(const RplidarNode& n) { nodes.push_back(n); }
+};
+
+typedef std::vector<uint8_t> Bytes;
+
+static void descriptor(Bytes* b, uint32_t size, bool stream, uint8_t type) {
+    const uint32_t v = size | (stream ? 1u << 30 : 0u);
+    const uint8_t d[7] = { kRpSync1, kRpSync2, (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24), type };
+    b->insert(b->end(), d, d + 7);
+}
+
+// Standard node: quality, start flag, angle in 1/64 deg, distance in 1/4 mm
+static void node(Bytes* b, uint8_t quality, bool start, uint16_t angle_q6, uint16_t dist_q2) {
+    const uint16_t a = (uint16_t)(angle_q6 << 1 | 1);
+    const uint8_t n[5] = { (uint8_t)(quality << 2 | (start ? 1 : 2)), (uint8_t)a, (uint8_t)(a >> 8), (uint8_t)dist_q2,
+        (uint8_t)(dist_q2 >> 8) };
+    b->insert(b->end(), n, n + 5);
+}
+
+static void capsule(Bytes* b, uint16_t start_q6, bool restart, uint16_t dist_mm) {
+    uint8_t c[kRpDenseCapsuleBytes];
+    const uint16_t a = (uint16_t)(start_q6 | (restart ? 0x8000u : 0u));
+    c[2] = (uint8_t)a;
+    c[3] = (uint8_t)(a >> 8);
+    for (size_t k = 0; k < kRpDenseCabins; ++k) {
+        c[4 + 2 * k] = (uint8_t)dist_mm;
+        c[5 + 2 * k] = (uint8_t)(dist_mm >> 8);
+    }
+    uint8_t sum = 0;
+    for (size_t i = 2; i < sizeof(c); ++i) sum ^= c[i];
+    c[0] = (uint8_t)(0xA0 | (sum & 0xF));
+    c[1] = (uint8_t)(0x50 | (sum >> 4));
+    b->insert(b->end(), c, c + sizeof(c));
+}
+
+static void requests() {
+    uint8_t out[16];
+    CHECK(rplidar_request(out, kRpCmdGetHealth) == 2 && out[0] == 0xA5 && out[1] == 0x52);
+    const uint8_t payload[2] = { 0x12, 0x34 };
+    CHECK(rplidar_request(out, 0x84, payload, 2) == 6);
+    CHECK(out[2] == 2 && out[3] == 0x12 && out[4] == 0x34 && out[5] == (0xA5 ^ 0x84 ^ 2 ^ 0x12 ^ 0x34));
+    CHECK(rplidar_express_request(out, 1) == 9);
+    uint8_t x = 0;
+    for (int i = 0; i < 8; ++i) x ^= out[i];
+    CHECK(out[1] == kRpCmdExpressScan && out[3] == 1 && out[8] == x);
+}
+
+static void answers_split_anywhere() {
+    Bytes b;
+    b.push_back(0x00);                      // noise before the descriptor
+    b.push_back(kRpSync1);
+    descriptor(&b, 3, false, kRpAnsHealth);
+    b.push_back(kRpHealthWarning);
+    b.push_back(0x34);
+    b.push_back(0x12);
+    descriptor(&b, 20, false, kRpAnsInfo);
+    for (uint8_t i = 0; i < 20; ++i) b.push_back(i + 1);
+
+    // every chunk size from one byte at a time to all at once gives the same answers
+    for (size_t chunk = 1; chunk <= b.size(); ++chunk) {
+        RplidarDecoder dec;
+        Sink sink;
+        for (size_t i = 0; i < b.size(); i += chunk) dec.feed(&b[i], chunk < b.size() - i ? chunk : b.size() - i, sink);
+        CHECK(sink.healths == 1 && sink.health.status == kRpHealthWarning && sink.health.error_code == 0x1234);
+        CHECK(sink.infos == 1 && sink.info.model == 1 && sink.info.serial[15] == 20);
+        CHECK(dec.resync_bytes() == 2);
+    }
+}
+
+static void node_stream() {
+    Bytes b;
+    descriptor(&b, kRpNodeBytes, true, kRpAnsNode);
+    node(&b, 15, true, 90 * 64, 4000);
+    node(&b, 15, false, 180 * 64, 0);
+    Bytes bad;
+    node(&bad, 15, false, 200 * 64, 8);
+    bad[0] = (uint8_t)(bad[0] | 3);          // start == !start: not a node
+    b.insert(b.end(), bad.begin(), bad.end());
+    node(&b, 15, false, 270 * 64, 400);
+
+    RplidarDecoder dec;
+    Sink sink;
+    dec.feed(&b[0], b.size(), sink);
+    CHECK(dec.answer_type() == kRpAnsNode);
+    CHECK(dec.bad_records() >= 1 && dec.resync_bytes() >= 1);
+    // the corrupt record costs itself (and whatever the resync misreads), never the stream
+    CHECK(sink.nodes.size() >= 3);
+    if (sink.nodes.size() >= 3) {
+        CHECK(sink.nodes[0].start && sink.nodes[0].angle_deg == 90.0f && sink.nodes[0].range_mm == 1000.0f);
+        CHECK(sink.nodes[0].quality == 15 && !sink.nodes[1].start && sink.nodes[1].range_mm == 0.0f);
+        const RplidarNode& last = sink.nodes.back();
+        CHECK(last.angle_deg == 270.0f && last.range_mm == 100.0f);
+    }
+    CHECK(dec.nodes() == sink.nodes.size());
+
+    // reset drops the stream: the next bytes must be a descriptor again
+    dec.reset();
+    CHECK(dec.answer_type() == 0);
+    Bytes more;
+    node(&more, 15, true, 10 * 64, 40);
+    const size_t before = sink.nodes.size();
+    dec.feed(&more[0], more.size(), sink);
+    CHECK(sink.nodes.size() == before);
+}
+
+static void dense_capsules() {
+    Bytes b;
+    descriptor(&b, kRpDenseCapsuleBytes, true, kRpAnsDenseCapsule);
+    capsule(&b, 0, true, 1000);
+    capsule(&b, 8 * 64, false, 2000);
+    capsule(&b, 16 * 64, false, 3000);
+
+    RplidarDecoder dec;
+    Sink sink;
+    dec.feed(&b[0], b.size(), sink);
+    CHECK(sink.nodes.size() == 2 * kRpDenseCabins);   // each capsule decodes when the next arrives
+    if (sink.nodes.size() == 2 * kRpDenseCabins) {
+        CHECK(sink.nodes[0].angle_deg == 0.0f && sink.nodes[0].range_mm == 1000.0f);
+        CHECK(sink.nodes[0].quality == kRpDenseQuality);
+        CHECK(sink.nodes[kRpDenseCabins].angle_deg == 8.0f && sink.nodes[kRpDenseCabins].range_mm == 2000.0f);
+    }
+
+    // a checksum failure drops that capsule and the span to it, keeping the record boundary
+    Bytes c;
+    capsule(&c, 24 * 64, false, 4000);
+    c[40] ^= 0x55;
+    capsule(&c, 32 * 64, false, 5000);
+    capsule(&c, 40 * 64, false, 6000);
+    const size_t before = sink.nodes.size();
+    dec.feed(&c[0], c.size(), sink);
+    CHECK(dec.bad_records() == 1);
+    CHECK(sink.nodes.size() == before + kRpDenseCabins);
+    if (sink.nodes.size() == before + kRpDenseCabins) CHECK(sink.nodes[before].range_mm == 5000.0f);
+
+    // broken sync nibbles: the decoder slides byte by byte to the next capsule
+    Bytes d;
+    capsule(&d, 48 * 64, false, 7000);
+    d[1] = 0x00;
+    capsule(&d, 56 * 64, false, 8000);
+    dec.feed(&d[0], d.size(), sink);
+    CHECK(dec.bad_records() > 1 && dec.resync_bytes() >= kRpDenseCapsuleBytes);
+}
+
+static void unusable_descriptors() {
+    RplidarDecoder dec;
+    Sink sink;
+    Bytes b;
+    descriptor(&b, 4096, false, kRpAnsInfo);   // larger than the decoder holds
+    descriptor(&b, 0, false, kRpAnsHealth);
+    descriptor(&b, 4, false, 0x77);            // unknown type: consumed, then skipped
+    b.insert(b.end(), 4, 0xEE);
+    descriptor(&b, 3, false, kRpAnsHealth);
+    b.insert(b.end(), 3, 0);
+    dec.feed(&b[0], b.size(), sink);
+    CHECK(dec.unknown_answers() == 3);
+    CHECK(sink.healths == 1 && sink.infos == 0 && sink.nodes.empty());
+}
+
+int main() {
+    requests();
+    answers_split_anywhere();
+    node_stream();
+    dense_capsules();
+    unusable_descriptors();
+    return test_exit("rplidar_protocol");
+}
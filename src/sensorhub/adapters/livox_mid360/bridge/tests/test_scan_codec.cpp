@@ -0,0 +1,140 @@
+// scan_codec.h: encode -> decode round trip for every codec this build has, and blocks the
+// decoder must refuse (truncated, inconsistent header, wrong point count).
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "scan_codec.h"
+#include "tests/bridge_test.h"
+
+// A scan with what real ones have: small steps, wraps in t_offset_ns, NaN / far points and
+// jumps beyond the uint16 deltas (escapes).
+static std::vector<BridgePoint> make_scan(size_t n) {
+    std::vector<BridgePoint> pts(n);
+    uint32_t t = 4294967000u;
+    std::srand(7);
+    for (size_t i = 0; i < n; ++i) {
+        BridgePoint& p = pts[i];
+        const float a = 0.01f * (float)i;
+        p.x = 10.0f * std::cos(a) + 0.001f * (float)(std::rand() % 50);
+        p.y = 10.0f * std::sin(a);
+        p.z = -1.0f + 0.0005f * (float)(i % 200);
+        if (i % 97 == 5) p.x = 500.0f;                 // 500 m away and back: two escapes
+        if (i % 131 == 7) p.z = std::nanf("");
+        t += 1000 + (uint32_t)(std::rand() % 3);
+        p.t_offset_ns = t;
+        p.reflectivity = (uint8_t)(i * 3);
+        p.tag = (uint8_t)(i % 4);
+        p.reserved = 0xABCD;
+    }
+    return pts;
+}
+
+static int32_t mm(float v) {
+    const float m = v * 1000.0f;
+    return (m > -1.0e9f && m < 1.0e9f) ? (int32_t)lrintf(m) : 0;
+}
+
+static bool same_point(const BridgePoint& a, const BridgePoint& b) {
+    return mm(a.x) == mm(b.x) && mm(a.y) == mm(b.y) && mm(a.z) == mm(b.z) && a.t_offset_ns == b.t_offset_ns &&
+           a.reflectivity == b.reflectivity && a.tag == b.tag && b.reserved == 0;
+}
+
+static void round_trip(uint8_t codec, size_t n) {
+    ScanEncoder enc;
+    CHECK(enc.configure(codec, codec == kCodecZstd ? 3 : 1));
+    const std::vector<BridgePoint> pts = make_scan(n);
+    std::vector<uint8_t> out;
+    std::vector<CodecBlockRef> blocks;
+    enc.encode(pts.empty() ? NULL : &pts[0], n, &out, &blocks);
+    CHECK(blocks.size() == (n ? (n + kCodecBlockPoints - 1) / kCodecBlockPoints : 1));
+    CHECK(out.size() <= ScanEncoder::max_output(n));
+
+    std::vector<uint8_t> scratch(kCodecMaxRaw);
+    std::vector<BridgePoint> dec(kCodecBlockPoints);
+    size_t first = 0, bad = 0;
+    for (size_t k = 0; k < blocks.size(); ++k) {
+        const CodecBlockRef& r = blocks[k];
+        BridgeCodecBlock b;
+        std::memcpy(&b, &out[r.offset], sizeof(b));
+        CHECK(b.first_point == first && b.scan_points == n);
+        CHECK(b.codec == codec || b.codec == kCodecNone);   // stored when compression does not help
+        CHECK(scan_codec_decode(&out[r.offset], r.len, r.points, &dec[0], &scratch[0]));
+        for (uint32_t i = 0; i < r.points; ++i)
+            if (!same_point(pts[first + i], dec[i])) ++bad;
+        first += r.points;
+    }
+    CHECK(first == n);
+    CHECK(bad == 0);
+}
+
+static void refused() {
+    ScanEncoder enc;
+    CHECK(enc.configure(kCodecNone, 1));
+    const size_t n = 300;
+    const std::vector<BridgePoint> pts = make_scan(n);
+    std::vector<uint8_t> out;
+    std::vector<CodecBlockRef> blocks;
+    enc.encode(&pts[0], n, &out, &blocks);
+    CHECK(blocks.size() == 1);
+    const size_t len = blocks[0].len;
+    std::vector<uint8_t> scratch(kCodecMaxRaw);
+    std::vector<BridgePoint> dec(kCodecBlockPoints);
+    CHECK(scan_codec_decode(&out[0], len, n, &dec[0], &scratch[0]));
+
+    BridgeCodecBlock b;
+    std::memcpy(&b, &out[0], sizeof(b));
+    CHECK(b.n_escapes > 0);
+
+    // exact-size copies, so a decoder reading past the block would be caught by ASan
+    std::vector<uint8_t> cut(out.begin(), out.begin() + len - 1);
+    CHECK(!scan_codec_decode(&cut[0], cut.size(), n, &dec[0], &scratch[0]));
+    CHECK(!scan_codec_decode(&out[0], sizeof(b) - 1, n, &dec[0], &scratch[0]));
+    CHECK(!scan_codec_decode(&out[0], len, n - 1, &dec[0], &scratch[0]));
+    CHECK(!scan_codec_decode(&out[0], len, kCodecBlockPoints + 1, &dec[0], &scratch[0]));
+
+    struct Patch {
+        size_t offset;
+        uint8_t value;
+    };
+    const Patch patches[] = {
+        { offsetof(BridgeCodecBlock, codec), 9 },          // unknown codec
+        { offsetof(BridgeCodecBlock, quant), 1 },          // unknown unit
+        { offsetof(BridgeCodecBlock, raw_len), 0 },        // raw_len != 12 n + 4 escapes
+        { offsetof(BridgeCodecBlock, n_escapes), 0 },      // escapes in the planes not listed
+        { offsetof(BridgeCodecBlock, n_escapes) + 3, 0x80 },
+    };
+    for (size_t i = 0; i < sizeof(patches) / sizeof(patches[0]); ++i) {
+        std::vector<uint8_t> bad(out.begin(), out.begin() + len);
+        bad[patches[i].offset] = patches[i].value;
+        CHECK(!scan_codec_decode(&bad[0], bad.size(), n, &dec[0], &scratch[0]));
+    }
+
+    // an escape marker with its int32 list one short: raw_len and n_escapes agree, data not
+    std::vector<uint8_t> bad(out.begin(), out.begin() + len - 4);
+    BridgeCodecBlock short_b = b;
+    --short_b.n_escapes;
+    short_b.raw_len -= 4;
+    std::memcpy(&bad[0], &short_b, sizeof(short_b));
+    CHECK(!scan_codec_decode(&bad[0], bad.size(), n, &dec[0], &scratch[0]));
+}
+
+int main() {
+    CHECK(scan_codec_parse("none") == kCodecNone && scan_codec_parse("lz4") == kCodecLz4);
+    CHECK(scan_codec_parse("zstd") == kCodecZstd && scan_codec_parse("gzip") == -1);
+    CHECK(scan_codec_available(scan_codec_default()));
+    for (uint8_t c = kCodecNone; c <= kCodecZstd; ++c) {
+        if (!scan_codec_available(c)) {
+            ScanEncoder enc;
+            CHECK(!enc.configure(c, 1));
+            continue;
+        }
+        const size_t sizes[] = { 0, 1, 2, 1000, kCodecBlockPoints, kCodecBlockPoints + 1, 3 * kCodecBlockPoints + 17 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) round_trip(c, sizes[i]);
+    }
+    refused();
+    return test_exit("scan_codec");
+}
@@ -0,0 +1,204 @@
+// Livox MID-360 Bridge - batched UDP emission
+//
+// Records are packed back-to-back into MTU-sized datagrams and handed to the kernel with
+// one sendmmsg() per batch. A datagram may therefore carry several records:
+//   - binary frames are self-delimiting (fixed header + payload_len, see bridge_frame.h)
+//   - NDJSON records are terminated by '\n'
+// Records larger than the MTU (scan fragments) travel in their own datagram, referenced in
+// place rather than copied, and force a flush so the caller may reuse its buffer.
+// The batch is flushed when `max_msgs` datagrams are queued or when the oldest queued
+// record is older than the flush deadline. Not thread-safe; callers serialize.
+//
+// Each destination is a lane (0 .. kLanes-1) with its own packing datagram; add_lanes()
+// queues one record for several lanes, so every consumer's datagrams go out in the same
+// sendmmsg and an in-place fragment is referenced once per lane without copying. Send
+// errors are also counted per lane, for backpressure (backpressure.h).
+
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class UdpBatcher {
+public:
+    static const size_t kLanes = 32;
+
+    UdpBatcher()
+        : sock_(-1), mtu_(1472), max_msgs_(32), flush_ns_(1000000ull), n_(0), open_lanes_(0),
+          first_ns_(0), datagrams_(0), syscalls_(0), send_errors_(0) {
+        std::memset(lanes_, 0, sizeof(lanes_));
+        std::memset(lane_errors_, 0, sizeof(lane_errors_));
+    }
+
+    void open(int sock, size_t mtu, size_t max_msgs, uint64_t flush_ns) {
+        sock_ = sock;
+        mtu_ = mtu ? mtu : 1472;
+        max_msgs_ = max_msgs ? max_msgs : 1;
+        flush_ns_ = flush_ns;
+        bufs_.assign(max_msgs_ * mtu_, 0);
+        msgs_.resize(max_msgs_);
+        msg_lane_.resize(max_msgs_);
+        iovs_.resize(max_msgs_ * 2);
+        n_ = 0;
+        reset_packing();
+    }
+
+    // Single destination on lane 0.
+    void open(int sock, const sockaddr_in& dst, size_t mtu, size_t max_msgs, uint64_t flush_ns) {
+        open(sock, mtu, max_msgs, flush_ns);
+        set_lane(0, dst);
+    }
+
+    // (Re)point a lane at dst / stop it. Queued datagrams are sent first: they reference
+    // the lane's address.
+    void set_lane(size_t lane, const sockaddr_in& dst) {
+        if (lane >= kLanes) return;
+        if (n_) flush();
+        lanes_[lane].dst = dst;
+        open_lanes_ |= 1u << lane;
+    }
+
+    void close_lane(size_t lane) {
+        if (lane >= kLanes) return;
+        if (n_) flush();
+        open_lanes_ &= ~(1u << lane);
+    }
+
+    // Queue a record made of up to two pieces for lane 0.
+    void add(const void* a, size_t a_len, const void* b, size_t b_len, uint64_t now_ns) {
+        add_lanes(1u, a, a_len, b, b_len, now_ns);
+    }
+
+    // Queue a record for every open lane in the mask.
+    void add_lanes(uint32_t lanes, const void* a, size_t a_len, const void* b, size_t b_len, uint64_t now_ns) {
+        lanes &= open_lanes_;
+        if (sock_ < 0 || !lanes) return;
+        const size_t len = a_len + b_len;
+
+        if (len > mtu_) {
+            for (; lanes; lanes &= lanes - 1) {
+                if (n_ == max_msgs_) flush();
+                set_iov(n_, (size_t)__builtin_ctz(lanes), const_cast<void*>(a), a_len, const_cast<void*>(b), b_len);
+                ++n_;
+            }
+            flush();
+            return;
+        }
+
+        for (; lanes; lanes &= lanes - 1) {
+            const size_t l = (size_t)__builtin_ctz(lanes);
+            if (lanes_[l].packing < 0 || iovs_[lanes_[l].packing * 2].iov_len + len > mtu_) {
+                if (n_ == max_msgs_) flush();
+                if (n_ == 0) first_ns_ = now_ns;
+                set_iov(n_, l, slot(n_), 0, NULL, 0);
+                lanes_[l].packing = (int)n_;
+                ++n_;
+            }
+            iovec& iov = iovs_[lanes_[l].packing * 2];
+            uint8_t* dst = static_cast<uint8_t*>(iov.iov_base) + iov.iov_len;
+            std::memcpy(dst, a, a_len);
+            if (b_len) std::memcpy(dst + a_len, b, b_len);
+            iov.iov_len += len;
+        }
+
+        if (n_ == max_msgs_ && iovs_[(n_ - 1) * 2].iov_len == mtu_) flush();
+        else flush_if_due(now_ns);
+    }
+
+    void flush_if_due(uint64_t now_ns) {
+        if (n_ && now_ns - first_ns_ >= flush_ns_) flush();
+    }
+
+    void flush() {
+        size_t sent = 0;
+        while (sent < n_) {
+            int r = sendmmsg(sock_, &msgs_[sent], (unsigned)(n_ - sent), 0);
+            ++syscalls_;
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                send_errors_ += n_ - sent;   // EAGAIN/ENOBUFS: drop the rest of the batch
+                for (size_t i = sent; i < n_; ++i) ++lane_errors_[msg_lane_[i]];
+                break;
+            }
+            sent += (size_t)r;
+        }
+        datagrams_ += sent;
+        n_ = 0;
+        reset_packing();
+    }
+
+    size_t pending() const { return n_; }
+    size_t mtu() const { return mtu_; }
+    uint32_t open_lanes() const { return open_lanes_; }
+    uint64_t datagrams() const { return datagrams_; }
+    uint64_t syscalls() const { return syscalls_; }
+    uint64_t send_errors() const { return send_errors_; }
+    uint64_t lane_errors(size_t lane) const { return lane < kLanes ? lane_errors_[lane] : 0; }
+
+private:
+    struct Lane {
+        sockaddr_in dst;
+        int packing;               // queued packing datagram with room, -1 if none
+    };
+
+    uint8_t* slot(size_t i) { return &bufs_[i * mtu_]; }
+
+    void reset_packing() {
+        for (size_t l = 0; l < kLanes; ++l) lanes_[l].packing = -1;
+    }
+
+    void set_iov(size_t i, size_t lane, void* a, size_t a_len, void* b, size_t b_len) {
+        iovs_[i * 2].iov_base = a;
+        iovs_[i * 2].iov_len = a_len;
+        iovs_[i * 2 + 1].iov_base = b;
+        iovs_[i * 2 + 1].iov_len = b_len;
+        std::memset(&msgs_[i], 0, sizeof(mmsghdr));
+        msg_lane_[i] = (uint8_t)lane;
+        msgs_[i].msg_hdr.msg_name = &lanes_[lane].dst;
+        msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msgs_[i].msg_hdr.msg_iov = &iovs_[i * 2];
+        msgs_[i].msg_hdr.msg_iovlen = b_len ? 2 : 1;
+    }
+
+    int sock_;
+    size_t mtu_;
+    size_t max_msgs_;
+    uint64_t flush_ns_;
+    std::vector<uint8_t> bufs_;    // max_msgs_ packing buffers of mtu_ bytes
+    std::vector<mmsghdr> msgs_;
+    std::vector<uint8_t> msg_lane_;  // lane of each queued datagram
+    std::vector<iovec> iovs_;      // two per message
+    size_t n_;                     // datagrams queued
+    Lane lanes_[kLanes];
+    uint32_t open_lanes_;
+    uint64_t first_ns_;
+    uint64_t datagrams_;
+    uint64_t syscalls_;
+    uint64_t send_errors_;
+    uint64_t lane_errors_[kLanes];
+};
+
+// Path MTU towards dst minus IPv4+UDP headers; falls back to 1472 (Ethernet).
+static inline size_t udp_payload_mtu(const sockaddr_in& dst) {
+    size_t payload = 1472;
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return payload;
+    if (connect(s, reinterpret_cast<const sockaddr*>(&dst), sizeof(dst)) == 0) {
+        int mtu = 0;
+        socklen_t len = sizeof(mtu);
+        if (getsockopt(s, IPPROTO_IP, IP_MTU, &mtu, &len) == 0 && mtu > 28) {
+            payload = (size_t)mtu - 28;
+            if (payload > 65507) payload = 65507;
+        }
+    }
+    close(s);
+    return payload;
+}
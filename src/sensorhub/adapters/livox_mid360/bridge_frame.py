@@ -0,0 +1,359 @@
+"""
+Python mirror of the livox_bridge binary frame format (bridge/bridge_frame.h).
+
+Layout is little-endian and packed; keep this file in sync with the C++ header.
+"""
+
+import struct
+from typing import NamedTuple, Optional
+
+import numpy as np
+
+FRAME_MAGIC = b"LVXB"
+FRAME_VERSION = 2
+
+MSG_POINTS = 1  # one SDK packet, SDK point layout
+MSG_SCAN = 2    # one assembled scan (possibly fragmented), POINT_XYZRT layout
+MSG_IMU = 3     # batch of IMU samples, IMU_SAMPLE layout
+MSG_IMU_PREINT = 4  # IMU integrated over one scan, IMU_PREINT layout
+MSG_SCAN_COMPRESSED = 5  # one compressed block of a scan, decodes to POINT_XYZRT (scan_codec.py)
+MSG_GRID_DELTA = 6  # changed tiles of the bridge grid map (LIVOX_GRID), GRID_TILE layout, see GridTiles
+MSG_LASER_SCAN = 7  # one revolution of a 2D scanner (rplidar_bridge), LASER_POINT layout
+MSG_RANGE_IMAGE = 8  # spherical range image of a scan (LIVOX_RANGE_IMAGE), rows of RANGE_IMAGE_ROWS
+
+FLAG_FUSED = 0x01  # scan merged from several devices in the common frame
+FLAG_DESKEWED = 0x02  # scan points rotated into the sensor frame at stamp_ns (IMU deskew)
+FLAG_DOWNSAMPLED = 0x04  # scan voxel-downsampled by the bridge because this consumer lagged
+FUSED_HANDLE = 0
+
+POINT_CARTESIAN_HIGH = 1
+POINT_CARTESIAN_LOW = 2
+POINT_SPHERICAL = 3
+POINT_XYZRT = 4
+IMU_SAMPLE = 5
+IMU_PREINT = 6
+POINT_XYZRT_COLUMNS = 7  # scans with LIVOX_POINT_LAYOUT=columns, see PointColumns
+GRID_TILE = 8
+LASER_POINT = 9
+RANGE_IMAGE_ROWS = 10  # records are image rows, see RangeImage
+
+GRID_TILE_CELLS = 16
+GRID_UNKNOWN = -32768     # ground_cm / height_cm of a cell not observed
+GRID_TILE_CLEARED = 0x01  # tile flag: it left the bridge's map window, forget it
+
+HEADER = struct.Struct("<4sBBBBIIHHIIBBHQQQ")
+HEADER_SIZE = HEADER.size  # 56
+# The same layout as a numpy record, for header columns (header_column)
+HEADER_DTYPE = np.dtype([
+    ("magic", "S4"), ("version", "u1"), ("msg_type", "u1"), ("point_format", "u1"), ("time_type", "u1"),
+    ("handle", "<u4"), ("seq", "<u4"), ("frag_index", "<u2"), ("frag_count", "<u2"), ("point_count", "<u4"),
+    ("payload_len", "<u4"), ("frame_cnt", "u1"), ("flags", "u1"), ("reserved", "<u2"),
+    ("host_ts_ns", "<u8"), ("device_ts_ns", "<u8"), ("stamp_ns", "<u8"),
+])
+
+POINT_DTYPES = {
+    POINT_CARTESIAN_HIGH: np.dtype(
+        [("x", "<i4"), ("y", "<i4"), ("z", "<i4"), ("reflectivity", "u1"), ("tag", "u1")]
+    ),
+    POINT_CARTESIAN_LOW: np.dtype(
+        [("x", "<i2"), ("y", "<i2"), ("z", "<i2"), ("reflectivity", "u1"), ("tag", "u1")]
+    ),
+    POINT_SPHERICAL: np.dtype(
+        [("depth", "<u4"), ("theta", "<u2"), ("phi", "<u2"), ("reflectivity", "u1"), ("tag", "u1")]
+    ),
+    POINT_XYZRT: np.dtype(
+        [("x", "<f4"), ("y", "<f4"), ("z", "<f4"), ("t_offset_ns", "<u4"),
+         ("reflectivity", "u1"), ("tag", "u1"), ("reserved", "<u2")]
+    ),
+    # IMU records share the point_format numbering
+    IMU_SAMPLE: np.dtype(
+        [("stamp_ns", "<u8"), ("gx", "<f4"), ("gy", "<f4"), ("gz", "<f4"),
+         ("ax", "<f4"), ("ay", "<f4"), ("az", "<f4")]
+    ),
+    IMU_PREINT: np.dtype(
+        [("scan_seq", "<u4"), ("samples", "<u4"), ("start_ns", "<u8"), ("end_ns", "<u8"),
+         ("dq", "<f4", (4,)), ("dv", "<f4", (3,)), ("dp", "<f4", (3,))]
+    ),
+    # layers are [row = cy % 16][col = cx % 16]
+    GRID_TILE: np.dtype(
+        [("tx", "<i4"), ("ty", "<i4"), ("cell_mm", "<u2"), ("flags", "u1"), ("reserved", "u1"),
+         ("ground_cm", "<i2", (GRID_TILE_CELLS, GRID_TILE_CELLS)),
+         ("height_cm", "<i2", (GRID_TILE_CELLS, GRID_TILE_CELLS)),
+         ("occupancy", "u1", (GRID_TILE_CELLS, GRID_TILE_CELLS))]
+    ),
+    LASER_POINT: np.dtype(
+        [("angle_deg", "<f4"), ("range_mm", "<f4"), ("t_offset_ns", "<u4"), ("quality", "u1"),
+         ("reserved", "u1", (3,))]
+    ),
+}
+
+
+# POINT_XYZRT fields as stored by POINT_XYZRT_COLUMNS, in payload order (no reserved field)
+COLUMN_FIELDS = (("x", "<f4"), ("y", "<f4"), ("z", "<f4"), ("t_offset_ns", "<u4"),
+                 ("reflectivity", "u1"), ("tag", "u1"))
+COLUMN_POINT_SIZE = 18
+
+
+class PointColumns:
+    """
+    Points in the columnar layout: pts["x"], pts["tag"], ... are contiguous 1-D arrays
+    over one buffer (raw), so numpy work on a field needs no strided copy. n points take
+    n * COLUMN_POINT_SIZE bytes: x[n], y[n], z[n], t_offset_ns[n], reflectivity[n], tag[n].
+    """
+
+    __slots__ = ("raw", "_cols")
+
+    def __init__(self, buf, count: int, offset: int = 0) -> None:
+        self.raw = np.frombuffer(buf, dtype=np.uint8, count=count * COLUMN_POINT_SIZE, offset=offset)
+        self._cols = {}
+        off = 0
+        for name, dt in COLUMN_FIELDS:
+            size = count * np.dtype(dt).itemsize
+            self._cols[name] = self.raw[off:off + size].view(dt)
+            off += size
+
+    @classmethod
+    def concatenate(cls, parts) -> "PointColumns":
+        """One PointColumns holding the points of parts in order, column by column."""
+        count = sum(len(p) for p in parts)
+        out = cls(bytearray(count * COLUMN_POINT_SIZE), count)
+        for name, _ in COLUMN_FIELDS:
+            np.concatenate([p[name] for p in parts], out=out[name])
+        return out
+
+    def __getitem__(self, name: str) -> np.ndarray:
+        return self._cols[name]
+
+    def __len__(self) -> int:
+        return len(self._cols["x"])
+
+    @property
+    def names(self):
+        return tuple(name for name, _ in COLUMN_FIELDS)
+
+    @property
+    def nbytes(self) -> int:
+        return self.raw.nbytes
+
+    def copy(self) -> "PointColumns":
+        return PointColumns(self.raw.copy(), len(self))
+
+    def setflags(self, write: bool) -> None:
+        for a in self._cols.values():
+            a.setflags(write=write)
+        self.raw.setflags(write=write)
+
+    def to_records(self) -> np.ndarray:
+        """The same points as a POINT_XYZRT structured array (a copy)."""
+        out = np.zeros(len(self), dtype=POINT_DTYPES[POINT_XYZRT])
+        for name, _ in COLUMN_FIELDS:
+            out[name] = self._cols[name]
+        return out
+
+
+# Bytes per range image pixel: float32 range plus uint8 intensity
+RANGE_PIXEL_SIZE = 5
+
+
+class RangeImage:
+    """
+    Rows of a spherical range image (MSG_RANGE_IMAGE): range_m is a (rows, width) float32
+    array (0 = no return) and intensity a (rows, width) uint8 array, both views over one
+    buffer (raw): range_m[rows][width] followed by intensity[rows][width]. Row 0 is the top
+    of the field of view, column 0 looks backwards and columns run clockwise from above.
+    """
+
+    __slots__ = ("raw", "range_m", "intensity")
+
+    def __init__(self, buf, rows: int, width: int, offset: int = 0) -> None:
+        self.raw = np.frombuffer(buf, dtype=np.uint8, count=rows * width * RANGE_PIXEL_SIZE, offset=offset)
+        split = rows * width * 4
+        self.range_m = self.raw[:split].view("<f4").reshape(rows, width)
+        self.intensity = self.raw[split:].reshape(rows, width)
+
+    @classmethod
+    def concatenate(cls, parts) -> "RangeImage":
+        """One RangeImage holding the rows of parts in order."""
+        rows = sum(len(p) for p in parts)
+        width = parts[0].width
+        out = cls(bytearray(rows * width * RANGE_PIXEL_SIZE), rows, width)
+        np.concatenate([p.range_m for p in parts], out=out.range_m)
+        np.concatenate([p.intensity for p in parts], out=out.intensity)
+        return out
+
+    def __len__(self) -> int:
+        return self.range_m.shape[0]
+
+    @property
+    def width(self) -> int:
+        return self.range_m.shape[1]
+
+    @property
+    def nbytes(self) -> int:
+        return self.raw.nbytes
+
+    def copy(self) -> "RangeImage":
+        return RangeImage(self.raw.copy(), len(self), self.width)
+
+    def setflags(self, write: bool) -> None:
+        self.range_m.setflags(write=write)
+        self.intensity.setflags(write=write)
+        self.raw.setflags(write=write)
+
+
+class GridTiles:
+    """
+    Consumer-side copy of the bridge grid map: apply() every MSG_GRID_DELTA record array in
+    order and tiles holds the latest record of each tile the bridge still keeps. A receiver
+    that missed deltas asks the bridge for {"cmd":"grid_snapshot"}.
+    """
+
+    def __init__(self) -> None:
+        self.tiles = {}          # (tx, ty) -> GRID_TILE record
+        self.cell_m = 0.0
+
+    def apply(self, records) -> None:
+        records = np.array(records, copy=True)     # the delta's buffer may be reused
+        for t in records:
+            key = (int(t["tx"]), int(t["ty"]))
+            if t["flags"] & GRID_TILE_CLEARED:
+                self.tiles.pop(key, None)
+            else:
+                self.tiles[key] = t
+            self.cell_m = int(t["cell_mm"]) / 1000.0
+
+    def layers(self):
+        """
+        (origin, ground_cm, height_cm, occupancy) over the bounding box of the tiles, or None
+        without tiles: 2-D arrays indexed [y][x], origin the (x, y) in m of cell [0][0]'s
+        corner. Cells of missing tiles are GRID_UNKNOWN / 0.
+        """
+        if not self.tiles:
+            return None
+        n = GRID_TILE_CELLS
+        x0 = min(k[0] for k in self.tiles)
+        y0 = min(k[1] for k in self.tiles)
+        w = (max(k[0] for k in self.tiles) - x0 + 1) * n
+        h = (max(k[1] for k in self.tiles) - y0 + 1) * n
+        ground = np.full((h, w), GRID_UNKNOWN, dtype=np.int16)
+        height = np.full((h, w), GRID_UNKNOWN, dtype=np.int16)
+        occupancy = np.zeros((h, w), dtype=np.uint8)
+        for (tx, ty), t in self.tiles.items():
+            r, c = (ty - y0) * n, (tx - x0) * n
+            ground[r:r + n, c:c + n] = t["ground_cm"]
+            height[r:r + n, c:c + n] = t["height_cm"]
+            occupancy[r:r + n, c:c + n] = t["occupancy"]
+        return (x0 * n * self.cell_m, y0 * n * self.cell_m), ground, height, occupancy
+
+
+class FrameHeader(NamedTuple):
+    magic: bytes
+    version: int
+    msg_type: int
+    point_format: int
+    time_type: int
+    handle: int
+    seq: int
+    frag_index: int
+    frag_count: int
+    point_count: int
+    payload_len: int
+    frame_cnt: int
+    flags: int
+    reserved: int
+    host_ts_ns: int
+    device_ts_ns: int
+    stamp_ns: int  # device time mapped to host CLOCK_REALTIME; scan t_offset_ns is relative to it
+
+
+def header_column(ring) -> np.ndarray:
+    """The header column of a receiver history (livox_frames.SampleRing or a
+    core SampleRing with row_size HEADER_SIZE) as a HEADER_DTYPE array in slot order, no
+    copy. Slots not written yet are zero; match seq / stamp_ns against latest() / last(k)
+    when a slot may be rewritten while reading."""
+    return np.frombuffer(ring.rows(), dtype=HEADER_DTYPE)
+
+
+def is_binary_frame(buf) -> bool:
+    return len(buf) >= HEADER_SIZE and bytes(buf[:4]) == FRAME_MAGIC
+
+
+def parse_header(buf, offset: int = 0) -> Optional[FrameHeader]:
+    if len(buf) - offset < HEADER_SIZE:
+        return None
+    hdr = FrameHeader(*HEADER.unpack_from(buf, offset))
+    if hdr.magic != FRAME_MAGIC or hdr.version != FRAME_VERSION:
+        return None
+    return hdr
+
+
+def points_view(buf, hdr: FrameHeader, offset: int = 0):
+    """Zero-copy structured view over the payload of a frame (points or IMU records), or
+    a PointColumns for columnar scans, or a RangeImage for range images."""
+    if hdr.point_format == POINT_XYZRT_COLUMNS:
+        return PointColumns(buf, hdr.point_count, offset + HEADER_SIZE)
+    if hdr.point_format == RANGE_IMAGE_ROWS:
+        width = hdr.payload_len // (RANGE_PIXEL_SIZE * hdr.point_count) if hdr.point_count else 0
+        return RangeImage(buf, hdr.point_count, width, offset + HEADER_SIZE)
+    dtype = POINT_DTYPES.get(hdr.point_format)
+    if dtype is None:
+        raise ValueError(f"unknown point_format {hdr.point_format}")
+    return np.frombuffer(buf, dtype=dtype, count=hdr.point_count, offset=offset + HEADER_SIZE)
+
+
+
+def iter_records(datagram):
+    """
+    Split a bridge datagram into records. With UDP batching a datagram may carry several
+    binary frames (self-delimiting via payload_len) and '\n'-terminated NDJSON lines.
+    Yields (FrameHeader, memoryview) for frames and (None, bytes) for NDJSON lines.
+    """
+    mv = memoryview(datagram)
+    off = 0
+    end = len(mv)
+    while off < end:
+        hdr = parse_header(mv, off) if bytes(mv[off:off + 4]) == FRAME_MAGIC else None
+        if hdr is not None:
+            n = HEADER_SIZE + hdr.payload_len
+            yield hdr, mv[off:off + n]
+            off += n
+            continue
+        nl = bytes(mv[off:]).find(b"\n")
+        stop = end if nl < 0 else off + nl
+        if stop > off:
+            yield None, bytes(mv[off:stop])
+        off = stop + 1
+
+
+class ScanReassembler:
+    """Joins fragments of one scan (same seq) back into a single point array (or
+    PointColumns, joined column by column, or RangeImage, row by row)."""
+
+    def __init__(self) -> None:
+        self._seq: Optional[int] = None
+        self._parts: list = []
+        self.incomplete = 0
+
+    def add(self, buf, hdr: FrameHeader):
+        pts = points_view(buf, hdr)
+        if hdr.frag_count <= 1:
+            return pts
+        if hdr.seq != self._seq or hdr.frag_index != len(self._parts):
+            if self._parts:
+                self.incomplete += 1
+            self._parts = []
+            self._seq = hdr.seq
+            if hdr.frag_index != 0:
+                return None
+        self._parts.append(pts.copy())
+        if len(self._parts) == hdr.frag_count:
+            if hdr.point_format == POINT_XYZRT_COLUMNS:
+                out = PointColumns.concatenate(self._parts)
+            elif hdr.point_format == RANGE_IMAGE_ROWS:
+                out = RangeImage.concatenate(self._parts)
+            else:
+                out = np.concatenate(self._parts)
+            self._parts = []
+            self._seq = None
+            return out
+        return None
@@ -0,0 +1,172 @@
+"""
+Bridge frame receiver: the livox_frames C++ extension (bridge/livox_frames.cpp) when it is
+built and importable, else a pure-Python receiver with the same interface.
+
+    rx = open_receiver()            # livox_frames.Receiver or PyReceiver
+    rx.open_udp(0)                  # or rx.open_shm(name)
+    rx.start()
+    got = rx.recv(100)              # (bridge_frame.FrameHeader, numpy array) or None
+
+Both return whole messages: fragmented scans joined, compressed scans decoded and
+returned as msg 2 with POINT_XYZRT points. Columnar scans (LIVOX_POINT_LAYOUT=columns)
+come back as bridge_frame.PointColumns instead of an array, range images (msg 8) as
+bridge_frame.RangeImage. The fallback does the same work under the GIL,
+so it is for machines without the extension, not for full sensor rate.
+
+With history > 0 both also keep points_history / imu_history rings of
+(stamp_ns, (header, array)) entries with latest() / last(k) (livox_frames.SampleRing or
+sensorhub.core.sample_ring.SampleRing), plus typed columns over the same slots: the stamps
+and the record headers (bridge_frame.header_column). queue_depth 0 then keeps history
+only. The native receiver fills its rings on the receive thread; the fallback while recv() is called.
+Grid deltas (msg 6) and range images (msg 8) share points_history with the scans.
+
+stats() counts what was lost on the way - kernel_drops (receive buffer overflows,
+SO_RXQ_OVFL), incomplete scans, dropped queue records, shm_lost - and the queue depth;
+livox_adapter reports them to the bridge as {"cmd":"lag"} (bridge/backpressure.h).
+"""
+
+import select
+import socket
+import struct
+from collections import deque
+from typing import Optional
+
+from sensorhub.adapters.livox_mid360 import bridge_frame, scan_codec
+from sensorhub.adapters.livox_mid360.shm_ring import ShmRingReader
+from sensorhub.core.sample_ring import SampleRing
+
+try:
+    import livox_frames as _native
+except ImportError:  # extension not built
+    _native = None
+
+
+# Linux value; older Pythons do not export it
+_SO_RXQ_OVFL = getattr(socket, "SO_RXQ_OVFL", 40)
+_OVFL_CMSG = socket.CMSG_SPACE(4)
+
+
+def native_available() -> bool:
+    return _native is not None
+
+
+def open_receiver(queue_depth: int = 64, native: bool = True, history: int = 0):
+    if native and _native is not None:
+        return _native.Receiver(queue_depth, history)
+    return PyReceiver(queue_depth, history)
+
+
+class PyReceiver:
+    def __init__(self, queue_depth: int = 64, history: int = 0) -> None:
+        self._sock: Optional[socket.socket] = None
+        self._shm: Optional[ShmRingReader] = None
+        self._depth = queue_depth or (0 if history else 1)
+        self._queue: deque = deque(maxlen=max(queue_depth, 1))
+        self.points_history = SampleRing(history, bridge_frame.HEADER_SIZE) if history else None
+        self.imu_history = SampleRing(history, bridge_frame.HEADER_SIZE) if history else None
+        self._frags = bridge_frame.ScanReassembler()
+        self._scans = scan_codec.CompressedScanReassembler()
+        self.port = 0
+        self.running = False
+        self._stats = dict(datagrams=0, bytes=0, records=0, ndjson=0, bad_blocks=0, dropped=0, kernel_drops=0)
+
+    def open_udp(self, port: int, addr: str = "0.0.0.0", group: str = "", rcvbuf: int = 8 << 20) -> None:
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        s.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, rcvbuf)
+        s.setsockopt(socket.SOL_SOCKET, _SO_RXQ_OVFL, 1)
+        s.bind((addr, port))
+        if group:
+            mreq = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+            s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+        s.setblocking(False)
+        self._sock = s
+        self.port = s.getsockname()[1]
+
+    def open_shm(self, name: str) -> None:
+        self._shm = ShmRingReader(name)
+
+    def start(self) -> bool:
+        self.running = self._sock is not None or self._shm is not None
+        return self.running
+
+    def stop(self) -> None:
+        self.running = False
+        if self._sock is not None:
+            self._sock.close()
+            self._sock = None
+        if self._shm is not None:
+            self._shm.close()
+            self._shm = None
+
+    def recv(self, timeout_ms: int = 100):
+        if not self._queue and self.running:
+            self._fill(timeout_ms)
+        return self._queue.popleft() if self._queue else None
+
+    def stats(self) -> dict:
+        out = dict(self._stats)
+        out["incomplete"] = self._frags.incomplete + self._scans.missing_blocks
+        out["shm_lost"] = self._shm.lost if self._shm is not None else 0
+        out["queued"] = len(self._queue)
+        out["capacity"] = self._depth
+        return out
+
+    def _fill(self, timeout_ms: int) -> None:
+        if self._shm is not None:
+            for rec in self._shm.drain(256):
+                self._consume(rec)
+            if not self._queue:
+                select.select([], [], [], min(timeout_ms, 5) / 1000.0)
+            return
+        rs, _, _ = select.select([self._sock], [], [], max(timeout_ms, 0) / 1000.0)
+        if not rs:
+            return
+        for _ in range(64):
+            try:
+                data, anc, _, _ = self._sock.recvmsg(65535, _OVFL_CMSG)
+            except BlockingIOError:
+                break
+            for level, kind, value in anc:
+                if level == socket.SOL_SOCKET and kind == _SO_RXQ_OVFL and len(value) >= 4:
+                    self._stats["kernel_drops"] = struct.unpack_from("<I", value)[0]
+            self._consume(data)
+
+    def _consume(self, data) -> None:
+        self._stats["datagrams"] += 1
+        self._stats["bytes"] += len(data)
+        for hdr, rec in bridge_frame.iter_records(data):
+            if hdr is None:
+                self._stats["ndjson"] += 1
+                continue
+            if hdr.msg_type == bridge_frame.MSG_SCAN_COMPRESSED:
+                try:
+                    pts = self._scans.add(rec, hdr)
+                except ValueError:
+                    self._stats["bad_blocks"] += 1
+                    continue
+                if pts is None:
+                    continue
+                hdr = self._scans.header._replace(msg_type=bridge_frame.MSG_SCAN,
+                                                  point_format=bridge_frame.POINT_XYZRT)
+            elif hdr.frag_count > 1:
+                pts = self._frags.add(rec, hdr)
+            else:
+                pts = bridge_frame.points_view(rec, hdr).copy()
+            if pts is None:
+                continue
+            self._push(hdr._replace(frag_index=0, frag_count=1, point_count=len(pts),
+                                    payload_len=pts.nbytes), pts)
+
+    def _push(self, hdr, pts) -> None:
+        self._stats["records"] += 1
+        if self.points_history is not None:
+            pts.setflags(write=False)      # shared with the history
+            imu = hdr.msg_type in (bridge_frame.MSG_IMU, bridge_frame.MSG_IMU_PREINT)
+            (self.imu_history if imu else self.points_history).append(
+                hdr.stamp_ns, (hdr, pts), bridge_frame.HEADER.pack(*hdr))
+        if not self._depth:
+            return
+        if len(self._queue) == self._queue.maxlen:
+            self._stats["dropped"] += 1
+        self._queue.append((hdr, pts))
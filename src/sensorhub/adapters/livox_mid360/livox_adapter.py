@@ -1,5 +1,6 @@
 
 import os
+import json
 import time
 import socket
 import struct
@@ -9,8 +10,11 @@ import threading
 import logging
 from typing import Optional
 
+import numpy as np
 from fastapi import APIRouter, HTTPException
 from sensorhub.core.sensor_base import AbstractSensorAdapter
+from sensorhub.adapters.livox_mid360 import bridge_frame, frame_receiver
+from sensorhub.adapters.livox_mid360.shm_ring import ShmRingReader
 
 router = APIRouter(prefix="/livox", tags=["livox"])
 
@@ -46,6 +50,72 @@ def livox_service_stop(service_name: str = "livox_bridge"):
         raise HTTPException(status_code=500, detail=f"systemd stop failed: {e}")
 
 
+def _record_payload(sensor_id: str, hdr, arr) -> dict:
+    if hdr.msg_type == bridge_frame.MSG_IMU:
+        kind = "imu"
+    elif hdr.msg_type == bridge_frame.MSG_IMU_PREINT:
+        kind = "imu_preint"
+    elif hdr.msg_type == bridge_frame.MSG_GRID_DELTA:
+        kind = "grid"               # GRID_TILE records, apply to a bridge_frame.GridTiles
+    elif hdr.msg_type == bridge_frame.MSG_RANGE_IMAGE:
+        kind = "range_image"        # a bridge_frame.RangeImage
+    else:
+        kind = "scan" if hdr.msg_type == bridge_frame.MSG_SCAN else "points"
+    return {
+        "sensor_id": sensor_id,
+        "type": kind,
+        "handle": hdr.handle,
+        "seq": hdr.seq,
+        "stamp_ns": hdr.stamp_ns,
+        "point_format": hdr.point_format,
+        "fused": bool(hdr.flags & bridge_frame.FLAG_FUSED),
+        "deskewed": bool(hdr.flags & bridge_frame.FLAG_DESKEWED),
+        "downsampled": bool(hdr.flags & bridge_frame.FLAG_DOWNSAMPLED),
+        "frame_header": bridge_frame.HEADER.pack(*hdr),   # with records: the bridge frame as received
+        "records": arr,             # read-only structured numpy array, bridge_frame.POINT_DTYPES,
+                                    # or bridge_frame.PointColumns for columnar scans,
+                                    # bridge_frame.RangeImage for range images
+    }
+
+
+class _RecordRing:
+    """Adapter ring over a receiver history (frame_receiver.py): its (stamp_ns, (hdr, arr))
+    entries become sample payloads only when read, so ingest costs Python nothing."""
+
+    def __init__(self, history, sensor_id: str) -> None:
+        self._history = history
+        self._sensor_id = sensor_id
+
+    def __len__(self) -> int:
+        return len(self._history)
+
+    @property
+    def seq(self) -> int:
+        return self._history.seq
+
+    def latest(self):
+        got = self._history.latest()
+        return self._entry(got) if got is not None else None
+
+    def last(self, k: int):
+        return [self._entry(e) for e in self._history.last(k)]
+
+    def since(self, after: int):
+        seq, got = self._history.since(after)
+        return seq, [self._entry(e) for e in got]
+
+    def columns(self):
+        """(stamp_ns, header) columns of the history in slot order: an int64 array and a
+        bridge_frame.HEADER_DTYPE array, both views without a copy."""
+        h = self._history
+        stamps = h.stamps() if hasattr(h, "stamps") else np.frombuffer(h.ts_column(), dtype=np.int64)
+        return stamps, bridge_frame.header_column(h)
+
+    def _entry(self, entry):
+        stamp_ns, (hdr, arr) = entry
+        return stamp_ns, _record_payload(self._sensor_id, hdr, arr)
+
+
 class LivoxMid360Adapter(AbstractSensorAdapter):
     def __init__(
         self,
@@ -60,6 +130,15 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
         imu_port: int = 56401,
         listen_udp: bool = True,
         publish_period: float = 0.5,
+        shm_name: Optional[str] = None,  # LIVOX_SHM_NAME of the bridge; replaces UDP listening
+        output: str = "counters",        # "points": publish bridge scans / IMU as numpy arrays
+        bridge_host: str = "127.0.0.1",  # points mode: bridge control address (subscription)
+        bridge_ctl_port: int = 18181,    # LIVOX_CTL_PORT of the bridge
+        bridge_format: str = "binary",   # points mode: "binary" or "compressed" subscription
+        native: bool = True,             # use the livox_frames extension when it is built
+        history_size: int = 64,          # points mode: scans / IMU records kept for history
+        grid: bool = False,              # points mode: also take the bridge's grid deltas (LIVOX_GRID)
+        range_image: bool = False,       # points mode: also take its range images (LIVOX_RANGE_IMAGE)
         hz: Optional[float] = None,    # <-- accept hz from config
         **kwargs,                      # <-- swallow any future keys safely
     ) -> None:
@@ -80,6 +159,18 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
         self.point_port = int(point_port)
         self.imu_port = int(imu_port)
         self.listen_udp = bool(listen_udp)
+        self.shm_name = shm_name
+        if output not in ("counters", "points"):
+            raise ValueError(f"output must be 'counters' or 'points', not {output!r}")
+        self.output = output
+        self.bridge_ctl = (bridge_host, int(bridge_ctl_port))
+        self.bridge_format = bridge_format
+        self.native = bool(native)
+        self.history_size = max(int(history_size), 1)
+        self.grid = bool(grid)
+        self.range_image = bool(range_image)
+        self.imu_ring: Optional[_RecordRing] = None   # points mode: IMU batches / preint
+        self._notified = [0, 0]          # points / IMU history seq handed to on_sample
 
         # Map 'hz' (if provided) to publish_period, otherwise keep provided publish_period
         self.publish_period = (1.0 / hz) if (hz and hz > 0) else float(publish_period)
@@ -87,6 +178,16 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
         self._pt_sock = None
         self._imu_sock = None
         self._proc = None
+        self._shm: Optional[ShmRingReader] = None
+        self._rx = None                 # points mode: frame_receiver.open_receiver()
+        self._ctl_sock: Optional[socket.socket] = None
+        self._sub_renew_at = 0.0
+        self._sub_ttl = 30.0
+        self._lag_at = 0.0
+        self._grid_synced = False
+        self._cmd_cv = threading.Condition()
+        self._cmd_next_id = 0
+        self._cmd_done: dict = {}       # client id awaited by command() -> its cmd_done, or None
 
         self._point_pkts = 0
         self._point_bytes = 0
@@ -94,9 +195,22 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
         self._imu_bytes = 0
         self._last_point_ts = 0.0
         self._last_imu_ts = 0.0
+        self._points = 0
+        self._scans = 0
 
         self._thread: Optional[threading.Thread] = None
 
+    def json_view(self, data):
+        """Points mode: the record without its arrays and raw header bytes (REST, WebSocket
+        poll); push clients and latest / history callers still get them."""
+        if not isinstance(data, dict) or "records" not in data:
+            return data
+        records = data["records"]
+        view = {k: v for k, v in data.items() if k not in ("records", "frame_header")}
+        view["count"] = len(records)
+        view["nbytes"] = int(getattr(records, "nbytes", 0))
+        return view
+
     def _systemd_start(self) -> None:
         try:
             subprocess.run(["systemctl", "start", self.service_name], check=True)
@@ -166,7 +280,20 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
         else:
             self._spawn_bridge()
 
-        if self.listen_udp:
+        if self.output == "points":
+            # history only: scans land in the receiver's rings, the adapter reads them on demand
+            self._rx = frame_receiver.open_receiver(queue_depth=0, native=self.native,
+                                                    history=self.history_size)
+            self.ring = _RecordRing(self._rx.points_history, self.sensor_id)
+            self.imu_ring = _RecordRing(self._rx.imu_history, self.sensor_id)
+            self.logger.info("Points mode with the %s receiver",
+                             "native" if frame_receiver.native_available() and self.native else "Python")
+            if not self.shm_name:
+                self._rx.open_udp(0)
+                self._rx.start()
+                self._ctl_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                self._ctl_sock.setblocking(False)
+        elif self.listen_udp and not self.shm_name:
             try:
                 self._pt_sock = self._join_multicast(self.point_port)
             except Exception as e:
@@ -187,10 +314,186 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
             )
             self._thread.start()
 
+    def _open_shm(self) -> None:
+        try:
+            self._shm = ShmRingReader(self.shm_name)
+            self.logger.info("Attached to bridge shm ring %s (%d slots)", self._shm.path, self._shm.slot_count)
+        except Exception as e:
+            self.logger.debug("shm ring %s not ready: %s", self.shm_name, e)
+            self._shm = None
+
+    def _drain_shm(self) -> None:
+        now = time.time()
+        while True:
+            got = self._shm.view()
+            if got is None:
+                return
+            seq, mv = got
+            hdr = bridge_frame.parse_header(mv)
+            is_imu = hdr is None and bytes(mv[:13]) == b'{"type":"imu"'
+            n = len(mv)
+            mv.release()
+            if not self._shm.still_valid(seq):
+                self._shm.lost += 1
+                continue
+            if hdr is not None:
+                if hdr.msg_type in (bridge_frame.MSG_POINTS, bridge_frame.MSG_SCAN,
+                                    bridge_frame.MSG_SCAN_COMPRESSED):
+                    if hdr.msg_type != bridge_frame.MSG_POINTS and hdr.frag_index == 0:
+                        self._scans += 1
+                    self._point_pkts += 1
+                    self._point_bytes += n
+                    self._points += hdr.point_count
+                    self._last_point_ts = now
+                elif hdr.msg_type == bridge_frame.MSG_IMU:
+                    # binary IMU batches: count samples so imu_pkts matches NDJSON mode
+                    self._imu_pkts += hdr.point_count
+                    self._imu_bytes += n
+                    self._last_imu_ts = now
+            elif is_imu:
+                # NDJSON records (imu/info/ack) share the ring with binary frames
+                self._imu_pkts += 1
+                self._imu_bytes += n
+                self._last_imu_ts = now
+
+    def _run_shm(self) -> None:
+        last_pub = time.time()
+        while not self._stop.is_set():
+            if self._shm is None:
+                self._open_shm()
+            if self._shm is not None:
+                self._drain_shm()
+
+            now = time.time()
+            if (now - last_pub) >= self.publish_period:
+                self.publish(self._counters(now))
+                last_pub = now
+            time.sleep(0.005)
+
+    def _subscribe(self, now: float) -> None:
+        """Take (or renew) a bridge subscription for points + IMU (+ grid, range images) to our
+        receiver port."""
+        try:
+            while True:
+                reply = json.loads(self._ctl_sock.recv(65535))
+                if reply.get("cmd") == "subscribe" and reply.get("status") == "ok":
+                    self._sub_ttl = float(reply.get("ttl_s") or 0) or 30.0
+                    if self.grid and not self._grid_synced:
+                        # deltas only carry changes: start from the bridge's whole map
+                        self._ctl_sock.sendto(b'{"cmd":"grid_snapshot"}', self.bridge_ctl)
+                        self._grid_synced = True
+                elif reply.get("type") == "cmd_done":
+                    with self._cmd_cv:
+                        if reply.get("id") in self._cmd_done:
+                            self._cmd_done[reply["id"]] = reply
+                            self._cmd_cv.notify_all()
+        except (OSError, ValueError):
+            pass
+        if now < self._sub_renew_at:
+            return
+        streams = "points,imu" + (",grid" if self.grid else "") + (",range" if self.range_image else "")
+        cmd = {"cmd": "subscribe", "streams": streams,
+               "format": self.bridge_format,
+               "port": self._rx.port}
+        try:
+            self._ctl_sock.sendto(json.dumps(cmd).encode(), self.bridge_ctl)
+        except OSError as e:
+            self.logger.debug("subscribe to %s:%d failed: %s", *self.bridge_ctl, e)
+        # leases expire after ttl_s; renew well before, and retry soon until the bridge answers
+        self._sub_renew_at = now + self._sub_ttl / 3.0
+
+    def _report_lag(self, now: float) -> None:
+        """Tell the bridge what our receiver lost so far, so it can downsample or shed scans
+        for us while we fall behind ({"cmd":"lag"}, bridge/backpressure.h)."""
+        if now < self._lag_at:
+            return
+        self._lag_at = now + 0.5
+        st = self._rx.stats()
+        lost = st.get("kernel_drops", 0) + st["incomplete"] + st["dropped"]
+        cmd = {"cmd": "lag", "port": self._rx.port, "lost": lost,
+               "queued": st.get("queued", 0), "capacity": st.get("capacity", 0)}
+        try:
+            self._ctl_sock.sendto(json.dumps(cmd).encode(), self.bridge_ctl)
+        except OSError:
+            pass
+
+    def command(self, cmd: dict, timeout_s: float = 5.0) -> Optional[dict]:
+        """Send a device command (set_work_mode, set_fov, ...) to the bridge and wait for its
+        {"type":"cmd_done"}: every lidar has acked, failed or timed out ("status" ok, partial or
+        failed). Points mode only; None if no completion came (bad_args, bridge busy or down)."""
+        if self._ctl_sock is None:
+            raise RuntimeError("bridge commands need output='points' over UDP")
+        with self._cmd_cv:
+            self._cmd_next_id += 1
+            cid = self._cmd_next_id
+            self._cmd_done[cid] = None
+        self._ctl_sock.sendto(json.dumps(dict(cmd, id=cid)).encode(), self.bridge_ctl)
+        # the points thread reads the control socket and files the record
+        with self._cmd_cv:
+            self._cmd_cv.wait_for(lambda: self._cmd_done[cid] is not None, timeout_s)
+            return self._cmd_done.pop(cid, None)
+
+    def _run_points(self) -> None:
+        while not self._stop.is_set():
+            if self.shm_name and not self._rx.running:
+                try:
+                    self._rx.open_shm(self.shm_name)
+                    self._rx.start()
+                except Exception as e:
+                    self.logger.debug("shm ring %s not ready: %s", self.shm_name, e)
+                    time.sleep(0.5)
+                    continue
+            if self._ctl_sock is not None:
+                now = time.time()
+                self._subscribe(now)
+                self._report_lag(now)
+            # no queue, so this only waits (without the GIL on the native receiver); the
+            # Python receiver fills its history here
+            self._rx.recv(10 if self.on_sample else 50)
+            if self.on_sample:
+                self._notify()
+            else:                       # a hook set later starts at the newest record
+                self._notified = [self.ring.seq, self.imu_ring.seq]
+
+    def _notify(self) -> None:
+        """Hand the records that reached the histories since the last call to on_sample."""
+        for i, ring in enumerate((self.ring, self.imu_ring)):
+            self._notified[i], got = ring.since(self._notified[i])
+            for ts_ns, data in got:
+                try:
+                    self.on_sample(self._sample(ts_ns, data))
+                except Exception:
+                    pass
+
+    def _counters(self, now: float) -> dict:
+        payload = {
+            "sensor_id": self.sensor_id,
+            "status": "running",
+            "point_pkts": self._point_pkts,
+            "point_bytes": self._point_bytes,
+            "imu_pkts": self._imu_pkts,
+            "imu_bytes": self._imu_bytes,
+            "last_point_ts": self._last_point_ts,
+            "last_imu_ts": self._last_imu_ts,
+            "timestamp": now,
+        }
+        if self._shm is not None:
+            payload["points"] = self._points
+            payload["scans"] = self._scans
+            payload["shm_lost"] = self._shm.lost
+            payload["shm_resyncs"] = self._shm.resyncs
+        return payload
+
     def run(self) -> None:
         self.logger.info("Livox MID-360 run() loop started.")
         last_pub = time.time()
         try:
+            if self.output == "points":
+                self._run_points()
+                return
+            if self.shm_name:
+                self._run_shm()
+                return
             while not self._stop.is_set():
                 poll_end = time.time() + 0.05
                 while time.time() < poll_end:
@@ -215,18 +518,7 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
 
                 now = time.time()
                 if (now - last_pub) >= self.publish_period:
-                    payload = {
-                        "sensor_id": self.sensor_id,
-                        "status": "running",
-                        "point_pkts": self._point_pkts,
-                        "point_bytes": self._point_bytes,
-                        "imu_pkts": self._imu_pkts,
-                        "imu_bytes": self._imu_bytes,
-                        "last_point_ts": self._last_point_ts,
-                        "last_imu_ts": self._last_imu_ts,
-                        "timestamp": now,
-                    }
-                    self.publish(payload)
+                    self.publish(self._counters(now))
                     last_pub = now
 
                 time.sleep(0.01)
@@ -244,6 +536,17 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
                     pass
         self._pt_sock = None
         self._imu_sock = None
+        if self._ctl_sock is not None:
+            try:
+                cmd = {"cmd": "unsubscribe", "port": self._rx.port}
+                self._ctl_sock.sendto(json.dumps(cmd).encode(), self.bridge_ctl)
+            except OSError:
+                pass
+            self._ctl_sock.close()
+            self._ctl_sock = None
+        if self._shm is not None:
+            self._shm.close()
+            self._shm = None
 
         if self.use_systemd:
             self._systemd_stop()
@@ -251,3 +554,6 @@ class LivoxMid360Adapter(AbstractSensorAdapter):
             self._terminate_bridge()
 
         super().stop()
+        if self._rx is not None:
+            self._rx.stop()             # after the run loop is done with it
+            self._rx = None
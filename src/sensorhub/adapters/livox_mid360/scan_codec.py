@@ -0,0 +1,135 @@
+"""
+Python decoder for compressed scans (msg 5, bridge/scan_codec.h).
+
+Each message is one block of a scan: a BridgeCodecBlock followed by the block's columns,
+compressed with LZ4 (block format), zstd or stored. LZ4 needs the `lz4` package and zstd the
+`zstandard` package; blocks in a codec whose package is missing raise ValueError. Keep this
+file in sync with the C++ header.
+"""
+
+import struct
+from typing import Optional
+
+import numpy as np
+
+from sensorhub.adapters.livox_mid360 import bridge_frame
+
+try:
+    import lz4.block as _lz4
+except ImportError:  # pragma: no cover - optional
+    _lz4 = None
+try:
+    import zstandard as _zstd
+except ImportError:  # pragma: no cover - optional
+    _zstd = None
+
+CODEC_NONE = 0
+CODEC_LZ4 = 1
+CODEC_ZSTD = 2
+
+BLOCK = struct.Struct("<BBHIIII")
+BLOCK_SIZE = BLOCK.size  # 20
+BLOCK_POINTS = 2048
+ESCAPE = 0xFFFF
+
+
+def available(codec: int) -> bool:
+    return codec == CODEC_NONE or (codec == CODEC_LZ4 and _lz4 is not None) or (
+        codec == CODEC_ZSTD and _zstd is not None)
+
+
+def _columns(payload, raw_len: int, codec: int) -> bytes:
+    data = bytes(payload)
+    if codec == CODEC_NONE:
+        raw = data
+    elif codec == CODEC_LZ4 and _lz4 is not None:
+        raw = _lz4.decompress(data, uncompressed_size=raw_len)
+    elif codec == CODEC_ZSTD and _zstd is not None:
+        raw = _zstd.ZstdDecompressor().decompress(data, max_output_size=raw_len)
+    else:
+        raise ValueError(f"codec {codec} not available")
+    if len(raw) != raw_len:
+        raise ValueError("block size mismatch")
+    return raw
+
+
+def decode_block(buf, hdr: bridge_frame.FrameHeader) -> tuple:
+    """
+    Decode one msg 5 frame (header included in buf) into (first_point, scan_points, points),
+    points being a POINT_XYZRT array of hdr.point_count records with reserved = 0.
+    """
+    off = bridge_frame.HEADER_SIZE
+    codec, quant, _, first, scan_points, raw_len, n_esc = BLOCK.unpack_from(buf, off)
+    n = hdr.point_count
+    if quant != 0 or n > BLOCK_POINTS or raw_len != 12 * n + 4 * n_esc or n_esc > 3 * n:
+        raise ValueError("malformed block")
+    raw = np.frombuffer(_columns(buf[off + BLOCK_SIZE:off + hdr.payload_len], raw_len, codec), dtype=np.uint8)
+
+    out = np.zeros(n, dtype=bridge_frame.POINT_DTYPES[bridge_frame.POINT_XYZRT])
+    esc = raw[12 * n:].view("<i4")
+    k = 0
+    for a, name in enumerate(("x", "y", "z")):
+        zz = raw[2 * a * n:(2 * a + 1) * n].astype(np.uint32) | (
+            raw[(2 * a + 1) * n:(2 * a + 2) * n].astype(np.uint32) << 8)
+        d = ((zz >> 1).astype(np.int64) ^ -(zz & 1).astype(np.int64))
+        escaped = zz == ESCAPE
+        m = int(escaped.sum())
+        if k + m > n_esc:
+            raise ValueError("escape list too short")
+        d[escaped] = esc[k:k + m]
+        k += m
+        # float32 like the C++ decoder, so both give the same bits
+        out[name] = np.cumsum(d).astype(np.int32).astype(np.float32) * np.float32(0.001)
+    if k != n_esc:
+        raise ValueError("unused escapes")
+    dt = raw[6 * n:10 * n].reshape(4, n).astype(np.uint64)
+    dt = dt[0] | (dt[1] << 8) | (dt[2] << 16) | (dt[3] << 24)
+    out["t_offset_ns"] = np.cumsum(dt) & 0xFFFFFFFF
+    out["reflectivity"] = raw[10 * n:11 * n]
+    out["tag"] = raw[11 * n:12 * n]
+    return first, scan_points, out
+
+
+class CompressedScanReassembler:
+    """
+    Collects the blocks of one scan (same seq) into a single POINT_XYZRT array. Blocks decode
+    independently, so a lost block leaves its points zero and is counted in `missing_blocks`
+    instead of dropping the scan; a scan is returned when its last block (or the next scan)
+    arrives; `header` is then the header of that scan's first block.
+    """
+
+    def __init__(self) -> None:
+        self._seq: Optional[int] = None
+        self._pts: Optional[np.ndarray] = None
+        self._got = 0
+        self._count = 0
+        self._hdr: Optional[bridge_frame.FrameHeader] = None
+        self.header: Optional[bridge_frame.FrameHeader] = None
+        self.missing_blocks = 0
+
+    def add(self, buf, hdr: bridge_frame.FrameHeader) -> Optional[np.ndarray]:
+        first, scan_points, pts = decode_block(buf, hdr)
+        done = None
+        if hdr.seq != self._seq:
+            done = self._finish()
+            self._seq = hdr.seq
+            self._pts = np.zeros(scan_points, dtype=pts.dtype)
+            self._got = 0
+            self._count = hdr.frag_count
+            self._hdr = hdr
+        if first + len(pts) <= len(self._pts):
+            self._pts[first:first + len(pts)] = pts
+            self._got += 1
+        if hdr.frag_index + 1 == hdr.frag_count:
+            return self._finish()
+        return done
+
+    def _finish(self) -> Optional[np.ndarray]:
+        if self._pts is None:
+            return None
+        out = self._pts
+        self.header = self._hdr
+        self.missing_blocks += max(self._count - self._got, 0)
+        self._pts = None
+        self._seq = None
+        return out
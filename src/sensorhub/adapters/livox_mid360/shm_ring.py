@@ -0,0 +1,127 @@
+"""
+Reader for the livox_bridge shared-memory ring (bridge/shm_ring.h).
+
+The bridge is the single producer; every reader maps /dev/shm/<name> read-only and keeps
+its own cursor, so the REST adapter and a recorder can consume the same stream
+independently. Sequence numbers let each reader count records it lost to overruns.
+"""
+
+import mmap
+import os
+import struct
+from typing import List, Optional, Tuple
+
+import numpy as np
+
+RING_MAGIC = 0x5258564C  # "LVXR"
+RING_VERSION = 1
+SLOT_WRITING = 0xFFFFFFFFFFFFFFFF
+
+_HEADER = struct.Struct("<IIIIII")
+_WRITE_SEQ_OFFSET = 64
+_SLOT_HEADER_SIZE = 16
+
+
+class ShmRingReader:
+    def __init__(self, name: str, from_start: bool = False) -> None:
+        self.name = name
+        self.path = name if name.startswith("/dev/shm/") else os.path.join("/dev/shm", name.lstrip("/"))
+        self._mm: Optional[mmap.mmap] = None
+        self.lost = 0
+        self.resyncs = 0
+        self._open(from_start)
+
+    def _open(self, from_start: bool) -> None:
+        fd = os.open(self.path, os.O_RDONLY)
+        try:
+            self._mm = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+        magic, version, slot_count, slot_size, data_offset, _pid = _HEADER.unpack_from(self._mm, 0)
+        if magic != RING_MAGIC or version != RING_VERSION:
+            self.close()
+            raise RuntimeError(f"{self.path}: not a livox_bridge ring (magic={magic:#x}, version={version})")
+        self.slot_count = slot_count
+        self.slot_size = slot_size
+        self.data_offset = data_offset
+        self._mask = slot_count - 1
+
+        # numpy views straight onto the mapping: write_seq and the strided slot seq column
+        self._write_seq = np.frombuffer(self._mm, dtype="<u8", count=1, offset=_WRITE_SEQ_OFFSET)
+        self._slot_seq = np.ndarray(
+            (slot_count,), dtype="<u8", buffer=self._mm, offset=data_offset, strides=(slot_size,)
+        )
+        self._slot_len = np.ndarray(
+            (slot_count,), dtype="<u4", buffer=self._mm, offset=data_offset + 8, strides=(slot_size,)
+        )
+        self.cursor = 1 if from_start else int(self._write_seq[0]) + 1
+
+    def close(self) -> None:
+        self._write_seq = None
+        self._slot_seq = None
+        self._slot_len = None
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except BufferError:
+                pass  # outstanding views; the mapping is released when they go away
+            self._mm = None
+
+    def write_seq(self) -> int:
+        return int(self._write_seq[0])
+
+    def _payload_offset(self, idx: int) -> int:
+        return self.data_offset + idx * self.slot_size + _SLOT_HEADER_SIZE
+
+    def view(self) -> Optional[Tuple[int, memoryview]]:
+        """
+        Zero-copy access to the next record. The returned memoryview aliases the shared
+        slot; call still_valid(seq) after consuming it to confirm it was not overwritten.
+        """
+        while True:
+            ws = int(self._write_seq[0])
+            r = self.cursor
+            if ws + 1 < r:
+                # producer restarted with a fresh ring
+                self.resyncs += 1
+                self.cursor = r = ws + 1
+            if r > ws:
+                return None
+            if ws - r >= self.slot_count:
+                skip_to = ws - self.slot_count + 1
+                self.lost += skip_to - r
+                self.cursor = r = skip_to
+            idx = (r - 1) & self._mask
+            if int(self._slot_seq[idx]) != r:
+                self.lost += 1
+                self.cursor = r + 1
+                continue
+            n = int(self._slot_len[idx])
+            off = self._payload_offset(idx)
+            self.cursor = r + 1
+            return r, memoryview(self._mm)[off:off + n]
+
+    def still_valid(self, seq: int) -> bool:
+        return int(self._slot_seq[(seq - 1) & self._mask]) == seq
+
+    def read(self) -> Optional[Tuple[int, bytes]]:
+        """Copy out the next record, retrying past any slot the producer lapped."""
+        while True:
+            got = self.view()
+            if got is None:
+                return None
+            seq, mv = got
+            data = bytes(mv)
+            mv.release()
+            if self.still_valid(seq):
+                return seq, data
+            self.lost += 1
+
+    def drain(self, max_records: int = 4096) -> List[bytes]:
+        out: List[bytes] = []
+        while len(out) < max_records:
+            got = self.read()
+            if got is None:
+                break
+            out.append(got[1])
+        return out
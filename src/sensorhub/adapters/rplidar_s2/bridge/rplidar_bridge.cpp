@@ -0,0 +1,1114 @@
+// RPLidar S2 Bridge - 2D laser scans over the livox_bridge transports
+// Talks the RPLidar serial protocol (rplidar_protocol.h) to an S2 on a serial port or an S2E
+// over UDP, assembles one scan per revolution and publishes it as a binary msg 7 frame
+// (BridgeLaserPoint records, see bridge_frame.h) through the same UDP / shm / subscriber
+// transports as livox_bridge, so the Python adapter maps scans straight into numpy.
+//
+// Environment variables:
+//   RPLIDAR_SOURCE     : input, "serial" (default), "udp" (S2E), "replay" or "synthetic"
+//   RPLIDAR_DEVICE     : serial port (default /dev/ttyUSB0)
+//   RPLIDAR_BAUD       : serial baud rate (default 1000000)
+//   RPLIDAR_IP         : S2E address for the udp source (default 192.168.11.2)
+//   RPLIDAR_DEVICE_PORT: S2E UDP port (default 8089)
+//   RPLIDAR_SCAN_MODE  : "standard" (SCAN, quality per point) or "dense" (EXPRESS_SCAN, default)
+//   RPLIDAR_EXPRESS_MODE: EXPRESS_SCAN working mode for "dense" (default 1 = DenseBoost)
+//   RPLIDAR_SCAN_MAX_POINTS: preallocated points per revolution (default 8192)
+//   RPLIDAR_MIN_POINTS : drop revolutions with fewer nodes (default 100: motor spin-up, noise)
+//   RPLIDAR_WATCHDOG_MS: restart the device handshake when no node arrived for this long
+//                        (default 2000)
+//   RPLIDAR_UDP_PORT   : UDP port of the default route (default 18090, 0 = no UDP output)
+//   RPLIDAR_CTL_PORT   : UDP port to receive JSON control commands (default 18190)
+//   RPLIDAR_SUB_TTL_S  : subscription lease, renewed by every subscribe (default 30, 0 = no expiry)
+//   RPLIDAR_BRIDGE_FORMAT: "binary" (default) or "ndjson" (scan summaries only, see below)
+//   RPLIDAR_SHM_NAME, _SHM_SLOTS, _SHM_SLOT_BYTES, _SHM_RESUME, _UDP_ADDR, _MCAST_TTL,
+//   _MCAST_IF, _UDP_FLUSH_US, _UDP_BATCH, _UDP_MTU, _UDP_LOOPBACK, _BRIDGE_STDOUT: as the LIVOX_ variables
+//                        (see livox_bridge.cpp, bridge_transport.h)
+//   RPLIDAR_STATS_MS   : period of the {"type":"stats"} record (default 1000, 0 = off)
+//   RPLIDAR_RECORD_DIR : record every byte read from the device into <dir>/rplidar_<time>.lvxr
+//   RPLIDAR_RECORD_CHUNK_MB: recording chunk size (default 16)
+//   RPLIDAR_REPLAY     : replay this .lvxr file (implies "replay")
+//   RPLIDAR_REPLAY_SPEED: replay rate, 1 = real time (default), 0 = as fast as possible
+//   RPLIDAR_REPLAY_LOOP: if "1", restart the replay at the end instead of exiting
+//   RPLIDAR_SYNTH_HZ   : synthetic source: revolutions per second (default 10)
+//   RPLIDAR_SYNTH_SPS  : synthetic source: samples per second (default 32000)
+//
+// Command line (overrides the matching variables):
+//   rplidar_bridge [--source <serial|udp|replay|synthetic>] [--device <tty>] [--record <dir>]
+//                  [--replay <file.lvxr> [--speed <x>] [--loop]]
+//
+// Scans: frame_cnt counts revolutions, stamp_ns is the host CLOCK_REALTIME the first node of
+// the revolution was read, t_offset_ns spreads the nodes evenly up to the read of the last
+// one (the device has no clock). The first, partial revolution after a (re)start is dropped.
+// NDJSON consumers get {"type":"scan"} summaries; info, health and stats records are NDJSON.
+//
+// Control (JSON datagrams to RPLIDAR_CTL_PORT, "id" echoed in the reply):
+//   {"cmd":"subscribe","port":..,"streams":"points,info,stats","format":"binary","decimate":N}
+//   {"cmd":"unsubscribe","sub":id}        as livox_bridge
+//   {"cmd":"get_info"} / {"cmd":"get_stats"}   the info / stats record, to the sender only
+//   {"cmd":"restart","reset":0|1}         redo the handshake (optionally after a device RESET)
+//
+// Threads: one epoll reactor does everything (device reads, decoding, assembly, output,
+// commands); a revolution is a few thousand nodes every 100 ms. The synthetic and replay
+// sources run on their own thread behind a socketpair that stands in for the serial port.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <termios.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bridge_frame.h"      // binary wire format, msg 7 / BridgeLaserPoint
+#include "bridge_transport.h"  // UDP / shm / stdout output, shared with livox_bridge
+#include "bridge_stats.h"
+#include "command_dispatch.h"
+#include "recorder.h"
+#include "subscriptions.h"
+#include "rplidar_protocol.h"
+
+// ---- Output ----
+static BridgeTransport g_out;
+static SubscriberTable& g_subs = g_out.subs();
+static uint64_t g_sub_ttl_ns = 30000000000ull;
+static uint16_t g_ctl_port = 18190;
+static uint64_t g_stats_ns = 1000000000ull;
+static BridgeCounters g_stats;            // point_packets = device reads, points = nodes
+static LatencyHistogram g_lat_sent;       // read of a revolution's last node -> sent
+static uint64_t g_start_ns = 0;
+static uint64_t g_rx_bytes = 0;
+
+static RecordWriter g_recorder;
+static size_t g_record_chunk_bytes = 16u << 20;
+
+static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ---- Device link ----
+// Handshake: STOP, GET_INFO, GET_HEALTH, then SCAN / EXPRESS_SCAN. Every step has a timeout
+// and is retried; a device reporting an error state gets a RESET and starts over. Replay
+// input is not interactive: it already holds the answers the device gave when recorded.
+enum LinkState { kLinkIdle, kLinkInfo, kLinkHealth, kLinkReset, kLinkScanning };
+static const char* const kLinkStateNames[] = { "idle", "info", "health", "reset", "scanning" };
+static const uint64_t kLinkStepTimeoutNs = 1000000000ull;
+static const uint64_t kLinkResetNs = 2000000000ull;       // the S2 reboots after RESET
+static const unsigned kLinkStepRetries = 3;
+
+struct DeviceLink {
+    int fd;
+    bool interactive;
+    bool dense;                 // EXPRESS_SCAN (dense capsules) instead of SCAN
+    uint8_t express_mode;
+    uint8_t state;              // LinkState
+    unsigned attempts;          // of the current step
+    uint64_t deadline_ns;
+    uint64_t last_node_ns;
+    uint64_t watchdog_ns;
+    uint64_t restarts;
+    uint32_t handle;            // FNV-1a of the serial (or device address before GET_INFO)
+    bool have_info;
+    RplidarInfo info;
+    RplidarHealth health;
+};
+
+static DeviceLink g_link;
+static RplidarDecoder g_decoder;
+
+// Handles are never 0 (kBridgeFusedHandle)
+static uint32_t fnv1a(const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 16777619u; }
+    return h ? h : 1;
+}
+
+static void link_send(uint8_t cmd) {
+    uint8_t req[16];
+    size_t n = g_link.dense && cmd == kRpCmdExpressScan ? rplidar_express_request(req, g_link.express_mode)
+                                                        : rplidar_request(req, cmd);
+    g_decoder.reset();        // the answer starts with a new descriptor
+    if (write(g_link.fd, req, n) != (ssize_t)n) std::perror("rplidar: device write");
+}
+
+static void link_step(uint8_t state, uint64_t t) {
+    g_link.state = state;
+    g_link.deadline_ns = t + (state == kLinkReset ? kLinkResetNs : kLinkStepTimeoutNs);
+    switch (state) {
+    case kLinkInfo:
+        link_send(kRpCmdStop);
+        link_send(kRpCmdGetInfo);
+        break;
+    case kLinkHealth:
+        link_send(kRpCmdGetHealth);
+        break;
+    case kLinkReset:
+        link_send(kRpCmdReset);
+        break;
+    case kLinkScanning:
+        link_send(g_link.dense ? kRpCmdExpressScan : kRpCmdScan);
+        g_link.last_node_ns = t;
+        break;
+    default:
+        break;
+    }
+}
+
+static void scan_restart();
+
+// (Re)start the handshake from the top: after open, a watchdog expiry or a "restart" command
+static void link_start(uint64_t t) {
+    scan_restart();
+    if (!g_link.interactive) {
+        g_link.state = kLinkScanning;
+        g_link.last_node_ns = t;
+        return;
+    }
+    g_link.attempts = 0;
+    link_step(kLinkInfo, t);
+}
+
+static void link_tick(uint64_t t) {
+    if (!g_link.interactive || g_link.state == kLinkIdle) return;
+    if (g_link.state == kLinkScanning) {
+        if (g_link.watchdog_ns && t - g_link.last_node_ns > g_link.watchdog_ns) {
+            std::cerr << "rplidar: no measurements for " << g_link.watchdog_ns / 1000000 << " ms, restarting"
+                      << std::endl;
+            ++g_link.restarts;
+            link_start(t);
+        }
+        return;
+    }
+    if (t < g_link.deadline_ns) return;
+    if (g_link.state == kLinkReset) { link_start(t); return; }
+    if (++g_link.attempts > kLinkStepRetries) {
+        std::cerr << "rplidar: no answer to " << kLinkStateNames[g_link.state] << " request, restarting"
+                  << std::endl;
+        ++g_link.restarts;
+        g_link.attempts = 0;
+        link_step(kLinkInfo, t);
+        return;
+    }
+    link_step(g_link.state, t);
+}
+
+// ---- Scan assembly ----
+// Nodes are appended to the open revolution until a node flagged start closes it.
+struct LaserScan {
+    std::vector<BridgeLaserPoint> pts;    // capacity RPLIDAR_SCAN_MAX_POINTS, never grown
+    size_t n;
+    uint64_t first_ns, first_rt_ns;       // read of the first node
+    uint64_t last_ns;                     // read of the last node
+    bool started;                         // a start node was seen: this revolution is whole
+    uint8_t frame_cnt;
+};
+
+static LaserScan g_scan;
+static size_t g_min_points = 100;
+static uint64_t g_short_scans = 0;
+static uint64_t g_read_ns = 0, g_read_rt_ns = 0;   // current device read
+
+static void scan_restart() {
+    g_scan.n = 0;
+    g_scan.started = false;
+}
+
+static void emit_ndjson(const char* line, size_t len, uint32_t mask) { g_out.ndjson(line, len, mask); }
+
+static void publish_scan() {
+    LaserScan& s = g_scan;
+    const uint32_t n = (uint32_t)s.n;
+    if (n < g_min_points) { ++g_short_scans; return; }
+    const uint64_t span = s.last_ns - s.first_ns;
+    for (uint32_t i = 0; i < n; ++i)
+        s.pts[i].t_offset_ns = n > 1 ? (uint32_t)(span * i / (n - 1)) : 0;
+    g_out.enq_ns = s.last_ns;
+
+    const uint32_t bin = g_out.route(kStreamPoints, kEncBinary) | g_out.route(kStreamPoints, kEncCompressed);
+    if (bin) {
+        BridgeFrameHeader h;
+        bridge_init_header(&h, kBridgeMsgLaserScan);
+        h.point_format = kBridgeLaserPoint;
+        h.handle = g_link.handle;
+        h.frame_cnt = s.frame_cnt;
+        h.host_ts_ns = s.first_ns;
+        h.stamp_ns = s.first_rt_ns;
+        g_out.binary(h, s.pts.data(), n, sizeof(BridgeLaserPoint), bin);
+    }
+    const uint32_t js = g_out.route(kStreamPoints, kEncNdjson);
+    if (js) {
+        float rmin = 0, rmax = 0;
+        uint32_t returns = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            const float r = s.pts[i].range_mm;
+            if (r <= 0) continue;
+            if (!returns || r < rmin) rmin = r;
+            if (r > rmax) rmax = r;
+            ++returns;
+        }
+        char buf[512];
+        const int len = std::snprintf(buf, sizeof(buf),
+            "{\"type\":\"scan\",\"handle\":%u,\"ts_us\":%" PRIu64 ",\"frame_cnt\":%u,\"points\":%u,"
+            "\"returns\":%u,\"range_min_mm\":%.1f,\"range_max_mm\":%.1f,\"duration_ms\":%.2f}",
+            g_link.handle, s.first_rt_ns / 1000, s.frame_cnt, n, returns, rmin, rmax, span / 1e6);
+        emit_ndjson(buf, (size_t)len, js);
+    }
+    g_out.enq_ns = 0;
+    BridgeCounters::inc(g_stats.scans);
+    BridgeCounters::inc(g_stats.points_out, n);
+}
+
+// ---- Decoder sink ----
+// {"type":"info"} of the device; "id" is set for a get_info reply, "valid" is false
+// until the device answered GET_INFO
+static size_t build_info(char* buf, size_t cap, uint32_t req_id = 0) {
+    char serial[33];
+    for (size_t i = 0; i < sizeof(g_link.info.serial); ++i)
+        std::snprintf(serial + 2 * i, 3, "%02X", g_link.info.serial[i]);
+    int n = std::snprintf(buf, cap, "{\"type\":\"info\",");
+    if (req_id) n += std::snprintf(buf + n, cap - n, "\"id\":%u,", req_id);
+    n += std::snprintf(buf + n, cap - n,
+        "\"sensor\":\"rplidar\",\"valid\":%s,\"handle\":%u,\"model\":%u,\"firmware\":\"%u.%02u\","
+        "\"hardware\":%u,\"serial\":\"%s\",\"scan_mode\":\"%s\"}",
+        g_link.have_info ? "true" : "false", g_link.handle, g_link.info.model, g_link.info.fw_major,
+        g_link.info.fw_minor, g_link.info.hardware, serial, g_link.dense ? "dense" : "standard");
+    return (size_t)n;
+}
+
+static void emit_info() {
+    char buf[320];
+    const size_t n = build_info(buf, sizeof(buf));
+    emit_ndjson(buf, n, g_out.route(kStreamInfo, kEncNdjson));
+}
+
+static void emit_health() {
+    static const char* const kStatus[] = { "good", "warning", "error" };
+    char buf[160];
+    const int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"health\",\"handle\":%u,\"status\":\"%s\",\"error_code\":%u}",
+        g_link.handle, g_link.health.status < 3 ? kStatus[g_link.health.status] : "unknown",
+        g_link.health.error_code);
+    emit_ndjson(buf, (size_t)n, g_out.route(kStreamInfo, kEncNdjson));
+}
+
+struct DecoderSink {
+    void on_info(const RplidarInfo& info) {
+        g_link.info = info;
+        g_link.have_info = true;
+        g_link.handle = fnv1a(info.serial, sizeof(info.serial));
+        emit_info();
+        if (g_link.state == kLinkInfo) {
+            g_link.attempts = 0;
+            link_step(kLinkHealth, g_read_ns);
+        }
+    }
+
+    void on_health(const RplidarHealth& health) {
+        g_link.health = health;
+        emit_health();
+        if (g_link.state != kLinkHealth) return;
+        g_link.attempts = 0;
+        if (health.status == kRpHealthError) {
+            std::cerr << "rplidar: device error 0x" << std::hex << health.error_code << std::dec << ", resetting"
+                      << std::endl;
+            link_step(kLinkReset, g_read_ns);
+        }
+        else {
+            link_step(kLinkScanning, g_read_ns);
+        }
+    }
+
+    void on_node(const RplidarNode& nd) {
+        LaserScan& s = g_scan;
+        BridgeCounters::inc(g_stats.points);
+        g_link.last_node_ns = g_read_ns;
+        if (nd.start) {
+            if (s.started && s.n) publish_scan();
+            s.started = true;
+            s.n = 0;
+            ++s.frame_cnt;
+        }
+        if (!s.started) return;        // partial first revolution
+        if (s.n == 0) {
+            s.first_ns = g_read_ns;
+            s.first_rt_ns = g_read_rt_ns;
+        }
+        if (s.n == s.pts.size()) {
+            BridgeCounters::inc(g_stats.truncated);
+            return;
+        }
+        BridgeLaserPoint& p = s.pts[s.n++];
+        p.angle_deg = nd.angle_deg;
+        p.range_mm = nd.range_mm;
+        p.t_offset_ns = 0;
+        p.quality = nd.quality;
+        std::memset(p.reserved, 0, sizeof(p.reserved));
+        s.last_ns = g_read_ns;
+    }
+};
+
+// Read what the device sent; false at EOF or on a read error.
+static bool drain_device() {
+    uint8_t buf[8192];
+    DecoderSink sink;
+    for (;;) {
+        const ssize_t n = read(g_link.fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            std::perror("rplidar: device read");
+            return false;
+        }
+        if (n == 0) return false;
+        g_read_ns = now_ns();
+        g_read_rt_ns = realtime_ns();
+        g_rx_bytes += (uint64_t)n;
+        BridgeCounters::inc(g_stats.point_packets);
+        if (g_recorder.is_open())
+            g_recorder.append(kRecDeviceBytes, g_link.handle, g_read_ns, g_read_rt_ns, buf, (size_t)n);
+        g_decoder.feed(buf, (size_t)n, sink);
+    }
+}
+
+// ---- Stats ----
+static size_t build_stats(char* buf, size_t cap, bool advance, uint32_t req_id = 0) {
+    static LatencyHistogram::Snapshot prev_sent;
+    const uint64_t t = now_ns();
+    int n = std::snprintf(buf, cap, "{\"type\":\"stats\",");
+    if (req_id) n += std::snprintf(buf + n, cap - n, "\"id\":%u,", req_id);
+    n += std::snprintf(buf + n, cap - n,
+        "\"ts_us\":%" PRIu64 ",\"uptime_s\":%.3f,"
+        "\"link\":{\"state\":\"%s\",\"handle\":%u,\"restarts\":%" PRIu64 ",\"health\":%u},"
+        "\"rx\":{\"reads\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"nodes\":%" PRIu64 ",\"bad_records\":%" PRIu64 ","
+        "\"resync_bytes\":%" PRIu64 ",\"unknown_answers\":%" PRIu64 "},"
+        "\"tx\":{\"records\":%" PRIu64 ",\"scans\":%" PRIu64 ",\"points\":%" PRIu64 ","
+        "\"udp_bytes\":%" PRIu64 ",\"shm_bytes\":%" PRIu64 ",\"udp_datagrams\":%" PRIu64 ",\"udp_syscalls\":%" PRIu64 "},"
+        "\"drops\":{\"truncated\":%" PRIu64 ",\"short_scans\":%" PRIu64 ",\"udp_send_errors\":%" PRIu64 ","
+        "\"shm_oversize\":%" PRIu64 "},\"latency_us\":{",
+        realtime_ns() / 1000, (t - g_start_ns) / 1e9,
+        kLinkStateNames[g_link.state], g_link.handle, g_link.restarts, g_link.health.status,
+        BridgeCounters::get(g_stats.point_packets), g_rx_bytes, BridgeCounters::get(g_stats.points),
+        g_decoder.bad_records(), g_decoder.resync_bytes(), g_decoder.unknown_answers(),
+        BridgeCounters::get(g_stats.records), BridgeCounters::get(g_stats.scans),
+        BridgeCounters::get(g_stats.points_out), BridgeCounters::get(g_stats.udp_bytes),
+        BridgeCounters::get(g_stats.shm_bytes), g_out.batcher().datagrams(), g_out.batcher().syscalls(),
+        BridgeCounters::get(g_stats.truncated), g_short_scans, g_out.batcher().send_errors(), g_out.shm_oversize());
+    n += format_latency(buf + n, cap - n, "read_to_sent", &g_lat_sent, 1, &prev_sent, advance);
+    n += std::snprintf(buf + n, cap - n, "}");
+    if (g_recorder.is_open())
+        n += std::snprintf(buf + n, cap - n,
+            ",\"record\":{\"records\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"chunks\":%zu,\"dropped\":%" PRIu64 "}",
+            g_recorder.records(), g_recorder.bytes(), g_recorder.chunks(), g_recorder.dropped());
+    n += std::snprintf(buf + n, cap - n, ",\"subscribers\":%zu}", g_subs.active());
+    return (size_t)n;
+}
+
+static void emit_stats() {
+    const uint32_t mask = g_out.route(kStreamStats, kEncNdjson);
+    char buf[2048];
+    const size_t n = build_stats(buf, sizeof(buf), true);   // always: it advances the latency baseline
+    emit_ndjson(buf, n, mask);
+}
+
+// ---- Control commands (adapter -> bridge) ----
+// Single-threaded, so handlers apply their command directly. Each returns 0, or one of:
+static const int kCmdBadArgs = -1;
+static const int kCmdNoReply = -2;   // answered directly (get_info, get_stats, subscribe)
+
+enum CmdStatus { kCmdStatusOk, kCmdStatusBadRequest, kCmdStatusUnknown, kCmdStatusBadArgs, kCmdStatusFull };
+static const char* const kCmdStatusNames[] = { "ok", "bad_request", "unknown_command", "bad_args", "full" };
+
+static void cmd_name(const BridgeCommand& c, char* out, size_t cap) {
+    const size_t n = c.has_name() && c.name.size() < cap ? c.name.size() : 0;
+    if (n) std::memcpy(out, c.name.begin, n);
+    out[n] = '\0';
+}
+
+static int cmd_get_stats(const BridgeCommand& c, const sockaddr_in& src) {
+    char buf[2048];
+    const size_t n = build_stats(buf, sizeof(buf), false, c.id);
+    g_out.reply(src, buf, n);
+    return kCmdNoReply;
+}
+
+static int cmd_get_info(const BridgeCommand& c, const sockaddr_in& src) {
+    char buf[320];
+    const size_t n = build_info(buf, sizeof(buf), c.id);
+    g_out.reply(src, buf, n);
+    return kCmdNoReply;
+}
+
+static int cmd_restart(const BridgeCommand& c, const sockaddr_in&) {
+    if (!g_link.interactive) return kCmdBadArgs;
+    ++g_link.restarts;
+    if (c.int_field("reset", 0)) { scan_restart(); link_step(kLinkReset, now_ns()); }
+    else link_start(now_ns());
+    return 0;
+}
+
+// Destination of a subscription: "addr" / "port", each defaulting to the sender's.
+static bool sub_destination(const BridgeCommand& c, const sockaddr_in& src, sockaddr_in* dst) {
+    *dst = src;
+    JsonValue v;
+    if (c.string_field("addr", &v)) {
+        char buf[INET_ADDRSTRLEN];
+        json_string(v, buf, sizeof(buf));
+        if (inet_pton(AF_INET, buf, &dst->sin_addr) != 1) return false;
+    }
+    const int port = c.int_field("port", ntohs(src.sin_port));
+    if (port <= 0 || port > 65535) return false;
+    dst->sin_port = htons((uint16_t)port);
+    return true;
+}
+
+static void sub_reply(const BridgeCommand& c, const sockaddr_in& src, int status, uint32_t id) {
+    char name[32], buf[256];
+    cmd_name(c, name, sizeof(name));
+    const int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"cmd\",\"id\":%u,\"cmd\":\"%s\",\"status\":\"%s\",\"requests\":0,\"sub\":%u,"
+        "\"ttl_s\":%.0f}",
+        c.id, name, kCmdStatusNames[status], id, g_sub_ttl_ns / 1e9);
+    g_out.reply(src, buf, (size_t)n);
+}
+
+static int cmd_subscribe(const BridgeCommand& c, const sockaddr_in& src) {
+    sockaddr_in dst;
+    bool ok = sub_destination(c, src, &dst);
+    JsonValue v;
+    const uint32_t streams = c.string_field("streams", &v) ? bridge_stream_mask(v.begin, v.size()) : (uint32_t)kStreamAll;
+    uint8_t format = g_out.format();
+    if (c.string_field("format", &v)) {
+        const int f = bridge_encoding_parse(v.begin, v.size());
+        if (f < 0) ok = false;
+        else format = (uint8_t)f;
+    }
+    const int decimate = c.int_field("decimate", 1);
+    if (!ok || !streams || decimate <= 0) {
+        sub_reply(c, src, kCmdStatusBadArgs, 0);
+        return kCmdNoReply;
+    }
+    const bool renew = g_subs.find(dst) >= 0;
+    const int slot = g_out.subscribe(dst, streams, format, (uint32_t)decimate,
+        g_sub_ttl_ns ? now_ns() + g_sub_ttl_ns : 0);
+    if (slot < 0) {
+        sub_reply(c, src, kCmdStatusFull, 0);
+        return kCmdNoReply;
+    }
+    const uint32_t id = g_subs.at(slot).id;
+    if (!renew) {
+        char addr[INET_ADDRSTRLEN];
+        if (!inet_ntop(AF_INET, &dst.sin_addr, addr, sizeof(addr))) std::snprintf(addr, sizeof(addr), "?");
+        std::cerr << "subscriber " << id << ": " << addr << ":" << ntohs(dst.sin_port) << " "
+                  << bridge_encoding_name(format) << ", streams 0x" << std::hex << streams << std::dec
+                  << ", decimate " << decimate << std::endl;
+    }
+    sub_reply(c, src, kCmdStatusOk, id);
+    return kCmdNoReply;
+}
+
+static int cmd_unsubscribe(const BridgeCommand& c, const sockaddr_in& src) {
+    sockaddr_in dst;
+    const int id = c.int_field("sub", 0);
+    const int slot = id > 0 ? g_subs.find_id((uint32_t)id) : (sub_destination(c, src, &dst) ? g_subs.find(dst) : -1);
+    if (slot < 0) {
+        sub_reply(c, src, kCmdStatusBadArgs, 0);
+        return kCmdNoReply;
+    }
+    const uint32_t sub = g_subs.at(slot).id;
+    g_out.unsubscribe(slot);
+    std::cerr << "subscriber " << sub << ": unsubscribed" << std::endl;
+    sub_reply(c, src, kCmdStatusOk, sub);
+    return kCmdNoReply;
+}
+
+struct CommandEntry {
+    const char* name;
+    int (*fn)(const BridgeCommand& c, const sockaddr_in& src);
+};
+
+static const CommandEntry kCommands[] = {
+    { "get_info",    cmd_get_info },
+    { "get_stats",   cmd_get_stats },
+    { "restart",     cmd_restart },
+    { "subscribe",   cmd_subscribe },
+    { "unsubscribe", cmd_unsubscribe },
+};
+
+static void emit_cmd_reply(const BridgeCommand& c, int status) {
+    char name[32], buf[256];
+    cmd_name(c, name, sizeof(name));
+    const int n = std::snprintf(buf, sizeof(buf),
+        "{\"type\":\"cmd\",\"id\":%u,\"cmd\":\"%s\",\"status\":\"%s\",\"requests\":0}",
+        c.id, name, kCmdStatusNames[status]);
+    emit_ndjson(buf, (size_t)n, g_out.route(kStreamInfo, kEncNdjson));
+}
+
+static void handle_command(const char* msg, size_t len, const sockaddr_in& src) {
+    BridgeCommand c;
+    if (!c.parse(msg, len) || !c.has_name()) {
+        emit_cmd_reply(c, kCmdStatusBadRequest);
+        return;
+    }
+    const CommandEntry* e = command_find(kCommands, c.name);
+    if (!e) {
+        emit_cmd_reply(c, kCmdStatusUnknown);
+        return;
+    }
+    const int r = e->fn(c, src);
+    if (r == kCmdNoReply) return;
+    emit_cmd_reply(c, r == kCmdBadArgs ? kCmdStatusBadArgs : kCmdStatusOk);
+}
+
+// ---- Device transports ----
+static bool baud_constant(int baud, speed_t* out) {
+    switch (baud) {
+    case 115200:  *out = B115200; return true;
+    case 230400:  *out = B230400; return true;
+    case 460800:  *out = B460800; return true;
+    case 921600:  *out = B921600; return true;
+    case 1000000: *out = B1000000; return true;
+    case 1500000: *out = B1500000; return true;
+    case 2000000: *out = B2000000; return true;
+    default:      return false;
+    }
+}
+
+// Raw 8N1 at `baud`. DTR is cleared: on Slamtec's USB adapters it gates the motor.
+static int open_serial(const char* path, int baud) {
+    speed_t speed;
+    if (!baud_constant(baud, &speed)) {
+        std::cerr << "RPLIDAR_BAUD " << baud << " is not a supported rate" << std::endl;
+        return -2;
+    }
+    const int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) { std::perror(path); return -1; }
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) { std::perror("tcgetattr"); close(fd); return -1; }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) { std::perror("tcsetattr"); close(fd); return -1; }
+    const int dtr = TIOCM_DTR;
+    ioctl(fd, TIOCMBIC, &dtr);
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+// S2E: the same protocol over UDP, one connected socket
+static int open_udp_device(const char* ip, uint16_t port) {
+    sockaddr_in dst;
+    std::memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &dst.sin_addr) != 1) {
+        std::cerr << "RPLIDAR_IP must be an IPv4 address" << std::endl;
+        return -2;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { std::perror("device socket"); return -1; }
+    const int rcvbuf = 1 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (connect(fd, (const sockaddr*)&dst, sizeof(dst)) < 0) { std::perror("device connect"); close(fd); return -1; }
+    return fd;
+}
+
+// ---- Emulated devices (socketpair) ----
+static std::atomic<bool> g_source_stopping(false);
+
+static bool write_all(int fd, const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    while (n) {
+        const ssize_t w = write(fd, b, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        b += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+static void sleep_until(uint64_t t) {
+    timespec ts;
+    ts.tv_sec = (time_t)(t / 1000000000ull);
+    ts.tv_nsec = (long)(t % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+static size_t rp_descriptor(uint8_t* out, uint32_t size, bool stream, uint8_t type) {
+    const uint32_t v = size | (stream ? 1u << 30 : 0u);
+    out[0] = kRpSync1;
+    out[1] = kRpSync2;
+    for (int i = 0; i < 4; ++i) out[2 + i] = (uint8_t)(v >> (8 * i));
+    out[6] = type;
+    return kRpDescriptorBytes;
+}
+
+// A device in a 6 x 4 m room, answering the handshake and streaming SCAN nodes or dense
+// capsules at sps samples/s and hz revolutions/s.
+class SyntheticDevice {
+public:
+    SyntheticDevice() : fd_(-1), hz_(10.0), sps_(32000.0), first_node_(true) {}
+
+    void configure(double hz, double sps) {
+        if (hz > 0) hz_ = hz;
+        if (sps > 0) sps_ = sps;
+    }
+
+    void start(int fd) {
+        fd_ = fd;
+        thread_ = std::thread(&SyntheticDevice::run, this);
+    }
+
+    void join() { if (thread_.joinable()) thread_.join(); }
+
+private:
+    enum Mode { kStopped, kScan, kDense };
+
+    static float room_range_mm(double deg) {
+        const double a = deg * M_PI / 180.0, c = std::cos(a), s = std::sin(a);
+        const double tx = std::fabs(c) > 1e-9 ? 3000.0 / std::fabs(c) : 1e12;
+        const double ty = std::fabs(s) > 1e-9 ? 2000.0 / std::fabs(s) : 1e12;
+        return (float)(tx < ty ? tx : ty);
+    }
+
+    // Requests the bridge sent: 0xA5 cmd [len payload checksum]
+    void handle_requests(int* mode) {
+        uint8_t buf[256];
+        const ssize_t n = recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+        for (ssize_t i = 0; i + 1 < n; ++i) {
+            if (buf[i] != kRpSync1) continue;
+            const uint8_t cmd = buf[i + 1];
+            uint8_t out[64];
+            size_t len = 0;
+            if (cmd == kRpCmdGetInfo) {
+                len = rp_descriptor(out, 20, false, kRpAnsInfo);
+                const uint8_t info[20] = { 0x61, 0x01, 0x01, 0x12, 'S', 'Y', 'N', 'T', 'H', 'E', 'T', 'I', 'C',
+                                           0, 0, 0, 0, 0, 0, 1 };
+                std::memcpy(out + len, info, sizeof(info));
+                len += sizeof(info);
+            }
+            else if (cmd == kRpCmdGetHealth) {
+                len = rp_descriptor(out, 3, false, kRpAnsHealth);
+                out[len++] = kRpHealthGood;
+                out[len++] = 0;
+                out[len++] = 0;
+            }
+            else if (cmd == kRpCmdScan) {
+                len = rp_descriptor(out, kRpNodeBytes, true, kRpAnsNode);
+                *mode = kScan;
+                first_node_ = true;
+            }
+            else if (cmd == kRpCmdExpressScan) {
+                len = rp_descriptor(out, kRpDenseCapsuleBytes, true, kRpAnsDenseCapsule);
+                *mode = kDense;
+                first_node_ = true;
+            }
+            else if (cmd == kRpCmdStop || cmd == kRpCmdReset) {
+                *mode = kStopped;
+            }
+            if (len && !write_all(fd_, out, len)) return;
+            i += 1;
+        }
+    }
+
+    void run() {
+        int mode = kStopped;
+        const double per_rev = sps_ / hz_;
+        const uint64_t step_ns = 1000000ull;      // write every ms
+        double angle = 0.0;                       // in samples of the current revolution
+        double owed = 0.0;
+        uint64_t t = now_ns();
+        std::vector<uint8_t> out;
+        while (!g_source_stopping.load(std::memory_order_relaxed)) {
+            handle_requests(&mode);
+            t += step_ns;
+            sleep_until(t);
+            if (mode == kStopped) { owed = 0; continue; }
+            owed += sps_ * step_ns / 1e9;
+            out.clear();
+            if (mode == kScan) {
+                for (; owed >= 1.0; owed -= 1.0) {
+                    const double deg = angle * 360.0 / per_rev;
+                    const bool start = first_node_ || angle == 0.0;
+                    first_node_ = false;
+                    const uint16_t a_q6 = (uint16_t)(deg * 64.0);
+                    const uint16_t d_q2 = (uint16_t)(room_range_mm(deg) * 4.0f);
+                    const uint8_t q = 47;
+                    out.push_back((uint8_t)((q << 2) | (start ? 1 : 2)));
+                    out.push_back((uint8_t)(((a_q6 << 1) & 0xFF) | 1));
+                    out.push_back((uint8_t)(a_q6 >> 7));
+                    out.push_back((uint8_t)(d_q2 & 0xFF));
+                    out.push_back((uint8_t)(d_q2 >> 8));
+                    if ((angle += 1.0) >= per_rev) angle = 0.0;
+                }
+            }
+            else {
+                for (; owed >= (double)kRpDenseCabins; owed -= kRpDenseCabins) {
+                    uint8_t cap[kRpDenseCapsuleBytes];
+                    const double deg = angle * 360.0 / per_rev;
+                    uint16_t a = (uint16_t)(deg * 64.0) & 0x7FFF;
+                    if (first_node_) a |= 0x8000;
+                    first_node_ = false;
+                    cap[2] = (uint8_t)a;
+                    cap[3] = (uint8_t)(a >> 8);
+                    for (size_t k = 0; k < kRpDenseCabins; ++k) {
+                        const uint16_t d = (uint16_t)room_range_mm(deg + k * 360.0 / per_rev);
+                        cap[4 + 2 * k] = (uint8_t)d;
+                        cap[5 + 2 * k] = (uint8_t)(d >> 8);
+                    }
+                    uint8_t sum = 0;
+                    for (size_t i = 2; i < kRpDenseCapsuleBytes; ++i) sum ^= cap[i];
+                    cap[0] = (uint8_t)(0xA0 | (sum & 0xF));
+                    cap[1] = (uint8_t)(0x50 | (sum >> 4));
+                    out.insert(out.end(), cap, cap + sizeof(cap));
+                    if ((angle += kRpDenseCabins) >= per_rev) angle -= per_rev;
+                }
+            }
+            if (!out.empty() && !write_all(fd_, out.data(), out.size())) break;
+        }
+        shutdown(fd_, SHUT_WR);
+    }
+
+    int fd_;
+    double hz_, sps_;
+    bool first_node_;          // the next node / capsule is the first since a scan request
+    std::thread thread_;
+};
+
+// The device bytes of a recording, written at their recorded pace (speed x, 0 = at once).
+class ReplayDevice {
+public:
+    ReplayDevice() : fd_(-1), speed_(1.0), loop_(false) {}
+
+    bool open(const char* path, double speed, bool loop) {
+        if (!reader_.open(path)) {
+            std::cerr << "replay: cannot open " << path << std::endl;
+            return false;
+        }
+        speed_ = speed;
+        loop_ = loop;
+        std::cerr << "replay source: " << path << ", " << reader_.records() << " records"
+                  << (reader_.indexed() ? "" : " (no index: recording was cut short)") << std::endl;
+        return true;
+    }
+
+    void start(int fd) {
+        fd_ = fd;
+        thread_ = std::thread(&ReplayDevice::run, this);
+    }
+
+    void join() { if (thread_.joinable()) thread_.join(); }
+
+private:
+    void run() {
+        do {
+            reader_.rewind();
+            RecordReader::Record r;
+            uint64_t rec0 = 0, t0 = now_ns();
+            while (!g_source_stopping.load(std::memory_order_relaxed) && reader_.next(&r)) {
+                if (r.h->kind != kRecDeviceBytes) continue;
+                if (!rec0) rec0 = r.h->host_ns;
+                if (speed_ > 0) sleep_until(t0 + (uint64_t)((r.h->host_ns - rec0) / speed_));
+                if (!write_all(fd_, r.payload, r.h->len)) return;
+            }
+        } while (loop_ && !g_source_stopping.load(std::memory_order_relaxed));
+        shutdown(fd_, SHUT_WR);       // EOF: the bridge drains what is left and exits
+    }
+
+    int fd_;
+    double speed_;
+    bool loop_;
+    RecordReader reader_;
+    std::thread thread_;
+};
+
+// ---- Reactor ----
+static int open_control_socket() {
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) { std::perror("control socket"); return -1; }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(g_ctl_port);
+
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::perror("control bind");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Periodic timerfd, or -1 when period_ns is 0 or the timer cannot be created.
+static int open_timer(uint64_t period_ns) {
+    if (!period_ns) return -1;
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) { std::perror("timerfd"); return -1; }
+    itimerspec its;
+    its.it_interval.tv_sec = (time_t)(period_ns / 1000000000ull);
+    its.it_interval.tv_nsec = (long)(period_ns % 1000000000ull);
+    its.it_value = its.it_interval;
+    timerfd_settime(fd, 0, &its, NULL);
+    return fd;
+}
+
+static void drain_control(int sock) {
+    char buf[4096];
+    for (;;) {
+        sockaddr_in src; socklen_t sl = sizeof(src);
+        const ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr*)&src, &sl);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) std::perror("control recvfrom");
+            return;
+        }
+        if (n > 0) handle_command(buf, (size_t)n, src);
+    }
+}
+
+static bool epoll_watch(int ep, int fd) {
+    if (fd < 0) return true;
+    epoll_event e;
+    std::memset(&e, 0, sizeof(e));
+    e.events = EPOLLIN;
+    e.data.fd = fd;
+    return epoll_ctl(ep, EPOLL_CTL_ADD, fd, &e) == 0;
+}
+
+static bool read_timer(int fd) {
+    uint64_t expirations;
+    return read(fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations);
+}
+
+// Runs until SIGINT/SIGTERM or the device input ends. Returns 0 after a signal or the end
+// of a replay, 3 on a device error.
+static int run_reactor(int sig_fd, int ctl_fd) {
+    const int stats_fd = open_timer(g_stats_ns);
+    const int tick_fd = open_timer(100000000ull);    // handshake timeouts, watchdog, leases
+    const int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0 || !epoll_watch(ep, sig_fd) || !epoll_watch(ep, ctl_fd) || !epoll_watch(ep, stats_fd) ||
+        !epoll_watch(ep, tick_fd) || !epoll_watch(ep, g_link.fd)) {
+        std::perror("epoll");
+        return 3;
+    }
+    link_start(now_ns());
+
+    int rc = -1;
+    while (rc < 0) {
+        epoll_event ev[8];
+        const int n = epoll_wait(ep, ev, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("epoll_wait");
+            rc = 3;
+            break;
+        }
+        for (int i = 0; i < n && rc < 0; ++i) {
+            const int fd = ev[i].data.fd;
+            if (fd == sig_fd) {
+                signalfd_siginfo si;
+                if (read(sig_fd, &si, sizeof(si)) == (ssize_t)sizeof(si)) {
+                    std::cerr << "rplidar_bridge: " << strsignal((int)si.ssi_signo) << ", shutting down" << std::endl;
+                    rc = 0;
+                }
+            }
+            else if (fd == g_link.fd) {
+                if (!drain_device()) {
+                    rc = g_link.interactive ? 3 : 0;
+                    if (rc) std::cerr << "rplidar_bridge: device closed" << std::endl;
+                }
+            }
+            else if (fd == ctl_fd) {
+                drain_control(ctl_fd);
+            }
+            else if (fd == stats_fd) {
+                if (read_timer(fd)) emit_stats();
+            }
+            else if (fd == tick_fd && read_timer(fd)) {
+                const uint64_t t = now_ns();
+                link_tick(t);
+                g_out.expire(t, [](int slot) {
+                    std::cerr << "subscriber " << g_subs.at(slot).id << ": lease expired" << std::endl;
+                });
+            }
+        }
+        g_out.flush();       // a revolution's datagrams leave together
+    }
+    if (g_link.interactive) link_send(kRpCmdStop);
+    close(ep);
+    if (stats_fd >= 0) close(stats_fd);
+    if (tick_fd >= 0) close(tick_fd);
+    return rc;
+}
+
+static void usage() {
+    std::cerr << "usage: rplidar_bridge [--source <serial|udp|replay|synthetic>] [--device <tty>] [--record <dir>]\n"
+                 "                      [--replay <file.lvxr> [--speed <x>] [--loop]]" << std::endl;
+}
+
+// ---- Main ----
+int main(int argc, char** argv) {
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    const int sig_fd = signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sig_fd < 0) { std::perror("signalfd"); return 3; }
+    g_start_ns = now_ns();
+
+    const char* source_name = std::getenv("RPLIDAR_SOURCE");
+    const char* device = std::getenv("RPLIDAR_DEVICE");
+    const char* record_dir = std::getenv("RPLIDAR_RECORD_DIR");
+    const char* replay_path = std::getenv("RPLIDAR_REPLAY");
+    double replay_speed = 1.0;
+    if (const char* p = std::getenv("RPLIDAR_REPLAY_SPEED")) replay_speed = std::atof(p);
+    bool replay_loop = bridge_env_flag("RPLIDAR", "REPLAY_LOOP", false);
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--source" && i + 1 < argc) source_name = argv[++i];
+        else if (a == "--device" && i + 1 < argc) device = argv[++i];
+        else if (a == "--record" && i + 1 < argc) record_dir = argv[++i];
+        else if (a == "--replay" && i + 1 < argc) replay_path = argv[++i];
+        else if (a == "--speed" && i + 1 < argc) replay_speed = std::atof(argv[++i]);
+        else if (a == "--loop") replay_loop = true;
+        else { usage(); return 2; }
+    }
+    if (replay_path && !*replay_path) replay_path = NULL;
+    if (!source_name || !*source_name) source_name = replay_path ? "replay" : "serial";
+    const std::string source = source_name;
+    if (source != "serial" && source != "udp" && source != "replay" && source != "synthetic") {
+        std::cerr << "RPLIDAR_SOURCE must be serial, udp, replay or synthetic" << std::endl;
+        return 2;
+    }
+    if (source == "replay" && !replay_path) {
+        std::cerr << "the replay source needs RPLIDAR_REPLAY or --replay <file.lvxr>" << std::endl;
+        return 2;
+    }
+    if (!device || !*device) device = "/dev/ttyUSB0";
+
+    g_link.fd = -1;
+    g_link.interactive = source != "replay";
+    const char* mode = std::getenv("RPLIDAR_SCAN_MODE");
+    g_link.dense = !mode || std::string(mode) != "standard";
+    if (mode && std::string(mode) != "standard" && std::string(mode) != "dense") {
+        std::cerr << "RPLIDAR_SCAN_MODE must be standard or dense" << std::endl;
+        return 2;
+    }
+    g_link.express_mode = 1;
+    if (const char* p = std::getenv("RPLIDAR_EXPRESS_MODE")) g_link.express_mode = (uint8_t)std::atoi(p);
+    g_link.watchdog_ns = 2000000000ull;
+    if (const char* p = std::getenv("RPLIDAR_WATCHDOG_MS")) g_link.watchdog_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    size_t max_points = 8192;
+    if (const char* p = std::getenv("RPLIDAR_SCAN_MAX_POINTS")) max_points = (size_t)std::atoi(p);
+    if (const char* p = std::getenv("RPLIDAR_MIN_POINTS")) g_min_points = (size_t)std::atoi(p);
+    g_scan.pts.resize(max_points ? max_points : 1);
+    if (const char* p = std::getenv("RPLIDAR_CTL_PORT")) g_ctl_port = (uint16_t)std::atoi(p);
+    if (const char* p = std::getenv("RPLIDAR_SUB_TTL_S")) g_sub_ttl_ns = (uint64_t)std::atoi(p) * 1000000000ull;
+    if (const char* p = std::getenv("RPLIDAR_STATS_MS")) g_stats_ns = (uint64_t)std::atoi(p) * 1000000ull;
+    if (const char* p = std::getenv("RPLIDAR_RECORD_CHUNK_MB")) g_record_chunk_bytes = (size_t)std::atoi(p) << 20;
+
+    g_out.attach(&g_stats, &g_lat_sent);
+    if (const int rc = g_out.open_from_env("RPLIDAR", 18090, kEncBinary)) return rc;
+
+    // The device end of the link; emulated devices get the other end of a socketpair
+    SyntheticDevice synthetic;
+    ReplayDevice replay;
+    int peer = -1;
+    if (source == "serial" || source == "udp") {
+        int fd;
+        if (source == "serial") {
+            int baud = 1000000;
+            if (const char* p = std::getenv("RPLIDAR_BAUD")) baud = std::atoi(p);
+            fd = open_serial(device, baud);
+            g_link.handle = fnv1a(device, std::strlen(device));
+        }
+        else {
+            const char* ip = std::getenv("RPLIDAR_IP");
+            if (!ip || !*ip) ip = "192.168.11.2";
+            uint16_t port = 8089;
+            if (const char* p = std::getenv("RPLIDAR_DEVICE_PORT")) port = (uint16_t)std::atoi(p);
+            fd = open_udp_device(ip, port);
+            g_link.handle = fnv1a(ip, std::strlen(ip));
+        }
+        if (fd < 0) return fd == -2 ? 2 : 3;
+        g_link.fd = fd;
+    }
+    else {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) { std::perror("socketpair"); return 3; }
+        g_link.fd = sv[0];
+        peer = sv[1];
+        fcntl(g_link.fd, F_SETFL, fcntl(g_link.fd, F_GETFL) | O_NONBLOCK);
+        g_link.handle = fnv1a(source.data(), source.size());
+        if (source == "replay") {
+            if (!replay.open(replay_path, replay_speed, replay_loop)) return 2;
+            replay.start(peer);
+        }
+        else {
+            double hz = 10.0, sps = 32000.0;
+            if (const char* p = std::getenv("RPLIDAR_SYNTH_HZ")) hz = std::atof(p);
+            if (const char* p = std::getenv("RPLIDAR_SYNTH_SPS")) sps = std::atof(p);
+            synthetic.configure(hz, sps);
+            std::cerr << "synthetic source: " << sps << " samples/s at " << hz << " Hz" << std::endl;
+            synthetic.start(peer);
+        }
+    }
+
+    // A replay is its own recording
+    if (record_dir && *record_dir && source != "replay") {
+        if (!g_recorder.open(record_dir, g_record_chunk_bytes, "rplidar")) {
+            std::perror("record");
+            return 3;
+        }
+        std::cerr << "recording to " << g_recorder.path() << std::endl;
+    }
+
+    const int ctl_fd = open_control_socket();
+    const int rc = run_reactor(sig_fd, ctl_fd);
+
+    g_source_stopping.store(true);
+    if (peer >= 0) shutdown(g_link.fd, SHUT_RDWR);   // unblocks the emulated device's writes
+    synthetic.join();
+    replay.join();
+    if (ctl_fd >= 0) close(ctl_fd);
+    close(sig_fd);
+    if (peer >= 0) close(peer);
+    close(g_link.fd);
+    g_recorder.close();
+    g_out.close();
+    return rc;
+}
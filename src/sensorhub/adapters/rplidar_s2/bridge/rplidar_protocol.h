@@ -0,0 +1,278 @@
+// RPLidar S2 Bridge - device protocol: request framing and a streaming response decoder
+//
+// Requests are 0xA5 <cmd>, followed for commands with a payload by <len> <payload> <checksum>
+// (XOR of every byte before it). Every response starts with a 7-byte descriptor
+//   0xA5 0x5A  u32 (size | mode << 30)  u8 type
+// and is either one `size`-byte answer (mode 0: info, health) or an endless stream of
+// `size`-byte records (mode 1: measurement nodes until STOP).
+//
+// RplidarDecoder takes whatever the serial port / UDP socket delivered, in any split, and
+// calls the sink for every complete answer:
+//   sink.on_info(const RplidarInfo&), sink.on_health(const RplidarHealth&),
+//   sink.on_node(const RplidarNode&)   nodes in angle order, start set on the first node
+//                                      of a new revolution
+// Measurement streams are the standard SCAN nodes (type 0x81, 5 bytes) and the dense
+// capsules of EXPRESS_SCAN (type 0x85, 84 bytes: 40 distances between two start angles,
+// what the S2 sends in its DenseBoost mode). A record that fails its check bits or checksum
+// is counted and the decoder slides one byte to find the next record boundary, so line
+// noise costs a few nodes, never the stream. Single-threaded, no allocation.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum RplidarCmd {
+    kRpCmdStop = 0x25,
+    kRpCmdReset = 0x40,
+    kRpCmdScan = 0x20,
+    kRpCmdExpressScan = 0x82,
+    kRpCmdGetInfo = 0x50,
+    kRpCmdGetHealth = 0x52,
+};
+
+enum RplidarAnswer {
+    kRpAnsInfo = 0x04,          // RplidarInfo, 20 B
+    kRpAnsHealth = 0x06,        // RplidarHealth, 3 B
+    kRpAnsNode = 0x81,          // standard measurement node, 5 B
+    kRpAnsDenseCapsule = 0x85,  // dense capsule, 84 B
+};
+
+enum RplidarHealthStatus { kRpHealthGood = 0, kRpHealthWarning = 1, kRpHealthError = 2 };
+
+static const uint8_t kRpSync1 = 0xA5;
+static const uint8_t kRpSync2 = 0x5A;
+static const size_t kRpDescriptorBytes = 7;
+static const size_t kRpNodeBytes = 5;
+static const size_t kRpDenseCapsuleBytes = 84;
+static const size_t kRpDenseCabins = 40;
+static const uint8_t kRpDenseQuality = 0x2F << 2;   // dense capsules carry no quality: SDK value for a return
+
+struct RplidarInfo {
+    uint8_t model;
+    uint8_t fw_minor;
+    uint8_t fw_major;
+    uint8_t hardware;
+    uint8_t serial[16];
+};
+
+struct RplidarHealth {
+    uint8_t  status;      // RplidarHealthStatus
+    uint16_t error_code;
+};
+
+struct RplidarNode {
+    float   angle_deg;    // clockwise, [0, 360)
+    float   range_mm;     // 0 = no return
+    uint8_t quality;
+    bool    start;        // first node of a revolution
+};
+
+// Frame request `cmd` with an optional payload into out (at least 4 + n bytes). Returns its size.
+static inline size_t rplidar_request(uint8_t* out, uint8_t cmd, const uint8_t* payload = NULL, uint8_t n = 0) {
+    out[0] = kRpSync1;
+    out[1] = cmd;
+    if (!n) return 2;
+    out[2] = n;
+    uint8_t sum = (uint8_t)(kRpSync1 ^ cmd ^ n);
+    for (uint8_t i = 0; i < n; ++i) {
+        out[3 + i] = payload[i];
+        sum ^= payload[i];
+    }
+    out[3 + n] = sum;
+    return 4 + (size_t)n;
+}
+
+// EXPRESS_SCAN in scan mode `mode` (the S2 lists its modes with GET_LIDAR_CONF; DenseBoost
+// is mode 1 on current firmware).
+static inline size_t rplidar_express_request(uint8_t* out, uint8_t mode) {
+    const uint8_t payload[5] = { mode, 0, 0, 0, 0 };   // working_mode, working_flags u16, param u16
+    return rplidar_request(out, kRpCmdExpressScan, payload, sizeof(payload));
+}
+
+static inline uint16_t rp_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t rp_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+class RplidarDecoder {
+public:
+    RplidarDecoder() : nodes_(0), bad_records_(0), resync_bytes_(0), unknown_(0) { reset(); }
+
+    // Forget any partial response: call before sending a request that gets a new descriptor.
+    void reset() {
+        have_ = 0;
+        in_answer_ = false;
+        type_ = 0;
+        size_ = 0;
+        stream_ = false;
+        have_capsule_ = false;
+        prev_start_q6_ = 0;
+        last_angle_ = -1.0f;
+    }
+
+    template <typename Sink>
+    void feed(const uint8_t* p, size_t n, Sink& sink) {
+        while (n) {
+            const size_t want = in_answer_ ? size_ : kRpDescriptorBytes;
+            const size_t take = want - have_ < n ? want - have_ : n;
+            std::memcpy(buf_ + have_, p, take);
+            have_ += take;
+            p += take;
+            n -= take;
+            if (have_ < want) return;
+            if (!in_answer_) descriptor();
+            else answer(sink);
+        }
+    }
+
+    uint8_t answer_type() const { return in_answer_ ? type_ : 0; }
+    uint64_t nodes() const { return nodes_; }
+    uint64_t bad_records() const { return bad_records_; }    // failed check bits / checksum
+    uint64_t resync_bytes() const { return resync_bytes_; }  // bytes skipped to find a record or descriptor
+    uint64_t unknown_answers() const { return unknown_; }
+
+private:
+    // Drop the first `k` buffered bytes
+    void shift(size_t k) {
+        std::memmove(buf_, buf_ + k, have_ - k);
+        have_ -= k;
+        resync_bytes_ += k;
+    }
+
+    void descriptor() {
+        if (buf_[0] != kRpSync1 || buf_[1] != kRpSync2) {
+            shift(1);
+            return;
+        }
+        const uint32_t v = rp_u32(buf_ + 2);
+        size_ = v & 0x3FFFFFFFu;
+        stream_ = (v >> 30) == 1;
+        type_ = buf_[6];
+        have_ = 0;
+        if (size_ == 0 || size_ > sizeof(buf_)) {   // nothing we can hold: wait for the next descriptor
+            ++unknown_;
+            return;
+        }
+        in_answer_ = true;
+        have_capsule_ = false;
+        last_angle_ = -1.0f;
+    }
+
+    template <typename Sink>
+    void answer(Sink& sink) {
+        switch (type_) {
+        case kRpAnsInfo:
+            if (size_ >= 20) {
+                RplidarInfo info;
+                info.model = buf_[0];
+                info.fw_minor = buf_[1];
+                info.fw_major = buf_[2];
+                info.hardware = buf_[3];
+                std::memcpy(info.serial, buf_ + 4, sizeof(info.serial));
+                sink.on_info(info);
+            }
+            break;
+        case kRpAnsHealth:
+            if (size_ >= 3) {
+                RplidarHealth health;
+                health.status = buf_[0];
+                health.error_code = rp_u16(buf_ + 1);
+                sink.on_health(health);
+            }
+            break;
+        case kRpAnsNode:
+            if (size_ == kRpNodeBytes && !node(sink)) return;
+            break;
+        case kRpAnsDenseCapsule:
+            if (size_ == kRpDenseCapsuleBytes && !capsule(sink)) return;
+            break;
+        default:
+            ++unknown_;
+            break;
+        }
+        have_ = 0;
+        if (!stream_) in_answer_ = false;
+    }
+
+    // False when the buffered bytes are not a node: one byte has been dropped, keep filling.
+    template <typename Sink>
+    bool node(Sink& sink) {
+        const uint8_t s = buf_[0] & 1, ns = (buf_[0] >> 1) & 1, c = buf_[1] & 1;
+        if (s == ns || !c) {
+            ++bad_records_;
+            shift(1);
+            return false;
+        }
+        RplidarNode nd;
+        nd.quality = buf_[0] >> 2;
+        nd.angle_deg = (rp_u16(buf_ + 1) >> 1) / 64.0f;
+        nd.range_mm = rp_u16(buf_ + 3) / 4.0f;
+        nd.start = s != 0;
+        emit(nd, sink);
+        return true;
+    }
+
+    // Dense capsule: sync nibbles 0xA / 0x5 over a split checksum, u16 start angle (q6, bit
+    // 15 = first capsule after the scan started), 40 u16 distances (mm). Its distances lie
+    // between its start angle and the next capsule's, so each capsule is decoded when the
+    // one after it arrives.
+    template <typename Sink>
+    bool capsule(Sink& sink) {
+        if ((buf_[0] >> 4) != 0xA || (buf_[1] >> 4) != 0x5) {
+            ++bad_records_;
+            shift(1);
+            return false;
+        }
+        uint8_t sum = 0;
+        for (size_t i = 2; i < kRpDenseCapsuleBytes; ++i) sum ^= buf_[i];
+        if (sum != (uint8_t)((buf_[0] & 0xF) | ((buf_[1] & 0xF) << 4))) {
+            ++bad_records_;
+            have_capsule_ = false;   // the angle span to it is unknown
+            return true;             // framing was fine: drop the capsule, keep the boundary
+        }
+        const uint16_t a = rp_u16(buf_ + 2);
+        const bool restart = (a & 0x8000u) != 0;
+        const uint32_t start_q6 = a & 0x7FFFu;
+        if (have_capsule_ && !restart) {
+            uint32_t span = start_q6 + (start_q6 < prev_start_q6_ ? 360u * 64u : 0u) - prev_start_q6_;
+            for (size_t k = 0; k < kRpDenseCabins; ++k) {
+                RplidarNode nd;
+                float angle = (prev_start_q6_ + span * (float)k / kRpDenseCabins) / 64.0f;
+                if (angle >= 360.0f) angle -= 360.0f;
+                nd.angle_deg = angle;
+                nd.range_mm = (float)rp_u16(prev_ + 2 * k);
+                nd.quality = nd.range_mm > 0 ? kRpDenseQuality : 0;
+                nd.start = false;
+                emit(nd, sink);
+            }
+        }
+        if (restart) last_angle_ = -1.0f;
+        std::memcpy(prev_, buf_ + 4, sizeof(prev_));
+        prev_start_q6_ = start_q6;
+        have_capsule_ = true;
+        return true;
+    }
+
+    // Dense nodes carry no start bit: a new revolution begins where the angle wraps.
+    template <typename Sink>
+    void emit(RplidarNode& nd, Sink& sink) {
+        if (type_ == kRpAnsDenseCapsule) nd.start = last_angle_ >= 0.0f && nd.angle_deg < last_angle_;
+        last_angle_ = nd.angle_deg;
+        ++nodes_;
+        sink.on_node(nd);
+    }
+
+    uint8_t buf_[128];
+    size_t have_;
+    bool in_answer_;
+    uint8_t type_;
+    size_t size_;
+    bool stream_;
+    bool have_capsule_;
+    uint32_t prev_start_q6_;
+    uint8_t prev_[2 * kRpDenseCabins];
+    float last_angle_;
+    uint64_t nodes_, bad_records_, resync_bytes_, unknown_;
+};
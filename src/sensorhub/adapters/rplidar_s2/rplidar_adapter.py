@@ -1,7 +1,11 @@
 ﻿
 """
-RPLidar S2 Adapter with SDK-or-rplidar fallback
+RPLidar S2 Adapter with bridge, SDK or rplidar backends
 
+- backend="bridge": the native rplidar_bridge (bridge/rplidar_bridge.cpp) reads and decodes
+  the device; scans arrive as binary msg 7 frames and are mapped straight into numpy
+  (LASER_POINT records, no per-point Python work). Samples then carry the bridge frame
+  ("frame_header" + "records") like the livox points mode, instead of angle/range lists.
 - If pyrplidarsdk (Slamtec SDK Python wrapper) is available, use it.
 - Otherwise, fall back to the pure-Python 'rplidar' library (serial only).
 
@@ -12,12 +16,17 @@ Patched backend:
 - Passes a quiet logger to suppress module-level "Starting motor" noise.
 """
 
+import json
 import logging
+import os
+import socket
+import subprocess
 import time
 import threading
 from dataclasses import dataclass
 from typing import Optional, List, Tuple
 
+from sensorhub.adapters.livox_mid360 import bridge_frame, frame_receiver
 from sensorhub.core.sensor_base import AbstractSensorAdapter
 
 
@@ -291,11 +300,205 @@ class _RplidarBackend:
             return None
 
 
+# ---------------------------- bridge backend ------------------------------
+
+class _BridgeBackend:
+    """
+    Scans from rplidar_bridge: spawned from bridge_path (or already running, e.g. as a
+    service), subscribed over its control port and received over UDP, or read from its shm
+    ring when shm_name is set (RPLIDAR_SHM_NAME). Same interface as the other backends, but
+    get_scan_data returns numpy views of the scan instead of lists.
+    """
+
+    _HEALTH = {0: "Good", 1: "Warning", 2: "Error"}
+
+    def __init__(self, port: Optional[str], baudrate: int, ip: Optional[str], udp_port: int,
+                 bridge_path: Optional[str] = None, bridge_host: str = "127.0.0.1",
+                 ctl_port: int = 18190, shm_name: Optional[str] = None, native: bool = True,
+                 logger: Optional[logging.Logger] = None):
+        self._port = port or "/dev/ttyUSB0"
+        self._baudrate = baudrate
+        self._ip = ip
+        self._udp_port = udp_port
+        self._bridge_path = bridge_path
+        self._ctl = (bridge_host, int(ctl_port))
+        self._shm_name = shm_name
+        self._native = native
+        self._logger = logger or logging.getLogger("sensorhub.adapters.rplidar_s2.bridge")
+
+        self._proc: Optional[subprocess.Popen] = None
+        self._rx = None
+        self._ctl_sock: Optional[socket.socket] = None
+        self._sub_renew_at = 0.0
+        self._sub_ttl = 30.0
+        self._next_id = 0
+        self.last_frame = None          # (FrameHeader, LASER_POINT array) of the last scan
+
+    def _spawn(self) -> None:
+        if not os.path.isfile(self._bridge_path):
+            raise RuntimeError(f"rplidar_bridge not found: {self._bridge_path}")
+        env = dict(os.environ, RPLIDAR_CTL_PORT=str(self._ctl[1]), RPLIDAR_BAUD=str(self._baudrate))
+        if self._ip:
+            env.update(RPLIDAR_SOURCE="udp", RPLIDAR_IP=self._ip, RPLIDAR_DEVICE_PORT=str(self._udp_port))
+        else:
+            env.update(RPLIDAR_SOURCE=env.get("RPLIDAR_SOURCE", "serial"), RPLIDAR_DEVICE=self._port)
+        if self._shm_name:
+            env["RPLIDAR_SHM_NAME"] = self._shm_name
+        self._proc = subprocess.Popen(
+            [self._bridge_path],
+            env=env,
+            stdout=subprocess.DEVNULL,
+            cwd=os.path.dirname(self._bridge_path) or None,
+        )
+        self._logger.info("Spawned rplidar_bridge: %s", self._bridge_path)
+
+    def connect(self) -> bool:
+        if self._bridge_path:
+            self._spawn()
+        self._ctl_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._ctl_sock.settimeout(1.0)
+        self._rx = frame_receiver.open_receiver(queue_depth=4, native=self._native)
+        if self._shm_name:
+            deadline = time.time() + 3.0
+            while True:           # the bridge creates the ring at startup
+                try:
+                    self._rx.open_shm(self._shm_name)
+                    break
+                except Exception:
+                    if time.time() >= deadline:
+                        return False
+                    time.sleep(0.1)
+        else:
+            self._rx.open_udp(0)
+        return bool(self._rx.start())
+
+    def disconnect(self) -> None:
+        self.stop_scan()
+        if self._ctl_sock is not None:
+            self._ctl_sock.close()
+            self._ctl_sock = None
+        if self._rx is not None:
+            self._rx.stop()
+            self._rx = None
+        if self._proc is not None:
+            try:
+                self._proc.terminate()
+                self._proc.wait(timeout=3.0)
+            except Exception:
+                try:
+                    self._proc.kill()
+                except Exception:
+                    pass
+            finally:
+                self._proc = None
+
+    def _request(self, cmd: dict) -> Optional[dict]:
+        """Send a command and wait for the reply carrying its id (get_info, get_stats)."""
+        if self._ctl_sock is None:
+            return None
+        self._next_id += 1
+        cid = self._next_id
+        try:
+            self._ctl_sock.sendto(json.dumps(dict(cmd, id=cid)).encode(), self._ctl)
+            end = time.time() + 1.0
+            while time.time() < end:
+                reply = json.loads(self._ctl_sock.recv(65535))
+                if reply.get("id") == cid:
+                    return reply
+        except (OSError, ValueError):
+            pass
+        return None
+
+    def get_device_info(self) -> Optional[_DeviceInfo]:
+        info = self._request({"cmd": "get_info"})
+        if not info or not info.get("valid"):
+            return None
+        major, _, minor = str(info.get("firmware", "0.0")).partition(".")
+        return _DeviceInfo(
+            model=int(info.get("model", 0)),
+            firmware_version=(int(major or 0) << 8) | int(minor or 0),
+            hardware_version=int(info.get("hardware", 0)),
+            serial_number=str(info.get("serial", "")),
+        )
+
+    def get_health(self) -> Optional[_DeviceHealth]:
+        stats = self._request({"cmd": "get_stats"})
+        if not stats:
+            return None
+        link = stats.get("link", {})
+        return _DeviceHealth(status=self._HEALTH.get(link.get("health"), "Unknown"))
+
+    def _subscribe(self, now: float) -> None:
+        """Take (or renew) the points subscription for our receiver port (UDP only)."""
+        if self._shm_name or now < self._sub_renew_at:
+            return
+        cmd = {"cmd": "subscribe", "streams": "points", "format": "binary", "port": self._rx.port}
+        try:
+            self._ctl_sock.sendto(json.dumps(cmd).encode(), self._ctl)
+        except OSError as e:
+            self._logger.debug("subscribe to %s:%d failed: %s", *self._ctl, e)
+        # leases expire after RPLIDAR_SUB_TTL_S (30 s by default); renew well before
+        self._sub_renew_at = now + self._sub_ttl / 3.0
+
+    def start_scan(self) -> bool:
+        """The bridge scans on its own; only our subscription is needed."""
+        if self._rx is None:
+            return False
+        self._sub_renew_at = 0.0
+        self._subscribe(time.time())
+        return True
+
+    def stop_scan(self) -> None:
+        if self._ctl_sock is not None and self._rx is not None and not self._shm_name:
+            try:
+                cmd = {"cmd": "unsubscribe", "port": self._rx.port}
+                self._ctl_sock.sendto(json.dumps(cmd).encode(), self._ctl)
+            except OSError:
+                pass
+
+    def get_scan_data(self):
+        """
+        Wait up to 100 ms for the next revolution: returns (angles_deg, ranges_mm, qualities)
+        as numpy views of one LASER_POINT array, or None.
+        """
+        if self._rx is None:
+            return None
+        if self._proc is not None and self._proc.poll() is not None:
+            raise RuntimeError(f"rplidar_bridge exited with {self._proc.returncode}")
+        self._subscribe(time.time())
+        got = self._rx.recv(100)
+        if got is None:
+            return None
+        hdr, pts = got
+        if hdr.msg_type != bridge_frame.MSG_LASER_SCAN:
+            return None
+        self.last_frame = (hdr, pts)
+        return pts["angle_deg"], pts["range_mm"], pts["quality"]
+
+    def scan_payload(self, sensor_id: str, now: float) -> dict:
+        """Sample for the scan get_scan_data just returned: the bridge frame as received, so
+        WebSocket push clients get it as a binary frame (api/ws.py) without re-encoding."""
+        hdr, pts = self.last_frame
+        return {
+            "sensor_id": sensor_id,
+            "type": "scan",
+            "handle": hdr.handle,
+            "seq": hdr.seq,
+            "frame_cnt": hdr.frame_cnt,
+            "stamp_ns": hdr.stamp_ns,
+            "point_format": hdr.point_format,
+            "frame_header": bridge_frame.HEADER.pack(*hdr),
+            "records": pts,             # read-only LASER_POINT array
+            "timestamp": now,
+        }
+
+
 # ----------------------------- Adapter class ------------------------------
 
 class RPLidarS2Adapter(AbstractSensorAdapter):
     """
-    RPLidar S2 adapter that prefers pyrplidarsdk, falls back to rplidar.
+    RPLidar S2 adapter. backend="auto" prefers pyrplidarsdk and falls back to rplidar;
+    "bridge" uses rplidar_bridge (native decoding, scans as numpy arrays).
     """
 
     def __init__(
@@ -308,6 +511,12 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
         udp_port: int = 8089,
         hz: Optional[float] = None,
         publish_empty_scans: bool = False,
+        backend: str = "auto",                # "auto", "bridge", "sdk" or "rplidar"
+        bridge_path: Optional[str] = None,    # bridge backend: spawn this rplidar_bridge
+        bridge_host: str = "127.0.0.1",       # bridge backend: control address
+        bridge_ctl_port: int = 18190,         # RPLIDAR_CTL_PORT of the bridge
+        shm_name: Optional[str] = None,       # RPLIDAR_SHM_NAME of the bridge; replaces UDP
+        native: bool = True,                  # use the livox_frames extension when it is built
     ):
         super().__init__(sensor_id, kind)
         self.logger = getattr(
@@ -323,6 +532,14 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
         self.udp_port = udp_port
         self.hz = hz
         self.publish_empty_scans = publish_empty_scans
+        if backend not in ("auto", "bridge", "sdk", "rplidar"):
+            raise ValueError(f"backend must be 'auto', 'bridge', 'sdk' or 'rplidar', not {backend!r}")
+        self.backend = backend
+        self.bridge_path = bridge_path
+        self.bridge_host = bridge_host
+        self.bridge_ctl_port = int(bridge_ctl_port)
+        self.shm_name = shm_name
+        self.native = bool(native)
 
         # Tuning knobs
         self._startup_delay = 0.5          # seconds to let sampling spin up
@@ -341,14 +558,26 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
 
     def _make_backend(self):
         """
-        Choose backend: pyrplidarsdk if importable, else rplidar.
+        Choose backend: rplidar_bridge when asked for, else pyrplidarsdk if importable,
+        else rplidar.
         """
+        if self.backend == "bridge":
+            self._using_sdk = False
+            return _BridgeBackend(self.port, self.baud, self.ip, self.udp_port,
+                                  bridge_path=self.bridge_path, bridge_host=self.bridge_host,
+                                  ctl_port=self.bridge_ctl_port, shm_name=self.shm_name,
+                                  native=self.native, logger=self.logger)
+        if self.backend == "rplidar":
+            self._using_sdk = False
+            return _RplidarBackend(self.port, self.baud, self.ip, self.udp_port)
         try:
             # Try SDK first
             import pyrplidarsdk  # noqa: F401
             self._using_sdk = True
             return _SDKBackend(self.port, self.baud, self.ip, self.udp_port)
         except Exception as sdk_err:
+            if self.backend == "sdk":
+                raise RuntimeError("backend='sdk' but pyrplidarsdk is not importable") from sdk_err
             # Fall back to rplidar
             self._using_sdk = False
             if self.ip:
@@ -362,7 +591,9 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
     def start(self):
         """Connect, check health, start scanning, spawn run loop."""
         backend = self._make_backend()
-        transport = f"udp://{self.ip}:{self.udp_port}" if self._using_sdk and self.ip else f"{self.port}@{self.baud}"
+        transport = f"udp://{self.ip}:{self.udp_port}" if self.ip else f"{self.port}@{self.baud}"
+        if self.backend == "bridge":
+            transport = f"rplidar_bridge ({transport})"
         self.logger.info("RPLIDAR S2 connecting via %s (hz=%s)...", transport, self.hz)
 
         if not backend.connect():
@@ -410,13 +641,16 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
                     angles, ranges, qualities = scan
                     if len(angles) >= self._min_points:
                         if self._min_pub_period == 0.0 or (now - self._last_pub_ts) >= self._min_pub_period:
-                            self.publish({
-                                "sensor_id": self.sensor_id,
-                                "angles": angles,
-                                "ranges": ranges,
-                                "qualities": qualities,
-                                "timestamp": now,
-                            })
+                            if isinstance(self._driver, _BridgeBackend):
+                                self.publish(self._driver.scan_payload(self.sensor_id, now))
+                            else:
+                                self.publish({
+                                    "sensor_id": self.sensor_id,
+                                    "angles": angles,
+                                    "ranges": ranges,
+                                    "qualities": qualities,
+                                    "timestamp": now,
+                                })
                             self._last_pub_ts = now
                 else:
                     if (now - self._last_empty_log) >= self._empty_log_interval and self.publish_empty_scans:
@@ -425,7 +659,8 @@ class RPLidarS2Adapter(AbstractSensorAdapter):
 
                 # Reset backoff on successful iteration and throttle polling
                 self._backoff_sec = 1.0
-                time.sleep(self._poll_interval)
+                if not isinstance(self._driver, _BridgeBackend):   # that one waits in recv()
+                    time.sleep(self._poll_interval)
 
             except Exception as e:
                 self.logger.warning("RPLIDAR S2 read error: %s; reconnect in %.1fs", e, self._backoff_sec)
@@ -1,12 +1,15 @@
 
-import os, time
-from typing import Any
+import os, time, json, socket
+from typing import Any, Optional
 from fastapi import APIRouter
 from ..video.pipeline_manager import PipelineManager
 
 router = APIRouter(prefix="/metrics", tags=["metrics"])
 pm = PipelineManager()  # reuse the manager instance; if you keep a global one, import it instead
 
+# livox_bridge control socket (LIVOX_CTL_PORT of the bridge)
+LIVOX_CTL_ADDR = ("127.0.0.1", int(os.getenv("LIVOX_CTL_PORT", "18181")))
+
 def _read_meminfo() -> dict[str, int]:
     out = {}
     try:
@@ -29,6 +32,28 @@ def system_metrics():
         "mem_kb": {k: mem.get(k) for k in ("MemTotal", "MemFree", "Buffers", "Cached")}
     }
 
+def _livox_bridge_stats(timeout: float = 0.3) -> Optional[dict[str, Any]]:
+    """Ask livox_bridge for its counters/latency; the reply comes back to our own UDP port."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(timeout)
+    try:
+        sock.sendto(b'{"cmd":"get_stats"}', LIVOX_CTL_ADDR)
+        data, _ = sock.recvfrom(65535)
+        return json.loads(data)
+    except (OSError, ValueError):
+        return None
+    finally:
+        sock.close()
+
+@router.get("/livox")
+def livox_metrics():
+    stats = _livox_bridge_stats()
+    return {
+        "timestamp": time.time(),
+        "available": stats is not None,
+        "bridge": stats,
+    }
+
 @router.get("/video")
 def video_metrics():
     rows: list[dict[str, Any]] = []
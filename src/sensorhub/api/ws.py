@@ -1,3 +1,35 @@
+"""
+WebSocket API (/ws).
+
+Poll mode (the default):
+    {"action": "subscribe", "sensor_id": "gps1"}
+    {"action": "poll"}  ->  {"type": "poll-result", "data": {sensor_id: latest sample}}
+
+Push mode sends every sample as the adapter publishes it, so latency is not the poll interval:
+    {"action": "subscribe", "sensor_id": "livox", "mode": "push", "queue": 8}
+    {"action": "unsubscribe", "sensor_id": "livox"}
+The adapter's on_sample hook hands each sample to a bounded queue per subscription; a slow
+client loses the oldest samples, reported as {"type": "dropped", "sensor_id", "count"}
+(the total so far, at most once a second). Samples go out as {"type": "sample",
+"sensor_id", "ts", "data"} text frames, encoded once however many clients take them.
+Samples that carry a bridge frame (livox points mode: data["frame_header"] + "records")
+go out as binary frames instead, passed through without re-encoding the points:
+
+    u16 n (little-endian) | sensor_id (n bytes, UTF-8) | LVXB header (56 B) | payload
+
+in the livox_bridge binary format (adapters/livox_mid360/bridge/bridge_frame.h).
+{"action": "ping"} answers {"type": "pong"} in either mode. A message that is not a JSON
+object, or a poll result that cannot be serialized, is answered with {"type": "error"}; the
+connection stays open.
+"""
+
+import asyncio
+import json
+import struct
+import threading
+import time
+from collections import deque
+from typing import Dict, Optional
 
 from fastapi import APIRouter, WebSocket, WebSocketDisconnect
 from fastapi.encoders import jsonable_encoder
@@ -5,13 +37,171 @@ from ..core.sensor_manager import manager
 
 router = APIRouter()
 
+PUSH_QUEUE_DEFAULT = 8
+PUSH_QUEUE_MAX = 1024
+DROPPED_NOTICE_S = 1.0
+
+
+class _Outgoing:
+    """One published sample, encoded on first send and shared by every subscriber."""
+
+    __slots__ = ("sensor_id", "sample", "_msg")
+
+    def __init__(self, sensor_id: str, sample: dict) -> None:
+        self.sensor_id = sensor_id
+        self.sample = sample
+        self._msg = None
+
+    def message(self):
+        """(binary, payload) for ws.send_bytes / ws.send_text."""
+        if self._msg is None:
+            data = self.sample.get("data")
+            if isinstance(data, dict) and "frame_header" in data and "records" in data:
+                sid = self.sensor_id.encode()
+                records = data["records"]           # numpy array, or PointColumns (columnar scans)
+                records = memoryview(getattr(records, "raw", records)).cast("B")
+                self._msg = (True, b"".join((struct.pack("<H", len(sid)), sid, data["frame_header"], records)))
+            else:
+                try:
+                    text = json.dumps(jsonable_encoder({"type": "sample", **self.sample}))
+                except (TypeError, ValueError) as e:
+                    text = json.dumps({"type": "error", "sensor_id": self.sensor_id,
+                                       "error": f"sample not JSON-serializable: {e}"})
+                self._msg = (False, text)
+        return self._msg
+
+
+class _Subscription:
+    def __init__(self, conn: "_Connection", sensor_id: str, depth: int) -> None:
+        self.conn = conn
+        self.sensor_id = sensor_id
+        self.queue: deque = deque(maxlen=depth)
+        self.dropped = 0
+        self.reported = 0
+        self.reported_at = 0.0
+
+    def offer(self, out: _Outgoing) -> None:
+        # adapter thread: deque appends are atomic, maxlen drops the oldest
+        if len(self.queue) == self.queue.maxlen:
+            self.dropped += 1
+        self.queue.append(out)
+        self.conn.wake()
+
+
+class _Fanout:
+    """Installed as adapter.on_sample; feeds every push subscription of that sensor (and
+    whatever hook the adapter had before)."""
+
+    def __init__(self, adapter) -> None:
+        self.sensor_id = adapter.sensor_id
+        self.subs = ()                  # copy-on-write: the adapter thread iterates it
+        self._chained = adapter.on_sample
+        adapter.on_sample = self
+
+    def __call__(self, sample: dict) -> None:
+        subs = self.subs
+        if subs:
+            out = _Outgoing(self.sensor_id, sample)
+            for sub in subs:
+                sub.offer(out)
+        if self._chained:
+            self._chained(sample)
+
+    def add(self, sub: _Subscription) -> None:
+        self.subs = self.subs + (sub,)
+
+    def remove(self, sub: _Subscription) -> None:
+        self.subs = tuple(s for s in self.subs if s is not sub)
+
+
+_fanouts: Dict[str, _Fanout] = {}
+_fanouts_lock = threading.Lock()
+
+
+def _fanout(sensor_id: str) -> Optional[_Fanout]:
+    adapter = manager.adapters.get(sensor_id)
+    if adapter is None:
+        return None
+    with _fanouts_lock:
+        f = _fanouts.get(sensor_id)
+        if f is None:
+            f = _fanouts[sensor_id] = _Fanout(adapter)
+        return f
+
+
+class _Connection:
+    """Push state of one client: its subscriptions and a sender woken by new samples."""
+
+    def __init__(self, ws: WebSocket) -> None:
+        self.ws = ws
+        self.loop = asyncio.get_running_loop()
+        self.event = asyncio.Event()
+        self.subs: Dict[str, _Subscription] = {}
+        self._wake_pending = False
+        self.task: Optional[asyncio.Task] = None
+
+    def wake(self) -> None:
+        # one call_soon_threadsafe per burst, not per sample
+        if not self._wake_pending:
+            self._wake_pending = True
+            self.loop.call_soon_threadsafe(self.event.set)
+
+    def subscribe(self, fanout: _Fanout, depth: int) -> None:
+        self.unsubscribe(fanout.sensor_id)
+        sub = _Subscription(self, fanout.sensor_id, depth)
+        self.subs[fanout.sensor_id] = sub
+        fanout.add(sub)
+        if self.task is None:
+            self.task = asyncio.create_task(self._send_loop())
+
+    def unsubscribe(self, sensor_id: str) -> None:
+        sub = self.subs.pop(sensor_id, None)
+        if sub is not None and sensor_id in _fanouts:
+            _fanouts[sensor_id].remove(sub)
+
+    def close(self) -> None:
+        for sid in list(self.subs):
+            self.unsubscribe(sid)
+        if self.task is not None:
+            self.task.cancel()
+
+    async def _send_loop(self) -> None:
+        try:
+            while True:
+                await self.event.wait()
+                self.event.clear()
+                self._wake_pending = False
+                for sub in list(self.subs.values()):
+                    while sub.queue:
+                        binary, msg = sub.queue.popleft().message()
+                        if binary:
+                            await self.ws.send_bytes(msg)
+                        else:
+                            await self.ws.send_text(msg)
+                    now = time.monotonic()
+                    if sub.dropped != sub.reported and now - sub.reported_at >= DROPPED_NOTICE_S:
+                        sub.reported, sub.reported_at = sub.dropped, now
+                        await self.ws.send_json({'type': 'dropped', 'sensor_id': sub.sensor_id,
+                                                 'count': sub.dropped})
+        except (WebSocketDisconnect, RuntimeError, OSError):
+            return                      # the receive loop sees the disconnect and cleans up
+
+
 @router.websocket('/ws')
 async def ws_endpoint(ws: WebSocket):
     await ws.accept()
+    conn = _Connection(ws)
     try:
         subscriptions: set[str] = set()
         while True:
-            msg = await ws.receive_json()
+            try:
+                msg = await ws.receive_json()
+            except (ValueError, TypeError, KeyError):   # not JSON, or a binary frame
+                await ws.send_json({'type': 'error', 'error': 'message is not JSON'})
+                continue
+            if not isinstance(msg, dict):
+                await ws.send_json({'type': 'error', 'error': 'message must be a JSON object'})
+                continue
             action = msg.get('action')
 
             if action == 'subscribe':
@@ -20,26 +210,49 @@ async def ws_endpoint(ws: WebSocket):
                     await ws.send_json({'type': 'error', 'error': 'sensor_id must be a string'})
                     continue
 
-                if sid in manager.adapters:
+                mode = msg.get('mode', 'poll')
+                if sid not in manager.adapters:
+                    await ws.send_json({'type': 'error', 'error': f'unknown sensor {sid}'})
+                elif mode == 'push':
+                    depth = msg.get('queue', PUSH_QUEUE_DEFAULT)
+                    if not isinstance(depth, int) or not 1 <= depth <= PUSH_QUEUE_MAX:
+                        await ws.send_json({'type': 'error', 'error': f'queue must be 1..{PUSH_QUEUE_MAX}'})
+                        continue
+                    subscriptions.discard(sid)
+                    conn.subscribe(_fanout(sid), depth)
+                    await ws.send_json({'type': 'subscribed', 'sensor_id': sid, 'mode': 'push', 'queue': depth})
+                elif mode == 'poll':
+                    conn.unsubscribe(sid)
                     subscriptions.add(sid)
                     await ws.send_json({'type': 'subscribed', 'sensor_id': sid})
                 else:
-                    await ws.send_json({'type': 'error', 'error': f'unknown sensor {sid}'})
+                    await ws.send_json({'type': 'error', 'error': 'mode must be "poll" or "push"'})
+
+            elif action == 'unsubscribe':
+                sid = msg.get('sensor_id')
+                subscriptions.discard(sid)
+                conn.unsubscribe(sid)
+                await ws.send_json({'type': 'unsubscribed', 'sensor_id': sid})
 
             elif action == 'poll':
                 out = {}
                 for sid in list(subscriptions):
                     s = manager.latest(sid)
                     if s:
-                        # If s is a Pydantic model, .dict() is fine, but it may contain datetimes.
-                        # jsonable_encoder below will convert nested datetimes into ISO strings.
-                        out[sid] = s.dict()
+                        out[sid] = s.model_dump()
+                try:
+                    # datetimes (and other non-JSON-native types) into JSON-serializable values
+                    text = json.dumps({'type': 'poll-result', 'data': jsonable_encoder(out)})
+                except (TypeError, ValueError) as e:
+                    text = json.dumps({'type': 'error', 'error': f'sample not JSON-serializable: {e}'})
+                await ws.send_text(text)
 
-                # Convert any datetimes (and other non-JSON-native types) into JSON-serializable values.
-                payload = {'type': 'poll-result', 'data': jsonable_encoder(out)}
-                await ws.send_json(payload)
+            elif action == 'ping':
+                await ws.send_json({'type': 'pong'})
 
             else:
                 await ws.send_json({'type': 'error', 'error': 'unknown action'})
     except WebSocketDisconnect:
         return
+    finally:
+        conn.close()
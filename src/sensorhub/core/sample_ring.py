@@ -0,0 +1,94 @@
+"""
+Fixed-capacity ring of typed samples: an int64 timestamp column (ns since the epoch), an
+optional fixed-size row column (row_size bytes per slot, e.g. a packed record header) and a
+payload column, preallocated once. append() stores into the next slot without building a
+sample dict or a timestamp string; latest() is O(1) and last(k) O(k). ts_column() and
+rows() expose the typed columns without a copy.
+
+One writer (the adapter thread) and any number of readers, without a lock: the writer
+stores the slot, then its sequence number, then the ring's write sequence; a reader checks
+the slot sequence after reading and skips entries the writer overwrote meanwhile (the same
+protocol as the bridge's shm ring).
+"""
+
+from array import array
+from typing import Any, Iterator, List, Optional, Tuple
+
+
+class SampleRing:
+    def __init__(self, capacity: int = 1024, row_size: int = 0) -> None:
+        if capacity < 1:
+            raise ValueError("capacity must be >= 1")
+        self.capacity = capacity
+        self.row_size = row_size
+        self._ts = array("q", bytes(8 * capacity))       # ts_ns per slot
+        self._rows = bytearray(row_size * capacity)      # row per slot
+        self._slot_seq = array("Q", bytes(8 * capacity)) # 1-based seq of the sample in the slot
+        self._data: List[Any] = [None] * capacity
+        self._seq = 0                                    # samples written
+
+    def append(self, ts_ns: int, data: Any, row: bytes = b"") -> int:
+        if len(row) != self.row_size:
+            raise ValueError(f"row must be {self.row_size} bytes")
+        seq = self._seq + 1
+        i = (seq - 1) % self.capacity
+        self._slot_seq[i] = 0
+        self._ts[i] = ts_ns
+        if row:
+            self._rows[i * self.row_size:(i + 1) * self.row_size] = row
+        self._data[i] = data
+        self._slot_seq[i] = seq
+        self._seq = seq
+        return seq
+
+    @property
+    def seq(self) -> int:
+        """Samples appended so far (the newest sample's sequence number)."""
+        return self._seq
+
+    def __len__(self) -> int:
+        return min(self._seq, self.capacity)
+
+    def _read(self, seq: int) -> Optional[Tuple[int, Any]]:
+        i = (seq - 1) % self.capacity
+        ts, data = self._ts[i], self._data[i]
+        return (ts, data) if self._slot_seq[i] == seq else None
+
+    def latest(self) -> Optional[Tuple[int, Any]]:
+        seq = self._seq
+        while seq > 0:
+            got = self._read(seq)
+            if got is not None:
+                return got
+            seq = self._seq   # lapped while reading: retry at the new head
+        return None
+
+    def last(self, k: int) -> List[Tuple[int, Any]]:
+        """Up to k newest samples, oldest first, as (ts_ns, data)."""
+        head = self._seq
+        return self._collect(head - min(max(k, 0), head) + 1, head)
+
+    def since(self, after: int) -> Tuple[int, List[Tuple[int, Any]]]:
+        """(seq, samples appended after seq `after`); pass seq back next time to see every
+        sample once (those already overwritten are gone)."""
+        head = self._seq
+        return head, self._collect(after + 1, head)
+
+    def _collect(self, first: int, head: int) -> List[Tuple[int, Any]]:
+        out = []
+        for seq in range(max(first, head - self.capacity + 1), head + 1):
+            got = self._read(seq)
+            if got is not None:
+                out.append(got)
+        return out
+
+    def __iter__(self) -> Iterator[Tuple[int, Any]]:
+        return iter(self.last(self.capacity))
+
+    def ts_column(self) -> memoryview:
+        """The raw int64 timestamp column in slot order (e.g. numpy.frombuffer), no copy."""
+        return memoryview(self._ts)
+
+    def rows(self) -> memoryview:
+        """The row column in the same slot order, row_size bytes per slot, no copy."""
+        return memoryview(self._rows).toreadonly()
@@ -1,35 +1,61 @@
-
 import threading
 import time
 from abc import ABC, abstractmethod
-from collections import deque
 from datetime import datetime, timezone
-from typing import Any, Optional, Deque, Callable
+from typing import Any, Optional, Callable
+
+from .sample_ring import SampleRing
 
 class AbstractSensorAdapter(ABC):
-    def __init__(self, sensor_id: str, kind: str, ring_size: int = 1024):
+    def __init__(self, sensor_id: str, kind: str, ring_size: int = 1024, ring: Optional[SampleRing] = None):
         self.sensor_id = sensor_id
         self.kind = kind
-        self.ring: Deque[dict] = deque(maxlen=ring_size)
-        self.latest: Optional[dict] = None
+        # (ts_ns, data) per sample; anything with SampleRing's latest() / last(k) / len() works
+        self.ring = ring if ring is not None else SampleRing(ring_size)
+        self._latest: Optional[dict] = None
         self._thread: Optional[threading.Thread] = None
         self._stop = threading.Event()
         self.on_sample: Optional[Callable[[dict], None]] = None
 
     def publish(self, data: Any):
-        sample = {
-            'sensor_id': self.sensor_id,
-            'ts': datetime.now(timezone.utc).isoformat(),
-            'data': data,
-        }
-        self.latest = sample
-        self.ring.append(sample)
+        ts_ns = time.time_ns()
+        self._latest = None
+        self.ring.append(ts_ns, data)
         if self.on_sample:
             try:
-                self.on_sample(sample)
+                self.on_sample(self._sample(ts_ns, data))
             except Exception:
                 pass
 
+    def _sample(self, ts_ns: int, data: Any) -> dict:
+        # 'ts' stays the ISO-8601 UTC string on_sample hooks and latest readers always got
+        return {
+            'sensor_id': self.sensor_id,
+            'ts': datetime.fromtimestamp(ts_ns / 1e9, timezone.utc).isoformat(),
+            'data': data,
+        }
+
+    def json_view(self, data: Any) -> Any:
+        """The payload as REST and WebSocket poll serve it. Adapters whose samples carry
+        arrays or raw bytes return a JSON-safe summary instead."""
+        return data
+
+    @property
+    def latest(self) -> Optional[dict]:
+        """Newest sample as {'sensor_id', 'ts', 'data'}, built on read. Adapters may still
+        assign it; the assigned dict is served until their next publish()."""
+        if self._latest is not None:
+            return self._latest
+        got = self.ring.latest()
+        return self._sample(*got) if got is not None else None
+
+    @latest.setter
+    def latest(self, sample: Optional[dict]) -> None:
+        self._latest = sample
+
+    def history(self, limit: int = 100) -> list:
+        return [self._sample(ts_ns, data) for ts_ns, data in self.ring.last(limit)]
+
     def start(self):
         if self._thread and self._thread.is_alive():
             return
@@ -1,6 +1,7 @@
 
 import importlib
 import yaml
+from datetime import datetime
 from typing import Dict, List, Optional
 from pathlib import Path
 from .sensor_base import AbstractSensorAdapter
@@ -34,16 +35,29 @@ class SensorManager:
     def list(self) -> List[SensorInfo]:
         return [SensorInfo(id=a.sensor_id, kind=a.kind) for a in self.adapters.values()]
 
+    # REST / poll view. Samples are validated, except for adapters with their own json_view:
+    # the payload is then a summary the adapter builds for this response, and only 'ts' is
+    # converted (samples carry it as an ISO-8601 string).
+    @staticmethod
+    def _view(a: AbstractSensorAdapter, s: dict) -> Sample:
+        if type(a).json_view is AbstractSensorAdapter.json_view:
+            return Sample(**s)
+        ts = s['ts']
+        if isinstance(ts, str):
+            ts = datetime.fromisoformat(ts)
+        return Sample.model_construct(**dict(s, ts=ts, data=a.json_view(s['data'])))
+
     def latest(self, sensor_id: str) -> Optional[Sample]:
         a = self.adapters.get(sensor_id)
-        if not a or not a.latest:
+        s = a.latest if a else None
+        if s is None:
             return None
-        return Sample(**a.latest)
+        return self._view(a, s)
 
     def history(self, sensor_id: str, limit: int = 100) -> List[Sample]:
         a = self.adapters.get(sensor_id)
         if not a:
             return []
-        return [Sample(**s) for s in list(a.ring)[-limit:]]
+        return [self._view(a, s) for s in a.history(limit)]
 
 manager = SensorManager()
@@ -0,0 +1,52 @@
+import numpy as np
+from fastapi import FastAPI
+from fastapi.testclient import TestClient
+
+from sensorhub.adapters.livox_mid360 import bridge_frame
+from sensorhub.adapters.livox_mid360.livox_adapter import LivoxMid360Adapter, _RecordRing
+from sensorhub.api import routes, ws as ws_api
+from sensorhub.core.sample_ring import SampleRing
+from sensorhub.core.sensor_manager import manager
+
+
+def _scan_header(n: int) -> bridge_frame.FrameHeader:
+    return bridge_frame.FrameHeader(
+        bridge_frame.FRAME_MAGIC, 1, bridge_frame.MSG_SCAN, bridge_frame.POINT_XYZRT, 0, 7, 42, 0, 1, n,
+        n * bridge_frame.POINT_DTYPES[bridge_frame.POINT_XYZRT].itemsize, 0, bridge_frame.FLAG_DESKEWED, 0,
+        1, 2, 1_700_000_000_000_000_000)
+
+
+def test_latest_serves_points_mode_samples_as_json():
+    a = LivoxMid360Adapter('lidar_rest', output='points', use_systemd=False)
+    history = SampleRing(4)
+    a.ring = _RecordRing(history, 'lidar_rest')
+    pts = np.zeros(3, dtype=bridge_frame.POINT_DTYPES[bridge_frame.POINT_XYZRT])
+    hdr = _scan_header(len(pts))
+    history.append(hdr.stamp_ns, (hdr, pts))
+    manager.adapters['lidar_rest'] = a
+    app = FastAPI()
+    app.include_router(routes.router)
+    app.include_router(ws_api.router)
+    try:
+        client = TestClient(app)
+        r = client.get('/sensors/lidar_rest/latest')
+        assert r.status_code == 200
+        data = r.json()['data']
+        assert data['type'] == 'scan' and data['seq'] == 42 and data['deskewed'] is True
+        assert data['count'] == 3 and data['nbytes'] == pts.nbytes
+        assert 'records' not in data and 'frame_header' not in data
+
+        r = client.get('/sensors/lidar_rest/history', params={'limit': 5})
+        assert r.status_code == 200 and [s['data']['count'] for s in r.json()['samples']] == [3]
+
+        with client.websocket_connect('/ws') as ws:
+            ws.send_json({'action': 'subscribe', 'sensor_id': 'lidar_rest'})
+            assert ws.receive_json()['type'] == 'subscribed'
+            ws.send_json({'action': 'poll'})
+            msg = ws.receive_json()
+            assert msg['type'] == 'poll-result' and msg['data']['lidar_rest']['data']['count'] == 3
+
+        # the Python API still hands out the arrays
+        assert a.latest['data']['records'] is pts
+    finally:
+        manager.adapters.pop('lidar_rest', None)
@@ -0,0 +1,114 @@
+import threading
+from datetime import datetime
+
+import pytest
+from pydantic import ValidationError
+
+from sensorhub.core.sample_ring import SampleRing
+from sensorhub.core.sensor_base import AbstractSensorAdapter
+from sensorhub.core.sensor_manager import SensorManager
+
+
+def test_wraparound_keeps_newest():
+    r = SampleRing(4)
+    assert r.latest() is None and len(r) == 0
+    for i in range(10):
+        r.append(i * 1000, {'i': i})
+    assert len(r) == 4 and r.seq == 10
+    assert r.latest() == (9000, {'i': 9})
+    assert [d['i'] for _, d in r.last(3)] == [7, 8, 9]
+    assert [d['i'] for _, d in r.last(100)] == [6, 7, 8, 9]
+    assert r.last(0) == []
+    assert sorted(r.ts_column().tolist()) == [6000, 7000, 8000, 9000]
+
+
+def test_readers_see_ordered_samples_while_writing():
+    r = SampleRing(8)
+    done = threading.Event()
+
+    def write():
+        for i in range(1, 20001):
+            r.append(i, i)
+        done.set()
+
+    t = threading.Thread(target=write)
+    t.start()
+    while not done.is_set():
+        got = r.last(8)
+        assert all(ts == d for ts, d in got)
+        assert [ts for ts, _ in got] == sorted(ts for ts, _ in got)
+    t.join()
+    assert r.latest() == (20000, 20000)
+
+
+class Counter(AbstractSensorAdapter):
+    def run(self):
+        for i in range(5):
+            self.publish({'n': i})
+
+
+def test_adapter_latest_and_history():
+    m = SensorManager()
+    m.register(Counter('c', 'counter', ring_size=3))
+    m.adapters['c']._thread.join()
+    s = m.latest('c')
+    assert s.sensor_id == 'c' and s.data == {'n': 4}
+    assert [h.data['n'] for h in m.history('c', limit=10)] == [2, 3, 4]
+    assert m.history('c', limit=10)[0].ts <= s.ts
+    assert m.latest('missing') is None
+
+
+def test_hook_payload_and_latest_keep_their_contract():
+    got = []
+    c = Counter('h', 'counter')
+    c.on_sample = got.append
+    c.run()
+    assert len(got) == 5 and isinstance(got[-1]['ts'], str)
+    assert datetime.fromisoformat(got[-1]['ts']).tzinfo is not None
+    assert c.latest == got[-1]
+    c.latest = {'sensor_id': 'h', 'ts': got[0]['ts'], 'data': {'n': -1}}   # adapters may assign it
+    assert c.latest['data'] == {'n': -1}
+    c.publish({'n': 5})
+    assert c.latest['data'] == {'n': 5}
+
+
+class Summarized(Counter):
+    def json_view(self, data):
+        return len(data)
+
+
+def test_view_validates_unless_the_adapter_summarizes():
+    m = SensorManager()
+    plain, summarized = Counter('p', 'counter'), Summarized('s', 'counter')
+    m.adapters.update(p=plain, s=summarized)
+    plain.latest = {'sensor_id': 'p', 'ts': 'not a time', 'data': 1}
+    with pytest.raises(ValidationError):
+        m.latest('p')
+    summarized.run()
+    s = m.latest('s')
+    assert s.data == 1 and isinstance(s.ts, datetime)
+
+
+def test_since_follows_every_sample_once():
+    r = SampleRing(4)
+    seq, got = r.since(0)
+    assert (seq, got) == (0, [])
+    r.append(1, 'a')
+    r.append(2, 'b')
+    seq, got = r.since(seq)
+    assert seq == 2 and [d for _, d in got] == ['a', 'b']
+    for i in range(3, 10):
+        r.append(i, i)
+    seq, got = r.since(seq)     # lapped: only what is still in the ring
+    assert seq == 9 and [ts for ts, _ in got] == [6, 7, 8, 9]
+    assert r.since(seq) == (9, [])
+
+
+def test_row_column_follows_the_slots():
+    r = SampleRing(3, row_size=2)
+    for i in range(5):
+        r.append(i, i, bytes((i, i)))
+    rows = r.rows()
+    assert rows.readonly and rows.nbytes == 6
+    assert [rows[(seq - 1) % 3 * 2] for seq in range(3, 6)] == [2, 3, 4]
+    assert r.last(1) == [(4, 4)]
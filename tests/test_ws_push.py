@@ -0,0 +1,69 @@
+from fastapi import FastAPI
+from fastapi.testclient import TestClient
+
+from sensorhub.api import ws as ws_api
+from sensorhub.core.sensor_base import AbstractSensorAdapter
+from sensorhub.core.sensor_manager import manager
+
+
+class Manual(AbstractSensorAdapter):
+    def run(self):
+        pass
+
+
+def test_push_sends_text_and_binary_frames():
+    a = Manual('push1', 'test')
+    manager.adapters['push1'] = a
+    app = FastAPI()
+    app.include_router(ws_api.router)
+    try:
+        with TestClient(app).websocket_connect('/ws') as ws:
+            ws.send_json({'action': 'subscribe', 'sensor_id': 'push1', 'mode': 'push', 'queue': 4})
+            assert ws.receive_json() == {'type': 'subscribed', 'sensor_id': 'push1', 'mode': 'push', 'queue': 4}
+
+            a.publish({'n': 1})
+            msg = ws.receive_json()
+            assert msg['type'] == 'sample' and msg['sensor_id'] == 'push1' and msg['data'] == {'n': 1}
+
+            a.publish({'frame_header': b'LVXB' + bytes(52), 'records': b'\x01\x02'})
+            raw = ws.receive_bytes()
+            assert raw[:7] == b'\x05\x00push1'
+            assert raw[7:11] == b'LVXB' and len(raw) == 7 + 56 + 2 and raw[-2:] == b'\x01\x02'
+
+            ws.send_json({'action': 'ping'})
+            assert ws.receive_json() == {'type': 'pong'}
+        assert ws_api._fanouts['push1'].subs == ()
+    finally:
+        manager.adapters.pop('push1', None)
+        ws_api._fanouts.pop('push1', None)
+
+
+class Opaque(AbstractSensorAdapter):
+    def run(self):
+        pass
+
+
+def test_bad_messages_and_unserializable_polls_keep_the_connection():
+    a = Opaque('opaque1', 'test')
+    a.publish({'blob': object()})
+    manager.adapters['opaque1'] = a
+    app = FastAPI()
+    app.include_router(ws_api.router)
+    try:
+        with TestClient(app).websocket_connect('/ws') as ws:
+            ws.send_text('not json')
+            assert ws.receive_json()['type'] == 'error'
+            ws.send_json([1, 2])
+            assert ws.receive_json()['type'] == 'error'
+            ws.send_json(3)
+            assert ws.receive_json()['type'] == 'error'
+
+            ws.send_json({'action': 'subscribe', 'sensor_id': 'opaque1'})
+            assert ws.receive_json()['type'] == 'subscribed'
+            ws.send_json({'action': 'poll'})
+            assert ws.receive_json()['type'] == 'error'
+
+            ws.send_json({'action': 'ping'})
+            assert ws.receive_json() == {'type': 'pong'}
+    finally:
+        manager.adapters.pop('opaque1', None)